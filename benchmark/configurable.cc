@@ -51,6 +51,26 @@ using unsafe_heap = dart::basic_heap<dart::unsafe_ptr>;
 using unsafe_buffer = dart::basic_buffer<dart::unsafe_ptr>;
 using unsafe_packet = dart::basic_packet<dart::unsafe_ptr>;
 
+// Counts SAX events, so that the tokenizers can be compared without building anything.
+struct event_counter {
+  bool StartObject() { return ++events; }
+  bool Key(char const*, size_t, bool) { return ++events; }
+  bool EndObject(size_t) { return ++events; }
+  bool StartArray() { return ++events; }
+  bool EndArray(size_t) { return ++events; }
+  bool String(char const*, size_t, bool) { return ++events; }
+  bool Int(int) { return ++events; }
+  bool Uint(unsigned) { return ++events; }
+  bool Int64(int64_t) { return ++events; }
+  bool Uint64(uint64_t) { return ++events; }
+  bool Double(double) { return ++events; }
+  bool RawNumber(char const*, size_t, bool) { return ++events; }
+  bool Bool(bool) { return ++events; }
+  bool Null() { return ++events; }
+
+  size_t events = 0;
+};
+
 #ifdef DART_HAS_YAJL
 struct yajl_owner {
   yajl_owner() = default;
@@ -416,6 +436,22 @@ BENCHMARK_F(benchmark_helper, flexbuffer_nontrivial_json_finalizing) (benchmark:
 }
 #endif
 
+BENCHMARK_F(benchmark_helper, dart_nontrivial_native_json_reader_test) (benchmark::State& state) {
+  auto chunk = input.size();
+  dart::detail::json_reader reader;
+  for (auto _ : state) {
+    for (auto const& pkt : input) {
+      event_counter counter;
+      benchmark::DoNotOptimize(reader.parse<dart::parse_default>(pkt.data(), pkt.size(), counter));
+    }
+    rate_counter += chunk;
+  }
+
+  auto bytes = std::accumulate(std::begin(input), std::end(input), 0, byte_counter);
+  state.SetBytesProcessed(bytes * state.iterations());
+  state.counters["parsed packets"] = rate_counter;
+}
+
 BENCHMARK_F(benchmark_helper, rapidjson_nontrivial_insitu_json_test) (benchmark::State& state) {
   auto chunk = input.size();
   for (auto _ : state) {
@@ -453,6 +489,24 @@ BENCHMARK_F(benchmark_helper, rapidjson_nontrivial_json_test) (benchmark::State&
   state.counters["parsed packets"] = rate_counter;
 }
 
+BENCHMARK_F(benchmark_helper, rapidjson_nontrivial_json_reader_test) (benchmark::State& state) {
+  auto chunk = input.size();
+  for (auto _ : state) {
+    for (auto const& pkt : input) {
+      // Same work as the native reader benchmark, events without a DOM.
+      rj::Reader reader;
+      event_counter counter;
+      rj::MemoryStream ss(pkt.data(), pkt.size());
+      benchmark::DoNotOptimize(reader.Parse(ss, counter).IsError());
+    }
+    rate_counter += chunk;
+  }
+
+  auto bytes = std::accumulate(std::begin(input), std::end(input), 0, byte_counter);
+  state.SetBytesProcessed(bytes * state.iterations());
+  state.counters["parsed packets"] = rate_counter;
+}
+
 BENCHMARK_F(benchmark_helper, rapidjson_nontrivial_json_key_lookups) (benchmark::State& state) {
   auto chunk = input.size();
   for (auto _ : state) {
@@ -1,6 +1,7 @@
 /*----- System Includes -----*/
 
 #include <random>
+#include <thread>
 #include <cassert>
 #include <unordered_set>
 #include <benchmark/benchmark.h>
@@ -98,6 +99,21 @@ typename Container::value_type rand_pick(Container const& cont) {
   else return typename Container::value_type {};
 }
 
+// Generates enough independently allocated objects that they can't all be in cache,
+// in a random order so the hardware prefetcher can't predict them either.
+std::vector<unsafe_buffer> generate_cold_objects(size_t num_keys) {
+  constexpr auto num_objects = 1 << 14;
+  std::vector<unsafe_buffer> objects;
+  objects.reserve(num_objects);
+  for (auto i = 0; i < num_objects; ++i) {
+    auto pkt = unsafe_heap::make_object("type", rand_string(static_string_size));
+    while (pkt.size() < num_keys) pkt.add_field(rand_string(static_string_size), i);
+    objects.push_back(pkt.finalize());
+  }
+  std::shuffle(objects.begin(), objects.end(), std::mt19937 {std::random_device {}()});
+  return objects;
+}
+
 /*----- Benchmark Definitions -----*/
 
 #if DART_HAS_RAPIDJSON
@@ -180,6 +196,184 @@ BENCHMARK_DEFINE_F(benchmark_helper, lookup_finalized_random_fields) (benchmark:
 
 BENCHMARK_REGISTER_F(benchmark_helper, lookup_finalized_random_fields)->Ranges({{1, 255}, {4, 255}});
 
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_finalized_key_handles) (benchmark::State& state) {
+  // Generate some random strings, and precompile them.
+  std::vector<std::string> keys(state.range(0));
+  std::generate(keys.begin(), keys.end(), [&] { return rand_string(state.range(1)); });
+  std::vector<dart::key> handles(keys.begin(), keys.end());
+
+  // Generate a batch of packets that share a shape.
+  std::vector<unsafe_buffer> packets;
+  for (auto i = 0; i < 64; ++i) {
+    auto pkt = unsafe_heap::make_object();
+    for (auto const& key : keys) pkt.add_field(key, i);
+    packets.push_back(pkt.finalize());
+  }
+
+  // Run the test.
+  for (auto _ : state) {
+    for (auto const& data : packets) {
+      for (auto const& handle : handles) benchmark::DoNotOptimize(data[handle]);
+      rate_counter += data.size();
+    }
+  }
+  state.counters["finalized key handle lookups"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_finalized_key_handles)->Ranges({{1, 255}, {4, 255}});
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_cold_finalized_field) (benchmark::State& state) {
+  auto objects = generate_cold_objects(state.range(0));
+  auto const batch_size = static_cast<size_t>(state.range(1));
+
+  // Run the test.
+  size_t start = 0;
+  for (auto _ : state) {
+    for (auto idx = start; idx < start + batch_size; ++idx) benchmark::DoNotOptimize(objects[idx]["type"]);
+    start = (start + batch_size) % objects.size();
+    rate_counter += batch_size;
+  }
+  state.counters["cold field lookups"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_cold_finalized_field)->Ranges({{64, 1024}, {64, 256}});
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_batch_cold_finalized_field) (benchmark::State& state) {
+  auto objects = generate_cold_objects(state.range(0));
+  auto const batch_size = static_cast<size_t>(state.range(1));
+  std::vector<unsafe_buffer> out(batch_size);
+
+  // Run the test.
+  size_t start = 0;
+  for (auto _ : state) {
+    auto batch = gsl::make_span(objects).subspan(start, batch_size);
+    unsafe_buffer::lookup_batch(batch, "type", out);
+    benchmark::DoNotOptimize(out.data());
+    start = (start + batch_size) % objects.size();
+    rate_counter += batch_size;
+  }
+  state.counters["cold field lookups"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_batch_cold_finalized_field)->Ranges({{64, 1024}, {64, 256}});
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_finalized_nested_paths) (benchmark::State& state) {
+  // Generate a chain of nested objects, each with some random siblings.
+  std::vector<std::string> keys(state.range(0));
+  std::generate(keys.begin(), keys.end(), [&] { return rand_string(static_string_size); });
+  auto pkt = unsafe_heap::make_object("leaf", 1);
+  for (auto const& key : keys) {
+    auto parent = unsafe_heap::make_object(key, std::move(pkt));
+    for (auto i = 0; i < 16; ++i) parent.add_field(rand_string(static_string_size), i);
+    pkt = std::move(parent);
+  }
+
+  // Build the path from the root down.
+  std::string needle;
+  for (auto it = keys.rbegin(); it != keys.rend(); ++it) needle += *it + ".";
+  needle += "leaf";
+  dart::path compiled {needle};
+
+  // Run the test.
+  auto data = pkt.finalize();
+  if (state.range(1)) {
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(data.get_nested(compiled));
+      ++rate_counter;
+    }
+  } else {
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(data.get_nested(needle));
+      ++rate_counter;
+    }
+  }
+  state.counters["nested path lookups"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_finalized_nested_paths)
+  ->Args({2, 0})
+  ->Args({2, 1})
+  ->Args({8, 0})
+  ->Args({8, 1});
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_finalized_eytzinger_fields) (benchmark::State& state) {
+  // Generate some random strings.
+  std::vector<std::string> keys(state.range(0));
+  std::generate(keys.begin(), keys.end(), [&] { return rand_string(state.range(1)); });
+
+  // Generate a packet with an eytzinger index.
+  auto pkt = unsafe_heap::make_object();
+  for (auto const& key : keys) pkt.add_field(key, key);
+  dart::finalize_options opts;
+  opts.eytzinger_threshold = 0;
+
+  // Look the keys up in a different order than they were inserted.
+  std::shuffle(keys.begin(), keys.end(), std::mt19937 {std::random_device {}()});
+
+  // Run the test.
+  auto size = pkt.size();
+  auto data = pkt.finalize(opts);
+  for (auto _ : state) {
+    for (auto const& key : keys) benchmark::DoNotOptimize(data[key]);
+    rate_counter += size;
+  }
+  state.counters["finalized eytzinger field lookups"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_finalized_eytzinger_fields)->Ranges({{1 << 8, 1 << 14}, {8, 32}});
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_finalized_perfect_hash_fields) (benchmark::State& state) {
+  // Generate some random strings.
+  std::vector<std::string> keys(state.range(0));
+  std::generate(keys.begin(), keys.end(), [&] { return rand_string(state.range(1)); });
+
+  // Generate a packet with a perfect hash index.
+  auto pkt = unsafe_heap::make_object();
+  for (auto const& key : keys) pkt.add_field(key, key);
+  dart::finalize_options opts;
+  opts.perfect_hash_threshold = 0;
+
+  // Look the keys up in a different order than they were inserted.
+  std::shuffle(keys.begin(), keys.end(), std::mt19937 {std::random_device {}()});
+
+  // Run the test.
+  auto size = pkt.size();
+  auto data = pkt.finalize(opts);
+  for (auto _ : state) {
+    for (auto const& key : keys) benchmark::DoNotOptimize(data[key]);
+    rate_counter += size;
+  }
+  state.counters["finalized perfect hash field lookups"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_finalized_perfect_hash_fields)->Ranges({{1 << 8, 1 << 14}, {8, 32}});
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_finalized_get_many) (benchmark::State& state) {
+  // Generate some random strings.
+  std::vector<std::string> keys(state.range(0));
+  std::generate(keys.begin(), keys.end(), [&] { return rand_string(state.range(1)); });
+
+  // Generate a packet.
+  auto pkt = unsafe_heap::make_object();
+  for (auto const& key : keys) pkt.add_field(key, key);
+
+  // Look all of the keys up as a single batch.
+  std::vector<dart::shim::string_view> views(keys.begin(), keys.end());
+  std::vector<unsafe_buffer> out(views.size());
+
+  // Run the test.
+  auto size = pkt.size();
+  auto data = pkt.finalize();
+  for (auto _ : state) {
+    data.get_many(views, out);
+    benchmark::DoNotOptimize(out.data());
+    rate_counter += size;
+  }
+  state.counters["finalized batched field lookups"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_finalized_get_many)->Ranges({{1, 255}, {4, 255}});
+
 #ifdef DART_HAS_ABI
 BENCHMARK_DEFINE_F(benchmark_helper, abi_lookup_finalized_random_fields) (benchmark::State& state) {
   // Generate some random strings.
@@ -268,6 +462,35 @@ BENCHMARK_REGISTER_F(benchmark_helper, lookup_finalized_colliding_fields)
   ->Args({64, 255, 8})
   ->Args({100, 255, 8});
 
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_finalized_shared_prefix_fields) (benchmark::State& state) {
+  // Generate some random strings behind a common prefix.
+  std::vector<std::string> keys(state.range(0));
+  std::generate(keys.begin(), keys.end(), [&] { return "request_" + rand_string(state.range(1)); });
+
+  // Generate a packet, optionally with wide prefixes.
+  auto pkt = unsafe_heap::make_object();
+  for (auto const& key : keys) pkt.add_field(key, key);
+  dart::finalize_options opts;
+  if (state.range(2)) opts.wide_prefix_threshold = 0;
+
+  // Run the test.
+  auto size = pkt.size();
+  auto data = pkt.finalize(opts);
+  for (auto _ : state) {
+    for (auto const& key : keys) benchmark::DoNotOptimize(data[key]);
+    rate_counter += size;
+  }
+  state.counters["finalized shared prefix field lookups"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_finalized_shared_prefix_fields)
+  ->Args({16, 8, 0})
+  ->Args({16, 8, 1})
+  ->Args({256, 8, 0})
+  ->Args({256, 8, 1})
+  ->Args({4096, 8, 0})
+  ->Args({4096, 8, 1});
+
 #ifdef DART_HAS_FLEXBUFFERS
 BENCHMARK_DEFINE_F(benchmark_helper, flexbuffer_lookup_finalized_random_fields) (benchmark::State& state) {
   // Generate some random strings.
@@ -395,6 +618,194 @@ BENCHMARK_DEFINE_F(benchmark_helper, iterate_finalized_random_elements) (benchma
 
 BENCHMARK_REGISTER_F(benchmark_helper, iterate_finalized_random_elements)->Ranges({{1 << 0, 1 << 8}});
 
+BENCHMARK_DEFINE_F(benchmark_helper, sum_finalized_decimal_elements) (benchmark::State& state) {
+  // Generate an array of doubles that can't be narrowed to floats.
+  auto arr = unsafe_heap::make_array();
+  for (auto i = 0; i < 10000; ++i) arr.push_back(i + 0.1);
+
+  // Range 0 selects the canonical encoding, 1 the packed encoding, and 2 a direct span.
+  dart::finalize_options opts;
+  if (state.range(0)) opts.packed_array_threshold = 0;
+
+  // Run the test.
+  auto size = arr.size();
+  auto data = unsafe_heap::make_object("arr", std::move(arr)).finalize(opts)["arr"];
+  if (state.range(0) == 2) {
+    for (auto _ : state) {
+      auto sum = 0.0;
+      for (auto val : data.as_span<double>()) sum += val;
+      benchmark::DoNotOptimize(sum);
+      rate_counter += size;
+    }
+  } else {
+    for (auto _ : state) {
+      auto sum = 0.0;
+      for (auto i = 0U; i < size; ++i) sum += data[i].decimal();
+      benchmark::DoNotOptimize(sum);
+      rate_counter += size;
+    }
+  }
+  state.counters["finalized decimal element sums"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, sum_finalized_decimal_elements)->DenseRange(0, 2);
+
+BENCHMARK_DEFINE_F(benchmark_helper, sum_finalized_record_fields) (benchmark::State& state) {
+  // Generate an array of identically shaped records.
+  auto arr = unsafe_heap::make_array();
+  for (auto i = 0; i < 10000; ++i) {
+    arr.push_back(unsafe_heap::make_object("id", i, "price", i + 0.1, "name", "item" + std::to_string(i)));
+  }
+
+  // Range 0 selects the canonical encoding, 1 the record batch encoding, and 2 a direct column span.
+  dart::finalize_options opts;
+  if (state.range(0)) opts.record_batch_threshold = 0;
+
+  // Run the test.
+  auto size = arr.size();
+  auto data = unsafe_heap::make_object("arr", std::move(arr)).finalize(opts)["arr"];
+  if (state.range(0) == 2) {
+    for (auto _ : state) {
+      auto sum = 0.0;
+      for (auto val : data.column_span<double>("price")) sum += val;
+      benchmark::DoNotOptimize(sum);
+      rate_counter += size;
+    }
+  } else {
+    for (auto _ : state) {
+      auto sum = 0.0;
+      for (auto i = 0U; i < size; ++i) sum += data[i]["price"].decimal();
+      benchmark::DoNotOptimize(sum);
+      rate_counter += size;
+    }
+  }
+  state.counters["finalized record field sums"] = rate_counter;
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, sum_finalized_record_fields)->DenseRange(0, 2);
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_dictionary_fields) (benchmark::State& state) {
+  // Generate a collection of differently shaped packets that reuse the same keys.
+  std::vector<std::string> keys;
+  for (auto i = 0; i < 32; ++i) keys.push_back("telemetry_field_" + std::to_string(i));
+  auto packets = unsafe_heap::make_object();
+  for (auto i = 0; i < 1000; ++i) {
+    auto pkt = unsafe_heap::make_object();
+    for (auto j = 0U; j < keys.size(); ++j) {
+      if ((i + j) % 3) pkt.add_field(keys[j], static_cast<int64_t>(i + j));
+    }
+    packets.add_field("packet_" + std::to_string(i), std::move(pkt));
+  }
+
+  // Range 0 selects the canonical encoding, 1 the key dictionary.
+  dart::finalize_options opts;
+  if (state.range(0)) opts.key_dictionary_threshold = 2;
+
+  // Run the test.
+  auto data = packets.finalize(opts);
+  for (auto _ : state) {
+    for (auto pkt : data) {
+      for (auto const& key : keys) benchmark::DoNotOptimize(pkt[key]);
+      rate_counter += keys.size();
+    }
+  }
+  state.counters["finalized key lookups"] = rate_counter;
+  state.counters["buffer bytes"] = data.get_bytes().size();
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_dictionary_fields)->DenseRange(0, 1);
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_small_aggregate_fields) (benchmark::State& state) {
+  // Generate a collection of tiny packets, each with a tiny nested array.
+  std::vector<std::string> keys {"ts", "host", "value", "unit"};
+  auto packets = unsafe_heap::make_object();
+  for (auto i = 0; i < 1000; ++i) {
+    auto pkt = unsafe_heap::make_object("ts", i, "host", "host" + std::to_string(i % 8), "value", i * 0.5, "unit", "ms");
+    pkt.add_field("tags", unsafe_heap::make_array("region", i % 4));
+    packets.add_field("packet_" + std::to_string(i), std::move(pkt));
+  }
+
+  // Range 0 selects the canonical encoding, 1 small aggregates.
+  dart::finalize_options opts;
+  if (state.range(0)) opts.small_aggregate_threshold = 1024;
+
+  // Run the test.
+  auto data = packets.finalize(opts);
+  for (auto _ : state) {
+    for (auto pkt : data) {
+      for (auto const& key : keys) benchmark::DoNotOptimize(pkt[key]);
+      benchmark::DoNotOptimize(pkt["tags"][1]);
+      rate_counter += keys.size() + 1;
+    }
+  }
+  state.counters["finalized small aggregate lookups"] = rate_counter;
+  state.counters["buffer bytes"] = data.get_bytes().size();
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_small_aggregate_fields)->DenseRange(0, 1);
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_inline_fields) (benchmark::State& state) {
+  // Generate a collection of packets made up of small scalars.
+  std::vector<std::string> keys {"ts", "host", "ok", "code", "unit"};
+  auto packets = unsafe_heap::make_object();
+  for (auto i = 0; i < 1000; ++i) {
+    auto pkt = unsafe_heap::make_object("ts", i, "host", "h" + std::to_string(i % 8), "ok", i % 2 == 0);
+    pkt.add_field("code", i % 500);
+    pkt.add_field("unit", "ms");
+    pkt.add_field("vals", unsafe_heap::make_array(i, true, "a"));
+    packets.add_field("packet_" + std::to_string(i), std::move(pkt));
+  }
+
+  // Range 0 selects the canonical encoding, 1 inline scalars.
+  dart::finalize_options opts;
+  if (state.range(0)) opts.inline_scalars = true;
+
+  // Run the test.
+  auto data = packets.finalize(opts);
+  for (auto _ : state) {
+    for (auto pkt : data) {
+      for (auto const& key : keys) benchmark::DoNotOptimize(pkt[key]);
+      benchmark::DoNotOptimize(pkt["vals"][1]);
+      rate_counter += keys.size() + 1;
+    }
+  }
+  state.counters["finalized inline lookups"] = rate_counter;
+  state.counters["buffer bytes"] = data.get_bytes().size();
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_inline_fields)->DenseRange(0, 1);
+
+BENCHMARK_DEFINE_F(benchmark_helper, lookup_compressed_fields) (benchmark::State& state) {
+  // Generate a packet made up mostly of cold string data.
+  auto packets = unsafe_heap::make_object();
+  for (auto i = 0; i < 1000; ++i) {
+    auto pkt = unsafe_heap::make_object("ts", i, "host", "h" + std::to_string(i % 8));
+    pkt.add_field("message", "request completed without incident after " + std::to_string(i) + " retries");
+    packets.add_field("packet_" + std::to_string(i), std::move(pkt));
+  }
+
+  // Range 0 looks up a field in every block from cold, range 1 from a warm cache.
+  auto data = packets.finalize();
+  dart::unsafe_compressed_buffer comp {data, static_cast<size_t>(state.range(1))};
+  for (auto _ : state) {
+    if (!state.range(0)) comp.evict();
+    for (auto i = 0; i < 1000; i += 50) {
+      benchmark::DoNotOptimize(comp["packet_" + std::to_string(i)]["ts"]);
+      ++rate_counter;
+    }
+  }
+  state.counters["compressed lookups"] = rate_counter;
+  state.counters["buffer bytes"] = data.get_bytes().size();
+  state.counters["compressed bytes"] = comp.get_bytes().size();
+  state.counters["resident bytes"] = comp.resident_bytes();
+}
+
+BENCHMARK_REGISTER_F(benchmark_helper, lookup_compressed_fields)
+  ->Args({0, 1 << 12})
+  ->Args({1, 1 << 12})
+  ->Args({0, 1 << 16})
+  ->Args({1, 1 << 16});
+
 BENCHMARK_DEFINE_F(benchmark_helper, iterate_dynamic_random_fields) (benchmark::State& state) {
   // Generate some random strings.
   std::vector<std::string> keys(state.range(0));
@@ -655,6 +1066,49 @@ BENCHMARK_F(benchmark_helper, finalize_dynamic_packet) (benchmark::State& state)
   state.counters["finalized packets"] = rate_counter;
 }
 
+BENCHMARK_F(benchmark_helper, finalize_modified_dynamic_packet) (benchmark::State& state) {
+  // Modifying the packet throws away the size it remembered from the last finalization.
+  int64_t counter = 0;
+  unsafe_heap flatter {flat};
+  for (auto _ : state) {
+    flatter.add_field("counter", counter++);
+    auto buf = flatter.finalize().get_bytes();
+    benchmark::DoNotOptimize(buf.data());
+    ++rate_counter;
+  }
+  state.counters["finalized packets"] = rate_counter;
+}
+
+BENCHMARK_F(benchmark_helper, refinalize_modified_nested_packet) (benchmark::State& state) {
+  // Untouched subtrees are copied straight out of the buffer they were definalized from.
+  int64_t counter = 0;
+  for (auto _ : state) {
+    auto dyn = unsafe_heap {unsafe_packet {nested_fin}.definalize()};
+    dyn.add_field("counter", counter++);
+    auto buf = dyn.finalize().get_bytes();
+    benchmark::DoNotOptimize(buf.data());
+    ++rate_counter;
+  }
+  state.counters["finalized packets"] = rate_counter;
+}
+
+BENCHMARK_DEFINE_F(benchmark_helper, finalize_large_dynamic_packet_in_parallel) (benchmark::State& state) {
+  // Roughly 10MB once finalized, spread across tens of thousands of subtrees.
+  auto records = unsafe_heap::make_array();
+  for (auto i = 0; i < 1 << 14; ++i) records.push_back(unsafe_heap {flat});
+  auto big = unsafe_heap::make_object("records", std::move(records));
+
+  dart::parallel_policy policy {static_cast<size_t>(state.range(0))};
+  for (auto _ : state) {
+    auto buf = big.finalize(policy).get_bytes();
+    benchmark::DoNotOptimize(buf.data());
+    ++rate_counter;
+  }
+  state.counters["finalized packets"] = rate_counter;
+}
+BENCHMARK_REGISTER_F(benchmark_helper, finalize_large_dynamic_packet_in_parallel)
+  ->DenseRange(1, std::max(std::thread::hardware_concurrency(), 1U))->UseRealTime();
+
 BENCHMARK_F(benchmark_helper, serialize_finalized_packet_into_json) (benchmark::State& state) {
   for (auto _ : state) {
     benchmark::DoNotOptimize(flat_fin.to_json().data());
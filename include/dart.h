@@ -39,6 +39,8 @@ static_assert(false, "libdart requires a c++14 enabled compiler.");
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <cstdio>
 #include <cstddef>
 #include <sstream>
 #include <cstring>
@@ -74,6 +76,12 @@ namespace dart {
   static constexpr auto write_default = rapidjson::kWriteDefaultFlags;
   static constexpr auto write_nan = rapidjson::kWriteNanAndInfFlag;
   static constexpr auto write_permissive = write_nan;
+#elif defined(DART_USE_NATIVE_JSON)
+  static constexpr auto parse_default = 0U;
+  static constexpr auto parse_comments = detail::json_reader::parse_comments;
+  static constexpr auto parse_nan = detail::json_reader::parse_nan;
+  static constexpr auto parse_trailing_commas = detail::json_reader::parse_trailing_commas;
+  static constexpr auto parse_permissive = parse_comments | parse_nan | parse_trailing_commas;
 #endif
 
   template <template <class> class RefCount>
@@ -1183,6 +1191,12 @@ namespace dart {
        */
       auto get_nested(shim::string_view path, char separator = '.') const -> value_type;
 
+      /**
+       *  @brief
+       *  Function returns the value associated with the precompiled path.
+       */
+      auto get_nested(path const& needle) const -> value_type;
+
       /**
        *  @brief
        *  Object access method, precisely equivalent to the corresponding subscript operator.
@@ -6865,6 +6879,64 @@ namespace dart {
       >
       basic_buffer<RefCount> finalize() const;
 
+      /**
+       *  @brief
+       *  Function transitions to a finalized state by returning a dart::buffer instance that
+       *  describes the same object tree, using any optional encodings enabled by the given options.
+       *
+       *  @details
+       *  Optional encodings trade some buffer size for faster access, and are chosen per
+       *  object as the buffer is laid out.
+       *  See dart::finalize_options for the available encodings.
+       *
+       *  Resulting buffers can be used anywhere a normal dart::buffer can be, and compare
+       *  equal to a buffer with the same contents finalized without options.
+       */
+      template <bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      basic_buffer<RefCount> finalize(finalize_options const& opts) const;
+
+      /**
+       *  @brief
+       *  Function transitions to a finalized state by returning a dart::buffer instance that
+       *  describes the same object tree, laying out large subtrees on several threads at once.
+       *
+       *  @details
+       *  Resulting buffer is byte for byte identical to one finalized on a single thread
+       *  with the same options.
+       *  See dart::parallel_policy for which heaps, and which options, benefit.
+       */
+      template <bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      basic_buffer<RefCount> finalize(parallel_policy const& policy, finalize_options const& opts = {}) const;
+
+      /**
+       *  @brief
+       *  Function finalizes the heap directly into memory owned by the caller, returning
+       *  the number of bytes used.
+       *
+       *  @details
+       *  Lays out exactly the same bytes as dart::heap::finalize would, but into the given
+       *  memory, which must be aligned to a 64-bit word boundary.
+       *  If the heap doesn't fit, throws dart::size_error, which carries the number of
+       *  bytes it would have needed; that can be somewhat more than the number of bytes
+       *  actually used when optional encodings are enabled.
+       *  The result can be wrapped in a dart::buffer, without copying, via the adopting
+       *  dart::buffer constructor.
+       */
+      template <bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      size_type finalize_into(gsl::span<gsl::byte> dest, finalize_options const& opts = {}) const;
+
       /**
        *  @brief
        *  Function transitions to a finalized state by returning a dart::buffer instance that
@@ -6959,7 +7031,7 @@ namespace dart {
         >
       >
       static basic_heap parse(shim::string_view json);
-#elif DART_HAS_RAPIDJSON
+#elif DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
       /**
        *  @brief
        *  Function constructs an optionally finalized packet to represent the given JSON string.
@@ -6967,6 +7039,8 @@ namespace dart {
        *  @details
        *  Parsing is based on RapidJSON, and so exposes the same parsing customization points as
        *  RapidJSON.
+       *  Defining DART_USE_NATIVE_JSON swaps in dart's own SIMD accelerated reader, which supports
+       *  everything below except comments.
        *  If your JSON has embedded comments in it, NaN or +/-Infinity values, or trailing commas,
        *  you can parse in the following ways:
        *  ```
@@ -6992,6 +7066,8 @@ namespace dart {
        *  @details
        *  Parsing is based on RapidJSON, and so exposes the same parsing customization points as
        *  RapidJSON.
+       *  Defining DART_USE_NATIVE_JSON swaps in dart's own SIMD accelerated reader, which supports
+       *  everything below except comments.
        *  If your JSON has embedded comments in it, NaN or +/-Infinity values, or trailing commas,
        *  you can parse in the following ways:
        *  ```
@@ -7246,6 +7322,17 @@ namespace dart {
        */
       basic_heap get_nested(shim::string_view path, char separator = '.') const;
 
+      /**
+       *  @brief
+       *  Function returns the value associated with the precompiled path.
+       *
+       *  @details
+       *  Segments are resolved as keys in objects, and as indices in arrays
+       *  (if they're numeric), and the path resolves to null if it runs into
+       *  anything else, or into a mapping that doesn't exist.
+       */
+      basic_heap get_nested(path const& needle) const;
+
       /**
        *  @brief
        *  Array access method, precisely equivalent to the corresponding subscript operator.
@@ -7982,9 +8069,18 @@ namespace dart {
       basic_heap project_keys(Spannable const& keys) const;
 
       void copy_on_write(size_type overcount = 1);
-      auto upper_bound() const -> size_type;
-      auto layout(gsl::byte* buffer) const noexcept -> size_type;
+      auto upper_bound(finalize_options const& opts = {}) const -> size_type;
+      auto small_upper_bound(finalize_options const& opts, size_type limit) const -> size_type;
+      auto exact_bound(finalize_options const& opts = {}) const -> size_type;
+      template <class Callback>
+      auto exact_offsets(finalize_options const& opts, Callback&& cb) const -> size_type;
+      gsl::span<gsl::byte const> finalized_source() const noexcept;
+      auto layout(gsl::byte* buffer, finalize_options const& opts = {}) const noexcept -> size_type;
+      auto layout(gsl::byte* buffer, finalize_options const& opts, detail::raw_type type) const noexcept -> size_type;
       detail::raw_type get_raw_type() const noexcept;
+      detail::raw_type get_raw_type(finalize_options const& opts) const;
+      detail::raw_type large_raw_type(finalize_options const& opts) const;
+      bool fits_inline(size_t bytes) const;
 
       template <class Deref>
       auto erase_key_impl(shim::string_view key, Deref&& deref, fields_type safeguard) -> iterator;
@@ -8006,13 +8102,17 @@ namespace dart {
       type_data data;
 
       static constexpr auto sso_bytes = sizeof(detail::inline_string_layout::buffer);
-      static constexpr auto max_aggregate_size = detail::object_layout::max_offset;
 
       /*----- Friends -----*/
 
       friend size_t detail::sso_bytes<RefCount>();
       friend class detail::object<RefCount>;
       friend class detail::array<RefCount>;
+      friend class detail::small_object<RefCount>;
+      friend class detail::small_array<RefCount>;
+      friend class detail::large_object<RefCount>;
+      friend class detail::large_array<RefCount>;
+      friend class detail::perfect_hash_scratch;
 
       template <class PacketType>
       friend struct convert::detail::typed_compare;
@@ -8238,9 +8338,10 @@ namespace dart {
         >
       >
       explicit basic_buffer(gsl::span<gsl::byte const> buffer) :
-        raw({detail::raw_type::object, buffer.data()}),
         buffer_ref(allocate_pointer(buffer))
-      {}
+      {
+        raw = {detail::identify_root(buffer_ref.get(), buffer.size()), buffer_ref.get()};
+      }
 
       /**
        *  @brief
@@ -8255,7 +8356,7 @@ namespace dart {
         >
       >
       explicit basic_buffer(RefCount<gsl::byte const> buffer) :
-        raw({detail::raw_type::object, buffer.get()}),
+        raw({detail::identify_root(buffer.get()), buffer.get()}),
         buffer_ref(validate_pointer(shareable_ptr<RefCount<gsl::byte const>> {std::move(buffer)}))
       {}
 
@@ -8272,7 +8373,7 @@ namespace dart {
         >
       >
       explicit basic_buffer(shareable_ptr<RefCount<gsl::byte const>> buffer) :
-        raw({detail::raw_type::object, buffer.get()}),
+        raw({detail::identify_root(buffer.get()), buffer.get()}),
         buffer_ref(validate_pointer(std::move(buffer)))
       {}
 
@@ -8293,7 +8394,7 @@ namespace dart {
         >
       >
       explicit basic_buffer(std::unique_ptr<gsl::byte const[], Del>&& buffer) :
-        raw({detail::raw_type::object, buffer.get()}),
+        raw({detail::identify_root(buffer.get()), buffer.get()}),
         buffer_ref(normalize(validate_pointer(std::move(buffer))))
       {}
 
@@ -8314,7 +8415,7 @@ namespace dart {
         >
       >
       explicit basic_buffer(std::unique_ptr<gsl::byte const, Del>&& buffer) :
-        raw({detail::raw_type::object, buffer.get()}),
+        raw({detail::identify_root(buffer.get()), buffer.get()}),
         buffer_ref(normalize(validate_pointer(std::move(buffer))))
       {}
 
@@ -8335,10 +8436,34 @@ namespace dart {
         >
       >
       explicit basic_buffer(std::unique_ptr<gsl::byte, Del>&& buffer) :
-        raw({detail::raw_type::object, buffer.get()}),
+        raw({detail::identify_root(buffer.get()), buffer.get()}),
         buffer_ref(normalize(validate_pointer(std::move(buffer))))
       {}
 
+      /**
+       *  @brief
+       *  Adopting network object constructor.
+       *
+       *  @details
+       *  Reconstitutes a previously finalized packet from memory owned by somebody else,
+       *  without copying it, and calls release with its address once the last reference
+       *  to it goes away.
+       *  Memory must be aligned to a 64-bit word boundary, and must outlive the packet.
+       *
+       *  @remarks
+       *  Release is never called if the given memory is rejected, but, like any other
+       *  deleter, is called if the reference count itself can't be allocated.
+       */
+      template <class Release, bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      basic_buffer(gsl::span<gsl::byte const> buffer, Release&& release) :
+        raw({detail::identify_root(buffer.data(), buffer.size()), buffer.data()}),
+        buffer_ref(adopt_pointer(buffer, std::forward<Release>(release)))
+      {}
+
       /**
        *  @brief
        *  Copy constructor.
@@ -8534,6 +8659,33 @@ namespace dart {
       >
       basic_buffer&& operator [](shim::string_view key) &&;
 
+      /**
+       *  @brief
+       *  Object subscript operator.
+       *
+       *  @details
+       *  Assuming this is an object, returns the value associated with the given
+       *  precompiled key, or a null packet if not such mapping exists.
+       *  The key remembers where it was last found, and checks there first.
+       */
+      basic_buffer operator [](key const& handle) const&;
+
+      /**
+       *  @brief
+       *  Object subscript operator.
+       *
+       *  @details
+       *  Assuming this is an object, returns the value associated with the given
+       *  precompiled key, or a null packet if not such mapping exists.
+       *  The key remembers where it was last found, and checks there first.
+       */
+      template <bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      basic_buffer&& operator [](key const& handle) &&;
+
       /**
        *  @brief
        *  Combined object/array subscript operator.
@@ -9265,7 +9417,26 @@ namespace dart {
         >
       >
       static basic_buffer parse(shim::string_view json);
-#elif DART_HAS_RAPIDJSON
+
+      /**
+       *  @brief
+       *  Function parses the given JSON string directly into memory owned by the caller,
+       *  returning the number of bytes used.
+       *
+       *  @details
+       *  Lays out exactly the same bytes as dart::buffer::from_json would, but into the given
+       *  memory, which must be aligned to a 64-bit word boundary.
+       *  If the result doesn't fit, throws dart::size_error, which carries the number of
+       *  bytes it would have needed.
+       */
+      template <unsigned parse_stack_size = default_parse_stack_size,
+               bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      static size_type from_json_into(shim::string_view json, gsl::span<gsl::byte> dest);
+#elif DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
       /**
        *  @brief
        *  Function constructs an optionally finalized packet to represent the given JSON string.
@@ -9273,6 +9444,8 @@ namespace dart {
        *  @details
        *  Parsing is based on RapidJSON, and so exposes the same parsing customization points as
        *  RapidJSON.
+       *  Defining DART_USE_NATIVE_JSON swaps in dart's own SIMD accelerated reader, which supports
+       *  everything below except comments.
        *  If your JSON has embedded comments in it, NaN or +/-Infinity values, or trailing commas,
        *  you can parse in the following ways:
        *  ```
@@ -9298,6 +9471,8 @@ namespace dart {
        *  @details
        *  Parsing is based on RapidJSON, and so exposes the same parsing customization points as
        *  RapidJSON.
+       *  Defining DART_USE_NATIVE_JSON swaps in dart's own SIMD accelerated reader, which supports
+       *  everything below except comments.
        *  If your JSON has embedded comments in it, NaN or +/-Infinity values, or trailing commas,
        *  you can parse in the following ways:
        *  ```
@@ -9315,6 +9490,25 @@ namespace dart {
         >
       >
       static basic_buffer parse(shim::string_view json);
+
+      /**
+       *  @brief
+       *  Function parses the given JSON string directly into memory owned by the caller,
+       *  returning the number of bytes used.
+       *
+       *  @details
+       *  Lays out exactly the same bytes as dart::buffer::from_json would, but into the given
+       *  memory, which must be aligned to a 64-bit word boundary.
+       *  If the result doesn't fit, throws dart::size_error, which carries the number of
+       *  bytes it would have needed.
+       */
+      template <unsigned flags = parse_default,
+               bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      static size_type from_json_into(shim::string_view json, gsl::span<gsl::byte> dest);
 #endif
 
 #if DART_HAS_RAPIDJSON
@@ -9492,6 +9686,83 @@ namespace dart {
       >
       basic_buffer&& get(shim::string_view key) &&;
 
+      /**
+       *  @brief
+       *  Object access method, precisely equivalent to the corresponding subscript operator.
+       *
+       *  @details
+       *  Assuming this is an object, function will return the value associated with the
+       *  given precompiled key as a new packet.
+       */
+      basic_buffer get(key const& handle) const&;
+
+      /**
+       *  @brief
+       *  Object access method, precisely equivalent to the corresponding subscript operator.
+       *
+       *  @details
+       *  Assuming this is an object, function will return the value associated with the
+       *  given precompiled key as a new packet.
+       */
+      template <bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      basic_buffer&& get(key const& handle) &&;
+
+      /**
+       *  @brief
+       *  Object access method, looks up many keys in a single pass.
+       *
+       *  @details
+       *  Assuming this is an object, function writes the value associated with each
+       *  key into the corresponding position of out, or a null packet if no such
+       *  mapping exists.
+       *  Keys are resolved in a single forward pass over the object, in the order
+       *  in which the object stores them (shorter keys first, then lexicographically).
+       *  Keys that are already in that order are used as is, otherwise they're sorted
+       *  internally first.
+       *
+       *  @remarks
+       *  Throws std::invalid_argument if out is not the same size as keys.
+       */
+      void get_many(gsl::span<shim::string_view const> keys, gsl::span<basic_buffer> out) const;
+
+      /**
+       *  @brief
+       *  Object access method, looks up many keys in a single pass.
+       *
+       *  @details
+       *  Behaves identically to the previous overload, but writes non-owning views
+       *  into out, skipping a reference count increment per key.
+       *  The views are valid for as long as the current buffer is.
+       */
+      template <bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      void get_many(gsl::span<shim::string_view const> keys, gsl::span<view> out) const;
+
+      /**
+       *  @brief
+       *  Object access method, looks up the same key across a batch of objects.
+       *
+       *  @details
+       *  Behaves as if out[i] were assigned pkts[i][key] for every i, but the
+       *  searches of the whole batch are stepped in lockstep, and the next probe of
+       *  every search is prefetched before any of them is compared.
+       *  For batches of objects that aren't in cache, this lets the cache misses of
+       *  different objects overlap, rather than stalling on each of them in turn.
+       *
+       *  @remarks
+       *  Throws std::invalid_argument if out is not the same size as pkts,
+       *  and dart::type_error if any of pkts is not an object.
+       */
+      static void lookup_batch(gsl::span<basic_buffer const> pkts,
+          shim::string_view key, gsl::span<basic_buffer> out);
+
       /**
        *  @brief
        *  Combined array/object access method, precisely equivalent to the corresponding
@@ -9541,6 +9812,19 @@ namespace dart {
        */
       basic_buffer get_nested(shim::string_view path, char separator = '.') const;
 
+      /**
+       *  @brief
+       *  Function returns the value associated with the precompiled path.
+       *
+       *  @details
+       *  Segments are resolved as keys in objects, and as indices in arrays
+       *  (if they're numeric), and the path resolves to null if it runs into
+       *  anything else, or into a mapping that doesn't exist.
+       *  The walk operates on the underlying network buffer directly, so the
+       *  only reference count taken is the one held by the result.
+       */
+      basic_buffer get_nested(path const& needle) const;
+
       /**
        *  @brief
        *  Array access method, precisely equivalent to the corresponding subscript operator.
@@ -9934,6 +10218,16 @@ namespace dart {
        */
       bool has_key(shim::string_view key) const;
 
+      /**
+       *  @brief
+       *  Returns whether a particular key-value pair exists within an object.
+       *
+       *  @details
+       *  If this is an object, function returns whether the given precompiled key is present
+       *  Throws otherwise.
+       */
+      bool has_key(key const& handle) const;
+
       /**
        *  @brief
        *  Returns whether a particular key-value pair exists within an object.
@@ -10205,6 +10499,44 @@ namespace dart {
        */
       gsl::span<gsl::byte const> get_bytes() const;
 
+      /**
+       *  @brief
+       *  Function returns the elements of a packed numeric array as a contiguous span.
+       *
+       *  @details
+       *  Arrays finalized with finalize_options::packed_array_threshold store homogeneous
+       *  numeric contents as a single run of values, which this function exposes without
+       *  copying, for numeric processing.
+       *  T must precisely match the stored representation, which is the narrowest of
+       *  int16_t, int32_t, int64_t, float, double, or bool that can represent every element.
+       *  The lifetime of the returned span is equal to the lifetime of the current packet.
+       *
+       *  @remarks
+       *  Throws dart::type_error if this is not a packed array of T, or if the host isn't
+       *  little endian, in which case the stored values can't be exposed as is.
+       */
+      template <class T>
+      gsl::span<T const> as_span() const;
+
+      /**
+       *  @brief
+       *  Function returns a single column of a record batch as a contiguous span.
+       *
+       *  @details
+       *  Arrays finalized with finalize_options::record_batch_threshold store the values
+       *  of each key of their objects together, and pack columns of primitives exactly like
+       *  packed arrays, which this function exposes without copying, such that scanning a
+       *  single field across every object touches nothing else.
+       *  T must precisely match the stored representation, as for as_span.
+       *  The lifetime of the returned span is equal to the lifetime of the current packet.
+       *
+       *  @remarks
+       *  Throws dart::type_error if this is not a record batch with a packed column of T
+       *  for the given key, or if the host isn't little endian.
+       */
+      template <class T>
+      gsl::span<T const> column_span(shim::string_view key) const;
+
       /**
        *  @brief
        *  Function allows the network buffer of the current packet to be exported
@@ -10460,6 +10792,8 @@ namespace dart {
       basic_buffer(detail::raw_element raw, buffer_ref_type ref);
 
       auto allocate_pointer(gsl::span<gsl::byte const> buffer) const -> buffer_ref_type;
+      template <class Release>
+      auto adopt_pointer(gsl::span<gsl::byte const> buffer, Release&& release) const -> buffer_ref_type;
       template <class Pointer>
       Pointer&& validate_pointer(Pointer&& ptr) const;
       template <class Pointer>
@@ -10484,6 +10818,8 @@ namespace dart {
       template <class From, class To>
       friend struct convert::detail::api_converter;
       friend struct detail::buffer_builder<RefCount>;
+      friend class basic_compressed_buffer<RefCount>;
+      friend struct std::hash<basic_buffer>;
 
   };
 
@@ -10828,6 +11164,24 @@ namespace dart {
         impl(basic_buffer<RefCount>(std::move(buffer)))
       {}
 
+      /**
+       *  @brief
+       *  Adopting network object constructor.
+       *
+       *  @details
+       *  Reconstitutes a previously finalized packet from memory owned by somebody else,
+       *  without copying it.
+       *  See the matching dart::buffer constructor for details.
+       */
+      template <class Release, bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      basic_packet(gsl::span<gsl::byte const> buffer, Release&& release) :
+        impl(basic_buffer<RefCount>(buffer, std::forward<Release>(release)))
+      {}
+
       /**
        *  @brief
        *  Copy constructor.
@@ -12301,6 +12655,44 @@ namespace dart {
       >
       basic_packet&& finalize() &&;
 
+      /**
+       *  @brief
+       *  Function transitions the current packet from being non-finalized to finalized in place,
+       *  using any optional encodings enabled by the given options.
+       *
+       *  @details
+       *  Optional encodings trade some buffer size for faster access, and are chosen per
+       *  object as the buffer is laid out.
+       *  See dart::finalize_options for the available encodings.
+       *
+       *  Has no effect if the packet is already finalized.
+       */
+      template <bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      basic_packet& finalize(finalize_options const& opts) &;
+
+      /**
+       *  @brief
+       *  Function transitions the current packet from being non-finalized to finalized in place,
+       *  using any optional encodings enabled by the given options.
+       *
+       *  @details
+       *  Optional encodings trade some buffer size for faster access, and are chosen per
+       *  object as the buffer is laid out.
+       *  See dart::finalize_options for the available encodings.
+       *
+       *  Has no effect if the packet is already finalized.
+       */
+      template <bool enabled = refcount::is_owner<RefCount>::value, class EnableIf =
+        std::enable_if_t<
+          enabled
+        >
+      >
+      basic_packet&& finalize(finalize_options const& opts) &&;
+
       /**
        *  @brief
        *  Function transitions the current packet from being non-finalized to finalized in place.
@@ -12421,7 +12813,7 @@ namespace dart {
         >
       >
       static basic_packet parse(shim::string_view json, bool finalized = true);
-#elif DART_HAS_RAPIDJSON
+#elif DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
       /**
        *  @brief
        *  Function constructs an optionally finalized packet to represent the given JSON string.
@@ -12429,6 +12821,8 @@ namespace dart {
        *  @details
        *  Parsing is based on RapidJSON, and so exposes the same parsing customization points as
        *  RapidJSON.
+       *  Defining DART_USE_NATIVE_JSON swaps in dart's own SIMD accelerated reader, which supports
+       *  everything below except comments.
        *  If your JSON has embedded comments in it, NaN or +/-Infinity values, or trailing commas,
        *  you can parse in the following ways:
        *  ```
@@ -12454,6 +12848,8 @@ namespace dart {
        *  @details
        *  Parsing is based on RapidJSON, and so exposes the same parsing customization points as
        *  RapidJSON.
+       *  Defining DART_USE_NATIVE_JSON swaps in dart's own SIMD accelerated reader, which supports
+       *  everything below except comments.
        *  If your JSON has embedded comments in it, NaN or +/-Infinity values, or trailing commas,
        *  you can parse in the following ways:
        *  ```
@@ -12836,6 +13232,17 @@ namespace dart {
        */
       basic_packet get_nested(shim::string_view path, char separator = '.') const;
 
+      /**
+       *  @brief
+       *  Function returns the value associated with the precompiled path.
+       *
+       *  @details
+       *  Segments are resolved as keys in objects, and as indices in arrays
+       *  (if they're numeric), and the path resolves to null if it runs into
+       *  anything else, or into a mapping that doesn't exist.
+       */
+      basic_packet get_nested(path const& needle) const;
+
       /**
        *  @brief
        *  Array access method, precisely equivalent to the corresponding subscript operator.
@@ -13546,6 +13953,44 @@ namespace dart {
        */
       gsl::span<gsl::byte const> get_bytes() const;
 
+      /**
+       *  @brief
+       *  Function returns the elements of a packed numeric array as a contiguous span.
+       *
+       *  @details
+       *  Arrays finalized with finalize_options::packed_array_threshold store homogeneous
+       *  numeric contents as a single run of values, which this function exposes without
+       *  copying, for numeric processing.
+       *  T must precisely match the stored representation, which is the narrowest of
+       *  int16_t, int32_t, int64_t, float, double, or bool that can represent every element.
+       *  The lifetime of the returned span is equal to the lifetime of the current packet.
+       *
+       *  @remarks
+       *  Throws dart::type_error if this is not a packed array of T, or if the host isn't
+       *  little endian, in which case the stored values can't be exposed as is.
+       */
+      template <class T>
+      gsl::span<T const> as_span() const;
+
+      /**
+       *  @brief
+       *  Function returns a single column of a record batch as a contiguous span.
+       *
+       *  @details
+       *  Arrays finalized with finalize_options::record_batch_threshold store the values
+       *  of each key of their objects together, and pack columns of primitives exactly like
+       *  packed arrays, which this function exposes without copying, such that scanning a
+       *  single field across every object touches nothing else.
+       *  T must precisely match the stored representation, as for as_span.
+       *  The lifetime of the returned span is equal to the lifetime of the current packet.
+       *
+       *  @remarks
+       *  Throws dart::type_error if this is not a record batch with a packed column of T
+       *  for the given key, or if the host isn't little endian.
+       */
+      template <class T>
+      gsl::span<T const> column_span(shim::string_view key) const;
+
       /**
        *  @brief
        *  Function allows the network buffer of the current packet to be exported
@@ -13800,9 +14245,12 @@ namespace dart {
 
       /*----- Private Helpers -----*/
 
-      size_t upper_bound() const noexcept;
-      auto layout(gsl::byte* buffer) const noexcept -> size_type;
+      size_t upper_bound(finalize_options const& opts = {}) const noexcept;
+      auto layout(gsl::byte* buffer, finalize_options const& opts = {}) const noexcept -> size_type;
+      auto layout(gsl::byte* buffer, finalize_options const& opts, detail::raw_type type) const noexcept -> size_type;
       detail::raw_type get_raw_type() const noexcept;
+      detail::raw_type get_raw_type(finalize_options const& opts) const;
+      bool fits_inline(size_t bytes) const;
 
       basic_heap<RefCount>& get_heap();
       basic_heap<RefCount> const& get_heap() const;
@@ -13828,16 +14276,180 @@ namespace dart {
       template <class From, class To>
       friend struct convert::detail::api_converter;
       friend struct detail::buffer_builder<RefCount>;
+      friend struct std::hash<basic_packet>;
+
+  };
+
+  /**
+   *  @brief
+   *  dart::compressed_buffer is an immutable, block compressed container around a
+   *  finalized dart::buffer, meant for packets that spend most of their time sitting
+   *  in a cache or on disk.
+   *
+   *  @details
+   *  The header, vtable, and extension area of the root object, along with its keys,
+   *  are kept uncompressed, while the fields themselves are grouped into blocks of
+   *  roughly the requested size, each of which is compressed independently with a small
+   *  LZ77 codec.
+   *  Looking up a field decompresses only the block holding it, on first access, into
+   *  a cache shared by every copy of the container, and hands out a dart::buffer that
+   *  refers directly into that block.
+   *  Buffers that refer to a key dictionary can only be decompressed as a whole, and
+   *  are served from a single cached copy of the original buffer instead.
+   *
+   *  @remarks
+   *  The bytes returned by get_bytes are self-contained, and can be written out and
+   *  handed back to the constructor later.
+   *  Like dart::buffer, a compressed_buffer can be shared freely between threads.
+   */
+  template <template <class> class RefCount>
+  class basic_compressed_buffer final {
+
+    static_assert(refcount::is_owner<RefCount>::value, "dart::compressed_buffer must own its bytes");
+
+    public:
+
+      /*----- Public Types -----*/
+
+      using size_type = size_t;
+      using buffer = basic_buffer<RefCount>;
+
+      /*----- Lifecycle Functions -----*/
+
+      /**
+       *  @brief
+       *  Compresses the given finalized object.
+       *
+       *  @details
+       *  Fields are grouped into blocks of at least block_size bytes (apart from the last),
+       *  so smaller blocks make first access cheaper, at the expense of compression ratio.
+       */
+      explicit basic_compressed_buffer(buffer const& buf, size_type block_size = default_block_size);
+
+      /**
+       *  @brief
+       *  Copies in, and checks the framing of, bytes previously returned by get_bytes.
+       *
+       *  @details
+       *  Malformed framing is reported with a dart::validation_error, as are blocks that
+       *  fail to decompress. The head is validated up front, and each block as it's
+       *  decompressed, with malformed contents reported as std::invalid_argument.
+       */
+      explicit basic_compressed_buffer(gsl::span<gsl::byte const> bytes);
+
+      basic_compressed_buffer(basic_compressed_buffer const&) = default;
+      basic_compressed_buffer(basic_compressed_buffer&&) noexcept = default;
+      ~basic_compressed_buffer() = default;
+
+      /*----- Operators -----*/
+
+      basic_compressed_buffer& operator =(basic_compressed_buffer const&) = default;
+      basic_compressed_buffer& operator =(basic_compressed_buffer&&) noexcept = default;
+
+      buffer operator [](shim::string_view key) const;
+
+      /*----- Public API -----*/
+
+      /**
+       *  @brief
+       *  Returns the value of the given key, decompressing the block that holds it if
+       *  it isn't already cached, or null if the key is absent.
+       */
+      buffer get(shim::string_view key) const;
+
+      /**
+       *  @brief
+       *  Returns whether the root object has the given key, without decompressing anything.
+       */
+      bool has_key(shim::string_view key) const noexcept;
+
+      /**
+       *  @brief
+       *  Returns the keys of the root object, in vtable order, without decompressing anything.
+       */
+      std::vector<shim::string_view> keys() const;
+
+      /**
+       *  @brief
+       *  Decompresses the entire buffer, and returns it.
+       *
+       *  @details
+       *  The result is a copy of the buffer that was compressed, byte for byte, and isn't
+       *  held by the cache.
+       */
+      buffer decompress() const;
+
+      /**
+       *  @brief
+       *  Drops every cached block.
+       *
+       *  @details
+       *  Values that have already been handed out keep their blocks alive until they
+       *  go away themselves.
+       */
+      void evict() const;
+
+      // Number of fields in the root object.
+      size_type size() const noexcept;
+
+      // Size of the buffer that was compressed.
+      size_type decompressed_size() const noexcept;
+
+      // Bytes currently held by the container, compressed and cached.
+      size_type resident_bytes() const;
+
+      // Self-contained serialized form of the container.
+      gsl::span<gsl::byte const> get_bytes() const noexcept;
+
+      /*----- Public Members -----*/
+
+      static constexpr size_type default_block_size = 1U << 14U;
+
+    private:
+
+      /*----- Private Types -----*/
+
+      using buffer_ref_type = detail::buffer_refcount_type<RefCount>;
+
+      struct block_cache {
+        std::mutex lock;
+        std::vector<buffer_ref_type> blocks;
+        buffer_ref_type whole;
+        size_type bytes = 0;
+      };
+
+      /*----- Private Helpers -----*/
+
+      void adopt(buffer_ref_type bytes, size_type len);
+      ssize_t find_field(shim::string_view key) const noexcept;
+      shim::string_view key_at(size_type idx) const noexcept;
+      buffer_ref_type load_block(size_type idx) const;
+      buffer_ref_type load_whole() const;
+      void decompress_into(gsl::byte* out) const;
+      static bool valid_value(detail::raw_element val, size_t bytes) noexcept;
+
+      detail::compressed_layout const* header() const noexcept;
+      detail::compressed_field const* fields() const noexcept;
+      detail::compressed_block const* blocks() const noexcept;
+      gsl::byte const* head() const noexcept;
+
+      /*----- Private Members -----*/
+
+      buffer_ref_type bytes;
+      size_type len;
+      std::shared_ptr<block_cache> cache;
 
   };
 
   using heap = basic_heap<std::shared_ptr>;
   using buffer = basic_buffer<std::shared_ptr>;
   using packet = basic_packet<std::shared_ptr>;
+  using compressed_buffer = basic_compressed_buffer<std::shared_ptr>;
 
   using unsafe_heap = basic_heap<unsafe_ptr>;
   using unsafe_buffer = basic_buffer<unsafe_ptr>;
   using unsafe_packet = basic_packet<unsafe_ptr>;
+  using unsafe_compressed_buffer = basic_compressed_buffer<unsafe_ptr>;
 
   using object = packet::object;
   using array = packet::array;
@@ -13897,6 +14509,209 @@ namespace dart {
   static_assert(std::is_nothrow_move_constructible<packet::null>::value
       && std::is_nothrow_move_assignable<packet::null>::value, "dart library is misconfigured");
 
+#if defined(DART_USE_SAJSON) || DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
+  /**
+   *  @brief
+   *  dart::json_stream_parser incrementally splits a stream of JSON text, handed over
+   *  in arbitrarily sized chunks, into its top-level values, and parses each one
+   *  as soon as it's complete.
+   *
+   *  @details
+   *  Streams can either be a sequence of values separated by optional whitespace
+   *  (mode::concatenated), or newline delimited JSON (mode::ndjson), where every
+   *  non-blank line holds exactly one value.
+   *  Chunk boundaries can fall anywhere, including in the middle of strings, escapes,
+   *  and numbers. Values that fit inside a single chunk are parsed straight out of it,
+   *  and only the leading part of a value that straddles chunks is copied aside.
+   *  Values are parsed with Packet::from_json, so dart::json_stream_parser hands out
+   *  finalized dart::buffer instances, and basic_json_stream_parser<dart::heap> hands
+   *  out mutable heaps.
+   *  Each completed value is passed to the callback given to feed, finish, or read.
+   *  ```
+   *  dart::json_stream_parser parser {dart::json_stream_parser::mode::ndjson};
+   *  parser.read(stdin, [&] (dart::buffer msg) { handle(std::move(msg)); });
+   *  ```
+   *
+   *  @remarks
+   *  Values that fail to parse are reported with a dart::stream_parse_error carrying
+   *  the offset and line they started on.
+   *  Each value is still parsed in one go once it's complete, so a value that straddles
+   *  chunks is held in memory in its entirety until then, and values longer than the
+   *  max_value given to the constructor are rejected the same way, without buffering
+   *  any more of them than that.
+   *  The offending value is dropped, and any input after it that hadn't been consumed
+   *  yet is kept, so calling feed, finish, or read again carries on with the next value.
+   *  The same goes for exceptions thrown by the callback.
+   */
+#ifdef DART_USE_SAJSON
+  template <class Packet, unsigned parse_stack_size = default_parse_stack_size>
+#else
+  template <class Packet, unsigned flags = parse_default>
+#endif
+  class basic_json_stream_parser final {
+
+    public:
+
+      /*----- Public Types -----*/
+
+      using size_type = size_t;
+      using value_type = Packet;
+
+      enum class mode {
+        concatenated,
+        ndjson
+      };
+
+      /*----- Lifecycle Functions -----*/
+
+      /**
+       *  @brief
+       *  Constructs a parser for the given framing.
+       *
+       *  @details
+       *  read_size is the size of the buffer used by the read overloads, which is
+       *  allocated the first time one of them is called, and reused afterwards.
+       *  max_value is the length, in bytes, of the longest value the parser will accept,
+       *  and so bounds how much of the stream it ever copies aside.
+       */
+      explicit basic_json_stream_parser(mode framing = mode::concatenated,
+          size_type read_size = default_read_size, size_type max_value = default_max_value);
+
+      basic_json_stream_parser(basic_json_stream_parser const&) = default;
+      basic_json_stream_parser(basic_json_stream_parser&&) noexcept = default;
+      ~basic_json_stream_parser() = default;
+
+      /*----- Operators -----*/
+
+      basic_json_stream_parser& operator =(basic_json_stream_parser const&) = default;
+      basic_json_stream_parser& operator =(basic_json_stream_parser&&) noexcept = default;
+
+      /*----- Public API -----*/
+
+      /**
+       *  @brief
+       *  Consumes the next chunk of the stream, calling cb with every value it completes.
+       *
+       *  @details
+       *  Returns the number of values passed to cb.
+       *  Top-level values that only end at the end of the stream (a bare number at the very
+       *  end, or a final NDJSON line without a newline) are held back until finish.
+       */
+      template <class Callback>
+      size_type feed(gsl::span<char const> chunk, Callback&& cb);
+
+      /**
+       *  @brief
+       *  Marks the end of the stream, calling cb with whatever value was held back,
+       *  and readies the parser for a new stream.
+       *
+       *  @details
+       *  Throws a dart::stream_parse_error if the stream ended in the middle of a value.
+       */
+      template <class Callback>
+      size_type finish(Callback&& cb);
+
+      /**
+       *  @brief
+       *  Reads the given file until end of file, feeding it through the parser
+       *  read_size bytes at a time, and then finishes the stream.
+       *
+       *  @details
+       *  Throws a std::system_error if the file can't be read.
+       */
+      template <class Callback>
+      size_type read(std::FILE* file, Callback&& cb);
+
+      /**
+       *  @brief
+       *  Reads the given file descriptor until end of file, feeding it through the parser
+       *  as data becomes available, and then finishes the stream.
+       *
+       *  @details
+       *  Unlike the FILE* overload, reads return as soon as any data is available,
+       *  so values arriving over a pipe or socket are handed out as they complete.
+       *  Throws a std::system_error if the descriptor can't be read.
+       */
+      template <class Callback>
+      size_type read(int fd, Callback&& cb);
+
+      /**
+       *  @brief
+       *  Reads the given stream until end of file, feeding it through the parser
+       *  read_size bytes at a time, and then finishes the stream.
+       *
+       *  @details
+       *  Throws a std::ios_base::failure if the stream goes bad.
+       */
+      template <class Callback>
+      size_type read(std::istream& in, Callback&& cb);
+
+      // Drops any partially consumed value, and readies the parser for a new stream.
+      void reset() noexcept;
+
+      // Whether the parser is in the middle of a value.
+      bool pending() const noexcept;
+
+      // Number of bytes of the stream consumed so far.
+      size_type offset() const noexcept;
+
+      // Line of the stream the parser is currently on, starting from one.
+      size_type line() const noexcept;
+
+      // Bytes of the current value that have been copied aside while waiting for the rest of it.
+      size_type buffered() const noexcept;
+
+      /*----- Public Members -----*/
+
+      static constexpr size_type default_read_size = 1U << 16U;
+      static constexpr size_type default_max_value = 1U << 26U;
+
+    private:
+
+      /*----- Private Types -----*/
+
+      enum class lexer : uint8_t {
+        idle,
+        aggregate,
+        string,
+        escape,
+        scalar
+      };
+
+      /*----- Private Helpers -----*/
+
+      template <class Callback>
+      size_type consume(char const* data, size_type len, Callback& cb);
+      template <class Callback>
+      size_type consume_values(char const* data, size_type len, size_type& pos, Callback& cb);
+      template <class Callback>
+      size_type consume_lines(char const* data, size_type len, size_type& pos, Callback& cb);
+      template <class Callback>
+      size_type complete(char const* data, size_type len, bool line, Callback& cb);
+      void set_aside(char const* data, size_type len);
+      Packet parse(shim::string_view json) const;
+
+      /*----- Private Members -----*/
+
+      mode framing;
+      lexer state;
+      size_type depth;
+      size_type consumed;
+      size_type lines;
+      size_type value_offset;
+      size_type value_line;
+      size_type read_size;
+      size_type max_value;
+      bool oversized;
+      std::string partial;
+      std::string backlog;
+      std::vector<char> read_buf;
+
+  };
+
+  using json_stream_parser = basic_json_stream_parser<buffer>;
+#endif
+
   /*----- Free Operator Declarations -----*/
 
   inline namespace literals {
@@ -13926,7 +14741,7 @@ namespace dart {
    *  came from an untrusted source.
    */
   inline bool is_valid(gsl::span<gsl::byte const> buffer) noexcept {
-    detail::raw_element raw {detail::raw_type::object, buffer.data()};
+    detail::raw_element raw {detail::identify_root(buffer.data(), buffer.size()), buffer.data()};
     return detail::valid_buffer<true, std::shared_ptr>(raw, buffer.size());
   }
 
@@ -13947,7 +14762,7 @@ namespace dart {
    *  came from an untrusted source.
    */
   inline bool is_valid(gsl::byte const* buffer, size_t len) noexcept {
-    detail::raw_element raw {detail::raw_type::object, buffer};
+    detail::raw_element raw {detail::identify_root(buffer, len), buffer};
     return detail::valid_buffer<true, std::shared_ptr>(raw, len);
   }
 
@@ -13969,7 +14784,7 @@ namespace dart {
    */
   template <class Del>
   bool is_valid(std::unique_ptr<gsl::byte, Del> const& buffer, size_t len) noexcept {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     return detail::valid_buffer<true, std::shared_ptr>(raw, len);
   }
 
@@ -13991,7 +14806,7 @@ namespace dart {
    */
   template <class Del>
   bool is_valid(std::unique_ptr<gsl::byte[], Del> const& buffer, size_t len) noexcept {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     return detail::valid_buffer<true, std::shared_ptr>(raw, len);
   }
 
@@ -14013,7 +14828,7 @@ namespace dart {
    */
   template <class Del>
   bool is_valid(std::unique_ptr<gsl::byte const, Del> const& buffer, size_t len) noexcept {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     return detail::valid_buffer<true, std::shared_ptr>(raw, len);
   }
 
@@ -14035,7 +14850,7 @@ namespace dart {
    */
   template <class Del>
   bool is_valid(std::unique_ptr<gsl::byte const[], Del> const& buffer, size_t len) noexcept {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     return detail::valid_buffer<true, std::shared_ptr>(raw, len);
   }
 
@@ -14056,7 +14871,7 @@ namespace dart {
    *  came from an untrusted source.
    */
   inline bool is_valid(std::shared_ptr<gsl::byte const> const& buffer, size_t len) noexcept {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     return detail::valid_buffer<true, std::shared_ptr>(raw, len);
   }
 
@@ -14077,7 +14892,7 @@ namespace dart {
    *  came from an untrusted source.
    */
   inline void validate(gsl::span<gsl::byte const> buffer) {
-    detail::raw_element raw {detail::raw_type::object, buffer.data()};
+    detail::raw_element raw {detail::identify_root(buffer.data(), buffer.size()), buffer.data()};
     detail::valid_buffer<false, std::shared_ptr>(raw, buffer.size());
   }
 
@@ -14098,7 +14913,7 @@ namespace dart {
    *  came from an untrusted source.
    */
   inline void validate(gsl::byte const* buffer, size_t len) {
-    detail::raw_element raw {detail::raw_type::object, buffer};
+    detail::raw_element raw {detail::identify_root(buffer, len), buffer};
     detail::valid_buffer<false, std::shared_ptr>(raw, len);
   }
 
@@ -14120,7 +14935,7 @@ namespace dart {
    */
   template <class Del>
   void validate(std::unique_ptr<gsl::byte, Del> const& buffer, size_t len) {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     detail::valid_buffer<false, std::shared_ptr>(raw, len);
   }
 
@@ -14142,7 +14957,7 @@ namespace dart {
    */
   template <class Del>
   void validate(std::unique_ptr<gsl::byte[], Del> const& buffer, size_t len) {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     detail::valid_buffer<false, std::shared_ptr>(raw, len);
   }
 
@@ -14164,7 +14979,7 @@ namespace dart {
    */
   template <class Del>
   void validate(std::unique_ptr<gsl::byte const, Del> const& buffer, size_t len) {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     detail::valid_buffer<false, std::shared_ptr>(raw, len);
   }
 
@@ -14186,7 +15001,7 @@ namespace dart {
    */
   template <class Del>
   void validate(std::unique_ptr<gsl::byte const[], Del> const& buffer, size_t len) {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     detail::valid_buffer<false, std::shared_ptr>(raw, len);
   }
 
@@ -14207,7 +15022,7 @@ namespace dart {
    *  came from an untrusted source.
    */
   inline void validate(std::shared_ptr<gsl::byte const> const& buffer, size_t len) {
-    detail::raw_element raw {detail::raw_type::object, buffer.get()};
+    detail::raw_element raw {detail::identify_root(buffer.get(), len), buffer.get()};
     detail::valid_buffer<false, std::shared_ptr>(raw, len);
   }
 
@@ -14237,7 +15052,7 @@ namespace dart {
   packet parse(shim::string_view json, bool finalize = false) {
     return from_json<parse_stack_size>(json, finalize);
   }
-#elif DART_HAS_RAPIDJSON
+#elif DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
   /**
    *  @brief
    *  Function constructs an optionally finalized packet to represent the given JSON string.
@@ -14245,6 +15060,8 @@ namespace dart {
    *  @details
    *  Parsing is based on RapidJSON, and so exposes the same parsing customization points as
    *  RapidJSON.
+   *  Defining DART_USE_NATIVE_JSON swaps in dart's own SIMD accelerated reader, which supports
+   *  everything below except comments.
    *  If your JSON has embedded comments in it, NaN or +/-Infinity values, or trailing commas,
    *  you can parse in the following ways:
    *  ```
@@ -14267,6 +15084,8 @@ namespace dart {
    *  @details
    *  Parsing is based on RapidJSON, and so exposes the same parsing customization points as
    *  RapidJSON.
+   *  Defining DART_USE_NATIVE_JSON swaps in dart's own SIMD accelerated reader, which supports
+   *  everything below except comments.
    *  If your JSON has embedded comments in it, NaN or +/-Infinity values, or trailing commas,
    *  you can parse in the following ways:
    *  ```
@@ -14283,6 +15102,123 @@ namespace dart {
   }
 #endif
 
+#if defined(DART_USE_SAJSON) || DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
+  /**
+   *  @brief
+   *  Function parses every line of a newline delimited JSON document into a finalized
+   *  dart::buffer, on the given number of threads, and returns them in input order.
+   *
+   *  @details
+   *  The input is cut into chunks at newline boundaries, and chunks are handed out to
+   *  a work stealing pool, with every thread reusing its own parser scratch space from
+   *  one line to the next.
+   *  Blank lines are skipped, so the result can be shorter than the number of lines.
+   *  Zero threads uses as many threads as the hardware supports, including the calling one.
+   *  If any line fails to parse, or holds a value that isn't an object, the first one
+   *  that did is reported with a dart::stream_parse_error carrying its line and offset.
+   *  Large files can be parsed in place through a dart::mapped_file:
+   *  ```
+   *  dart::mapped_file file {"backfill.ndjson"};
+   *  auto values = dart::parse_ndjson(file.view(), 8);
+   *  ```
+   */
+#ifdef DART_USE_SAJSON
+  template <unsigned parse_stack_size = default_parse_stack_size>
+#else
+  template <unsigned flags = parse_default>
+#endif
+  std::vector<buffer> parse_ndjson(shim::string_view ndjson, size_t threads = 0);
+
+  /**
+   *  @brief
+   *  Function parses every line of a newline delimited JSON document into a finalized
+   *  dart::buffer, on the given number of threads, and passes them to cb in input order.
+   *
+   *  @details
+   *  Rather than materializing every value at once, chunks are parsed a window at a time,
+   *  so only a few chunks' worth of values are alive at once, and cb is always called on the
+   *  calling thread.
+   *  Returns the number of values passed to cb.
+   *  If a line fails to parse, every value before it is passed to cb, and it's then reported
+   *  with a dart::stream_parse_error carrying its line and offset.
+   */
+#ifdef DART_USE_SAJSON
+  template <unsigned parse_stack_size = default_parse_stack_size, class Callback>
+#else
+  template <unsigned flags = parse_default, class Callback>
+#endif
+  size_t parse_ndjson(shim::string_view ndjson, size_t threads, Callback&& cb);
+
+  /**
+   *  @brief
+   *  Overloads of dart::parse_ndjson that run on the threads of an existing
+   *  dart::parallel_policy, rather than starting and stopping some of their own on every call.
+   *
+   *  @details
+   *  Worth it for repeated backfill runs over many smaller files:
+   *  ```
+   *  dart::parallel_policy policy {8};
+   *  for (auto& path : paths) {
+   *    dart::mapped_file file {path};
+   *    dart::parse_ndjson(file.view(), policy, [&] (dart::buffer val) { handle(std::move(val)); });
+   *  }
+   *  ```
+   *  The policy's threads run one batch at a time, so concurrent calls sharing it take turns.
+   */
+#ifdef DART_USE_SAJSON
+  template <unsigned parse_stack_size = default_parse_stack_size>
+#else
+  template <unsigned flags = parse_default>
+#endif
+  std::vector<buffer> parse_ndjson(shim::string_view ndjson, parallel_policy const& policy);
+
+#ifdef DART_USE_SAJSON
+  template <unsigned parse_stack_size = default_parse_stack_size, class Callback>
+#else
+  template <unsigned flags = parse_default, class Callback>
+#endif
+  size_t parse_ndjson(shim::string_view ndjson, parallel_policy const& policy, Callback&& cb);
+#endif
+
+}
+
+namespace std {
+
+  /**
+   *  @brief
+   *  Hashes the contents of a dart::heap.
+   *
+   *  @details
+   *  Any two packets that compare equal hash the same, irrespective of whether
+   *  either has been finalized, so heaps, buffers, and packets can share a key space.
+   */
+  template <template <class> class RefCount>
+  struct hash<dart::basic_heap<RefCount>> {
+    size_t operator ()(dart::basic_heap<RefCount> const& val) const noexcept;
+  };
+
+  /**
+   *  @brief
+   *  Hashes the contents of a dart::buffer.
+   *
+   *  @details
+   *  Objects finalized with dart::finalize_options::content_hash_threshold
+   *  carry their hashes with them, and so hash in constant time.
+   */
+  template <template <class> class RefCount>
+  struct hash<dart::basic_buffer<RefCount>> {
+    size_t operator ()(dart::basic_buffer<RefCount> const& val) const noexcept;
+  };
+
+  /**
+   *  @brief
+   *  Hashes the contents of a dart::packet.
+   */
+  template <template <class> class RefCount>
+  struct hash<dart::basic_packet<RefCount>> {
+    size_t operator ()(dart::basic_packet<RefCount> const& val) const noexcept;
+  };
+
 }
 
 /*----- Function Template Implementations -----*/
@@ -14290,14 +15226,20 @@ namespace dart {
 #include "dart/api.tcc"
 #include "dart/array.tcc"
 #include "dart/iterator.tcc"
+#include "dart/large_array.tcc"
+#include "dart/large_object.tcc"
 #include "dart/object.tcc"
 #include "dart/operators.tcc"
 #include "dart/primitive.tcc"
+#include "dart/record.tcc"
+#include "dart/small_array.tcc"
+#include "dart/small_object.tcc"
 #include "dart/string.tcc"
 #include "dart/heap/heap.h"
 #include "dart/buffer/buffer.h"
 #include "dart/packet/packet.h"
 #include "dart/connector/json.tcc"
+#include "dart/connector/json_stream.tcc"
 #include "dart/connector/yaml.tcc"
 
 #endif
@@ -36,6 +36,7 @@
 #define DART_BUFFER_MAX_SIZE      (1U << 5U)
 #define DART_HEAP_MAX_SIZE        (1U << 6U)
 #define DART_PACKET_MAX_SIZE      DART_HEAP_MAX_SIZE
+#define DART_KEY_MAX_SIZE         (1U << 6U)
 
 // This is embarrassing.
 // Dart iterators have big
@@ -291,6 +292,33 @@ extern "C" {
   };
   typedef struct dart_packet dart_packet_t;
 
+  /**
+   *  @brief
+   *  Struct is used to encode a precompiled key that will be looked up
+   *  in many dart_buffer_t objects.
+   *
+   *  @details
+   *  See documentation for dart::key in the Doxygen docs.
+   *
+   *  @remarks
+   *  dart_key_t's internally hold a live C++ object, and therefore cannot
+   *  simply be memcpy'd around, nor returned by value.
+   *  Treat these types as opaque handles to state that is managed FOR you by the
+   *  public API functions.
+   *  The storage is a union so that it's aligned for the object it holds,
+   *  which a plain character array isn't.
+   */
+  union dart_key_storage {
+    char raw[DART_KEY_MAX_SIZE];
+    long double align_decimal;
+    uint64_t align_integer;
+    void* align_pointer;
+  };
+  struct dart_key {
+    union dart_key_storage bytes;
+  };
+  typedef struct dart_key dart_key_t;
+
   /**
    *  @brief
    *  Struct is used to export non-owning access to a string with explicit length
@@ -3600,6 +3628,101 @@ extern "C" {
    */
   DART_ABI_EXPORT dart_err_t dart_buffer_obj_get_len_err(dart_buffer_t* dst, dart_buffer_t const* src, char const* key, size_t len);
 
+  /**
+   *  @brief
+   *  Function is used to check whether a precompiled key exists in a given object.
+   *
+   *  @details
+   *  Function is behaviorally identical to dart_buffer_obj_has_key, but avoids
+   *  repeating per-key work when the same key is queried in many objects.
+   *
+   *  @param[in] src
+   *  The object to query.
+   *
+   *  @param[in] key
+   *  The precompiled key whose existence should be queried.
+   *
+   *  @return
+   *  Whether the given key is present.
+   */
+  DART_ABI_EXPORT int dart_buffer_obj_has_key_handle(dart_buffer_t const* src, dart_key_t const* key);
+
+  /**
+   *  @brief
+   *  Function is used to retrieve the value for a given precompiled key from a given object.
+   *
+   *  @details
+   *  Function returns null instances for non-existent keys without modifying the object.
+   *  The key remembers the position at which it was last found, and checks there first,
+   *  so repeated lookups across objects of the same shape are very cheap.
+   *
+   *  @param[in] src
+   *  The source object to query from.
+   *
+   *  @param[in] key
+   *  The precompiled key to locate within the given object.
+   *
+   *  @return
+   *  The dart_buffer_t instance corresponding to the given key, or null in error.
+   */
+  DART_ABI_EXPORT dart_buffer_t dart_buffer_obj_get_handle(dart_buffer_t const* src, dart_key_t const* key);
+
+  /**
+   *  @brief
+   *  Function is used to retrieve the value for a given precompiled key from a given object.
+   *
+   *  @details
+   *  Function returns null instances for non-existent keys without modifying the object.
+   *  Function expects to received uninitialized memory. If using a pointer to a previous Dart
+   *  instance, it must be passed through an appropriate dart_destroy function first.
+   *
+   *  @param[out] dst
+   *  The dart_buffer_t instance that should be initialized with the result of the lookup.
+   *
+   *  @param[in] src
+   *  The object instance to query from.
+   *
+   *  @param[in] key
+   *  The precompiled key to locate within the given object.
+   *
+   *  @return
+   *  Whether anything went wrong during the lookup.
+   */
+  DART_ABI_EXPORT dart_err_t dart_buffer_obj_get_handle_err(dart_buffer_t* dst, dart_buffer_t const* src, dart_key_t const* key);
+
+  /**
+   *  @brief
+   *  Function is used to retrieve the values for many keys from a given object at once.
+   *
+   *  @details
+   *  Keys are resolved in a single forward pass over the object, which is considerably
+   *  cheaper than looking each key up individually. Keys can be passed in any order,
+   *  but passing them in the order the object stores them (shorter keys first, then
+   *  lexicographically) avoids an internal sort.
+   *  Function returns null instances for non-existent keys.
+   *  Function expects to receive uninitialized memory for every output. On success,
+   *  every output must eventually be passed through dart_buffer_destroy, on failure,
+   *  no output is initialized.
+   *
+   *  @param[in] src
+   *  The object instance to query from.
+   *
+   *  @param[in] keys
+   *  Array of the keys to locate within the given object.
+   *
+   *  @param[out] dsts
+   *  Array of dart_buffer_t instances that should be initialized with the results,
+   *  one per key.
+   *
+   *  @param[in] count
+   *  The number of keys, and outputs.
+   *
+   *  @return
+   *  Whether anything went wrong during the lookup.
+   */
+  DART_ABI_EXPORT dart_err_t dart_buffer_obj_get_many(dart_buffer_t const* src,
+      dart_string_view_t const* keys, dart_buffer_t* dsts, size_t count);
+
   /**
    *  @brief
    *  Function is used to retrieve the value for a given index within a given array.
@@ -3815,6 +3938,22 @@ extern "C" {
    */
   DART_ABI_EXPORT int dart_buffer_equal(dart_buffer_t const* lhs, dart_buffer_t const* rhs);
 
+  /**
+   *  @brief
+   *  Function hashes the contents of the given instance.
+   *
+   *  @details
+   *  Any two instances that compare equal hash the same. Objects finalized
+   *  with a content hash carry it with them, and hash in constant time.
+   *
+   *  @param[in] src
+   *  The instance to hash.
+   *
+   *  @return
+   *  The hash of the given instance, or zero if it couldn't be accessed.
+   */
+  DART_ABI_EXPORT uint64_t dart_buffer_hash(dart_buffer_t const* src);
+
   /**
    *  @brief
    *  Function checks whether the given instance is of object type.
@@ -3863,6 +4002,61 @@ extern "C" {
    */
   DART_ABI_EXPORT dart_type_t dart_buffer_get_type(dart_buffer_t const* src);
 
+  /*----- dart_key Lifecycle Functions -----*/
+
+  /**
+   *  @brief
+   *  Function is used to initialize a precompiled key from a null-terminated string.
+   *
+   *  @details
+   *  Function expects to receive uninitialized memory, and the resulting key must
+   *  eventually be passed to dart_key_destroy.
+   *
+   *  @param[out] dst
+   *  The dart_key_t instance to initialize.
+   *
+   *  @param[in] key
+   *  The null-terminated key to precompile.
+   *
+   *  @return
+   *  Whether anything went wrong during initialization.
+   */
+  DART_ABI_EXPORT dart_err_t dart_key_init_err(dart_key_t* dst, char const* key);
+
+  /**
+   *  @brief
+   *  Function is used to initialize a precompiled key from a, possibly unterminated, string.
+   *
+   *  @details
+   *  Function expects to receive uninitialized memory, and the resulting key must
+   *  eventually be passed to dart_key_destroy.
+   *
+   *  @param[out] dst
+   *  The dart_key_t instance to initialize.
+   *
+   *  @param[in] key
+   *  The possibly unterminated key to precompile.
+   *
+   *  @param[in] len
+   *  The length of the key in bytes.
+   *
+   *  @return
+   *  Whether anything went wrong during initialization.
+   */
+  DART_ABI_EXPORT dart_err_t dart_key_init_len_err(dart_key_t* dst, char const* key, size_t len);
+
+  /**
+   *  @brief
+   *  Function is used to destroy a precompiled key, releasing any resources it holds.
+   *
+   *  @param[in,out] key
+   *  The key to be destroyed.
+   *
+   *  @return
+   *  Whether anything went wrong during destruction.
+   */
+  DART_ABI_EXPORT dart_err_t dart_key_destroy(dart_key_t* key);
+
   /*----- dart_buffer JSON Manipulation Functions -----*/
 
   /**
@@ -244,20 +244,16 @@ namespace dart {
     }
 #endif
 
-#if DART_HAS_RAPIDJSON
     template <template <class> class RefCount>
-    array<RefCount>::array(rapidjson::Value const& vals) noexcept :
-      elems(static_cast<uint32_t>(vals.Size()))
+    array<RefCount>::array(buffer_parser<RefCount> const& parser, size_t idx) noexcept :
+      elems(static_cast<uint32_t>(parser.get_children(idx).size()))
     {
       // Iterate over our elements and write each one into the buffer.
       array_entry* entry = vtable();
       size_t offset = reinterpret_cast<gsl::byte*>(&vtable()[elems]) - DART_FROM_THIS_MUT;
-      for (auto it = vals.Begin(); it != vals.End(); ++it) {
-        // Identify the internal type of the current element.
-        auto& curr_val = *it;
-        auto val_type = json_identify<RefCount>(curr_val);
-
+      for (auto elem : parser.get_children(idx)) {
         // Using the current offset, align a pointer for the next element type.
+        auto val_type = parser.get_type(elem);
         auto* unaligned = DART_FROM_THIS_MUT + offset;
         auto* aligned = detail::align_pointer<RefCount>(unaligned, val_type);
         offset += aligned - unaligned;
@@ -266,37 +262,65 @@ namespace dart {
         new(entry++) array_entry(val_type, static_cast<uint32_t>(offset));
 
         // Recurse.
-        offset += json_lower<RefCount>(aligned, curr_val);
+        offset += parser.lower(aligned, elem);
       }
 
       // array is laid out, write in our final size.
       bytes = static_cast<uint32_t>(offset);
     }
-#endif
 
     // FIXME: Audit this function. A LOT has changed since it was written.
     template <template <class> class RefCount>
-    array<RefCount>::array(packet_elements<RefCount> const* vals) noexcept :
+    array<RefCount>::array(packet_elements<RefCount> const* vals, finalize_options const& opts) noexcept :
       elems(static_cast<uint32_t>(vals->size()))
     {
+      // Arrays of same-shaped objects can share a single copy of their keys, if requested.
+      if (is_batchable(vals, opts)) {
+        write_batch(vals, opts);
+        return;
+      }
+
+      // Homogeneous numeric arrays can skip the vtable entirely, if requested.
+      auto const packing = packing_for(vals, opts);
+      if (packing != raw_type::null) {
+        write_packed(vals, packing);
+        return;
+      }
+
       // Iterate over our elements and write each one into the buffer.
+      bool canonical = true, dependent = false;
       array_entry* entry = vtable();
       size_t offset = reinterpret_cast<gsl::byte*>(&vtable()[elems]) - DART_FROM_THIS_MUT;
       for (auto const& elem : *vals) {
+        // Scalars small enough to take the place of their offset don't take up any space in the body.
+        // Nested aggregates may be laid out with a smaller encoding than their own.
+        auto const type = elem.get_raw_type(opts);
+        if (opts.inline_scalars && elem.fits_inline(array_inline_bytes)) {
+          auto* curr = new(entry++) array_entry(type, 0);
+          curr->set_inline();
+          elem.layout(curr->inline_value(), opts, type);
+          canonical = false;
+          continue;
+        }
+
         // Using the current offset, align a pointer for the next element type.
         auto* unaligned = DART_FROM_THIS_MUT + offset;
-        auto* aligned = detail::align_pointer<RefCount>(unaligned, elem.get_raw_type());
+        auto* aligned = detail::align_pointer<RefCount>(unaligned, type);
         offset += aligned - unaligned;
 
         // Add an entry to the vtable.
-        new(entry++) array_entry(elem.get_raw_type(), static_cast<uint32_t>(offset));
+        new(entry++) array_entry(type, static_cast<uint32_t>(offset));
 
         // Recurse.
-        offset += elem.layout(aligned);
+        offset += elem.layout(aligned, opts, type);
+        canonical = canonical && detail::is_canonical<RefCount>({type, aligned});
+        dependent = dependent || detail::is_dependent<RefCount>({type, aligned});
       }
 
       // array is laid out, write in our final size.
       bytes = static_cast<uint32_t>(offset);
+      if (!canonical) elems |= aggregate_noncanonical_flag;
+      if (dependent) elems |= aggregate_dependent_flag;
     }
 
 // Unfortunately some versions of GCC and MSVC aren't smart enough to figure
@@ -330,6 +354,45 @@ namespace dart {
         else throw validation_error("Serialized array length is out of bounds");
       }
 
+      // The only extended encoding an array can use is packing, which replaces the vtable
+      // with a header, and a run of primitives that are always valid if they're in bounds.
+      if (elems & aggregate_extended_flag) {
+        if (header_len + sizeof(packed_array_layout) > static_cast<size_t>(total_size)) {
+          if (silent) return false;
+          else throw validation_error("Serialized array packing header is out of bounds");
+        }
+
+        auto const type = packed_type();
+        switch (type) {
+          case raw_type::short_integer:
+          case raw_type::integer:
+          case raw_type::long_integer:
+          case raw_type::decimal:
+          case raw_type::long_decimal:
+          case raw_type::boolean:
+            break;
+          case raw_type::object:
+            // Packed runs of rows are record batches, which carry a good deal more structure.
+            return valid_batch<silent>(static_cast<size_t>(total_size));
+          default:
+            if (silent) return false;
+            else throw validation_error("Serialized array uses an encoding of no known type");
+        }
+
+        auto const width = packed_header()->width.get();
+        if (width != alignment_of<RefCount>(type)) {
+          if (silent) return false;
+          else throw validation_error("Serialized array packing width is inconsistent");
+        } else if (packed_data() + size() * width - DART_FROM_THIS > total_size) {
+          if (silent) return false;
+          else throw validation_error("Serialized array packed values are out of bounds");
+        } else if (!valid_packed(packed_data(), type, size())) {
+          if (silent) return false;
+          else throw validation_error("Serialized array packed value is out of range");
+        }
+        return true;
+      }
+
       // The array reports a reasonable length,
       // so now check if the vtable is within bounds.
       auto* vtable_end = raw_vtable() + (size() * sizeof(array_entry));
@@ -341,7 +404,7 @@ namespace dart {
       // We now know that the vtable is fully within bounds, but it could still be full of crap
       // Check that every element in the vtable has a valid type
       for (size_t i = 0; i < size(); ++i) {
-        if (!valid_type(vtable()[i].get_type())) {
+        if (!valid_type(strip_inline(vtable()[i].get_type()))) {
           if (silent) return false;
           else throw validation_error("Serialized object value is of no known type");
         }
@@ -350,12 +413,29 @@ namespace dart {
       // We now know the entire vtable is within bounds,
       // so iterate over it and check all contained children.
       void const* prev = this;
-      for (auto raw_val : *this) {
+      for (size_t i = 0; i < size(); ++i) {
+        // Inline values are already known to be in bounds, but have to be scalars
+        // that fit in place of their offset.
+        auto const raw_val = get_elem(i);
+        if (vtable()[i].is_inline()) {
+          auto const kind = simplify_type(raw_val.type);
+          if (kind == type::object || kind == type::array) {
+            if (silent) return false;
+            else throw validation_error("Serialized array inline value is malformed");
+          }
+          auto valid_val = valid_buffer<silent, RefCount>(raw_val, array_inline_bytes);
+          if (!valid_val) return false;
+          continue;
+        }
+
         // Load the base address of the value and verify that it's within bounds.
         auto val_offset = raw_val.buffer - DART_FROM_THIS;
         if (val_offset > total_size) {
           if (silent) return false;
           else throw validation_error("Serialized array value offset is out of bounds");
+        } else if (raw_val.type == raw_type::null) {
+          // Nulls take up no space, so they share their offset with whatever follows them.
+          continue;
         } else if (raw_val.buffer <= prev) {
           if (silent) return false;
           else throw validation_error("Serialized array value contained a negative or cyclic offset");
@@ -381,7 +461,7 @@ namespace dart {
 
     template <template <class> class RefCount>
     size_t array<RefCount>::size() const noexcept {
-      return elems;
+      return elems & aggregate_size_mask;
     }
 
     template <template <class> class RefCount>
@@ -389,6 +469,16 @@ namespace dart {
       return bytes;
     }
 
+    template <template <class> class RefCount>
+    bool array<RefCount>::is_canonical() const noexcept {
+      return !(elems & aggregate_noncanonical_flag);
+    }
+
+    template <template <class> class RefCount>
+    bool array<RefCount>::is_dependent() const noexcept {
+      return elems & aggregate_dependent_flag;
+    }
+
     template <template <class> class RefCount>
     auto array<RefCount>::begin() const noexcept -> ll_iterator<RefCount> {
       return detail::ll_iterator<RefCount>(0, DART_FROM_THIS, load_elem);
@@ -409,6 +499,34 @@ namespace dart {
       return get_elem_impl(index, true);
     }
 
+    template <template <class> class RefCount>
+    bool array<RefCount>::is_packed() const noexcept {
+      return elems & aggregate_extended_flag;
+    }
+
+    template <template <class> class RefCount>
+    raw_type array<RefCount>::packed_type() const noexcept {
+      return static_cast<raw_type>(packed_header()->type.get());
+    }
+
+    template <template <class> class RefCount>
+    gsl::byte const* array<RefCount>::packed_data() const noexcept {
+      return raw_vtable() + sizeof(packed_array_layout);
+    }
+
+    template <template <class> class RefCount>
+    bool array<RefCount>::is_record_batch() const noexcept {
+      return is_packed() && packed_type() == raw_type::object;
+    }
+
+    template <template <class> class RefCount>
+    packed_array_layout const* array<RefCount>::batch_column(shim::string_view const key) const noexcept {
+      auto const idx = find_batch_key(key);
+      if (idx < 0) return nullptr;
+      auto const* column = DART_FROM_THIS + batch_keys()[idx].column.get();
+      return shim::launder(reinterpret_cast<packed_array_layout const*>(column));
+    }
+
     template <template <class> class RefCount>
     auto array<RefCount>::load_elem(gsl::byte const* base, size_t idx) noexcept
       -> typename ll_iterator<RefCount>::value_type
@@ -416,11 +534,80 @@ namespace dart {
       return get_array<RefCount>({raw_type::array, base})->get_elem(idx);
     }
 
+    template <template <class> class RefCount>
+    raw_type array<RefCount>::packing_for(packet_elements<RefCount> const* vals, finalize_options const& opts) noexcept {
+      if (vals->empty() || vals->size() < opts.packed_array_threshold) return raw_type::null;
+      return widest_primitive(vals->size(), [vals] (size_t idx) -> auto const& { return (*vals)[idx]; });
+    }
+
+    template <template <class> class RefCount>
+    bool array<RefCount>::is_batchable(packet_elements<RefCount> const* vals, finalize_options const& opts) noexcept {
+      if (vals->empty() || vals->size() < opts.record_batch_threshold) return false;
+
+      // Every element has to be an object with exactly the same keys as the first.
+      auto const* shape = vals->front().try_get_fields();
+      if (!shape || shape->empty()) return false;
+      for (auto const& elem : *vals) {
+        auto const* fields = elem.try_get_fields();
+        if (!fields || fields->size() != shape->size()) return false;
+        auto const same_key = [] (auto const& lhs, auto const& rhs) { return lhs.first.strv() == rhs.first.strv(); };
+        if (!std::equal(fields->begin(), fields->end(), shape->begin(), same_key)) return false;
+      }
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    size_t array<RefCount>::batch_upper_bound(packet_elements<RefCount> const* vals, finalize_options const& opts) {
+      // Start with the headers, the handles, and the key entries.
+      auto const& shape = *vals->front().try_get_fields();
+      size_t max = header_len + sizeof(packed_array_layout) + sizeof(record_batch_layout);
+      max += vals->size() * sizeof(little_order<uint32_t>) + shape.size() * sizeof(record_key_entry);
+
+      for (auto const& field : shape) {
+        // Each key is stored once, plus any padding it requires.
+        max += field.first.upper_bound() + alignment_of<RefCount>(field.first.get_raw_type()) - 1;
+
+        // Assume every column needs a vtable, which costs at least as much as packing it would.
+        max += sizeof(packed_array_layout) + alignment - 1;
+        max += vals->size() * sizeof(array_entry);
+        for (auto const& elem : *vals) {
+          auto const& val = elem.try_get_fields()->find(field.first)->second;
+          max += val.upper_bound(opts) + alignment_of<RefCount>(val.get_raw_type()) - 1;
+        }
+      }
+      return max + alignment - 1;
+    }
+
+    template <template <class> class RefCount>
+    template <class Loader>
+    raw_type array<RefCount>::widest_primitive(size_t count, Loader&& load) noexcept {
+      // Every value has to share a logical type, and the run is stored using
+      // the widest representation any of them needs.
+      auto widest = load(0).get_raw_type();
+      auto const kind = simplify_type(widest);
+      if (kind != type::integer && kind != type::decimal && kind != type::boolean) return raw_type::null;
+      for (size_t i = 0; i < count; ++i) {
+        auto const curr = load(i).get_raw_type();
+        if (simplify_type(curr) != kind) return raw_type::null;
+        else if (curr > widest) widest = curr;
+      }
+      return widest;
+    }
+
     template <template <class> class RefCount>
     auto array<RefCount>::get_elem_impl(size_t index, bool throw_if_absent) const -> raw_element {
       // Grab the value, or null, if the index is out of range.
       if (index < size()) {
+        // Elements of a packed array are laid out exactly like any other primitive,
+        // so a pointer into the run is indistinguishable from a standalone value.
+        // Record batches pack handles to their rows instead of values.
+        if (DART_UNLIKELY(is_packed())) {
+          auto const type = packed_type();
+          auto const* elem = packed_data() + index * packed_header()->width.get();
+          return {type == raw_type::object ? raw_type::record : type, elem};
+        }
         auto const& meta = vtable()[index];
+        if (DART_UNLIKELY(meta.is_inline())) return {strip_inline(meta.get_type()), meta.inline_value()};
         return {meta.get_type(), DART_FROM_THIS + meta.get_offset()};
       } else if (!throw_if_absent) {
         return {raw_type::null, nullptr};
@@ -429,6 +616,330 @@ namespace dart {
       }
     }
 
+    template <template <class> class RefCount>
+    void array<RefCount>::write_packed(packet_elements<RefCount> const* vals, raw_type type) noexcept {
+      auto* header = new(raw_vtable()) packed_array_layout;
+      auto const width = alignment_of<RefCount>(type);
+      header->type = static_cast<uint32_t>(type);
+      header->width = static_cast<uint32_t>(width);
+
+      auto load = [vals] (size_t idx) -> auto const& { return (*vals)[idx]; };
+      auto* data = write_run(raw_vtable() + sizeof(packed_array_layout), vals->size(), type, load);
+
+      // Zero the trailing padding, so packed buffers can still be compared via memcmp.
+      auto const offset = static_cast<size_t>(data - DART_FROM_THIS);
+      auto const padded = pad_bytes<RefCount>(offset, raw_type::array);
+      std::fill(data, DART_FROM_THIS_MUT + padded, gsl::byte {});
+      bytes = static_cast<uint32_t>(padded);
+      elems |= aggregate_extended_flag | aggregate_noncanonical_flag;
+    }
+
+    template <template <class> class RefCount>
+    void array<RefCount>::write_batch(packet_elements<RefCount> const* vals, finalize_options const& opts) noexcept {
+      auto const& shape = *vals->front().try_get_fields();
+      auto const num_rows = vals->size();
+
+      // The packed run holds a handle per row, each of which knows its own offset.
+      auto* header = new(raw_vtable()) packed_array_layout;
+      header->type = static_cast<uint32_t>(raw_type::object);
+      header->width = static_cast<uint32_t>(sizeof(little_order<uint32_t>));
+      auto* handles = reinterpret_cast<little_order<uint32_t>*>(raw_vtable() + sizeof(packed_array_layout));
+      for (size_t i = 0; i < num_rows; ++i) {
+        handles[i] = static_cast<uint32_t>(reinterpret_cast<gsl::byte*>(&handles[i]) - DART_FROM_THIS);
+      }
+
+      // Write the batch header, and then a single copy of every key.
+      auto* batch = new(&handles[num_rows]) record_batch_layout;
+      batch->keys = static_cast<uint32_t>(shape.size());
+      auto* keys = reinterpret_cast<record_key_entry*>(batch + 1);
+      size_t offset = reinterpret_cast<gsl::byte*>(keys + shape.size()) - DART_FROM_THIS_MUT;
+      auto* key = keys;
+      for (auto const& field : shape) {
+        auto* unaligned = DART_FROM_THIS_MUT + offset;
+        auto* aligned = detail::align_pointer<RefCount>(unaligned, field.first.get_raw_type());
+        offset += aligned - unaligned;
+        key->key = static_cast<uint32_t>(offset);
+        offset += field.first.layout(aligned);
+        ++key;
+      }
+
+      // Write a column per key.
+      bool dependent = false;
+      key = keys;
+      for (auto const& field : shape) {
+        offset = pad_bytes<RefCount>(offset, raw_type::array);
+        key->column = static_cast<uint32_t>(offset);
+        auto* column = new(DART_FROM_THIS_MUT + offset) packed_array_layout;
+        offset += sizeof(packed_array_layout);
+        ++key;
+
+        // Columns of primitives are packed, so that scanning them touches nothing else.
+        auto load = [&] (size_t idx) -> auto const& { return (*vals)[idx].try_get_fields()->find(field.first)->second; };
+        auto const packing = widest_primitive(num_rows, load);
+        if (packing != raw_type::null) {
+          column->type = static_cast<uint32_t>(packing);
+          column->width = static_cast<uint32_t>(alignment_of<RefCount>(packing));
+          offset = write_run(DART_FROM_THIS_MUT + offset, num_rows, packing, load) - DART_FROM_THIS_MUT;
+          continue;
+        }
+
+        // Everything else gets a vtable, exactly like an ordinary array.
+        column->type = static_cast<uint32_t>(raw_type::null);
+        column->width = 0;
+        auto* entry = reinterpret_cast<array_entry*>(DART_FROM_THIS_MUT + offset);
+        offset += num_rows * sizeof(array_entry);
+        for (size_t i = 0; i < num_rows; ++i) {
+          auto const& val = load(i);
+          auto const type = val.get_raw_type(opts);
+          auto* unaligned = DART_FROM_THIS_MUT + offset;
+          auto* aligned = detail::align_pointer<RefCount>(unaligned, type);
+          offset += aligned - unaligned;
+          new(entry++) array_entry(type, static_cast<uint32_t>(offset));
+          offset += val.layout(aligned, opts, type);
+          dependent = dependent || detail::is_dependent<RefCount>({type, aligned});
+        }
+      }
+
+      // Record batches can't be compared via memcmp against the arrays they were built from.
+      bytes = static_cast<uint32_t>(pad_bytes<RefCount>(offset, raw_type::array));
+      elems |= aggregate_extended_flag | aggregate_noncanonical_flag;
+      if (dependent) elems |= aggregate_dependent_flag;
+    }
+
+    template <template <class> class RefCount>
+    template <class Loader>
+    gsl::byte* array<RefCount>::write_run(gsl::byte* data, size_t count, raw_type type, Loader&& load) noexcept {
+      auto const width = alignment_of<RefCount>(type);
+      for (size_t i = 0; i < count; ++i) {
+        auto const& elem = load(i);
+        switch (type) {
+          case raw_type::short_integer:
+            new(data) primitive<int16_t>(static_cast<int16_t>(elem.integer()));
+            break;
+          case raw_type::integer:
+            new(data) primitive<int32_t>(static_cast<int32_t>(elem.integer()));
+            break;
+          case raw_type::long_integer:
+            new(data) primitive<int64_t>(elem.integer());
+            break;
+          case raw_type::decimal:
+            new(data) primitive<float>(static_cast<float>(elem.decimal()));
+            break;
+          case raw_type::long_decimal:
+            new(data) primitive<double>(elem.decimal());
+            break;
+          default:
+            DART_ASSERT(type == raw_type::boolean);
+            new(data) primitive<bool>(elem.boolean());
+            break;
+        }
+        data += width;
+      }
+      return data;
+    }
+
+// Unfortunately some versions of GCC and MSVC aren't smart enough to figure
+// out that if this function is declared noexcept the throwing cases are dead code
+#if DART_USING_GCC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wterminate"
+#elif DART_USING_MSVC
+#pragma warning(push)
+#pragma warning(disable: 4297)
+#endif
+
+    template <template <class> class RefCount>
+    template <bool silent>
+    bool array<RefCount>::valid_batch(size_t bytes) const noexcept(silent) {
+      auto const num_rows = size();
+      auto const in_bounds = [&] (gsl::byte const* ptr, size_t len) {
+        return ptr >= DART_FROM_THIS && static_cast<size_t>(ptr - DART_FROM_THIS) + len <= bytes;
+      };
+
+      // Every handle has to refer to itself, or rows won't be able to find their batch.
+      auto const width = packed_header()->width.get();
+      if (width != sizeof(little_order<uint32_t>)) {
+        if (silent) return false;
+        else throw validation_error("Serialized record batch handle width is inconsistent");
+      } else if (!in_bounds(packed_data(), num_rows * width + sizeof(record_batch_layout))) {
+        if (silent) return false;
+        else throw validation_error("Serialized record batch handles are out of bounds");
+      }
+      for (size_t i = 0; i < num_rows; ++i) {
+        auto const* handle = packed_data() + i * width;
+        auto const* self = shim::launder(reinterpret_cast<little_order<uint32_t> const*>(handle));
+        if (self->get() != static_cast<size_t>(handle - DART_FROM_THIS)) {
+          if (silent) return false;
+          else throw validation_error("Serialized record batch handle is inconsistent");
+        }
+      }
+
+      // Lookups binary search the shared keys, so they must be valid, and sorted.
+      auto const num_keys = batch_size();
+      if (!in_bounds(reinterpret_cast<gsl::byte const*>(batch_keys()), num_keys * sizeof(record_key_entry))) {
+        if (silent) return false;
+        else throw validation_error("Serialized record batch key table is out of bounds");
+      }
+      shim::optional<shim::string_view> prev;
+      dart_comparator<RefCount> comp;
+      for (size_t i = 0; i < num_keys; ++i) {
+        auto const& entry = batch_keys()[i];
+        auto const key_offset = entry.key.get();
+        if (key_offset >= bytes) {
+          if (silent) return false;
+          else throw validation_error("Serialized record batch key offset is out of bounds");
+        }
+        auto const raw_key = batch_key(i);
+        if (align_pointer<RefCount>(raw_key.buffer, raw_key.type) != raw_key.buffer) {
+          if (silent) return false;
+          else throw validation_error("Serialized record batch key offset does not meet alignment requirements");
+        } else if (!valid_buffer<silent, RefCount>(raw_key, bytes - key_offset)) {
+          return false;
+        }
+
+        auto const curr = get_string(raw_key)->get_strv();
+        if (prev && !comp(*prev, curr)) {
+          if (silent) return false;
+          else throw validation_error("Serialized record batch keys are out of order");
+        }
+        prev = curr;
+
+        // Validate the column, which is either a packed run, or a vtable.
+        auto const column_offset = entry.column.get();
+        auto const* column_base = DART_FROM_THIS + column_offset;
+        if (column_offset >= bytes || !in_bounds(column_base, sizeof(packed_array_layout))) {
+          if (silent) return false;
+          else throw validation_error("Serialized record batch column is out of bounds");
+        } else if (align_pointer<RefCount>(column_base, raw_type::array) != column_base) {
+          if (silent) return false;
+          else throw validation_error("Serialized record batch column does not meet alignment requirements");
+        }
+
+        auto const* column = shim::launder(reinterpret_cast<packed_array_layout const*>(column_base));
+        auto const* data = column_base + sizeof(packed_array_layout);
+        auto const column_width = column->width.get();
+        if (column_width) {
+          auto const column_type = static_cast<raw_type>(column->type.get());
+          auto const kind = valid_type(column_type) ? simplify_type(column_type) : type::null;
+          auto const packable = kind == type::integer || kind == type::decimal || kind == type::boolean;
+          if (!packable || column_width != alignment_of<RefCount>(column_type)) {
+            if (silent) return false;
+            else throw validation_error("Serialized record batch column uses an encoding of no known type");
+          } else if (!in_bounds(data, num_rows * column_width)) {
+            if (silent) return false;
+            else throw validation_error("Serialized record batch column values are out of bounds");
+          } else if (!valid_packed(data, column_type, num_rows)) {
+            if (silent) return false;
+            else throw validation_error("Serialized record batch column value is out of range");
+          }
+          continue;
+        }
+
+        if (!in_bounds(data, num_rows * sizeof(array_entry))) {
+          if (silent) return false;
+          else throw validation_error("Serialized record batch column vtable is out of bounds");
+        }
+        for (size_t row = 0; row < num_rows; ++row) {
+          auto const& meta = reinterpret_cast<array_entry const*>(data)[row];
+          if (!valid_type(meta.get_type())) {
+            if (silent) return false;
+            else throw validation_error("Serialized record batch value is of no known type");
+          }
+
+          auto const val_offset = meta.get_offset();
+          raw_element raw_val {meta.get_type(), DART_FROM_THIS + val_offset};
+          if (val_offset > bytes) {
+            if (silent) return false;
+            else throw validation_error("Serialized record batch value offset is out of bounds");
+          } else if (raw_val.type == raw_type::null) {
+            // Nulls take up no space, so they share their offset with whatever follows them.
+            continue;
+          } else if (val_offset == bytes) {
+            if (silent) return false;
+            else throw validation_error("Serialized record batch value offset is out of bounds");
+          } else if (align_pointer<RefCount>(raw_val.buffer, raw_val.type) != raw_val.buffer) {
+            if (silent) return false;
+            else throw validation_error("Serialized record batch value offset does not meet alignment requirements");
+          } else if (!valid_buffer<silent, RefCount>(raw_val, bytes - val_offset)) {
+            return false;
+          }
+        }
+      }
+      return true;
+    }
+
+#if DART_USING_GCC
+#pragma GCC diagnostic pop
+#elif DART_USING_MSVC
+#pragma warning(pop)
+#endif
+
+    template <template <class> class RefCount>
+    bool array<RefCount>::valid_packed(gsl::byte const* data, raw_type type, size_t count) noexcept {
+      // Every bit pattern is a valid number, but packed booleans are read straight out
+      // of the buffer as bools, so anything other than a zero or a one would be UB.
+      if (type != raw_type::boolean) return true;
+      return std::all_of(data, data + count, [] (auto byte) { return static_cast<uint8_t>(byte) <= 1; });
+    }
+
+    template <template <class> class RefCount>
+    record_batch_layout const* array<RefCount>::batch_header() const noexcept {
+      auto const* base = packed_data() + size() * sizeof(little_order<uint32_t>);
+      return shim::launder(reinterpret_cast<record_batch_layout const*>(base));
+    }
+
+    template <template <class> class RefCount>
+    record_key_entry const* array<RefCount>::batch_keys() const noexcept {
+      return shim::launder(reinterpret_cast<record_key_entry const*>(batch_header() + 1));
+    }
+
+    template <template <class> class RefCount>
+    size_t array<RefCount>::batch_size() const noexcept {
+      return batch_header()->keys;
+    }
+
+    template <template <class> class RefCount>
+    auto array<RefCount>::batch_key(size_t key_idx) const noexcept -> raw_element {
+      return {raw_type::string, DART_FROM_THIS + batch_keys()[key_idx].key.get()};
+    }
+
+    template <template <class> class RefCount>
+    auto array<RefCount>::batch_value(size_t key_idx, size_t row) const noexcept -> raw_element {
+      auto const* base = DART_FROM_THIS + batch_keys()[key_idx].column.get();
+      auto const* column = shim::launder(reinterpret_cast<packed_array_layout const*>(base));
+      auto const* data = base + sizeof(packed_array_layout);
+
+      // Packed columns are laid out exactly like packed arrays.
+      if (auto const width = column->width.get()) {
+        return {static_cast<raw_type>(column->type.get()), data + row * width};
+      }
+
+      auto const& meta = reinterpret_cast<array_entry const*>(data)[row];
+      if (meta.get_type() == raw_type::null) return {raw_type::null, nullptr};
+      return {meta.get_type(), DART_FROM_THIS + meta.get_offset()};
+    }
+
+    template <template <class> class RefCount>
+    ssize_t array<RefCount>::find_batch_key(shim::string_view const key) const noexcept {
+      // Keys are sorted in the same order as the vtable of an object.
+      dart_comparator<RefCount> comp;
+      size_t low = 0, high = batch_size();
+      while (low < high) {
+        auto const mid = low + (high - low) / 2;
+        auto const curr = get_string(batch_key(mid))->get_strv();
+        if (comp(curr, key)) low = mid + 1;
+        else if (comp(key, curr)) high = mid;
+        else return static_cast<ssize_t>(mid);
+      }
+      return -1;
+    }
+
+    template <template <class> class RefCount>
+    packed_array_layout const* array<RefCount>::packed_header() const noexcept {
+      return shim::launder(reinterpret_cast<packed_array_layout const*>(raw_vtable()));
+    }
+
     template <template <class> class RefCount>
     array_entry* array<RefCount>::vtable() noexcept {
       auto* base = DART_FROM_THIS_MUT + sizeof(bytes) + sizeof(elems);
@@ -245,10 +245,55 @@ namespace dart {
     return detail::values_impl(*this);
   }
 
+  template <template <class> class RefCount>
+  template <class T>
+  gsl::span<T const> basic_buffer<RefCount>::as_span() const {
+    static_assert(detail::packed_raw_type<T>::value != detail::raw_type::null,
+        "dart::buffer::as_span only supports int16_t, int32_t, int64_t, float, double, and bool");
+
+    // Small and large arrays are never packed.
+    if (raw.type == detail::raw_type::small_array || raw.type == detail::raw_type::large_array) {
+      throw type_error("dart::buffer is not a packed array of the requested type");
+    }
+    auto const* arr = detail::get_array<RefCount>(raw);
+    if (!arr->is_packed() || arr->packed_type() != detail::packed_raw_type<T>::value) {
+      throw type_error("dart::buffer is not a packed array of the requested type");
+    } else if (DART_BYTE_ORDER != DART_LITTLE_ENDIAN) {
+      throw type_error("dart::buffer cannot expose packed little endian values on this host");
+    }
+    return gsl::make_span(reinterpret_cast<T const*>(arr->packed_data()), arr->size());
+  }
+
+  template <template <class> class RefCount>
+  template <class T>
+  gsl::span<T const> basic_buffer<RefCount>::column_span(shim::string_view key) const {
+    static_assert(detail::packed_raw_type<T>::value != detail::raw_type::null,
+        "dart::buffer::column_span only supports int16_t, int32_t, int64_t, float, double, and bool");
+
+    auto const unpacked = raw.type == detail::raw_type::small_array || raw.type == detail::raw_type::large_array;
+    auto const* arr = unpacked ? nullptr : detail::get_array<RefCount>(raw);
+    auto const* column = (arr && arr->is_record_batch()) ? arr->batch_column(key) : nullptr;
+    if (!column || column->type != static_cast<uint32_t>(detail::packed_raw_type<T>::value) || !column->width) {
+      throw type_error("dart::buffer is not a record batch with a packed column of the requested type");
+    } else if (DART_BYTE_ORDER != DART_LITTLE_ENDIAN) {
+      throw type_error("dart::buffer cannot expose packed little endian values on this host");
+    }
+    auto const* data = reinterpret_cast<gsl::byte const*>(column + 1);
+    return gsl::make_span(reinterpret_cast<T const*>(data), arr->size());
+  }
+
   template <template <class> class RefCount>
   gsl::span<gsl::byte const> basic_buffer<RefCount>::get_bytes() const {
     if (!is_object()) throw type_error("dart::buffer is not an object and cannot return a network buffer");
-    auto len = detail::find_sizeof<RefCount>({detail::raw_type::object, raw.buffer});
+    else if (raw.type == detail::raw_type::record) {
+      throw type_error("dart::buffer is a row of a record batch, and has no network buffer of its own");
+    } else if (raw.type == detail::raw_type::small_object) {
+      throw type_error("dart::buffer is a small object, and has no network buffer of its own");
+    } else if (detail::is_dependent<RefCount>(raw)) {
+      throw type_error("dart::buffer refers to the key dictionary of an enclosing buffer, "
+          "and has no network buffer of its own");
+    }
+    auto len = detail::find_sizeof<RefCount>(raw);
     return gsl::make_span(raw.buffer, len);
   }
 
@@ -260,7 +305,7 @@ namespace dart {
     buffer_ref.share(bytes);
 
     // Return the size of the packet.
-    return detail::find_sizeof<RefCount>({detail::raw_type::object, buffer_ref.get()});
+    return detail::find_sizeof<RefCount>({detail::identify_root(buffer_ref.get()), buffer_ref.get()});
   }
 
   template <template <class> class RefCount>
@@ -401,7 +446,7 @@ namespace dart {
 
   template <template <class> class RefCount>
   auto basic_buffer<RefCount>::key_begin() const -> iterator {
-    return iterator(*this, detail::get_object<RefCount>(raw)->key_begin());
+    return iterator(*this, detail::object_deref<RefCount>([] (auto& obj) { return obj.key_begin(); }, raw));
   }
 
   template <template <class> class RefCount>
@@ -411,7 +456,7 @@ namespace dart {
 
   template <template <class> class RefCount>
   auto basic_buffer<RefCount>::key_end() const -> iterator {
-    return iterator(*this, detail::get_object<RefCount>(raw)->key_end());
+    return iterator(*this, detail::object_deref<RefCount>([] (auto& obj) { return obj.key_end(); }, raw));
   }
 
   template <template <class> class RefCount>
@@ -46,12 +46,12 @@ namespace dart {
 
   template <template <class> class RefCount>
   basic_buffer<RefCount> basic_buffer<RefCount>::get(size_type index) const& {
-    return basic_buffer(detail::get_array<RefCount>(raw)->get_elem(index), buffer_ref);
+    return basic_buffer(detail::array_deref<RefCount>([&] (auto& arr) { return arr.get_elem(index); }, raw), buffer_ref);
   }
 
   template <template <class> class RefCount>
   basic_buffer<RefCount>&& basic_buffer<RefCount>::get(size_type index) && {
-    raw = detail::get_array<RefCount>(raw)->get_elem(index);
+    raw = detail::array_deref<RefCount>([&] (auto& arr) { return arr.get_elem(index); }, raw);
     if (is_null()) buffer_ref = nullptr;
     return std::move(*this);
   }
@@ -70,13 +70,13 @@ namespace dart {
 
   template <template <class> class RefCount>
   basic_buffer<RefCount> basic_buffer<RefCount>::at(size_type index) const& {
-    return basic_buffer(detail::get_array<RefCount>(raw)->at_elem(index), buffer_ref);
+    return basic_buffer(detail::array_deref<RefCount>([&] (auto& arr) { return arr.at_elem(index); }, raw), buffer_ref);
   }
 
   template <template <class> class RefCount>
   template <bool enabled, class EnableIf>
   basic_buffer<RefCount>&& basic_buffer<RefCount>::at(size_type index) && {
-    raw = detail::get_array<RefCount>(raw)->at_elem(index);
+    raw = detail::array_deref<RefCount>([&] (auto& arr) { return arr.at_elem(index); }, raw);
     if (is_null()) buffer_ref = nullptr;
     return std::move(*this);
   }
@@ -109,34 +109,34 @@ namespace dart {
 
   template <template <class> class RefCount>
   basic_buffer<RefCount> basic_buffer<RefCount>::front() const& {
-    auto* arr = detail::get_array<RefCount>(raw);
+    auto elem = detail::array_deref<RefCount>([] (auto& arr) { return arr.get_elem(0); }, raw);
     if (empty()) return basic_buffer::make_null();
-    else return basic_buffer(arr->get_elem(0), buffer_ref);
+    else return basic_buffer(elem, buffer_ref);
   }
 
   template <template <class> class RefCount>
   template <bool enabled, class EnableIf>
   basic_buffer<RefCount>&& basic_buffer<RefCount>::front() && {
-    auto* arr = detail::get_array<RefCount>(raw);
+    auto elem = detail::array_deref<RefCount>([] (auto& arr) { return arr.get_elem(0); }, raw);
     if (empty()) raw = {detail::raw_type::null, nullptr};
-    else raw = arr->get_elem(0);
+    else raw = elem;
     if (is_null()) buffer_ref = nullptr;
     return std::move(*this);
   }
 
   template <template <class> class RefCount>
   basic_buffer<RefCount> basic_buffer<RefCount>::back() const& {
-    auto* arr = detail::get_array<RefCount>(raw);
+    auto elem = detail::array_deref<RefCount>([] (auto& arr) { return arr.get_elem(arr.size() - 1); }, raw);
     if (empty()) return basic_buffer::make_null();
-    else return basic_buffer(arr->get_elem(size() - 1), buffer_ref);
+    else return basic_buffer(elem, buffer_ref);
   }
 
   template <template <class> class RefCount>
   template <bool enabled, class EnableIf>
   basic_buffer<RefCount>&& basic_buffer<RefCount>::back() && {
-    auto* arr = detail::get_array<RefCount>(raw);
+    auto elem = detail::array_deref<RefCount>([] (auto& arr) { return arr.get_elem(arr.size() - 1); }, raw);
     if (empty()) raw = {detail::raw_type::null, nullptr};
-    else raw = arr->get_elem(size() - 1);
+    else raw = elem;
     if (is_null()) buffer_ref = nullptr;
     return std::move(*this);
   }
@@ -18,4 +18,7 @@
 #include "string.tcc"
 #include "primitive.tcc"
 
+// Compressed container functions
+#include "compressed.tcc"
+
 #endif
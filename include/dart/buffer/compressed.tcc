@@ -0,0 +1,398 @@
+#ifndef DART_BUFFER_COMPRESSED_H
+#define DART_BUFFER_COMPRESSED_H
+
+/*----- Project Includes -----*/
+
+#include "../common.h"
+
+/*----- Function Implementations -----*/
+
+namespace dart {
+
+  template <template <class> class RefCount>
+  basic_compressed_buffer<RefCount>::basic_compressed_buffer(buffer const& buf, size_type block_size) {
+    // Only whole network buffers can be compressed.
+    if (buf.raw.type != detail::raw_type::object) {
+      throw type_error("dart::compressed_buffer can only compress a finalized object");
+    }
+    auto const raw_bytes = buf.get_bytes();
+    auto const* base = raw_bytes.data();
+    auto const total = static_cast<size_t>(raw_bytes.size());
+    auto const* obj = detail::get_object<RefCount>(buf.raw);
+    auto const count = obj->size();
+    auto const head_len = count ? obj->field_offset(0) : total;
+    if (!block_size) block_size = 1;
+
+    // Group the fields into blocks of at least the requested size.
+    std::vector<std::pair<size_t, size_t>> ranges;
+    std::vector<uint32_t> field_blocks(count);
+    for (size_t i = 0, begin = head_len; i < count; ++i) {
+      field_blocks[i] = static_cast<uint32_t>(ranges.size());
+      auto const end = i + 1 < count ? obj->field_offset(i + 1) : total;
+      if (end - begin >= block_size || i + 1 == count) {
+        ranges.emplace_back(begin, end);
+        begin = end;
+      }
+    }
+
+    // Compress each block independently.
+    size_t largest = 0, keys_len = 0;
+    for (auto const& range : ranges) largest = std::max(largest, range.second - range.first);
+    std::vector<gsl::byte> scratch(detail::lz::bound(largest));
+    std::vector<gsl::byte> data;
+    std::vector<std::pair<size_t, size_t>> packed;
+    for (auto const& range : ranges) {
+      auto const written = detail::lz::compress(gsl::make_span(base + range.first, range.second - range.first), scratch.data());
+      packed.emplace_back(data.size(), written);
+      data.insert(data.end(), scratch.begin(), scratch.begin() + written);
+    }
+    for (size_t i = 0; i < count; ++i) {
+      keys_len += detail::get_string(detail::object<RefCount>::load_key(base, i))->size();
+    }
+
+    // Work out where every section goes.
+    auto const fields_off = sizeof(detail::compressed_layout);
+    auto const blocks_off = fields_off + count * sizeof(detail::compressed_field);
+    auto const head_off = detail::pad_bytes<RefCount>(blocks_off
+        + ranges.size() * sizeof(detail::compressed_block), detail::raw_type::object);
+    auto const keys_off = head_off + head_len;
+    auto const data_off = keys_off + keys_len;
+    auto const bytes_len = data_off + data.size();
+    if (bytes_len > std::numeric_limits<uint32_t>::max()) {
+      throw std::length_error("dart::compressed_buffer is too large to encode");
+    }
+
+    // Write everything out.
+    auto owner = detail::aligned_alloc<RefCount>(bytes_len, detail::raw_type::object, [&] (auto* out) {
+      auto* hdr = new(out) detail::compressed_layout;
+      hdr->magic = detail::compressed_layout::magic_number;
+      hdr->bytes = static_cast<uint32_t>(total);
+      hdr->head = static_cast<uint32_t>(head_len);
+      hdr->fields = static_cast<uint32_t>(count);
+      hdr->blocks = static_cast<uint32_t>(ranges.size());
+      hdr->keys = static_cast<uint32_t>(keys_len);
+
+      auto key_off = keys_off;
+      for (size_t i = 0; i < count; ++i) {
+        auto const key = detail::get_string(detail::object<RefCount>::load_key(base, i))->get_strv();
+        auto const val = detail::object<RefCount>::load_value(base, i);
+        auto* field = new(out + fields_off + i * sizeof(detail::compressed_field)) detail::compressed_field;
+        field->key = static_cast<uint32_t>(key_off);
+        field->key_len = static_cast<uint32_t>(key.size());
+        field->value = static_cast<uint32_t>(val.buffer ? val.buffer - base : 0);
+        field->block = field_blocks[i];
+        field->type = static_cast<uint16_t>(val.type);
+        field->flags = detail::is_dependent<RefCount>(val) ? detail::compressed_field::dependent_flag : 0;
+        std::copy(key.begin(), key.end(), reinterpret_cast<char*>(out + key_off));
+        key_off += key.size();
+      }
+      for (size_t i = 0; i < ranges.size(); ++i) {
+        auto* block = new(out + blocks_off + i * sizeof(detail::compressed_block)) detail::compressed_block;
+        block->offset = static_cast<uint32_t>(ranges[i].first);
+        block->bytes = static_cast<uint32_t>(ranges[i].second - ranges[i].first);
+        block->data = static_cast<uint32_t>(data_off + packed[i].first);
+        block->len = static_cast<uint32_t>(packed[i].second);
+      }
+      std::fill(out + blocks_off + ranges.size() * sizeof(detail::compressed_block), out + head_off, gsl::byte {});
+      std::copy(base, base + head_len, out + head_off);
+      std::copy(data.begin(), data.end(), out + data_off);
+    });
+    adopt(buffer_ref_type {std::move(owner)}, bytes_len);
+    cache->blocks.resize(ranges.size());
+  }
+
+  template <template <class> class RefCount>
+  basic_compressed_buffer<RefCount>::basic_compressed_buffer(gsl::span<gsl::byte const> in) {
+    auto& msg = "dart::compressed_buffer bytes are malformed";
+    auto const in_len = static_cast<size_t>(in.size());
+    if (in_len < sizeof(detail::compressed_layout)) throw validation_error(msg);
+    auto owner = detail::aligned_alloc<RefCount>(in_len, detail::raw_type::object, [&] (auto* out) {
+      std::copy(std::begin(in), std::end(in), out);
+    });
+    adopt(buffer_ref_type {std::move(owner)}, in_len);
+
+    // Check that every section lands within the bytes we were given, before sizing
+    // anything off of the header, so a bogus block count can't ask for an absurd cache.
+    auto const* hdr = header();
+    size_t const total = hdr->bytes, head_len = hdr->head, count = hdr->fields, nblocks = hdr->blocks;
+    auto const blocks_off = sizeof(detail::compressed_layout) + count * sizeof(detail::compressed_field);
+    auto const head_off = detail::pad_bytes<RefCount>(blocks_off
+        + nblocks * sizeof(detail::compressed_block), detail::raw_type::object);
+    auto const keys_off = head_off + head_len;
+    auto const data_off = keys_off + hdr->keys;
+    if (hdr->magic != detail::compressed_layout::magic_number) throw validation_error(msg);
+    else if (data_off > len || head_len > total) throw validation_error(msg);
+    else if (head_len < sizeof(detail::object<RefCount>)) throw validation_error(msg);
+    else if (count && !nblocks) throw validation_error(msg);
+    cache->blocks.resize(nblocks);
+
+    // Blocks have to cover the rest of the buffer, in order.
+    size_t next = head_len;
+    for (size_t i = 0; i < nblocks; ++i) {
+      auto const& block = blocks()[i];
+      if (block.offset != next || block.data < data_off) throw validation_error(msg);
+      else if (size_t {block.data} + block.len > len) throw validation_error(msg);
+      next += block.bytes;
+    }
+    if (next != total) throw validation_error(msg);
+
+    // Keys have to land in the key section, and values in the head or their own block.
+    // Fields are in vtable order, so their blocks can never go backwards.
+    for (size_t i = 0; i < count; ++i) {
+      auto const& field = fields()[i];
+      auto const type = static_cast<detail::raw_type>(field.type.get());
+      if (field.key < keys_off || size_t {field.key} + field.key_len > data_off) throw validation_error(msg);
+      else if (field.block >= nblocks || field.type.get() > std::numeric_limits<uint8_t>::max()) {
+        throw validation_error(msg);
+      } else if (i && field.block < fields()[i - 1].block) {
+        throw validation_error(msg);
+      } else if (type == detail::raw_type::null) {
+        continue;
+      } else if (!detail::valid_type(type)) {
+        throw validation_error(msg);
+      }
+
+      auto const& block = blocks()[field.block];
+      auto const in_head = field.value < head_len;
+      auto const in_block = field.value >= block.offset && field.value < size_t {block.offset} + block.bytes;
+      if (!in_head && !in_block) throw validation_error(msg);
+    }
+
+    // Values in the head are handed out without decompressing anything, so the head itself,
+    // and every value stored within it, has to be sound.
+    auto const* obj = detail::get_object<RefCount>({detail::raw_type::object, head()});
+    if (obj->get_sizeof() != total || !obj->template is_valid_layout<true>(head_len)) {
+      throw std::invalid_argument("dart::compressed_buffer head is malformed");
+    }
+    for (size_t i = 0; i < count; ++i) {
+      auto const& field = fields()[i];
+      auto const type = static_cast<detail::raw_type>(field.type.get());
+      if (type == detail::raw_type::null || field.value >= head_len) continue;
+      else if (!valid_value({type, head() + field.value}, head_len - field.value)) {
+        throw std::invalid_argument("dart::compressed_buffer head holds a malformed value");
+      }
+    }
+  }
+
+  template <template <class> class RefCount>
+  auto basic_compressed_buffer<RefCount>::operator [](shim::string_view key) const -> buffer {
+    return get(key);
+  }
+
+  template <template <class> class RefCount>
+  auto basic_compressed_buffer<RefCount>::get(shim::string_view key) const -> buffer {
+    auto const idx = find_field(key);
+    if (idx < 0) return buffer::make_null();
+
+    // Null takes up no space, and values stored alongside the vtable live in the head,
+    // which is never compressed.
+    auto const& field = fields()[idx];
+    auto const type = static_cast<detail::raw_type>(field.type.get());
+    auto const value = field.value.get();
+    if (type == detail::raw_type::null) return buffer::make_null();
+    else if (value < header()->head) return buffer({type, head() + value}, bytes);
+
+    // Values that refer to a key dictionary can only be read out of the whole buffer.
+    if (field.flags & detail::compressed_field::dependent_flag) {
+      auto whole = load_whole();
+      auto const* ptr = whole.get() + value;
+      return buffer({type, ptr}, std::move(whole));
+    }
+
+    // Everything else can be read straight out of its block, which keeps the alignment
+    // it had in the original buffer.
+    auto const& block = blocks()[field.block];
+    auto ref = load_block(field.block);
+    auto const* ptr = ref.get() + (block.offset % detail::object<RefCount>::alignment) + (value - block.offset);
+    return buffer({type, ptr}, std::move(ref));
+  }
+
+  template <template <class> class RefCount>
+  bool basic_compressed_buffer<RefCount>::has_key(shim::string_view key) const noexcept {
+    return find_field(key) >= 0;
+  }
+
+  template <template <class> class RefCount>
+  std::vector<shim::string_view> basic_compressed_buffer<RefCount>::keys() const {
+    std::vector<shim::string_view> keys;
+    keys.reserve(size());
+    for (size_type i = 0; i < size(); ++i) keys.push_back(key_at(i));
+    return keys;
+  }
+
+  template <template <class> class RefCount>
+  auto basic_compressed_buffer<RefCount>::decompress() const -> buffer {
+    auto owner = detail::aligned_alloc<RefCount>(decompressed_size(),
+        detail::raw_type::object, [this] (auto* out) { decompress_into(out); });
+    auto const* ptr = owner.get();
+    return buffer({detail::raw_type::object, ptr}, buffer_ref_type {std::move(owner)});
+  }
+
+  template <template <class> class RefCount>
+  void basic_compressed_buffer<RefCount>::evict() const {
+    std::lock_guard<std::mutex> guard {cache->lock};
+    for (auto& block : cache->blocks) block = nullptr;
+    cache->whole = nullptr;
+    cache->bytes = 0;
+  }
+
+  template <template <class> class RefCount>
+  auto basic_compressed_buffer<RefCount>::size() const noexcept -> size_type {
+    return header()->fields;
+  }
+
+  template <template <class> class RefCount>
+  auto basic_compressed_buffer<RefCount>::decompressed_size() const noexcept -> size_type {
+    return header()->bytes;
+  }
+
+  template <template <class> class RefCount>
+  auto basic_compressed_buffer<RefCount>::resident_bytes() const -> size_type {
+    std::lock_guard<std::mutex> guard {cache->lock};
+    return len + cache->bytes;
+  }
+
+  template <template <class> class RefCount>
+  gsl::span<gsl::byte const> basic_compressed_buffer<RefCount>::get_bytes() const noexcept {
+    return gsl::make_span(bytes.get(), len);
+  }
+
+  template <template <class> class RefCount>
+  void basic_compressed_buffer<RefCount>::adopt(buffer_ref_type ref, size_type ref_len) {
+    bytes = std::move(ref);
+    len = ref_len;
+    cache = std::make_shared<block_cache>();
+  }
+
+  template <template <class> class RefCount>
+  ssize_t basic_compressed_buffer<RefCount>::find_field(shim::string_view key) const noexcept {
+    // Fields are in vtable order, which sorts keys by length, and then lexicographically.
+    size_type low = 0, high = size();
+    detail::dart_comparator<RefCount> comp;
+    while (low < high) {
+      auto const mid = low + (high - low) / 2;
+      if (comp(key_at(mid), key)) low = mid + 1;
+      else high = mid;
+    }
+    if (low < size() && key_at(low) == key) return low;
+    else return -1;
+  }
+
+  template <template <class> class RefCount>
+  shim::string_view basic_compressed_buffer<RefCount>::key_at(size_type idx) const noexcept {
+    auto const& field = fields()[idx];
+    return {reinterpret_cast<char const*>(bytes.get() + field.key), field.key_len};
+  }
+
+  template <template <class> class RefCount>
+  auto basic_compressed_buffer<RefCount>::load_block(size_type idx) const -> buffer_ref_type {
+    {
+      std::lock_guard<std::mutex> guard {cache->lock};
+      if (cache->blocks[idx]) return cache->blocks[idx];
+    }
+
+    // Decompress outside of the lock, so that lookups into other blocks don't have to wait,
+    // and keep the block at the same offset from an eight byte boundary as in the original.
+    auto const& block = blocks()[idx];
+    auto const pad = block.offset % detail::object<RefCount>::alignment;
+    auto owner = detail::aligned_alloc<RefCount>(pad + block.bytes, detail::raw_type::object, [&] (auto* out) {
+      auto const in = gsl::make_span(bytes.get() + block.data, block.len);
+      if (!detail::lz::decompress(in, gsl::make_span(out + pad, block.bytes))) {
+        throw validation_error("dart::compressed_buffer block failed to decompress");
+      }
+    });
+
+    // Values are handed out of the block as is, so check every one that can be checked
+    // on its own. Values that refer to a key dictionary are only ever read out of the whole buffer.
+    auto const* begin = fields(), *end = fields() + size();
+    auto const* first = std::lower_bound(begin, end, idx,
+        [] (auto const& field, auto target) { return field.block < target; });
+    for (auto const* field = first; field != end && field->block == idx; ++field) {
+      auto const type = static_cast<detail::raw_type>(field->type.get());
+      auto const value = field->value.get();
+      if (type == detail::raw_type::null || value < header()->head) continue;
+      else if (field->flags & detail::compressed_field::dependent_flag) continue;
+
+      auto const* ptr = owner.get() + pad + (value - block.offset);
+      if (!valid_value({type, ptr}, size_t {block.offset} + block.bytes - value)) {
+        throw std::invalid_argument("dart::compressed_buffer block holds a malformed value");
+      }
+    }
+
+    // Somebody else may have beaten us to it.
+    std::lock_guard<std::mutex> guard {cache->lock};
+    auto& slot = cache->blocks[idx];
+    if (!slot) {
+      slot = buffer_ref_type {std::move(owner)};
+      cache->bytes += pad + block.bytes;
+    }
+    return slot;
+  }
+
+  template <template <class> class RefCount>
+  auto basic_compressed_buffer<RefCount>::load_whole() const -> buffer_ref_type {
+    {
+      std::lock_guard<std::mutex> guard {cache->lock};
+      if (cache->whole) return cache->whole;
+    }
+
+    auto owner = detail::aligned_alloc<RefCount>(decompressed_size(),
+        detail::raw_type::object, [this] (auto* out) { decompress_into(out); });
+
+    std::lock_guard<std::mutex> guard {cache->lock};
+    if (!cache->whole) {
+      cache->whole = buffer_ref_type {std::move(owner)};
+      cache->bytes += decompressed_size();
+    }
+    return cache->whole;
+  }
+
+  template <template <class> class RefCount>
+  void basic_compressed_buffer<RefCount>::decompress_into(gsl::byte* out) const {
+    std::copy(head(), head() + header()->head, out);
+    for (size_type i = 0; i < header()->blocks; ++i) {
+      auto const& block = blocks()[i];
+      auto const in = gsl::make_span(bytes.get() + block.data, block.len);
+      if (!detail::lz::decompress(in, gsl::make_span(out + block.offset, block.bytes))) {
+        throw validation_error("dart::compressed_buffer block failed to decompress");
+      }
+    }
+
+    // The whole buffer is handed out as is.
+    if (!detail::valid_buffer<true, RefCount>({detail::raw_type::object, out}, decompressed_size())) {
+      throw std::invalid_argument("dart::compressed_buffer decompressed to a malformed object");
+    }
+  }
+
+  template <template <class> class RefCount>
+  bool basic_compressed_buffer<RefCount>::valid_value(detail::raw_element val, size_t bytes) noexcept {
+    if (detail::align_pointer<RefCount>(val.buffer, val.type) != val.buffer) return false;
+    return detail::valid_buffer<true, RefCount>(val, bytes);
+  }
+
+  template <template <class> class RefCount>
+  detail::compressed_layout const* basic_compressed_buffer<RefCount>::header() const noexcept {
+    return shim::launder(reinterpret_cast<detail::compressed_layout const*>(bytes.get()));
+  }
+
+  template <template <class> class RefCount>
+  detail::compressed_field const* basic_compressed_buffer<RefCount>::fields() const noexcept {
+    auto* base = bytes.get() + sizeof(detail::compressed_layout);
+    return shim::launder(reinterpret_cast<detail::compressed_field const*>(base));
+  }
+
+  template <template <class> class RefCount>
+  detail::compressed_block const* basic_compressed_buffer<RefCount>::blocks() const noexcept {
+    auto* base = reinterpret_cast<gsl::byte const*>(fields() + size());
+    return shim::launder(reinterpret_cast<detail::compressed_block const*>(base));
+  }
+
+  template <template <class> class RefCount>
+  gsl::byte const* basic_compressed_buffer<RefCount>::head() const noexcept {
+    auto* end = reinterpret_cast<gsl::byte const*>(blocks() + header()->blocks);
+    return detail::align_pointer<RefCount>(end, detail::raw_type::object);
+  }
+
+}
+
+#endif
@@ -28,6 +28,20 @@ namespace dart {
     return buffer_ref_type {std::move(owner)};
   }
 
+  template <template <class> class RefCount>
+  template <class Release>
+  auto basic_buffer<RefCount>::adopt_pointer(gsl::span<gsl::byte const> buffer,
+      Release&& release) const -> buffer_ref_type
+  {
+    if (buffer.empty()) throw std::invalid_argument("dart::packet buffer must not be empty");
+    else if (detail::align_pointer<RefCount>(buffer.data(), detail::raw_type::object) != buffer.data()) {
+      throw std::invalid_argument("dart::packet pointer must be aligned to a 64-bit word boundary");
+    }
+
+    // Nothing left that can reject the buffer, take ownership.
+    return buffer_ref_type(buffer.data(), std::forward<Release>(release));
+  }
+
   template <template <class> class RefCount>
   template <class Pointer>
   Pointer&& basic_buffer<RefCount>::validate_pointer(Pointer&& ptr) const {
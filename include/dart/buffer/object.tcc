@@ -115,6 +115,17 @@ namespace dart {
     return std::move(*this).get(key);
   }
 
+  template <template <class> class RefCount>
+  basic_buffer<RefCount> basic_buffer<RefCount>::operator [](key const& handle) const& {
+    return get(handle);
+  }
+
+  template <template <class> class RefCount>
+  template <bool enabled, class EnableIf>
+  basic_buffer<RefCount>&& basic_buffer<RefCount>::operator [](key const& handle) && {
+    return std::move(*this).get(handle);
+  }
+
   template <template <class> class RefCount>
   template <class String>
   basic_buffer<RefCount> basic_buffer<RefCount>::get(basic_string<String> const& key) const& {
@@ -129,22 +140,108 @@ namespace dart {
 
   template <template <class> class RefCount>
   basic_buffer<RefCount> basic_buffer<RefCount>::get(shim::string_view key) const& {
-    return basic_buffer(detail::get_object<RefCount>(raw)->get_value(key), buffer_ref);
+    auto val = detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_value(key); }, raw);
+    return basic_buffer(val, buffer_ref);
   }
 
   template <template <class> class RefCount>
   template <bool enabled, class EnableIf>
   basic_buffer<RefCount>&& basic_buffer<RefCount>::get(shim::string_view key) && {
-    raw = detail::get_object<RefCount>(raw)->get_value(key);
+    raw = detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_value(key); }, raw);
+    if (is_null()) buffer_ref = nullptr;
+    return std::move(*this);
+  }
+
+  template <template <class> class RefCount>
+  basic_buffer<RefCount> basic_buffer<RefCount>::get(key const& handle) const& {
+    auto val = detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_value(handle); }, raw);
+    return basic_buffer(val, buffer_ref);
+  }
+
+  template <template <class> class RefCount>
+  template <bool enabled, class EnableIf>
+  basic_buffer<RefCount>&& basic_buffer<RefCount>::get(key const& handle) && {
+    raw = detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_value(handle); }, raw);
     if (is_null()) buffer_ref = nullptr;
     return std::move(*this);
   }
 
+  template <template <class> class RefCount>
+  void basic_buffer<RefCount>::get_many(gsl::span<shim::string_view const> keys, gsl::span<basic_buffer> out) const {
+    if (keys.size() != out.size()) {
+      throw std::invalid_argument("dart::buffer::get_many requires exactly one output per key");
+    }
+    detail::object_deref<RefCount>([&] (auto& obj) {
+      obj.get_values(keys, [&] (auto idx, auto val) { out[idx] = basic_buffer(val, buffer_ref); });
+    }, raw);
+  }
+
+  template <template <class> class RefCount>
+  template <bool enabled, class EnableIf>
+  void basic_buffer<RefCount>::get_many(gsl::span<shim::string_view const> keys, gsl::span<view> out) const {
+    view(*this).get_many(keys, out);
+  }
+
+  template <template <class> class RefCount>
+  void basic_buffer<RefCount>::lookup_batch(gsl::span<basic_buffer const> pkts,
+      shim::string_view key, gsl::span<basic_buffer> out)
+  {
+    if (pkts.size() != out.size()) {
+      throw std::invalid_argument("dart::buffer::lookup_batch requires exactly one output per packet");
+    }
+
+    // Check types up front, so nothing is written if the batch is unusable.
+    for (auto const& pkt : pkts) {
+      if (!pkt.is_object()) throw type_error("dart::buffer is not a finalized object and cannot be accessed as such");
+    }
+
+    // Rows of a record batch share their keys, so there's nothing to gain from interleaving them,
+    // and small and large objects use their own encodings, so look those up one at a time.
+    auto const plain = [] (auto const& pkt) { return pkt.raw.type == detail::raw_type::object; };
+    if (std::all_of(std::begin(pkts), std::end(pkts), plain)) {
+      auto load = [&] (size_t idx) { return detail::get_object<RefCount>(pkts[idx].raw); };
+      detail::object<RefCount>::get_values_batch(pkts.size(), load, key, [&] (auto idx, auto val) {
+        out[idx] = basic_buffer(val, pkts[idx].buffer_ref);
+      });
+      return;
+    }
+
+    // Everything else still gets batched, just without the stragglers.
+    std::vector<size_t> batched;
+    batched.reserve(pkts.size());
+    for (auto i = 0U; i < static_cast<size_t>(pkts.size()); ++i) {
+      if (plain(pkts[i])) batched.push_back(i);
+      else out[i] = pkts[i].get(key);
+    }
+    auto load = [&] (size_t idx) { return detail::get_object<RefCount>(pkts[batched[idx]].raw); };
+    detail::object<RefCount>::get_values_batch(batched.size(), load, key, [&] (auto idx, auto val) {
+      out[batched[idx]] = basic_buffer(val, pkts[batched[idx]].buffer_ref);
+    });
+  }
+
   template <template <class> class RefCount>
   basic_buffer<RefCount> basic_buffer<RefCount>::get_nested(shim::string_view path, char separator) const {
     return detail::get_nested_impl(*this, path, separator);
   }
 
+  template <template <class> class RefCount>
+  basic_buffer<RefCount> basic_buffer<RefCount>::get_nested(path const& needle) const {
+    // Walk the network buffer directly, and only take a reference for the result.
+    auto curr = raw;
+    for (auto const& seg : needle) {
+      auto const type = detail::simplify_type(curr.type);
+      if (type == detail::type::object) {
+        curr = detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_value(seg.name); }, curr);
+      } else if (type == detail::type::array && seg.index != path::npos) {
+        curr = detail::array_deref<RefCount>([&] (auto& arr) { return arr.get_elem(seg.index); }, curr);
+      } else {
+        return basic_buffer::make_null();
+      }
+    }
+    if (curr.type == detail::raw_type::null) return basic_buffer::make_null();
+    else return basic_buffer(curr, buffer_ref);
+  }
+
   template <template <class> class RefCount>
   template <class String>
   basic_buffer<RefCount> basic_buffer<RefCount>::at(basic_string<String> const& key) const& {
@@ -159,13 +256,14 @@ namespace dart {
 
   template <template <class> class RefCount>
   basic_buffer<RefCount> basic_buffer<RefCount>::at(shim::string_view key) const& {
-    return basic_buffer(detail::get_object<RefCount>(raw)->at_value(key), buffer_ref);
+    auto val = detail::object_deref<RefCount>([&] (auto& obj) { return obj.at_value(key); }, raw);
+    return basic_buffer(val, buffer_ref);
   }
 
   template <template <class> class RefCount>
   template <bool enabled, class EnableIf>
   basic_buffer<RefCount>&& basic_buffer<RefCount>::at(shim::string_view key) && {
-    raw = detail::get_object<RefCount>(raw)->at_value(key);
+    raw = detail::object_deref<RefCount>([&] (auto& obj) { return obj.at_value(key); }, raw);
     if (is_null()) buffer_ref = nullptr;
     return std::move(*this);
   }
@@ -178,7 +276,7 @@ namespace dart {
 
   template <template <class> class RefCount>
   auto basic_buffer<RefCount>::find(shim::string_view key) const -> iterator {
-    return iterator(*this, detail::get_object<RefCount>(raw)->get_it(key));
+    return iterator(*this, detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_it(key); }, raw));
   }
 
   template <template <class> class RefCount>
@@ -189,7 +287,7 @@ namespace dart {
 
   template <template <class> class RefCount>
   auto basic_buffer<RefCount>::find_key(shim::string_view key) const -> iterator {
-    return iterator(*this, detail::get_object<RefCount>(raw)->get_key_it(key));
+    return iterator(*this, detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_key_it(key); }, raw));
   }
 
   template <template <class> class RefCount>
@@ -205,7 +303,13 @@ namespace dart {
 
   template <template <class> class RefCount>
   bool basic_buffer<RefCount>::has_key(shim::string_view key) const {
-    auto elem = detail::get_object<RefCount>(raw)->get_key(key, [] (auto) {});
+    auto elem = detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_key(key, [] (auto) {}); }, raw);
+    return elem.buffer != nullptr;
+  }
+
+  template <template <class> class RefCount>
+  bool basic_buffer<RefCount>::has_key(key const& handle) const {
+    auto elem = detail::object_deref<RefCount>([&] (auto& obj) { return obj.get_key(handle, [] (auto) {}); }, raw);
     return elem.buffer != nullptr;
   }
 
@@ -14,8 +14,10 @@
 /*----- System Includes -----*/
 
 #include <map>
+#include <atomic>
 #include <vector>
 #include <math.h>
+#include <unordered_map>
 #include <gsl/gsl>
 #include <errno.h>
 #include <cstdlib>
@@ -41,9 +43,17 @@
 #include "meta.h"
 #include "support/ptrs.h"
 #include "support/ordered.h"
+#include "support/lz.h"
+#include "support/thread_pool.h"
+#include "support/json_reader.h"
+#include "support/mapped_file.h"
 
 /*----- System Includes with Compiler Flags -----*/
 
+#if defined(DART_USE_SAJSON) && defined(DART_USE_NATIVE_JSON)
+#error "dart can parse JSON with sajson, or with its built in reader, but not both"
+#endif
+
 // Current version of sajson emits unused parameter
 // warnings on Clang.
 #ifdef DART_USE_SAJSON
@@ -89,6 +99,8 @@ namespace dart {
   class basic_buffer;
   template <template <class> class RefCount>
   class basic_packet;
+  template <template <class> class RefCount>
+  class basic_compressed_buffer;
 
   struct type_error : std::logic_error {
     type_error(char const* msg) : logic_error(msg) {}
@@ -106,6 +118,282 @@ namespace dart {
     validation_error(char const* msg) : runtime_error(msg) {}
   };
 
+  // Thrown when a value read from a stream fails to parse,
+  // and carries where in the stream the value started.
+  struct stream_parse_error : parse_error {
+    stream_parse_error(char const* msg, size_t offset, size_t line) :
+      parse_error(msg),
+      offset(offset),
+      line(line)
+    {}
+    size_t offset;
+    size_t line;
+  };
+
+  // Thrown when a packet won't fit in the memory it's been given,
+  // and carries how much it would have needed.
+  struct size_error : std::length_error {
+    size_error(char const* msg, size_t needed) : length_error(msg), needed(needed) {}
+    size_t needed;
+  };
+
+  /**
+   *  @brief
+   *  Struct controls optional encodings that finalization can
+   *  apply to the objects of a finalized buffer.
+   *
+   *  @details
+   *  Every option is disabled by default, in which case finalization
+   *  produces the canonical encoding, which can be compared via memcmp.
+   *  Buffers that make use of optional encodings are readable through the
+   *  usual API, and compare equal to canonical buffers with the same contents.
+   */
+  struct finalize_options {
+    // Objects with at least this many keys carry a copy of their vtable
+    // in eytzinger order to speed up key lookup.
+    size_t eytzinger_threshold = std::numeric_limits<size_t>::max();
+
+    // Objects with at least this many keys carry a minimal perfect hash
+    // table over their keys, which resolves lookups in constant time.
+    size_t perfect_hash_threshold = std::numeric_limits<size_t>::max();
+
+    // Objects with at least this many keys carry a fingerprint of their key set,
+    // which allows lookups to be served from a per-thread cache shared by every
+    // object of the same shape.
+    size_t fingerprint_threshold = std::numeric_limits<size_t>::max();
+
+    // Objects with at least this many keys carry a further sixteen bytes of every key
+    // alongside their vtable, which settles comparisons between keys that share long
+    // common prefixes without having to touch the keys themselves.
+    size_t wide_prefix_threshold = std::numeric_limits<size_t>::max();
+
+    // Arrays with at least this many elements, all of which are integers, all of which
+    // are decimals, or all of which are booleans, are stored as a single contiguous run
+    // of values of the widest type required, without a vtable.
+    size_t packed_array_threshold = std::numeric_limits<size_t>::max();
+
+    // Arrays with at least this many elements, all of which are objects with exactly
+    // the same keys, are stored as a record batch: a single shared copy of the keys,
+    // followed by one column of values per key.
+    size_t record_batch_threshold = std::numeric_limits<size_t>::max();
+
+    // Keys that appear at least this many times across the whole buffer are stored once,
+    // in a dictionary at its root, and every object whose keys are all in the dictionary
+    // refers to them there instead of carrying copies of its own.
+    size_t key_dictionary_threshold = std::numeric_limits<size_t>::max();
+
+    // Nested objects and arrays that are guaranteed to take up fewer than this many bytes
+    // are stored as small aggregates, with a four byte header and sixteen bit offsets in
+    // their vtables. The threshold is capped at 64KiB, and the default of zero leaves
+    // every aggregate with the canonical encoding.
+    size_t small_aggregate_threshold = 0;
+
+    // Scalars small enough to fit are stored alongside the vtable instead of after their key
+    // or at the end of an offset, which lets lookups decode them without touching the rest of the
+    // buffer. Arrays store values of up to four bytes in place of their offsets, and objects
+    // store values of up to eight bytes in a section of their extension area.
+    bool inline_scalars = false;
+
+    // Objects with at least this many keys carry a sixty four bit hash of their contents, computed
+    // as they're laid out, which lets comparisons reject unequal buffers without walking them, and
+    // makes hashing a buffer constant time. Hashes of nested objects are reused by their parents.
+    size_t content_hash_threshold = std::numeric_limits<size_t>::max();
+
+    // Objects and arrays that might take up more than this many bytes are stored as large
+    // aggregates, with sixty four bit sizes and offsets, and none of the optional encodings.
+    // The default, which is also the cap, is the most the ordinary encoding can address,
+    // so only aggregates that couldn't otherwise be finalized at all are affected.
+    size_t large_aggregate_threshold = std::numeric_limits<uint32_t>::max();
+  };
+
+  namespace convert {
+    namespace detail {
+      template <class From, class To>
+      struct api_converter;
+    }
+  }
+
+  class parallel_policy;
+  namespace detail {
+    template <unsigned flags, class Callback>
+    size_t parse_ndjson_impl(shim::string_view ndjson, parallel_policy const& policy, Callback& cb);
+  }
+
+  /**
+   *  @brief
+   *  Class requests that a heap be finalized on several threads at once.
+   *
+   *  @details
+   *  Subtrees of at least grain bytes are handed out to a pool of threads, which lay them out
+   *  directly into their final positions, and the rest of the buffer is filled in around them.
+   *  Output is byte for byte identical to a sequential finalization.
+   *  The policy owns its threads, which live as long as any copy of it, so it's worth keeping
+   *  one around rather than making a new one for every finalization.
+   *  Only the canonical encoding, and the optional sections that don't change the shape
+   *  of an object (see dart::finalize_options), can be laid out in parallel; anything else,
+   *  and anything smaller than a couple of grains, is finalized on the calling thread.
+   *  The same threads can also be lent to dart::parse_ndjson, which ignores the grain.
+   */
+  class parallel_policy {
+
+    public:
+
+      /*----- Public Types -----*/
+
+      static constexpr size_t default_grain = 1U << 16;
+
+      /*----- Lifecycle Functions -----*/
+
+      // Finalizes on the given number of threads, including the calling one.
+      // Zero uses as many threads as the hardware supports.
+      explicit parallel_policy(size_t threads, size_t grain = default_grain) :
+        grain_bytes(grain ? grain : default_grain)
+      {
+        if (!threads) threads = std::max(std::thread::hardware_concurrency(), 1U);
+        if (threads > 1) pool = std::make_shared<detail::thread_pool>(threads);
+      }
+
+      /*----- Public API -----*/
+
+      size_t threads() const noexcept {
+        return pool ? pool->size() : 1;
+      }
+      size_t grain() const noexcept {
+        return grain_bytes;
+      }
+
+    private:
+
+      /*----- Private Members -----*/
+
+      size_t grain_bytes;
+      std::shared_ptr<detail::thread_pool> pool;
+
+      /*----- Friends -----*/
+
+      template <class, class>
+      friend struct convert::detail::api_converter;
+      template <unsigned, class Callback>
+      friend size_t detail::parse_ndjson_impl(shim::string_view, parallel_policy const&, Callback&);
+
+  };
+
+  namespace detail {
+    template <template <class> class RefCount>
+    class object;
+    template <template <class> class RefCount>
+    class record;
+    class key_dictionary;
+    template <template <class> class RefCount>
+    class buffer_parser;
+  }
+
+  /**
+   *  @brief
+   *  Class is a precompiled handle for a key that will be looked up
+   *  in many finalized objects.
+   *
+   *  @details
+   *  Computes everything finalized object lookup derives from a key up front,
+   *  so that looking up the same key across many buffers doesn't repeat the work.
+   *  The handle also remembers the vtable position it last matched at, and tries
+   *  that position first, which makes lookups across buffers of the same shape
+   *  nearly free.
+   *
+   *  @remarks
+   *  The remembered position is only a hint, and is maintained with relaxed
+   *  atomics, so a single handle can be shared between threads.
+   */
+  class key {
+
+    public:
+
+      /*----- Lifecycle Functions -----*/
+
+      explicit key(shim::string_view name);
+      key(key const& other);
+      ~key() = default;
+
+      /*----- Operators -----*/
+
+      key& operator =(key const& other);
+
+      /*----- Public API -----*/
+
+      shim::string_view strv() const noexcept;
+      size_t size() const noexcept;
+
+    private:
+
+      /*----- Private Members -----*/
+
+      std::string name;
+      uint32_t meta;
+      uint64_t hash;
+      mutable std::atomic<uint32_t> hint;
+
+      /*----- Friends -----*/
+
+      template <template <class> class>
+      friend class detail::object;
+
+  };
+
+  /**
+   *  @brief
+   *  Class is a precompiled, separator delimited path into nested objects and arrays.
+   *
+   *  @details
+   *  Splits the path once, up front, and precompiles a key for every segment,
+   *  so that evaluating the same path against many packets repeats none of that work.
+   *  Segments that are made up entirely of digits can also index into arrays.
+   *
+   *  @remarks
+   *  Like dart::key, a path can be shared between threads.
+   */
+  class path {
+
+    public:
+
+      /*----- Public Types -----*/
+
+      struct segment {
+        dart::key name;
+        size_t index;
+      };
+      using const_iterator = std::vector<segment>::const_iterator;
+
+      /*----- Lifecycle Functions -----*/
+
+      explicit path(shim::string_view needle, char separator = '.');
+      path(path const&) = default;
+      path(path&&) = default;
+      ~path() = default;
+
+      /*----- Operators -----*/
+
+      path& operator =(path const&) = default;
+      path& operator =(path&&) = default;
+
+      /*----- Public API -----*/
+
+      const_iterator begin() const noexcept;
+      const_iterator end() const noexcept;
+      size_t size() const noexcept;
+
+      /*----- Public Members -----*/
+
+      // Index of segments that can't be used to index into arrays.
+      static constexpr auto npos = std::numeric_limits<size_t>::max();
+
+    private:
+
+      /*----- Private Members -----*/
+
+      std::vector<segment> segments;
+
+  };
+
   namespace detail {
 
     template <class T>
@@ -209,9 +497,72 @@ namespace dart {
       decimal,
       long_decimal,
       boolean,
-      null
+      null,
+      small_object,
+      small_array,
+      large_object,
+      large_array,
+      // Never stored in a buffer, identifies a single row of a record batch.
+      record
+    };
+
+    /**
+     *  @brief
+     *  Flags describing the optional sections stored in the
+     *  extension area of a finalized object.
+     *
+     *  @details
+     *  Sections are laid out in the order of their flag values, and the size of
+     *  each is a function of the number of keys in the object, so readers can
+     *  locate any section using the flags alone.
+     *  The key dictionary is the one exception, and so comes last, and records
+     *  its own size.
+     *  The inline value section holds one eight byte slot per key, in vtable order,
+     *  for the values of entries marked with vtable_inline_flag, and comes first so
+     *  that it can be found without sizing any other section.
+     */
+    enum extension_type : uint32_t {
+      inline_value_section = 1U << 0,
+      eytzinger_section = 1U << 1,
+      perfect_hash_section = 1U << 2,
+      fingerprint_section = 1U << 3,
+      wide_prefix_section = 1U << 4,
+      content_hash_section = 1U << 5,
+      key_dictionary_section = 1U << 6,
+      all_sections = inline_value_section | eytzinger_section | perfect_hash_section
+        | fingerprint_section | wide_prefix_section | content_hash_section | key_dictionary_section
     };
 
+    // Finalized aggregates store layout flags in the upper bits of their element counts.
+    // Extended aggregates carry an extension area immediately following their vtable,
+    // and non-canonical aggregates contain an optional encoding somewhere in their subtree.
+    // Objects with shared keys store references into a key dictionary in place of their keys,
+    // and dependent aggregates refer to a key dictionary held by some enclosing object
+    // somewhere in their subtree, and so can't be copied out of their buffer verbatim.
+    static constexpr uint32_t aggregate_extended_flag = 1U << 31;
+    static constexpr uint32_t aggregate_noncanonical_flag = 1U << 30;
+    static constexpr uint32_t aggregate_shared_keys_flag = 1U << 29;
+    static constexpr uint32_t aggregate_dependent_flag = 1U << 28;
+    static constexpr uint32_t aggregate_size_mask = aggregate_dependent_flag - 1;
+
+    // Vtable entries mark values stored inline, rather than in the body of their aggregate,
+    // in the high bit of their type. Array entries hold the value in place of their offset,
+    // and object entries keep the offset of their key, and find the value in a separate section.
+    // Entries report the flag as part of their type, as masking it off every time a type
+    // is read out of the vtable is measurably slower, so anything that may see an inline
+    // entry has to strip it.
+    static constexpr uint8_t vtable_inline_flag = 1U << 7;
+    static constexpr size_t array_inline_bytes = sizeof(uint32_t);
+    static constexpr size_t object_inline_bytes = sizeof(uint64_t);
+
+    inline bool is_inline_type(raw_type type) noexcept {
+      return static_cast<uint8_t>(type) & vtable_inline_flag;
+    }
+
+    inline raw_type strip_inline(raw_type type) noexcept {
+      return static_cast<raw_type>(static_cast<uint8_t>(type) & ~vtable_inline_flag);
+    }
+
     /**
      *  @brief
      *  Used internally in scenarios where two dart types aren't contained within
@@ -395,6 +746,13 @@ namespace dart {
         // This sucks, but we need it for dart::buffer::inject
         void adjust_offset(std::ptrdiff_t diff) noexcept;
 
+        bool is_inline() const noexcept;
+        void set_inline() noexcept;
+
+        // Storage for a value held in place of the offset.
+        gsl::byte* inline_value() noexcept;
+        gsl::byte const* inline_value() const noexcept;
+
       protected:
 
         /*----- Protected Members -----*/
@@ -454,17 +812,325 @@ namespace dart {
     using array_entry = vtable_entry<void>;
     using object_layout = table_layout<prefix_entry>;
     using array_layout = table_layout<void>;
+
+    /**
+     *  @brief
+     *  Struct describes the header of the extension area of an object.
+     *
+     *  @details
+     *  Flags are taken from extension_type, and bytes gives the size
+     *  of the entire extension area, including the header itself.
+     */
+    struct extension_layout {
+      alignas(4) little_order<uint32_t> flags;
+      alignas(4) little_order<uint32_t> bytes;
+    };
+
+    /**
+     *  @brief
+     *  Struct describes the header of the perfect hash section of an object.
+     *
+     *  @details
+     *  The header is followed by one displacement per bucket, and then by one
+     *  slot per key, each of which holds the position of a key in the vtable.
+     *  Keys are hashed with the given seed, which is chosen at finalization
+     *  time such that no two keys share a slot.
+     *  Objects that couldn't be given a table keep the section, zeroed, with no buckets.
+     */
+    struct perfect_hash_layout {
+      alignas(4) little_order<uint32_t> seed;
+      alignas(4) little_order<uint32_t> buckets;
+    };
+
+    /**
+     *  @brief
+     *  Struct describes the header of a packed array.
+     *
+     *  @details
+     *  Packed arrays are marked by the extended flag in their element count, and replace
+     *  their vtable with this header, which is followed by one little endian value of the
+     *  given raw type per element, each of the given width, with no padding in between.
+     */
+    struct packed_array_layout {
+      alignas(4) little_order<uint32_t> type;
+      alignas(4) little_order<uint32_t> width;
+    };
+
+    /**
+     *  @brief
+     *  Struct describes the header of a record batch.
+     *
+     *  @details
+     *  Record batches are packed arrays of type object, whose packed run holds one
+     *  handle per row, each of which is the offset of the handle itself from the array.
+     *  The run is followed by this header, then one record_key_entry per shared key,
+     *  in vtable order, then the keys, and then one column per key.
+     *  Columns reuse packed_array_layout as their header. Columns of primitives of a
+     *  single kind are packed like any other packed array, while the rest have a width
+     *  of zero, and are followed by one array vtable entry per row, and then the values.
+     */
+    struct record_batch_layout {
+      alignas(4) little_order<uint32_t> keys;
+    };
+
+    // Offsets of a shared key, and of its column, from the base of a record batch.
+    struct record_key_entry {
+      alignas(4) little_order<uint32_t> key;
+      alignas(4) little_order<uint32_t> column;
+    };
+
+    /**
+     *  @brief
+     *  Struct describes the header of the key dictionary section of an object.
+     *
+     *  @details
+     *  The header is followed by the given number of keys, each laid out as an ordinary
+     *  string, and bytes gives the size of the whole section, including the header itself.
+     *  Objects that share keys replace each of their keys with a key_reference to one of them.
+     */
+    struct key_dictionary_layout {
+      alignas(4) little_order<uint32_t> bytes;
+      alignas(4) little_order<uint32_t> keys;
+    };
+
+    // Stored in place of a key, holds the distance back from itself to the key in the dictionary.
+    struct key_reference {
+      static constexpr auto alignment = sizeof(uint32_t);
+
+      alignas(alignment) little_order<uint32_t> offset;
+    };
+
+    /**
+     *  @brief
+     *  Struct describes an entry in the vtable of a small object.
+     *
+     *  @details
+     *  Mirrors object_entry with a sixteen bit offset, and keeps the key length
+     *  (capped at max_len) and the first bytes of the key as raw characters.
+     */
+    struct small_object_entry {
+      static constexpr size_t max_len = std::numeric_limits<uint8_t>::max();
+      static constexpr size_t prefix_len = 2;
+
+      alignas(2) little_order<uint16_t> offset;
+      alignas(1) little_order<uint8_t> type;
+      alignas(1) little_order<uint8_t> len;
+      char prefix[prefix_len];
+    };
+    static_assert(sizeof(small_object_entry) == 6, "dart library is misconfigured");
+
+    // An entry in the vtable of a small array, mirrors array_entry with a sixteen bit offset.
+    struct small_array_entry {
+      alignas(2) little_order<uint16_t> offset;
+      alignas(1) little_order<uint8_t> type;
+    };
+    static_assert(sizeof(small_array_entry) == 4, "dart library is misconfigured");
+
+    /**
+     *  @brief
+     *  Struct describes an entry in the vtable of a large object.
+     *
+     *  @details
+     *  Mirrors small_object_entry with a sixty four bit offset, which leaves
+     *  room for six bytes of the key.
+     */
+    struct large_object_entry {
+      static constexpr size_t max_len = std::numeric_limits<uint8_t>::max();
+      static constexpr size_t prefix_len = 6;
+
+      alignas(8) little_order<uint64_t> offset;
+      alignas(1) little_order<uint8_t> type;
+      alignas(1) little_order<uint8_t> len;
+      char prefix[prefix_len];
+    };
+    static_assert(sizeof(large_object_entry) == 16, "dart library is misconfigured");
+
+    // An entry in the vtable of a large array, mirrors array_entry with a sixty four bit offset.
+    struct large_array_entry {
+      alignas(8) little_order<uint64_t> offset;
+      alignas(8) little_order<uint8_t> type;
+    };
+    static_assert(sizeof(large_array_entry) == 16, "dart library is misconfigured");
+
+    /**
+     *  @brief
+     *  Struct describes the header of a compressed buffer.
+     *
+     *  @details
+     *  The header is followed by one compressed_field per field of the root object, in vtable
+     *  order, then one compressed_block per block, then the uncompressed head of the buffer
+     *  (everything before the first key), aligned to eight bytes, then the given number of
+     *  bytes of keys, and finally the compressed blocks themselves.
+     *  Blocks cover the rest of the buffer, in order, without gaps.
+     */
+    struct compressed_layout {
+      static constexpr uint32_t magic_number = 0x5A545244;
+
+      alignas(4) little_order<uint32_t> magic;
+      alignas(4) little_order<uint32_t> bytes;
+      alignas(4) little_order<uint32_t> head;
+      alignas(4) little_order<uint32_t> fields;
+      alignas(4) little_order<uint32_t> blocks;
+      alignas(4) little_order<uint32_t> keys;
+    };
+
+    // Locates the key of a field, relative to the header, and its value, relative to the
+    // original buffer, along with the type of the value and the block that holds it.
+    // Dependent values refer to a key dictionary outside of their block.
+    struct compressed_field {
+      static constexpr uint16_t dependent_flag = 1U << 0;
+
+      alignas(4) little_order<uint32_t> key;
+      alignas(4) little_order<uint32_t> key_len;
+      alignas(4) little_order<uint32_t> value;
+      alignas(4) little_order<uint32_t> block;
+      alignas(2) little_order<uint16_t> type;
+      alignas(2) little_order<uint16_t> flags;
+    };
+
+    // Locates the raw bytes of a block within the original buffer, and its compressed bytes
+    // relative to the header.
+    struct compressed_block {
+      alignas(4) little_order<uint32_t> offset;
+      alignas(4) little_order<uint32_t> bytes;
+      alignas(4) little_order<uint32_t> data;
+      alignas(4) little_order<uint32_t> len;
+    };
+
+    // Maps the native types that packed arrays can be exposed as to their raw types.
+    template <class T>
+    struct packed_raw_type : std::integral_constant<raw_type, raw_type::null> {};
+    template <>
+    struct packed_raw_type<int16_t> : std::integral_constant<raw_type, raw_type::short_integer> {};
+    template <>
+    struct packed_raw_type<int32_t> : std::integral_constant<raw_type, raw_type::integer> {};
+    template <>
+    struct packed_raw_type<int64_t> : std::integral_constant<raw_type, raw_type::long_integer> {};
+    template <>
+    struct packed_raw_type<float> : std::integral_constant<raw_type, raw_type::decimal> {};
+    template <>
+    struct packed_raw_type<double> : std::integral_constant<raw_type, raw_type::long_decimal> {};
+    template <>
+    struct packed_raw_type<bool> : std::integral_constant<raw_type, raw_type::boolean> {};
+
+    /**
+     *  @brief
+     *  Struct describes a single entry of the wide prefix section of an object.
+     *
+     *  @details
+     *  The section holds one entry per key, in vtable order, each of which
+     *  holds the bytes of the key that follow the prefix stored in its vtable
+     *  entry, zero padded out to the width of the entry.
+     */
+    struct wide_prefix_layout {
+      static constexpr auto max_len = 16U;
+
+      char bytes[max_len];
+    };
     static_assert(std::is_standard_layout<array_entry>::value, "dart library is misconfigured");
     static_assert(std::is_standard_layout<object_entry>::value, "dart library is misconfigured");
 
+    /**
+     *  @brief
+     *  Class remembers how many bytes a heap aggregate takes up once finalized.
+     *
+     *  @details
+     *  Heap aggregates are only ever modified after passing through basic_heap::copy_on_write,
+     *  which clears the cache, so a cached size stays valid for as long as the aggregate does.
+     *  Finalizing is a const operation, and may happen on several threads at once, so the size is
+     *  kept in an atomic. Copies start out empty, as copies are only ever made to be modified.
+     */
+    class layout_cache {
+      public:
+        layout_cache() = default;
+        layout_cache(layout_cache const&) noexcept {}
+        layout_cache& operator =(layout_cache const&) noexcept {
+          reset();
+          return *this;
+        }
+
+        // Zero means nothing has been cached.
+        size_t get() const noexcept {
+          return bytes.load(std::memory_order_relaxed);
+        }
+        void set(size_t val) const noexcept {
+          bytes.store(val, std::memory_order_relaxed);
+        }
+        void reset() const noexcept {
+          set(0);
+        }
+
+      private:
+        mutable std::atomic<size_t> bytes {0};
+    };
+
+    /**
+     *  @brief
+     *  Class remembers the finalized bytes a heap aggregate was definalized from.
+     *
+     *  @details
+     *  Cleared by basic_heap::copy_on_write along with the layout cache, so it's only ever set
+     *  for aggregates that still hold exactly what those bytes do, which can be copied straight
+     *  back out of them when the aggregate is finalized again.
+     *  Holds a reference to the buffer the bytes belong to, which keeps it alive.
+     */
+    template <class Buffer>
+    class source_link {
+      public:
+        source_link() = default;
+        source_link(source_link const&) noexcept {}
+        source_link& operator =(source_link const&) noexcept {
+          reset();
+          return *this;
+        }
+
+        // Returns an empty span if nothing has been linked.
+        gsl::span<gsl::byte const> get() const noexcept {
+          return bytes;
+        }
+        void set(Buffer const& buff, gsl::span<gsl::byte const> source) {
+          owner.emplace(buff);
+          bytes = source;
+        }
+        void reset() noexcept {
+          owner.reset();
+          bytes = {};
+        }
+
+      private:
+        shim::optional<Buffer> owner;
+        gsl::span<gsl::byte const> bytes;
+    };
+
+    // STL structures used by heap aggregates, along with their finalized sizes,
+    // and the finalized bytes they came from, if any.
+    // Views share the structures of the heaps they view, hence the indirection.
+    template <class Heap, class Buffer>
+    struct heap_elements : std::vector<Heap> {
+      using std::vector<Heap>::vector;
+
+      layout_cache finalized;
+      source_link<Buffer> source;
+    };
+    template <class Heap, class Comparator, class Buffer>
+    struct heap_fields : std::map<Heap, Heap, Comparator> {
+      using std::map<Heap, Heap, Comparator>::map;
+
+      layout_cache finalized;
+      source_link<Buffer> source;
+    };
+
     // Aliases for STL structures.
     template <template <class> class RefCount>
-    using packet_elements = std::vector<refcount::owner_indirection_t<basic_heap, RefCount>>;
-    template <template <class> class RefCount>
-    using packet_fields = std::map<
+    using packet_elements = heap_elements<
       refcount::owner_indirection_t<basic_heap, RefCount>,
+      refcount::owner_indirection_t<basic_buffer, RefCount>
+    >;
+    template <template <class> class RefCount>
+    using packet_fields = heap_fields<
       refcount::owner_indirection_t<basic_heap, RefCount>,
-      refcount::owner_indirection_t<dart_comparator, RefCount>
+      refcount::owner_indirection_t<dart_comparator, RefCount>,
+      refcount::owner_indirection_t<basic_buffer, RefCount>
     >;
 
     /**
@@ -628,13 +1294,11 @@ namespace dart {
 #ifdef DART_USE_SAJSON
         explicit object(sajson::value fields) noexcept;
 #endif
-#if DART_HAS_RAPIDJSON
-        explicit object(rapidjson::Value const& fields) noexcept;
-#endif
+        object(buffer_parser<RefCount> const& parser, size_t idx) noexcept;
 
         // Direct constructors
-        explicit object(gsl::span<packet_pair<RefCount>> pairs) noexcept;
-        explicit object(packet_fields<RefCount> const* fields) noexcept;
+        explicit object(gsl::span<packet_pair<RefCount>> pairs, finalize_options const& opts = {}) noexcept;
+        explicit object(packet_fields<RefCount> const* fields, finalize_options const& opts = {}) noexcept;
 
         // Special constructors
         object(object const* base, object const* incoming) noexcept;
@@ -653,8 +1317,19 @@ namespace dart {
         template <bool silent>
         bool is_valid(size_t bytes) const noexcept(silent);
 
+        // Checks only the vtable and extension area against the given bound,
+        // without touching any keys or values.
+        template <bool silent>
+        bool is_valid_layout(size_t bytes) const noexcept(silent);
+
         size_t size() const noexcept;
         size_t get_sizeof() const noexcept;
+        bool is_canonical() const noexcept;
+        bool is_dependent() const noexcept;
+        bool owns_dictionary() const noexcept;
+        bool has_content_hash() const noexcept;
+        uint64_t content_hash() const noexcept;
+        size_t field_offset(size_t idx) const noexcept;
 
         auto begin() const noexcept -> ll_iterator<RefCount>;
         auto key_begin() const noexcept -> ll_iterator<RefCount>;
@@ -663,14 +1338,24 @@ namespace dart {
 
         template <class Callback>
         auto get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element;
+        template <class Callback>
+        auto get_key(dart::key const& handle, Callback&& cb) const noexcept -> raw_element;
         auto get_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount>;
         auto get_key_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount>;
         auto get_value(shim::string_view const key) const noexcept -> raw_element;
+        auto get_value(dart::key const& handle) const noexcept -> raw_element;
+        template <class Callback>
+        void get_values(gsl::span<shim::string_view const> keys, Callback&& cb) const;
+        template <class Loader, class Callback>
+        static void get_values_batch(size_t count, Loader&& load, shim::string_view const key, Callback&& cb);
         auto at_value(shim::string_view const key) const -> raw_element;
 
         static auto load_key(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
         static auto load_value(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
 
+        static uint32_t extension_flags(size_t elems, finalize_options const& opts) noexcept;
+        static size_t extension_sizeof(uint32_t flags, size_t elems) noexcept;
+
         /*----- Public Members -----*/
 
         static constexpr auto alignment = sizeof(int64_t);
@@ -680,9 +1365,44 @@ namespace dart {
         /*----- Private Helpers -----*/
 
         size_t realign(size_t guess, size_t offset) noexcept;
-
+        template <class Key>
+        size_t layout_key(gsl::byte* buffer, Key const& key, key_dictionary const* dict) noexcept;
+        void write_extensions(uint32_t flags, bool canonical) noexcept;
+        void write_eytzinger() noexcept;
+        void write_perfect_hash() noexcept;
+        void write_fingerprint() noexcept;
+        void write_wide_prefix() noexcept;
+        void write_content_hash() noexcept;
+        uint64_t compute_content_hash() const noexcept;
+
+        template <class Hasher, class Callback>
+        auto get_key_impl(shim::string_view const key, Hasher&& hasher, Callback&& cb) const noexcept -> raw_element;
+        template <class Hasher, class Callback>
+        auto cached_get_key(shim::string_view const key, Hasher&& hasher, Callback&& cb) const noexcept -> raw_element;
+        template <class Hasher, class Callback>
+        auto search_get_key(shim::string_view const key, Hasher&& hasher, Callback&& cb) const noexcept -> raw_element;
         template <class Callback>
-        auto get_value_impl(shim::string_view const key, Callback&& cb) const -> raw_element;
+        auto linear_get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element;
+        template <class Callback>
+        auto binary_get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element;
+        template <class Callback>
+        auto eytzinger_get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element;
+        template <class Hasher, class Callback>
+        auto perfect_hash_get_key(shim::string_view const key,
+            Hasher&& hasher, Callback&& cb) const noexcept -> raw_element;
+
+        bool has_perfect_hash() const noexcept;
+        bool entry_matches(size_t idx, shim::string_view const key, uint32_t meta) const noexcept;
+        ssize_t compare_entry(size_t idx, shim::string_view const key) const noexcept;
+        ssize_t compare_tail(size_t idx, shim::string_view const key, wide_prefix_layout const* wide) const noexcept;
+        size_t gallop_lower_bound(size_t low, shim::string_view const key) const noexcept;
+
+        static size_t perfect_hash_buckets(size_t elems) noexcept;
+        static size_t perfect_hash_slot(uint64_t hash, uint32_t displacement, size_t elems) noexcept;
+        static wide_prefix_layout make_wide_prefix(shim::string_view const key) noexcept;
+
+        template <class Key, class Callback>
+        auto get_value_impl(Key const& key, Callback&& cb) const -> raw_element;
 
         object_entry* vtable() noexcept;
         object_entry const* vtable() const noexcept;
@@ -690,6 +1410,19 @@ namespace dart {
         gsl::byte* raw_vtable() noexcept;
         gsl::byte const* raw_vtable() const noexcept;
 
+        bool shares_keys() const noexcept;
+        gsl::byte const* key_at(gsl::byte const* slot) const noexcept;
+        gsl::byte const* value_after(gsl::byte const* slot, raw_type type) const noexcept;
+
+        bool is_extended() const noexcept;
+        extension_layout const* extension() const noexcept;
+        size_t extension_bytes() const noexcept;
+        gsl::byte* extension_section(uint32_t section) noexcept;
+        gsl::byte const* extension_section(uint32_t section) const noexcept;
+        wide_prefix_layout const* wide_prefixes() const noexcept;
+        gsl::byte* inline_value(size_t idx) noexcept;
+        gsl::byte const* inline_value(size_t idx) const noexcept;
+
         /*----- Private Members -----*/
 
         alignas(4) little_order<uint32_t> bytes;
@@ -721,10 +1454,8 @@ namespace dart {
 #ifdef DART_USE_SAJSON
         explicit array(sajson::value elems) noexcept;
 #endif
-#if DART_HAS_RAPIDJSON
-        explicit array(rapidjson::Value const& elems) noexcept;
-#endif
-        array(packet_elements<RefCount> const* elems) noexcept;
+        array(buffer_parser<RefCount> const& parser, size_t idx) noexcept;
+        array(packet_elements<RefCount> const* elems, finalize_options const& opts = {}) noexcept;
         array(array const&) = delete;
         ~array() = delete;
 
@@ -739,6 +1470,8 @@ namespace dart {
 
         size_t size() const noexcept;
         size_t get_sizeof() const noexcept;
+        bool is_canonical() const noexcept;
+        bool is_dependent() const noexcept;
 
         auto begin() const noexcept -> ll_iterator<RefCount>;
         auto end() const noexcept -> ll_iterator<RefCount>;
@@ -746,7 +1479,17 @@ namespace dart {
         auto get_elem(size_t index) const noexcept -> raw_element;
         auto at_elem(size_t index) const -> raw_element;
 
+        bool is_packed() const noexcept;
+        raw_type packed_type() const noexcept;
+        gsl::byte const* packed_data() const noexcept;
+
+        bool is_record_batch() const noexcept;
+        packed_array_layout const* batch_column(shim::string_view const key) const noexcept;
+
         static auto load_elem(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+        static raw_type packing_for(packet_elements<RefCount> const* vals, finalize_options const& opts) noexcept;
+        static bool is_batchable(packet_elements<RefCount> const* vals, finalize_options const& opts) noexcept;
+        static size_t batch_upper_bound(packet_elements<RefCount> const* vals, finalize_options const& opts);
 
         /*----- Public Members -----*/
 
@@ -757,6 +1500,24 @@ namespace dart {
         /*----- Private Helpers -----*/
 
         auto get_elem_impl(size_t index, bool throw_if_absent) const -> raw_element;
+        void write_packed(packet_elements<RefCount> const* vals, raw_type type) noexcept;
+        void write_batch(packet_elements<RefCount> const* vals, finalize_options const& opts) noexcept;
+        packed_array_layout const* packed_header() const noexcept;
+
+        template <bool silent>
+        bool valid_batch(size_t bytes) const noexcept(silent);
+        static bool valid_packed(gsl::byte const* data, raw_type type, size_t count) noexcept;
+        record_batch_layout const* batch_header() const noexcept;
+        record_key_entry const* batch_keys() const noexcept;
+        size_t batch_size() const noexcept;
+        auto batch_key(size_t key_idx) const noexcept -> raw_element;
+        auto batch_value(size_t key_idx, size_t row) const noexcept -> raw_element;
+        ssize_t find_batch_key(shim::string_view const key) const noexcept;
+
+        template <class Loader>
+        static raw_type widest_primitive(size_t count, Loader&& load) noexcept;
+        template <class Loader>
+        static gsl::byte* write_run(gsl::byte* data, size_t count, raw_type type, Loader&& load) noexcept;
 
         array_entry* vtable() noexcept;
         array_entry const* vtable() const noexcept;
@@ -771,39 +1532,424 @@ namespace dart {
 
         static constexpr auto header_len = sizeof(bytes) + sizeof(elems);
 
+        /*----- Friends -----*/
+
+        friend class record<RefCount>;
+
     };
     static_assert(std::is_standard_layout<array<std::shared_ptr>>::value, "dart library is misconfigured");
 
     /**
      *  @brief
      *  Class is the lowest level abstraction for safe interaction with
-     *  a dart::buffer string.
+     *  a single row of a dart::buffer record batch.
      *
      *  @details
-     *  Class wraps memory that is stored in little endian byte order,
-     *  irrespective of the native ordering of the host machine.
-     *  In other words, attempt to subvert its API at your peril.
+     *  Rows don't own any memory beyond their handle, which is enough to find the
+     *  batch they belong to, and exposes the same interface as a finalized object
+     *  by reading its keys and values out of the batch.
      */
-    template <class SizeType>
-    class basic_string {
+    template <template <class> class RefCount>
+    class record {
 
       public:
 
-        /*----- Public Types -----*/
-
-        using size_type = SizeType;
-
         /*----- Lifecycle Functions -----*/
 
-        basic_string() = delete;
-        explicit basic_string(shim::string_view strv) noexcept;
-        explicit basic_string(char const* str, size_t len) noexcept;
-        basic_string(basic_string const&) = delete;
-        ~basic_string() = delete;
+        record() = delete;
+        record(record const&) = delete;
+        ~record() = delete;
 
         /*----- Operators -----*/
 
-        basic_string& operator =(basic_string const&) = delete;
+        record& operator =(record const&) = delete;
+
+        /*----- Public API -----*/
+
+        template <bool silent>
+        bool is_valid(size_t bytes) const noexcept(silent);
+
+        size_t size() const noexcept;
+        size_t get_sizeof() const noexcept;
+
+        auto begin() const noexcept -> ll_iterator<RefCount>;
+        auto key_begin() const noexcept -> ll_iterator<RefCount>;
+        auto end() const noexcept -> ll_iterator<RefCount>;
+        auto key_end() const noexcept -> ll_iterator<RefCount>;
+
+        template <class Callback>
+        auto get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element;
+        template <class Callback>
+        auto get_key(dart::key const& handle, Callback&& cb) const noexcept -> raw_element;
+        auto get_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount>;
+        auto get_key_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount>;
+        auto get_value(shim::string_view const key) const noexcept -> raw_element;
+        auto get_value(dart::key const& handle) const noexcept -> raw_element;
+        template <class Callback>
+        void get_values(gsl::span<shim::string_view const> keys, Callback&& cb) const;
+        auto at_value(shim::string_view const key) const -> raw_element;
+
+        static auto load_key(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+        static auto load_value(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+
+        /*----- Public Members -----*/
+
+        static constexpr auto alignment = sizeof(uint32_t);
+
+      private:
+
+        /*----- Private Helpers -----*/
+
+        array<RefCount> const* batch() const noexcept;
+        size_t row() const noexcept;
+
+        /*----- Private Members -----*/
+
+        alignas(4) little_order<uint32_t> offset;
+
+        static constexpr auto header_len = sizeof(offset);
+
+    };
+    static_assert(std::is_standard_layout<record<std::shared_ptr>>::value, "dart library is misconfigured");
+
+    /**
+     *  @brief
+     *  Class is the lowest level abstraction for safe interaction with
+     *  a dart::buffer small object.
+     *
+     *  @details
+     *  Small objects are laid out exactly like objects, except that their header
+     *  and vtable use sixteen bit fields, and they never carry an extension area.
+     *  They're only ever nested within another aggregate, as the root of a network
+     *  buffer is always an object.
+     *  Class wraps memory that is stored in little endian byte order,
+     *  irrespective of the native ordering of the host machine.
+     *  In other words, attempt to subvert its API at your peril.
+     */
+    template <template <class> class RefCount>
+    class small_object {
+
+      public:
+
+        /*----- Lifecycle Functions -----*/
+
+        small_object() = delete;
+        explicit small_object(packet_fields<RefCount> const* fields, finalize_options const& opts) noexcept;
+        small_object(small_object const&) = delete;
+        ~small_object() = delete;
+
+        /*----- Operators -----*/
+
+        small_object& operator =(small_object const&) = delete;
+
+        /*----- Public API -----*/
+
+        template <bool silent>
+        bool is_valid(size_t bytes) const noexcept(silent);
+
+        size_t size() const noexcept;
+        size_t get_sizeof() const noexcept;
+
+        auto begin() const noexcept -> ll_iterator<RefCount>;
+        auto key_begin() const noexcept -> ll_iterator<RefCount>;
+        auto end() const noexcept -> ll_iterator<RefCount>;
+        auto key_end() const noexcept -> ll_iterator<RefCount>;
+
+        template <class Callback>
+        auto get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element;
+        template <class Callback>
+        auto get_key(dart::key const& handle, Callback&& cb) const noexcept -> raw_element;
+        auto get_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount>;
+        auto get_key_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount>;
+        auto get_value(shim::string_view const key) const noexcept -> raw_element;
+        auto get_value(dart::key const& handle) const noexcept -> raw_element;
+        template <class Callback>
+        void get_values(gsl::span<shim::string_view const> keys, Callback&& cb) const;
+        auto at_value(shim::string_view const key) const -> raw_element;
+
+        static auto load_key(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+        static auto load_value(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+
+        /*----- Public Members -----*/
+
+        static constexpr auto alignment = sizeof(int64_t);
+        static constexpr size_t max_size = std::numeric_limits<uint16_t>::max();
+
+      private:
+
+        /*----- Private Helpers -----*/
+
+        ssize_t find_key(shim::string_view const key) const noexcept;
+        int compare_entry(size_t idx, shim::string_view const key) const noexcept;
+
+        small_object_entry* vtable() noexcept;
+        small_object_entry const* vtable() const noexcept;
+
+        gsl::byte const* value_after(gsl::byte const* key, raw_type type) const noexcept;
+
+        /*----- Private Members -----*/
+
+        alignas(2) little_order<uint16_t> bytes;
+        alignas(2) little_order<uint16_t> elems;
+
+        static constexpr auto header_len = sizeof(bytes) + sizeof(elems);
+
+    };
+    static_assert(std::is_standard_layout<small_object<std::shared_ptr>>::value, "dart library is misconfigured");
+
+    /**
+     *  @brief
+     *  Class is the lowest level abstraction for safe interaction with
+     *  a dart::buffer small array.
+     *
+     *  @details
+     *  Small arrays are laid out exactly like arrays, except that their header
+     *  and vtable use sixteen bit fields, and they're never packed.
+     *  Class wraps memory that is stored in little endian byte order,
+     *  irrespective of the native ordering of the host machine.
+     *  In other words, attempt to subvert its API at your peril.
+     */
+    template <template <class> class RefCount>
+    class small_array {
+
+      public:
+
+        /*----- Lifecycle Functions -----*/
+
+        small_array() = delete;
+        explicit small_array(packet_elements<RefCount> const* elems, finalize_options const& opts) noexcept;
+        small_array(small_array const&) = delete;
+        ~small_array() = delete;
+
+        /*----- Operators -----*/
+
+        small_array& operator =(small_array const&) = delete;
+
+        /*----- Public API -----*/
+
+        template <bool silent>
+        bool is_valid(size_t bytes) const noexcept(silent);
+
+        size_t size() const noexcept;
+        size_t get_sizeof() const noexcept;
+
+        auto begin() const noexcept -> ll_iterator<RefCount>;
+        auto end() const noexcept -> ll_iterator<RefCount>;
+
+        auto get_elem(size_t index) const noexcept -> raw_element;
+        auto at_elem(size_t index) const -> raw_element;
+
+        static auto load_elem(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+
+        /*----- Public Members -----*/
+
+        static constexpr auto alignment = sizeof(int64_t);
+        static constexpr size_t max_size = std::numeric_limits<uint16_t>::max();
+
+      private:
+
+        /*----- Private Helpers -----*/
+
+        small_array_entry* vtable() noexcept;
+        small_array_entry const* vtable() const noexcept;
+
+        /*----- Private Members -----*/
+
+        alignas(2) little_order<uint16_t> bytes;
+        alignas(2) little_order<uint16_t> elems;
+
+        static constexpr auto header_len = sizeof(bytes) + sizeof(elems);
+
+    };
+    static_assert(std::is_standard_layout<small_array<std::shared_ptr>>::value, "dart library is misconfigured");
+
+    /**
+     *  @brief
+     *  Class is the lowest level abstraction for safe interaction with
+     *  a dart::buffer large object.
+     *
+     *  @details
+     *  Large objects are laid out like small objects, except that their header
+     *  and vtable use sixty four bit fields, which lets them describe more than
+     *  the four gigabytes an ordinary object can address.
+     *  They're only used for aggregates that need them, and can appear at the root
+     *  of a network buffer, where their header begins with a zero word that no
+     *  ordinary object can start with.
+     *  Class wraps memory that is stored in little endian byte order,
+     *  irrespective of the native ordering of the host machine.
+     *  In other words, attempt to subvert its API at your peril.
+     */
+    template <template <class> class RefCount>
+    class large_object {
+
+      public:
+
+        /*----- Lifecycle Functions -----*/
+
+        large_object() = delete;
+        explicit large_object(packet_fields<RefCount> const* fields, finalize_options const& opts) noexcept;
+        large_object(buffer_parser<RefCount> const& parser, size_t idx) noexcept;
+        large_object(large_object const&) = delete;
+        ~large_object() = delete;
+
+        /*----- Operators -----*/
+
+        large_object& operator =(large_object const&) = delete;
+
+        /*----- Public API -----*/
+
+        template <bool silent>
+        bool is_valid(size_t bytes) const noexcept(silent);
+
+        size_t size() const noexcept;
+        size_t get_sizeof() const noexcept;
+
+        auto begin() const noexcept -> ll_iterator<RefCount>;
+        auto key_begin() const noexcept -> ll_iterator<RefCount>;
+        auto end() const noexcept -> ll_iterator<RefCount>;
+        auto key_end() const noexcept -> ll_iterator<RefCount>;
+
+        template <class Callback>
+        auto get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element;
+        template <class Callback>
+        auto get_key(dart::key const& handle, Callback&& cb) const noexcept -> raw_element;
+        auto get_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount>;
+        auto get_key_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount>;
+        auto get_value(shim::string_view const key) const noexcept -> raw_element;
+        auto get_value(dart::key const& handle) const noexcept -> raw_element;
+        template <class Callback>
+        void get_values(gsl::span<shim::string_view const> keys, Callback&& cb) const;
+        auto at_value(shim::string_view const key) const -> raw_element;
+
+        static auto load_key(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+        static auto load_value(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+
+        /*----- Public Members -----*/
+
+        static constexpr auto alignment = sizeof(int64_t);
+
+      private:
+
+        /*----- Private Helpers -----*/
+
+        ssize_t find_key(shim::string_view const key) const noexcept;
+        int compare_entry(size_t idx, shim::string_view const key) const noexcept;
+
+        large_object_entry* vtable() noexcept;
+        large_object_entry const* vtable() const noexcept;
+
+        gsl::byte const* value_after(gsl::byte const* key, raw_type type) const noexcept;
+
+        /*----- Private Members -----*/
+
+        alignas(4) little_order<uint32_t> marker;
+        alignas(4) little_order<uint32_t> reserved;
+        alignas(8) little_order<uint64_t> bytes;
+        alignas(8) little_order<uint64_t> elems;
+
+        static constexpr auto header_len = sizeof(marker) + sizeof(reserved) + sizeof(bytes) + sizeof(elems);
+
+    };
+    static_assert(std::is_standard_layout<large_object<std::shared_ptr>>::value, "dart library is misconfigured");
+
+    /**
+     *  @brief
+     *  Class is the lowest level abstraction for safe interaction with
+     *  a dart::buffer large array.
+     *
+     *  @details
+     *  Large arrays are laid out like small arrays, except that their header
+     *  and vtable use sixty four bit fields, and they're never packed.
+     *  Class wraps memory that is stored in little endian byte order,
+     *  irrespective of the native ordering of the host machine.
+     *  In other words, attempt to subvert its API at your peril.
+     */
+    template <template <class> class RefCount>
+    class large_array {
+
+      public:
+
+        /*----- Lifecycle Functions -----*/
+
+        large_array() = delete;
+        explicit large_array(packet_elements<RefCount> const* elems, finalize_options const& opts) noexcept;
+        large_array(buffer_parser<RefCount> const& parser, size_t idx) noexcept;
+        large_array(large_array const&) = delete;
+        ~large_array() = delete;
+
+        /*----- Operators -----*/
+
+        large_array& operator =(large_array const&) = delete;
+
+        /*----- Public API -----*/
+
+        template <bool silent>
+        bool is_valid(size_t bytes) const noexcept(silent);
+
+        size_t size() const noexcept;
+        size_t get_sizeof() const noexcept;
+
+        auto begin() const noexcept -> ll_iterator<RefCount>;
+        auto end() const noexcept -> ll_iterator<RefCount>;
+
+        auto get_elem(size_t index) const noexcept -> raw_element;
+        auto at_elem(size_t index) const -> raw_element;
+
+        static auto load_elem(gsl::byte const* base, size_t idx) noexcept -> typename ll_iterator<RefCount>::value_type;
+
+        /*----- Public Members -----*/
+
+        static constexpr auto alignment = sizeof(int64_t);
+
+      private:
+
+        /*----- Private Helpers -----*/
+
+        large_array_entry* vtable() noexcept;
+        large_array_entry const* vtable() const noexcept;
+
+        /*----- Private Members -----*/
+
+        alignas(4) little_order<uint32_t> marker;
+        alignas(4) little_order<uint32_t> reserved;
+        alignas(8) little_order<uint64_t> bytes;
+        alignas(8) little_order<uint64_t> elems;
+
+        static constexpr auto header_len = sizeof(marker) + sizeof(reserved) + sizeof(bytes) + sizeof(elems);
+
+    };
+    static_assert(std::is_standard_layout<large_array<std::shared_ptr>>::value, "dart library is misconfigured");
+
+    /**
+     *  @brief
+     *  Class is the lowest level abstraction for safe interaction with
+     *  a dart::buffer string.
+     *
+     *  @details
+     *  Class wraps memory that is stored in little endian byte order,
+     *  irrespective of the native ordering of the host machine.
+     *  In other words, attempt to subvert its API at your peril.
+     */
+    template <class SizeType>
+    class basic_string {
+
+      public:
+
+        /*----- Public Types -----*/
+
+        using size_type = SizeType;
+
+        /*----- Lifecycle Functions -----*/
+
+        basic_string() = delete;
+        explicit basic_string(shim::string_view strv) noexcept;
+        explicit basic_string(char const* str, size_t len) noexcept;
+        basic_string(basic_string const&) = delete;
+        ~basic_string() = delete;
+
+        /*----- Operators -----*/
+
+        basic_string& operator =(basic_string const&) = delete;
 
         /*----- Public API -----*/
 
@@ -897,8 +2043,10 @@ namespace dart {
       using buffer = basic_buffer<RefCount>;
 
       template <class Span>
-      static auto build_buffer(Span pairs) -> buffer;
+      static auto build_buffer(Span pairs, finalize_options const& opts = {}) -> buffer;
       static auto merge_buffers(buffer const& base, buffer const& incoming) -> buffer;
+      static auto materialize(buffer const& base) -> buffer;
+      static bool is_copyable(buffer const& base) noexcept;
 
       template <class Spannable>
       static auto project_keys(buffer const& base, Spannable const& keys) -> buffer;
@@ -909,7 +2057,7 @@ namespace dart {
       static void project_each_pair(object<RefCount> const* base, gsl::span<Key const*> key_ptrs, Callback&& cb);
 
       template <class Span>
-      static size_t max_bytes(Span pairs);
+      static size_t max_bytes(Span pairs, finalize_options const& opts = {});
     };
 
     // Used for tag dispatch from factory functions.
@@ -959,73 +2107,649 @@ namespace dart {
 
     /**
      *  @brief
-     *  Function converts between internal type information and
-     *  user-facing type information.
+     *  Function converts between internal type information and
+     *  user-facing type information.
+     *
+     *  @details
+     *  Dart internally has to encode significantly more complicated
+     *  type information than it publicly exposes, so this function
+     *  works as a an efficient go-between for the two.
+     */
+    inline type simplify_type(raw_type type) noexcept {
+      switch (type) {
+        case raw_type::object:
+        case raw_type::small_object:
+        case raw_type::large_object:
+        case raw_type::record:
+          return detail::type::object;
+        case raw_type::array:
+        case raw_type::small_array:
+        case raw_type::large_array:
+          return detail::type::array;
+        case raw_type::small_string:
+        case raw_type::string:
+        case raw_type::big_string:
+          return detail::type::string;
+        case raw_type::short_integer:
+        case raw_type::integer:
+        case raw_type::long_integer:
+          return detail::type::integer;
+        case raw_type::decimal:
+        case raw_type::long_decimal:
+          return detail::type::decimal;
+        case raw_type::boolean:
+          return detail::type::boolean;
+        default:
+          DART_ASSERT(type == raw_type::null);
+          return detail::type::null;
+      }
+    }
+
+    inline bool valid_type(raw_type type) noexcept {
+      switch (type) {
+        case raw_type::object:
+        case raw_type::array:
+        case raw_type::small_object:
+        case raw_type::small_array:
+        case raw_type::large_object:
+        case raw_type::large_array:
+        case raw_type::string:
+        case raw_type::small_string:
+        case raw_type::big_string:
+        case raw_type::short_integer:
+        case raw_type::integer:
+        case raw_type::long_integer:
+        case raw_type::decimal:
+        case raw_type::long_decimal:
+        case raw_type::boolean:
+        case raw_type::null:
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    /**
+     *  @brief
+     *  Function computes the word held by the last four bytes of an object vtable
+     *  entry for the given key, masked by key_meta_mask.
+     *
+     *  @details
+     *  Those bytes hold the type of the value, the (capped) length of the key, and
+     *  the key prefix. The word is assembled from raw bytes, so it compares correctly
+     *  against vtable memory irrespective of host endianness.
+     */
+    inline uint32_t key_meta(shim::string_view key) noexcept {
+      constexpr auto max_len = std::numeric_limits<uint8_t>::max();
+      constexpr auto prefix_len = sizeof(prefix_entry::prefix_type);
+      auto const key_size = key.size();
+      uint8_t meta_bytes[sizeof(uint32_t)] {};
+      meta_bytes[1] = static_cast<uint8_t>(key_size < max_len ? key_size : max_len);
+      std::copy_n(key.data(), key_size < prefix_len ? key_size : prefix_len, &meta_bytes[2]);
+
+      uint32_t meta;
+      std::memcpy(&meta, meta_bytes, sizeof(meta));
+      return meta;
+    }
+
+    inline uint32_t key_meta_mask() noexcept {
+      uint8_t const mask_bytes[sizeof(uint32_t)] {0x00, 0xFF, 0xFF, 0xFF};
+      uint32_t mask;
+      std::memcpy(&mask, mask_bytes, sizeof(mask));
+      return mask;
+    }
+
+    /**
+     *  @brief
+     *  Function computes a seeded hash of a key that is stable across
+     *  platforms, and so can be persisted into finalized buffers.
+     *
+     *  @details
+     *  FNV-1a, followed by the murmur3 finalizer so that every bit
+     *  of the result depends on every byte of the key.
+     */
+    inline uint64_t hash_key(shim::string_view key, uint32_t seed) noexcept {
+      uint64_t hash = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+      for (auto c : key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+      }
+      hash ^= hash >> 33;
+      hash *= 0xFF51AFD7ED558CCDULL;
+      hash ^= hash >> 33;
+      hash *= 0xC4CEB9FE1A85EC53ULL;
+      hash ^= hash >> 33;
+      return hash;
+    }
+
+    // Folds a hash into a running hash, such that the result depends on the order of folding.
+    inline uint64_t hash_combine(uint64_t seed, uint64_t hash) noexcept {
+      seed ^= hash + 0x9E3779B97F4A7C15ULL + (seed << 6) + (seed >> 2);
+      seed ^= seed >> 33;
+      seed *= 0xFF51AFD7ED558CCDULL;
+      seed ^= seed >> 33;
+      return seed;
+    }
+
+    /**
+     *  @brief
+     *  Function computes a seeded hash of a run of bytes that is stable across
+     *  platforms, and so can be persisted into finalized buffers.
+     *
+     *  @details
+     *  Unlike hash_key, consumes eight bytes at a time, as it's used to hash
+     *  entire strings rather than keys, and finishes with the murmur3 finalizer.
+     */
+    inline uint64_t hash_bytes(char const* bytes, size_t len, uint64_t seed) noexcept {
+      uint64_t hash = seed ^ (len * 0x9E3779B97F4A7C15ULL);
+      size_t idx = 0;
+      for (; idx + sizeof(uint64_t) <= len; idx += sizeof(uint64_t)) {
+        little_order<uint64_t> word;
+        std::memcpy(&word, bytes + idx, sizeof(word));
+        hash ^= word.get() * 0x87C37B91114253D5ULL;
+        hash = ((hash << 31) | (hash >> 33)) * 0x4CF5AD432745937FULL;
+      }
+      uint64_t tail = 0;
+      for (size_t shift = 0; idx < len; ++idx, shift += 8) tail |= uint64_t {static_cast<uint8_t>(bytes[idx])} << shift;
+      hash ^= tail * 0x87C37B91114253D5ULL;
+      hash ^= hash >> 33;
+      hash *= 0xFF51AFD7ED558CCDULL;
+      hash ^= hash >> 33;
+      hash *= 0xC4CEB9FE1A85EC53ULL;
+      hash ^= hash >> 33;
+      return hash;
+    }
+
+    /**
+     *  @brief
+     *  Functions define the hash of the contents of a dart value.
+     *
+     *  @details
+     *  Hashes are computed from values, never from their encoding, so any two values
+     *  that compare equal hash the same, whether or not either was finalized, and
+     *  irrespective of the options it was finalized with.
+     *  Fields of an object are summed, so their order doesn't matter, while the elements
+     *  of an array are combined in order.
+     *  Hashes are persisted into finalized buffers, so these must never change.
+     */
+    enum class hash_seed : uint64_t {
+      null = 0x6E756C6C00000000ULL,
+      boolean = 0x626F6F6C00000000ULL,
+      integer = 0x696E746500000000ULL,
+      decimal = 0x6465636900000000ULL,
+      string = 0x7374726900000000ULL,
+      object = 0x6F626A6500000000ULL,
+      array = 0x6172726100000000ULL
+    };
+
+    inline uint64_t hash_null() noexcept {
+      return hash_combine(static_cast<uint64_t>(hash_seed::null), 0);
+    }
+
+    inline uint64_t hash_boolean(bool val) noexcept {
+      return hash_combine(static_cast<uint64_t>(hash_seed::boolean), val);
+    }
+
+    inline uint64_t hash_integer(int64_t val) noexcept {
+      return hash_combine(static_cast<uint64_t>(hash_seed::integer), static_cast<uint64_t>(val));
+    }
+
+    inline uint64_t hash_decimal(double val) noexcept {
+      // Positive and negative zero compare equal, so they have to hash the same.
+      if (val == 0.0) val = 0.0;
+      uint64_t bits;
+      std::memcpy(&bits, &val, sizeof(bits));
+      return hash_combine(static_cast<uint64_t>(hash_seed::decimal), bits);
+    }
+
+    inline uint64_t hash_string(shim::string_view val) noexcept {
+      return hash_bytes(val.data(), val.size(), static_cast<uint64_t>(hash_seed::string));
+    }
+
+    inline uint64_t hash_field(uint64_t key, uint64_t value) noexcept {
+      return hash_combine(key, value);
+    }
+
+    inline uint64_t hash_object(size_t size, uint64_t fields) noexcept {
+      return hash_combine(hash_combine(static_cast<uint64_t>(hash_seed::object), size), fields);
+    }
+
+    inline uint64_t hash_array(size_t size) noexcept {
+      return hash_combine(static_cast<uint64_t>(hash_seed::array), size);
+    }
+
+    // Returns the hash of the contents of the given element, reusing
+    // the hashes stored by any objects along the way.
+    template <template <class> class RefCount>
+    uint64_t hash_contents(raw_element elem) noexcept;
+
+    // Returns the hash stored by the given element, if it's an object that carries one.
+    template <template <class> class RefCount>
+    shim::optional<uint64_t> stored_hash(raw_element elem) noexcept;
+
+    // Returns the hash of the contents of a value of any dart type, by way of its public API.
+    template <class Packet>
+    uint64_t hash_generic(Packet const& pkt) noexcept;
+
+    /**
+     *  @brief
+     *  Struct represents a single entry of the per-thread shape cache.
+     *
+     *  @details
+     *  Remembers the vtable position at which a key (identified by its unseeded hash)
+     *  was found in an object with a given fingerprint.
+     */
+    struct shape_cache_entry {
+      uint64_t fingerprint;
+      uint64_t key;
+      size_t index;
+    };
+
+    /**
+     *  @brief
+     *  Function returns the per-thread shape cache entry for the given
+     *  fingerprint and key hash.
+     *
+     *  @details
+     *  Cache is direct mapped, so unrelated shapes and keys can evict each other.
+     *  Entries are only hints, and must be verified against the object before use.
+     */
+    inline shape_cache_entry& shape_cache_slot(uint64_t fingerprint, uint64_t key) noexcept {
+      static_assert(!(DART_SHAPE_CACHE_SIZE & (DART_SHAPE_CACHE_SIZE - 1)), "dart library is misconfigured");
+      static thread_local shape_cache_entry cache[DART_SHAPE_CACHE_SIZE] {};
+      auto const mixed = (fingerprint ^ key) * 0x9E3779B97F4A7C15ULL;
+      return cache[(mixed >> 32) & (DART_SHAPE_CACHE_SIZE - 1)];
+    }
+
+    // Hashes keys with the same function persisted into finalized buffers.
+    struct key_hasher {
+      size_t operator ()(shim::string_view key) const noexcept {
+        return static_cast<size_t>(hash_key(key, 0));
+      }
+    };
+
+    /**
+     *  @brief
+     *  Class represents the key dictionary of the buffer currently being
+     *  finalized, or validated, on this thread.
+     *
+     *  @details
+     *  While finalizing, the dictionary knows which allocation is being finalized, and where
+     *  each of its keys will be written, so objects within that allocation can refer to them.
+     *  While validating, it only knows the bounds of the section that holds the keys, which
+     *  every key reference must land within.
+     *  Dictionaries are made current by a scope, which restores the previous dictionary
+     *  on exit, as a finalized buffer holding a dictionary can be embedded in another.
+     */
+    class key_dictionary {
+
+      public:
+
+        /*----- Public Types -----*/
+
+        using counts_type = std::unordered_map<shim::string_view, size_t, key_hasher>;
+
+        class scope {
+
+          public:
+
+            /*----- Lifecycle Functions -----*/
+
+            inline explicit scope(key_dictionary* dict) noexcept;
+            scope(scope const&) = delete;
+            inline ~scope() noexcept;
+
+            /*----- Operators -----*/
+
+            scope& operator =(scope const&) = delete;
+
+          private:
+
+            /*----- Private Members -----*/
+
+            key_dictionary* prev;
+
+        };
+
+        /*----- Lifecycle Functions -----*/
+
+        // Finalization constructor, interns every key that occurs at least threshold times.
+        inline key_dictionary(counts_type const& counts, size_t threshold);
+
+        // Validation constructor, takes the bounds of the section being validated.
+        inline key_dictionary(gsl::byte const* begin, gsl::byte const* end) noexcept;
+
+        /*----- Public API -----*/
+
+        inline bool empty() const noexcept;
+        inline size_t get_sizeof() const noexcept;
+        inline size_t upper_bound() const noexcept;
+
+        inline void bind(gsl::byte const* base, size_t bytes) noexcept;
+        inline size_t layout(gsl::byte* buffer) noexcept;
+
+        inline bool is_root(void const* ptr) const noexcept;
+        inline bool in_buffer(void const* ptr) const noexcept;
+        inline gsl::byte const* find(shim::string_view key) const noexcept;
+        inline gsl::byte const* resolve(gsl::byte const* slot, size_t distance) const noexcept;
+        inline gsl::byte const* end() const noexcept;
+
+        inline static key_dictionary* current() noexcept;
+
+      private:
+
+        /*----- Private Helpers -----*/
+
+        inline static key_dictionary*& current_slot() noexcept;
+
+        /*----- Private Members -----*/
+
+        std::vector<shim::string_view> keys;
+        std::unordered_map<shim::string_view, gsl::byte const*, key_hasher> positions;
+        size_t references;
+        size_t bytes;
+        gsl::byte const* buffer_begin;
+        gsl::byte const* buffer_end;
+        gsl::byte const* section_begin;
+        gsl::byte const* section_end;
+
+    };
+
+    /**
+     *  @brief
+     *  Class represents the aggregates of the buffer currently being finalized on
+     *  this thread that have already been laid out by other threads.
+     *
+     *  @details
+     *  Parallel finalization lays out large subtrees ahead of time, directly into their
+     *  final positions, and then lays out the rest of the buffer as usual on the calling
+     *  thread, which only has to look up the size of those subtrees when it gets to them.
+     *  Made current by a scope, just like the key dictionary.
+     */
+    class prelaid_layout {
+
+      public:
+
+        /*----- Public Types -----*/
+
+        class scope {
+
+          public:
+
+            /*----- Lifecycle Functions -----*/
+
+            inline explicit scope(prelaid_layout const* layout) noexcept;
+            scope(scope const&) = delete;
+            inline ~scope() noexcept;
+
+            /*----- Operators -----*/
+
+            scope& operator =(scope const&) = delete;
+
+          private:
+
+            /*----- Private Members -----*/
+
+            prelaid_layout const* prev;
+
+        };
+
+        /*----- Lifecycle Functions -----*/
+
+        // Takes the addresses of every subtree that has been laid out, in ascending order.
+        inline explicit prelaid_layout(std::vector<gsl::byte const*> addresses) noexcept;
+
+        /*----- Public API -----*/
+
+        // Returns whether an aggregate has already been laid out at the given address.
+        inline static bool contains(void const* ptr) noexcept;
+
+      private:
+
+        /*----- Private Helpers -----*/
+
+        inline static prelaid_layout const*& current_slot() noexcept;
+
+        /*----- Private Members -----*/
+
+        std::vector<gsl::byte const*> addresses;
+
+    };
+
+    /**
+     *  @brief
+     *  Class holds the scratch space used to build perfect hash tables on this thread.
+     *
+     *  @details
+     *  Tables are built while objects are laid out, which can't allocate, so anyone
+     *  finalizing with perfect hashing enabled reserves enough space for the largest
+     *  object that will carry a table up front, and makes it current with a scope.
+     *  Objects that don't fit in the current scratch space are laid out without a table.
+     */
+    class perfect_hash_scratch {
+
+      public:
+
+        /*----- Public Types -----*/
+
+        class scope {
+
+          public:
+
+            /*----- Lifecycle Functions -----*/
+
+            inline explicit scope(perfect_hash_scratch* scratch) noexcept;
+            scope(scope const&) = delete;
+            inline ~scope() noexcept;
+
+            /*----- Operators -----*/
+
+            scope& operator =(scope const&) = delete;
+
+          private:
+
+            /*----- Private Members -----*/
+
+            perfect_hash_scratch* prev;
+
+        };
+
+        /*----- Lifecycle Functions -----*/
+
+        // Reserves enough space to build a table over the given number of keys.
+        inline explicit perfect_hash_scratch(size_t keys);
+
+        /*----- Public API -----*/
+
+        inline size_t capacity() const noexcept;
+
+        inline static perfect_hash_scratch* current() noexcept;
+
+        // Returns the number of keys in the largest object of the given heap that will carry a table.
+        template <class Heap>
+        static size_t largest_table(Heap const& hp, finalize_options const& opts);
+
+        /*----- Public Members -----*/
+
+        std::vector<uint64_t> hashes;
+        std::vector<uint32_t> members;
+        std::vector<uint32_t> starts;
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> candidates;
+        std::vector<bool> taken;
+
+      private:
+
+        /*----- Private Helpers -----*/
+
+        inline static perfect_hash_scratch*& current_slot() noexcept;
+
+    };
+
+    /**
+     *  @brief
+     *  Class builds a finalized buffer straight from a stream of JSON events,
+     *  without building a document, or a heap, along the way.
+     *
+     *  @details
+     *  Events are recorded onto a flat scratch tape as they arrive, and every aggregate
+     *  sorts its keys, and works out its exact finalized size, as soon as it ends.
+     *  By the time the document ends its buffer can be allocated once, at exactly the
+     *  right size, and laid out in a single pass over the tape.
+     *  Event handlers follow the RapidJSON handler concept, so a RapidJSON reader can
+     *  drive the parser directly, and clearing the parser keeps its scratch space around
+     *  for the next document.
+     *  Objects with duplicate keys keep the last value, just like heaps do, and aggregates
+     *  too large for the ordinary encoding use the large one.
+     */
+    template <template <class> class RefCount>
+    class buffer_parser {
+
+      public:
+
+        /*----- Lifecycle Functions -----*/
+
+        buffer_parser() = default;
+        explicit buffer_parser(size_t large_limit) noexcept;
+        buffer_parser(buffer_parser const&) = delete;
+        ~buffer_parser() = default;
+
+        /*----- Operators -----*/
+
+        buffer_parser& operator =(buffer_parser const&) = delete;
+
+        /*----- Public API -----*/
+
+        // JSON event handlers.
+        // API mandated by RapidJSON, not my preferred naming scheme.
+        bool StartObject();
+        bool Key(char const* str, size_t len, bool);
+        bool EndObject(size_t);
+        bool StartArray();
+        bool EndArray(size_t);
+        bool String(char const* str, size_t len, bool);
+        bool Int(int num);
+        bool Uint(unsigned num);
+        bool Int64(int64_t num);
+        bool Uint64(uint64_t num);
+        bool Double(double num);
+        bool RawNumber(char const*, size_t, bool);
+        bool Bool(bool val);
+        bool Null();
+
+        // Forgets the current document, but keeps up to DART_PARSER_RETAINED_BYTES
+        // of scratch space.
+        void clear() noexcept;
+
+        // Returns whether a whole document has been parsed, and what's at its root.
+        bool complete() const noexcept;
+        raw_type root_type() const noexcept;
+
+        // Returns exactly how many bytes the document needs, and lays it out
+        // into that many zeroed bytes.
+        size_t get_sizeof() const noexcept;
+        size_t layout(gsl::byte* buffer) const noexcept;
+
+        // Used by the low level object and array constructors to walk the tape.
+        // The children of an object are its keys, in sorted order, each of which is
+        // immediately followed by its value.
+        raw_type get_type(size_t idx) const noexcept;
+        shim::string_view get_string(size_t idx) const noexcept;
+        gsl::span<size_t const> get_children(size_t idx) const noexcept;
+        size_t lower(gsl::byte* buffer, size_t idx) const noexcept;
+
+      private:
+
+        /*----- Private Types -----*/
+
+        struct node {
+          raw_type type;
+          size_t size;
+          size_t bytes;
+          union {
+            int64_t integer;
+            double decimal;
+            bool boolean;
+            size_t offset;
+          };
+        };
+
+        /*----- Private Helpers -----*/
+
+        size_t add_node(node curr);
+        size_t add_string(char const* str, size_t len);
+        void end_aggregate();
+
+        /*----- Private Members -----*/
+
+        // Nodes in document order, along with the characters of every string,
+        // and the children of every aggregate that has ended.
+        std::vector<node> nodes;
+        std::vector<char> strings;
+        std::vector<size_t> children;
+
+        // Aggregates that haven't ended yet, along with where their children start
+        // in the list of children that haven't been claimed yet.
+        std::vector<std::pair<size_t, size_t>> open;
+        std::vector<size_t> pending;
+
+        // Aggregates that take up more than this many bytes use the large encoding.
+        size_t large_limit = object_layout::max_offset;
+
+    };
+
+    /**
+     *  @brief
+     *  Function provides a "safe" bridge between the high level
+     *  and low level object apis.
      *
      *  @details
-     *  Dart internally has to encode significantly more complicated
-     *  type information than it publicly exposes, so this function
-     *  works as a an efficient go-between for the two.
+     *  Don't pass it null.
+     *  Tries its damndest not to invoke UB, but god knows.
      */
-    inline type simplify_type(raw_type type) noexcept {
-      switch (type) {
-        case raw_type::object:
-          return detail::type::object;
-        case raw_type::array:
-          return detail::type::array;
-        case raw_type::small_string:
-        case raw_type::string:
-        case raw_type::big_string:
-          return detail::type::string;
-        case raw_type::short_integer:
-        case raw_type::integer:
-        case raw_type::long_integer:
-          return detail::type::integer;
-        case raw_type::decimal:
-        case raw_type::long_decimal:
-          return detail::type::decimal;
-        case raw_type::boolean:
-          return detail::type::boolean;
-        default:
-          DART_ASSERT(type == raw_type::null);
-          return detail::type::null;
+    template <template <class> class RefCount>
+    object<RefCount> const* get_object(raw_element raw) {
+      if (raw.type == raw_type::object) {
+        DART_ASSERT(raw.buffer != nullptr);
+        return shim::launder(reinterpret_cast<object<RefCount> const*>(raw.buffer));
+      } else {
+        throw type_error("dart::buffer is not a finalized object and cannot be accessed as such");
       }
     }
 
-    inline bool valid_type(raw_type type) noexcept {
-      switch (type) {
-        case raw_type::object:
-        case raw_type::array:
-        case raw_type::string:
-        case raw_type::small_string:
-        case raw_type::big_string:
-        case raw_type::short_integer:
-        case raw_type::integer:
-        case raw_type::long_integer:
-        case raw_type::decimal:
-        case raw_type::long_decimal:
-        case raw_type::boolean:
-        case raw_type::null:
-          return true;
-        default:
-          return false;
+    /**
+     *  @brief
+     *  Function provides a "safe" bridge between the high level
+     *  and low level record batch row apis.
+     *
+     *  @details
+     *  Don't pass it null.
+     *  Tries its damndest not to invoke UB, but god knows.
+     */
+    template <template <class> class RefCount>
+    record<RefCount> const* get_record(raw_element raw) {
+      if (raw.type == raw_type::record) {
+        DART_ASSERT(raw.buffer != nullptr);
+        return shim::launder(reinterpret_cast<record<RefCount> const*>(raw.buffer));
+      } else {
+        throw type_error("dart::buffer is not a finalized object and cannot be accessed as such");
       }
     }
 
     /**
      *  @brief
      *  Function provides a "safe" bridge between the high level
-     *  and low level object apis.
+     *  and low level small object apis.
      *
      *  @details
      *  Don't pass it null.
      *  Tries its damndest not to invoke UB, but god knows.
      */
     template <template <class> class RefCount>
-    object<RefCount> const* get_object(raw_element raw) {
-      if (simplify_type(raw.type) == type::object) {
+    small_object<RefCount> const* get_small_object(raw_element raw) {
+      if (raw.type == raw_type::small_object) {
         DART_ASSERT(raw.buffer != nullptr);
-        return shim::launder(reinterpret_cast<object<RefCount> const*>(raw.buffer));
+        return shim::launder(reinterpret_cast<small_object<RefCount> const*>(raw.buffer));
       } else {
         throw type_error("dart::buffer is not a finalized object and cannot be accessed as such");
       }
@@ -1042,7 +2766,7 @@ namespace dart {
      */
     template <template <class> class RefCount>
     array<RefCount> const* get_array(raw_element raw) {
-      if (simplify_type(raw.type) == type::array) {
+      if (raw.type == raw_type::array) {
         DART_ASSERT(raw.buffer != nullptr);
         return shim::launder(reinterpret_cast<array<RefCount> const*>(raw.buffer));
       } else {
@@ -1050,6 +2774,63 @@ namespace dart {
       }
     }
 
+    /**
+     *  @brief
+     *  Function provides a "safe" bridge between the high level
+     *  and low level small array apis.
+     *
+     *  @details
+     *  Don't pass it null.
+     *  Tries its damndest not to invoke UB, but god knows.
+     */
+    template <template <class> class RefCount>
+    small_array<RefCount> const* get_small_array(raw_element raw) {
+      if (raw.type == raw_type::small_array) {
+        DART_ASSERT(raw.buffer != nullptr);
+        return shim::launder(reinterpret_cast<small_array<RefCount> const*>(raw.buffer));
+      } else {
+        throw type_error("dart::buffer is not a finalized array and cannot be accessed as such");
+      }
+    }
+
+    /**
+     *  @brief
+     *  Function provides a "safe" bridge between the high level
+     *  and low level large object apis.
+     *
+     *  @details
+     *  Don't pass it null.
+     *  Tries its damndest not to invoke UB, but god knows.
+     */
+    template <template <class> class RefCount>
+    large_object<RefCount> const* get_large_object(raw_element raw) {
+      if (raw.type == raw_type::large_object) {
+        DART_ASSERT(raw.buffer != nullptr);
+        return shim::launder(reinterpret_cast<large_object<RefCount> const*>(raw.buffer));
+      } else {
+        throw type_error("dart::buffer is not a finalized object and cannot be accessed as such");
+      }
+    }
+
+    /**
+     *  @brief
+     *  Function provides a "safe" bridge between the high level
+     *  and low level large array apis.
+     *
+     *  @details
+     *  Don't pass it null.
+     *  Tries its damndest not to invoke UB, but god knows.
+     */
+    template <template <class> class RefCount>
+    large_array<RefCount> const* get_large_array(raw_element raw) {
+      if (raw.type == raw_type::large_array) {
+        DART_ASSERT(raw.buffer != nullptr);
+        return shim::launder(reinterpret_cast<large_array<RefCount> const*>(raw.buffer));
+      } else {
+        throw type_error("dart::buffer is not a finalized array and cannot be accessed as such");
+      }
+    }
+
     /**
      *  @brief
      *  Function provides a "safe" bridge between the high level
@@ -1106,11 +2887,59 @@ namespace dart {
       }
     }
 
+    template <template <class> class RefCount, class Callback>
+    auto object_deref(Callback&& cb, raw_element raw)
+      -> std::common_type_t<
+        decltype(std::forward<Callback>(cb)(std::declval<object<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<small_object<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<large_object<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<record<RefCount>&>()))
+      >
+    {
+      switch (raw.type) {
+        case raw_type::object:
+          return std::forward<Callback>(cb)(*get_object<RefCount>(raw));
+        case raw_type::small_object:
+          return std::forward<Callback>(cb)(*get_small_object<RefCount>(raw));
+        case raw_type::large_object:
+          return std::forward<Callback>(cb)(*get_large_object<RefCount>(raw));
+        case raw_type::record:
+          return std::forward<Callback>(cb)(*get_record<RefCount>(raw));
+        default:
+          throw type_error("dart::buffer is not a finalized object and cannot be accessed as such");
+      }
+    }
+
+    template <template <class> class RefCount, class Callback>
+    auto array_deref(Callback&& cb, raw_element raw)
+      -> std::common_type_t<
+        decltype(std::forward<Callback>(cb)(std::declval<array<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<small_array<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<large_array<RefCount>&>()))
+      >
+    {
+      switch (raw.type) {
+        case raw_type::array:
+          return std::forward<Callback>(cb)(*get_array<RefCount>(raw));
+        case raw_type::small_array:
+          return std::forward<Callback>(cb)(*get_small_array<RefCount>(raw));
+        case raw_type::large_array:
+          return std::forward<Callback>(cb)(*get_large_array<RefCount>(raw));
+        default:
+          throw type_error("dart::buffer is not a finalized array and cannot be accessed as such");
+      }
+    }
+
     template <template <class> class RefCount, class Callback>
     auto aggregate_deref(Callback&& cb, raw_element raw)
       -> std::common_type_t<
         decltype(std::forward<Callback>(cb)(std::declval<object<RefCount>&>())),
-        decltype(std::forward<Callback>(cb)(std::declval<array<RefCount>&>()))
+        decltype(std::forward<Callback>(cb)(std::declval<array<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<small_object<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<small_array<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<large_object<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<large_array<RefCount>&>())),
+        decltype(std::forward<Callback>(cb)(std::declval<record<RefCount>&>()))
       >
     {
       switch (raw.type) {
@@ -1118,6 +2947,16 @@ namespace dart {
           return std::forward<Callback>(cb)(*get_object<RefCount>(raw));
         case raw_type::array:
           return std::forward<Callback>(cb)(*get_array<RefCount>(raw));
+        case raw_type::small_object:
+          return std::forward<Callback>(cb)(*get_small_object<RefCount>(raw));
+        case raw_type::small_array:
+          return std::forward<Callback>(cb)(*get_small_array<RefCount>(raw));
+        case raw_type::large_object:
+          return std::forward<Callback>(cb)(*get_large_object<RefCount>(raw));
+        case raw_type::large_array:
+          return std::forward<Callback>(cb)(*get_large_array<RefCount>(raw));
+        case raw_type::record:
+          return std::forward<Callback>(cb)(*get_record<RefCount>(raw));
         default:
           throw type_error("dart::buffer is not a finalized aggregate and cannot be accessed as such");
       }
@@ -1196,8 +3035,13 @@ namespace dart {
     {
       switch (raw) {
         case raw_type::object:
+        case raw_type::small_object:
+        case raw_type::large_object:
+        case raw_type::record:
           return std::forward<Callback>(cb)(object_tag {});
         case raw_type::array:
+        case raw_type::small_array:
+        case raw_type::large_array:
           return std::forward<Callback>(cb)(array_tag {});
         case raw_type::small_string:
         case raw_type::string:
@@ -1235,6 +3079,11 @@ namespace dart {
       switch (raw.type) {
         case raw_type::object:
         case raw_type::array:
+        case raw_type::small_object:
+        case raw_type::small_array:
+        case raw_type::large_object:
+        case raw_type::large_array:
+        case raw_type::record:
           return aggregate_deref<RefCount>(std::forward<Callback>(cb), raw);
         case raw_type::small_string:
         case raw_type::string:
@@ -1274,6 +3123,13 @@ namespace dart {
       return reinterpret_cast<T*>((offset + (alignment - 1)) & ~(alignment - 1));
     }
 
+    // Same as the above, but for structures that aren't dart types, with an explicit alignment.
+    template <class T>
+    constexpr T* align_to(T* ptr, size_t alignment) noexcept {
+      uintptr_t offset = reinterpret_cast<uintptr_t>(ptr);
+      return reinterpret_cast<T*>((offset + (alignment - 1)) & ~(alignment - 1));
+    }
+
     template <template <class> class RefCount, class T>
     constexpr T pad_bytes(T bytes, raw_type type) noexcept {
       // Get the required alignment for a pointer of this type.
@@ -1292,6 +3148,41 @@ namespace dart {
       }
     }
 
+    // Returns whether the given element, and everything beneath it, uses the canonical encoding.
+    template <template <class> class RefCount>
+    bool is_canonical(raw_element elem) noexcept {
+      switch (elem.type) {
+        case raw_type::object:
+          return get_object<RefCount>(elem)->is_canonical();
+        case raw_type::array:
+          return get_array<RefCount>(elem)->is_canonical();
+        case raw_type::small_object:
+        case raw_type::small_array:
+        case raw_type::large_object:
+        case raw_type::large_array:
+        case raw_type::record:
+          return false;
+        default:
+          return true;
+      }
+    }
+
+    // Returns whether the given element refers to a key dictionary held outside of itself,
+    // and so has to be copied out through the API rather than byte for byte.
+    template <template <class> class RefCount>
+    bool is_dependent(raw_element elem) noexcept {
+      switch (elem.type) {
+        case raw_type::object:
+          return get_object<RefCount>(elem)->is_dependent();
+        case raw_type::array:
+          return get_array<RefCount>(elem)->is_dependent();
+        case raw_type::record:
+          return true;
+        default:
+          return false;
+      }
+    }
+
     template <bool silent, template <class> class RefCount>
     bool valid_buffer(raw_element elem, size_t bytes) noexcept(silent) {
       // Null is a special case because it occupies zero space in the network buffer
@@ -1336,6 +3227,49 @@ namespace dart {
       else return raw_type::decimal;
     }
 
+    // Returns the type of the object at the root of a network buffer, if it's at least long enough to tell.
+    // Large objects begin with a zero word, and ordinary objects begin with their (non-zero) size.
+    inline raw_type identify_root(gsl::byte const* buffer,
+        size_t bytes = std::numeric_limits<size_t>::max()) noexcept
+    {
+      uint32_t marker = 1;
+      if (buffer && bytes >= sizeof(marker)) std::memcpy(&marker, buffer, sizeof(marker));
+      return marker ? raw_type::object : raw_type::large_object;
+    }
+
+    // Returns the largest number of bytes an ordinary aggregate may need before it's
+    // laid out as a large one instead.
+    inline size_t large_aggregate_limit(finalize_options const& opts) noexcept {
+      return std::min(opts.large_aggregate_threshold, size_t {object_layout::max_offset});
+    }
+
+    // Returns whether the given options leave every aggregate with the canonical encoding,
+    // in which case the size of a heap can be worked out exactly before it's laid out.
+    inline bool has_exact_layout(finalize_options const& opts) noexcept {
+      auto constexpr unset = std::numeric_limits<size_t>::max();
+      return opts.packed_array_threshold == unset && opts.record_batch_threshold == unset
+        && opts.key_dictionary_threshold == unset && !opts.small_aggregate_threshold
+        && !opts.inline_scalars && opts.large_aggregate_threshold == finalize_options {}.large_aggregate_threshold;
+    }
+
+    // Returns whether the given options are the defaults, which are the only ones
+    // finalized sizes are cached for.
+    inline bool has_default_layout(finalize_options const& opts) noexcept {
+      auto constexpr unset = std::numeric_limits<size_t>::max();
+      return has_exact_layout(opts) && opts.eytzinger_threshold == unset
+        && opts.perfect_hash_threshold == unset && opts.fingerprint_threshold == unset
+        && opts.wide_prefix_threshold == unset && opts.content_hash_threshold == unset;
+    }
+
+    // Given the type and upper bound of an aggregate about to be laid out, returns
+    // the type it must actually be laid out as.
+    inline raw_type identify_aggregate(raw_type type, size_t bound, finalize_options const& opts) noexcept {
+      if (bound <= large_aggregate_limit(opts)) return type;
+      else if (type == raw_type::object) return raw_type::large_object;
+      else if (type == raw_type::array) return raw_type::large_array;
+      else return type;
+    }
+
 // Dart is header-only, so I think the scenarios where the ABI stability of
 // symbol mangling will be relevant are relatively few.
 #if DART_USING_GCC
@@ -1421,6 +3355,34 @@ namespace dart {
       }
     }
 
+    // Returns the number of bytes a scalar of the given type takes up once finalized,
+    // where the length only matters for strings.
+    template <template <class> class RefCount>
+    size_t scalar_sizeof(raw_type raw, size_t len) noexcept {
+      switch (raw) {
+        case raw_type::small_string:
+        case raw_type::string:
+          return string::static_sizeof(static_cast<string::size_type>(len));
+        case raw_type::big_string:
+          return big_string::static_sizeof(static_cast<big_string::size_type>(len));
+        case raw_type::short_integer:
+          return primitive<int16_t>::static_sizeof();
+        case raw_type::integer:
+          return primitive<int32_t>::static_sizeof();
+        case raw_type::long_integer:
+          return primitive<int64_t>::static_sizeof();
+        case raw_type::decimal:
+          return primitive<float>::static_sizeof();
+        case raw_type::long_decimal:
+          return primitive<double>::static_sizeof();
+        case raw_type::boolean:
+          return primitive<bool>::static_sizeof();
+        default:
+          DART_ASSERT(raw == raw_type::null);
+          return 0;
+      }
+    }
+
 #ifdef DART_USE_SAJSON
     // FIXME: Find somewhere better to put these functions.
     template <template <class> class RefCount>
@@ -1487,73 +3449,59 @@ namespace dart {
       }
       return detail::find_sizeof<RefCount>({raw, buffer});
     }
-#endif
-
-#if DART_HAS_RAPIDJSON
-    // FIXME: Find somewhere better to put these functions.
-    template <template <class> class RefCount>
-    raw_type json_identify(rapidjson::Value const& curr_val) {
-      switch (curr_val.GetType()) {
-        case rapidjson::kObjectType:
-          return raw_type::object;
-        case rapidjson::kArrayType:
-          return raw_type::array;
-        case rapidjson::kStringType:
-          // Figure out what type of string we've been given.
-          return identify_string<RefCount>({curr_val.GetString(), curr_val.GetStringLength()});
-        case rapidjson::kNumberType:
-          // Figure out what type of number we've been given.
-          if (curr_val.IsInt64()) return identify_integer(curr_val.GetInt64());
-          else return identify_decimal(curr_val.GetDouble());
-        case rapidjson::kTrueType:
-        case rapidjson::kFalseType:
-          return raw_type::boolean;
-        default:
-          DART_ASSERT(curr_val.IsNull());
-          return raw_type::null;
-      }
-    }
 
+    // Returns exactly how many bytes json_lower will use for the given value,
+    // walking it the same way the object and array constructors do.
     template <template <class> class RefCount>
-    size_t json_lower(gsl::byte* buffer, rapidjson::Value const& curr_val) {
+    size_t json_sizeof(sajson::value curr_val) {
       auto raw = json_identify<RefCount>(curr_val);
       switch (raw) {
         case raw_type::object:
-          new(buffer) object<RefCount>(curr_val);
-          break;
+          {
+            auto const elems = curr_val.get_length();
+            size_t offset = sizeof(object<RefCount>) + sizeof(object_entry) * elems;
+            for (auto idx = 0U; idx < elems; ++idx) {
+              auto key = curr_val.get_object_key(idx);
+              auto val = curr_val.get_object_value(idx);
+              offset = pad_bytes<RefCount>(offset, raw_type::string) + scalar_sizeof<RefCount>(raw_type::string, key.length());
+              offset = pad_bytes<RefCount>(offset, json_identify<RefCount>(val)) + json_sizeof<RefCount>(val);
+            }
+            return pad_bytes<RefCount>(offset, raw_type::object);
+          }
         case raw_type::array:
-          new(buffer) array<RefCount>(curr_val);
-          break;
+          {
+            auto const elems = curr_val.get_length();
+            size_t offset = sizeof(array<RefCount>) + sizeof(array_entry) * elems;
+            for (auto idx = 0U; idx < elems; ++idx) {
+              auto val = curr_val.get_array_element(idx);
+              offset = pad_bytes<RefCount>(offset, json_identify<RefCount>(val)) + json_sizeof<RefCount>(val);
+            }
+            return offset;
+          }
         case raw_type::small_string:
         case raw_type::string:
-          new(buffer) string(curr_val.GetString(), curr_val.GetStringLength());
-          break;
         case raw_type::big_string:
-          new(buffer) big_string(curr_val.GetString(), curr_val.GetStringLength());
-          break;
-        case raw_type::short_integer:
-          new(buffer) primitive<int16_t>(curr_val.GetInt());
-          break;
-        case raw_type::integer:
-          new(buffer) primitive<int32_t>(curr_val.GetInt());
-          break;
-        case raw_type::long_integer:
-          new(buffer) primitive<int64_t>(curr_val.GetInt64());
-          break;
-        case raw_type::decimal:
-          new(buffer) primitive<float>(curr_val.GetFloat());
-          break;
-        case raw_type::long_decimal:
-          new(buffer) primitive<double>(curr_val.GetDouble());
-          break;
-        case raw_type::boolean:
-          new(buffer) detail::primitive<bool>(curr_val.GetBool());
-          break;
+          return scalar_sizeof<RefCount>(raw, curr_val.get_string_length());
         default:
-          DART_ASSERT(curr_val.IsNull());
-          break;
+          return scalar_sizeof<RefCount>(raw, 0);
       }
-      return detail::find_sizeof<RefCount>({raw, buffer});
+    }
+#endif
+
+
+#ifdef DART_USE_SAJSON
+    // Lowers the given JSON document into memory owned by somebody else,
+    // as long as it fits.
+    template <template <class> class RefCount, class Value>
+    size_t json_lower_into(Value const& root, gsl::span<gsl::byte> dest) {
+      auto const bytes = json_sizeof<RefCount>(root);
+      if (static_cast<size_t>(dest.size()) < bytes) {
+        throw size_error("dart::buffer does not fit in the given buffer", bytes);
+      } else if (align_pointer<RefCount>(dest.data(), raw_type::object) != dest.data()) {
+        throw std::invalid_argument("dart::buffer can only be parsed into memory aligned to a 64-bit word boundary");
+      }
+      std::fill_n(dest.data(), bytes, gsl::byte {});
+      return json_lower<RefCount>(dest.data(), root);
     }
 #endif
 
@@ -1591,6 +3539,18 @@ namespace dart {
       else return view_return_indirection<Packet>(curr);
     }
 
+    template <class Packet>
+    Packet get_path_impl(Packet const& haystack, path const& needle) {
+      // Drag a view through each segment, so only the final value is reference counted.
+      typename Packet::view curr = haystack;
+      for (auto const& seg : needle) {
+        if (curr.is_object()) curr = curr[seg.name.strv()];
+        else if (curr.is_array() && seg.index != path::npos) curr = curr[seg.index];
+        else return Packet::make_null();
+      }
+      return view_return_indirection<Packet>(curr);
+    }
+
     template <class Packet>
     std::vector<Packet> keys_impl(Packet const& that) {
       std::vector<Packet> packets;
@@ -170,6 +170,26 @@ namespace dart {
       layout.offset += diff;
     }
 
+    template <class T>
+    bool vtable_entry<T>::is_inline() const noexcept {
+      return layout.type.get() & vtable_inline_flag;
+    }
+
+    template <class T>
+    void vtable_entry<T>::set_inline() noexcept {
+      layout.type = static_cast<uint8_t>(layout.type.get() | vtable_inline_flag);
+    }
+
+    template <class T>
+    gsl::byte* vtable_entry<T>::inline_value() noexcept {
+      return reinterpret_cast<gsl::byte*>(&layout.offset);
+    }
+
+    template <class T>
+    gsl::byte const* vtable_entry<T>::inline_value() const noexcept {
+      return reinterpret_cast<gsl::byte const*>(&layout.offset);
+    }
+
     inline prefix_entry::prefix_entry(detail::raw_type type, uint32_t offset, shim::string_view prefix) noexcept :
       vtable_entry<prefix_entry>(type, offset)
     {
@@ -223,28 +243,550 @@ namespace dart {
       return detail::prefix_compare_impl<sizeof(prefix_type)>(bytes, str, len);
     }
 
+    key_dictionary::scope::scope(key_dictionary* dict) noexcept : prev(current_slot()) {
+      current_slot() = dict;
+    }
+
+    key_dictionary::scope::~scope() noexcept {
+      current_slot() = prev;
+    }
+
+    key_dictionary::key_dictionary(counts_type const& counts, size_t threshold) :
+      references(0),
+      bytes(sizeof(key_dictionary_layout)),
+      buffer_begin(nullptr),
+      buffer_end(nullptr),
+      section_begin(nullptr),
+      section_end(nullptr)
+    {
+      for (auto const& count : counts) {
+        if (count.second < threshold) continue;
+        keys.push_back(count.first);
+        references += count.second;
+      }
+
+      // Lay the keys out in the same order objects sort them in, so the
+      // section is identical from one finalization to the next.
+      std::sort(keys.begin(), keys.end(), [] (auto lhs, auto rhs) {
+        if (lhs.size() != rhs.size()) return lhs.size() < rhs.size();
+        return lhs < rhs;
+      });
+      for (auto key : keys) {
+        bytes = (bytes + string::alignment - 1) & ~(string::alignment - 1);
+        bytes += string::static_sizeof(static_cast<string::size_type>(key.size()));
+      }
+
+      // Sections must keep the keys that follow them aligned.
+      bytes = (bytes + sizeof(int64_t) - 1) & ~(sizeof(int64_t) - 1);
+    }
+
+    key_dictionary::key_dictionary(gsl::byte const* begin, gsl::byte const* end) noexcept :
+      references(0),
+      bytes(end - begin),
+      buffer_begin(nullptr),
+      buffer_end(nullptr),
+      section_begin(begin),
+      section_end(end)
+    {}
+
+    bool key_dictionary::empty() const noexcept {
+      return keys.empty();
+    }
+
+    size_t key_dictionary::get_sizeof() const noexcept {
+      return bytes;
+    }
+
+    size_t key_dictionary::upper_bound() const noexcept {
+      // The root may need an extension header it wouldn't have otherwise, and a reference,
+      // with its stricter alignment, can take up to a few bytes more than a short key.
+      return sizeof(extension_layout) + bytes + references * sizeof(key_reference);
+    }
+
+    void key_dictionary::bind(gsl::byte const* base, size_t len) noexcept {
+      buffer_begin = base;
+      buffer_end = base + len;
+    }
+
+    size_t key_dictionary::layout(gsl::byte* buffer) noexcept {
+      auto* header = new(buffer) key_dictionary_layout;
+      header->bytes = static_cast<uint32_t>(bytes);
+      header->keys = static_cast<uint32_t>(keys.size());
+
+      size_t offset = sizeof(key_dictionary_layout);
+      for (auto key : keys) {
+        offset = (offset + string::alignment - 1) & ~(string::alignment - 1);
+        new(buffer + offset) string(key);
+        positions.emplace(key, buffer + offset);
+        offset += string::static_sizeof(static_cast<string::size_type>(key.size()));
+      }
+      section_begin = buffer;
+      section_end = buffer + bytes;
+      return bytes;
+    }
+
+    bool key_dictionary::is_root(void const* ptr) const noexcept {
+      return ptr == buffer_begin;
+    }
+
+    bool key_dictionary::in_buffer(void const* ptr) const noexcept {
+      auto const* bytes_ptr = static_cast<gsl::byte const*>(ptr);
+      return bytes_ptr >= buffer_begin && bytes_ptr < buffer_end;
+    }
+
+    gsl::byte const* key_dictionary::find(shim::string_view key) const noexcept {
+      auto const it = positions.find(key);
+      return it == positions.end() ? nullptr : it->second;
+    }
+
+    gsl::byte const* key_dictionary::resolve(gsl::byte const* slot, size_t distance) const noexcept {
+      // Checked without forming any pointers that could land outside the buffer.
+      if (slot < section_begin || distance > static_cast<size_t>(slot - section_begin)) return nullptr;
+      auto const* key = slot - distance;
+      return key < section_end ? key : nullptr;
+    }
+
+    gsl::byte const* key_dictionary::end() const noexcept {
+      return section_end;
+    }
+
+    key_dictionary* key_dictionary::current() noexcept {
+      return current_slot();
+    }
+
+    key_dictionary*& key_dictionary::current_slot() noexcept {
+      static thread_local key_dictionary* curr = nullptr;
+      return curr;
+    }
+
+    prelaid_layout::scope::scope(prelaid_layout const* layout) noexcept : prev(current_slot()) {
+      current_slot() = layout;
+    }
+
+    prelaid_layout::scope::~scope() noexcept {
+      current_slot() = prev;
+    }
+
+    prelaid_layout::prelaid_layout(std::vector<gsl::byte const*> addresses) noexcept :
+      addresses(std::move(addresses))
+    {
+      DART_ASSERT(std::is_sorted(this->addresses.begin(), this->addresses.end()));
+    }
+
+    bool prelaid_layout::contains(void const* ptr) noexcept {
+      auto const* curr = current_slot();
+      if (!curr) return false;
+      auto const& addrs = curr->addresses;
+      return std::binary_search(addrs.begin(), addrs.end(), static_cast<gsl::byte const*>(ptr));
+    }
+
+    prelaid_layout const*& prelaid_layout::current_slot() noexcept {
+      static thread_local prelaid_layout const* curr = nullptr;
+      return curr;
+    }
+
+    perfect_hash_scratch::scope::scope(perfect_hash_scratch* scratch) noexcept : prev(current_slot()) {
+      current_slot() = scratch;
+    }
+
+    perfect_hash_scratch::scope::~scope() noexcept {
+      current_slot() = prev;
+    }
+
+    perfect_hash_scratch::perfect_hash_scratch(size_t keys) :
+      hashes(keys),
+      members(keys),
+      starts(keys + 1),
+      order(keys),
+      candidates(keys),
+      taken(keys)
+    {}
+
+    size_t perfect_hash_scratch::capacity() const noexcept {
+      return hashes.size();
+    }
+
+    perfect_hash_scratch* perfect_hash_scratch::current() noexcept {
+      return current_slot();
+    }
+
+    template <class Heap>
+    size_t perfect_hash_scratch::largest_table(Heap const& hp, finalize_options const& opts) {
+      size_t largest = 0;
+      if (auto* fields = hp.try_get_fields()) {
+        if (fields->size() >= opts.perfect_hash_threshold) largest = fields->size();
+        for (auto const& field : *fields) largest = std::max(largest, largest_table(field.second, opts));
+      } else if (auto* elems = hp.try_get_elements()) {
+        for (auto const& elem : *elems) largest = std::max(largest, largest_table(elem, opts));
+      }
+      return largest;
+    }
+
+    perfect_hash_scratch*& perfect_hash_scratch::current_slot() noexcept {
+      static thread_local perfect_hash_scratch* curr = nullptr;
+      return curr;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::StartObject() {
+      node curr {};
+      curr.type = raw_type::object;
+      auto const idx = add_node(curr);
+      open.emplace_back(idx, pending.size());
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::Key(char const* str, size_t len, bool) {
+      // Values are found through their keys, which they immediately follow.
+      pending.push_back(add_string(str, len));
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::EndObject(size_t) {
+      // Sort our keys real quick, keeping the last of any duplicates.
+      dart_comparator<RefCount> comp;
+      auto const first = pending.begin() + open.back().second;
+      std::stable_sort(first, pending.end(), [&] (auto lhs, auto rhs) {
+        return comp(get_string(lhs), get_string(rhs));
+      });
+      auto last = first;
+      for (auto it = first; it != pending.end(); ++it) {
+        if (it + 1 != pending.end() && get_string(*it) == get_string(*(it + 1))) continue;
+        *last++ = *it;
+      }
+      pending.erase(last, pending.end());
+
+      // Now that we know what order everything goes in, work out exactly how big we are,
+      // the same way the object constructor will.
+      auto& curr = nodes[open.back().first];
+      curr.size = pending.end() - first;
+      auto measure = [&] (size_t bytes) {
+        for (auto it = first; it != pending.end(); ++it) {
+          auto const& key = nodes[*it];
+          auto const& val = nodes[*it + 1];
+          bytes = pad_bytes<RefCount>(bytes, raw_type::string) + key.bytes;
+          bytes = pad_bytes<RefCount>(bytes, val.type) + val.bytes;
+        }
+        return pad_bytes<RefCount>(bytes, raw_type::object);
+      };
+      curr.bytes = measure(sizeof(object<RefCount>) + sizeof(object_entry) * curr.size);
+
+      // Objects that don't fit the ordinary encoding use the large one.
+      if (curr.bytes > large_limit || curr.size > aggregate_size_mask) {
+        curr.type = raw_type::large_object;
+        curr.bytes = measure(sizeof(large_object<RefCount>) + sizeof(large_object_entry) * curr.size);
+      }
+      end_aggregate();
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::StartArray() {
+      node curr {};
+      curr.type = raw_type::array;
+      auto const idx = add_node(curr);
+      open.emplace_back(idx, pending.size());
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::EndArray(size_t) {
+      // Work out exactly how big we are, the same way the array constructor will.
+      auto& curr = nodes[open.back().first];
+      auto const first = pending.begin() + open.back().second;
+      curr.size = pending.end() - first;
+      auto measure = [&] (size_t bytes) {
+        for (auto it = first; it != pending.end(); ++it) {
+          auto const& elem = nodes[*it];
+          bytes = pad_bytes<RefCount>(bytes, elem.type) + elem.bytes;
+        }
+        return bytes;
+      };
+      curr.bytes = measure(sizeof(array<RefCount>) + sizeof(array_entry) * curr.size);
+
+      // Arrays that don't fit the ordinary encoding use the large one, which is padded out
+      // like an object.
+      if (curr.bytes > large_limit || curr.size > aggregate_size_mask) {
+        curr.type = raw_type::large_array;
+        curr.bytes = measure(sizeof(large_array<RefCount>) + sizeof(large_array_entry) * curr.size);
+        curr.bytes = pad_bytes<RefCount>(curr.bytes, raw_type::array);
+      }
+      end_aggregate();
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::String(char const* str, size_t len, bool) {
+      add_string(str, len);
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::Int(int num) {
+      return Int64(num);
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::Uint(unsigned num) {
+      return Int64(num);
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::Int64(int64_t num) {
+      node curr {};
+      curr.type = identify_integer(num);
+      curr.bytes = scalar_sizeof<RefCount>(curr.type, 0);
+      curr.integer = num;
+      add_node(curr);
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::Uint64(uint64_t num) {
+      // Anything too big for a signed integer can only be represented approximately.
+      if (num > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) return Double(static_cast<double>(num));
+      else return Int64(static_cast<int64_t>(num));
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::Double(double num) {
+      node curr {};
+      curr.type = identify_decimal(num);
+      curr.bytes = scalar_sizeof<RefCount>(curr.type, 0);
+      curr.decimal = num;
+      add_node(curr);
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::RawNumber(char const*, size_t, bool) {
+      // Rapidjson doesn't detect characteristics of incoming parse-type, so this has to be implemented
+      // regardless of whether it'll be used.
+      throw std::logic_error("dart::packet library is misconfigured, unimplemented RawNumber handler called");
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::Bool(bool val) {
+      node curr {};
+      curr.type = raw_type::boolean;
+      curr.bytes = scalar_sizeof<RefCount>(curr.type, 0);
+      curr.boolean = val;
+      add_node(curr);
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::Null() {
+      node curr {};
+      curr.type = raw_type::null;
+      add_node(curr);
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    buffer_parser<RefCount>::buffer_parser(size_t large_limit) noexcept : large_limit(large_limit) {}
+
+    template <template <class> class RefCount>
+    void buffer_parser<RefCount>::clear() noexcept {
+      nodes.clear();
+      strings.clear();
+      children.clear();
+      open.clear();
+      pending.clear();
+
+      // Give back whatever an unusually large document left us with.
+      auto const retained = nodes.capacity() * sizeof(node) + strings.capacity()
+        + (children.capacity() + pending.capacity()) * sizeof(size_t)
+        + open.capacity() * sizeof(std::pair<size_t, size_t>);
+      if (retained > DART_PARSER_RETAINED_BYTES) {
+        std::vector<node> {}.swap(nodes);
+        std::vector<char> {}.swap(strings);
+        std::vector<size_t> {}.swap(children);
+        std::vector<std::pair<size_t, size_t>> {}.swap(open);
+        std::vector<size_t> {}.swap(pending);
+      }
+    }
+
+    template <template <class> class RefCount>
+    bool buffer_parser<RefCount>::complete() const noexcept {
+      return !nodes.empty() && open.empty();
+    }
+
+    template <template <class> class RefCount>
+    raw_type buffer_parser<RefCount>::root_type() const noexcept {
+      return nodes.empty() ? raw_type::null : nodes.front().type;
+    }
+
+    template <template <class> class RefCount>
+    size_t buffer_parser<RefCount>::get_sizeof() const noexcept {
+      DART_ASSERT(complete());
+      return nodes.front().bytes;
+    }
+
+    template <template <class> class RefCount>
+    size_t buffer_parser<RefCount>::layout(gsl::byte* buffer) const noexcept {
+      DART_ASSERT(complete());
+      return lower(buffer, 0);
+    }
+
+    template <template <class> class RefCount>
+    raw_type buffer_parser<RefCount>::get_type(size_t idx) const noexcept {
+      return nodes[idx].type;
+    }
+
+    template <template <class> class RefCount>
+    shim::string_view buffer_parser<RefCount>::get_string(size_t idx) const noexcept {
+      auto const& curr = nodes[idx];
+      return {strings.data() + curr.offset, curr.size};
+    }
+
+    template <template <class> class RefCount>
+    gsl::span<size_t const> buffer_parser<RefCount>::get_children(size_t idx) const noexcept {
+      auto const& curr = nodes[idx];
+      return gsl::make_span(children.data() + curr.offset, curr.size);
+    }
+
+    template <template <class> class RefCount>
+    size_t buffer_parser<RefCount>::lower(gsl::byte* buffer, size_t idx) const noexcept {
+      auto const& curr = nodes[idx];
+      switch (curr.type) {
+        case raw_type::object:
+          new(buffer) object<RefCount>(*this, idx);
+          break;
+        case raw_type::array:
+          new(buffer) array<RefCount>(*this, idx);
+          break;
+        case raw_type::large_object:
+          new(buffer) large_object<RefCount>(*this, idx);
+          break;
+        case raw_type::large_array:
+          new(buffer) large_array<RefCount>(*this, idx);
+          break;
+        case raw_type::small_string:
+        case raw_type::string:
+          new(buffer) string(get_string(idx));
+          break;
+        case raw_type::big_string:
+          new(buffer) big_string(get_string(idx));
+          break;
+        case raw_type::short_integer:
+          new(buffer) primitive<int16_t>(static_cast<int16_t>(curr.integer));
+          break;
+        case raw_type::integer:
+          new(buffer) primitive<int32_t>(static_cast<int32_t>(curr.integer));
+          break;
+        case raw_type::long_integer:
+          new(buffer) primitive<int64_t>(curr.integer);
+          break;
+        case raw_type::decimal:
+          new(buffer) primitive<float>(static_cast<float>(curr.decimal));
+          break;
+        case raw_type::long_decimal:
+          new(buffer) primitive<double>(curr.decimal);
+          break;
+        case raw_type::boolean:
+          new(buffer) primitive<bool>(curr.boolean);
+          break;
+        default:
+          DART_ASSERT(curr.type == raw_type::null);
+          break;
+      }
+      DART_ASSERT(find_sizeof<RefCount>({curr.type, buffer}) == curr.bytes);
+      return curr.bytes;
+    }
+
+    template <template <class> class RefCount>
+    size_t buffer_parser<RefCount>::add_node(node curr) {
+      if (open.empty() && !nodes.empty()) {
+        throw parse_error("dart::buffer can only be parsed from a single JSON document");
+      }
+
+      // Array elements are remembered as they arrive, object values are found through their keys.
+      auto const idx = nodes.size();
+      nodes.push_back(curr);
+      if (!open.empty() && nodes[open.back().first].type == raw_type::array) pending.push_back(idx);
+      return idx;
+    }
+
+    template <template <class> class RefCount>
+    size_t buffer_parser<RefCount>::add_string(char const* str, size_t len) {
+      // Strings are only guaranteed to live as long as the event, so copy them out.
+      node curr {};
+      curr.type = identify_string<RefCount>({str, len});
+      curr.size = len;
+      curr.bytes = scalar_sizeof<RefCount>(curr.type, len);
+      curr.offset = strings.size();
+      strings.insert(strings.end(), str, str + len);
+      return add_node(curr);
+    }
+
+    template <template <class> class RefCount>
+    void buffer_parser<RefCount>::end_aggregate() {
+      // Hand our children over for safe keeping.
+      auto& curr = nodes[open.back().first];
+      auto const first = pending.begin() + open.back().second;
+      curr.offset = children.size();
+      children.insert(children.end(), first, pending.end());
+      pending.erase(first, pending.end());
+      open.pop_back();
+    }
+
     template <template <class> class RefCount>
     template <class Span>
-    auto buffer_builder<RefCount>::build_buffer(Span pairs) -> buffer {
+    auto buffer_builder<RefCount>::build_buffer(Span pairs, finalize_options const& opts) -> buffer {
       using owner = buffer_refcount_type<RefCount>;
 
       // Low level object code assumes keys are sorted, so validate that assumption.
       std::sort(std::begin(pairs), std::end(pairs), dart_comparator<RefCount> {});
 
+      // Rows of a record batch, and anything that refers to a key dictionary, don't own all of
+      // their bytes, and have to be copied out through the API, which can throw, so it has to
+      // happen before anything is laid out.
+      for (auto& pair : pairs) {
+        auto* value = pair.value.try_get_buffer();
+        if (value && is_dependent<RefCount>(value->raw)) pair.value = basic_packet<RefCount> {basic_heap<RefCount> {*value}};
+      }
+
       // Calculate how much space we'll need.
-      auto bytes = max_bytes(pairs);
+      auto bytes = max_bytes(pairs, opts);
+
+      // Perfect hash tables are built as objects are laid out, which can't allocate.
+      shim::optional<perfect_hash_scratch> scratch;
+      if (opts.perfect_hash_threshold != std::numeric_limits<size_t>::max()) {
+        size_t largest = pairs.size() >= opts.perfect_hash_threshold ? pairs.size() : 0;
+        for (auto const& pair : pairs) {
+          if (auto* heap = pair.value.try_get_heap()) {
+            largest = std::max(largest, perfect_hash_scratch::largest_table(*heap, opts));
+          }
+        }
+        scratch.emplace(largest);
+      }
 
       // Build it.
-      auto ref = aligned_alloc<RefCount>(max_bytes(pairs), raw_type::object, [&] (auto* ptr) {
+      auto ref = aligned_alloc<RefCount>(bytes, raw_type::object, [&] (auto* ptr) {
         // XXX: std::fill_n is REQUIRED here so that we can perform memcmps for finalized packets.
         std::fill_n(ptr, bytes, gsl::byte {});
-        new(ptr) detail::object<RefCount>(pairs);
+        perfect_hash_scratch::scope guard {scratch ? &*scratch : nullptr};
+        new(ptr) detail::object<RefCount>(pairs, opts);
       });
       return basic_buffer<RefCount> {std::move(ref)};
     }
 
     template <template <class> class RefCount>
     auto buffer_builder<RefCount>::merge_buffers(buffer const& base, buffer const& incoming) -> buffer {
+      // Large objects are merged on the heap, which lays the result out again from scratch.
+      if (base.raw.type == raw_type::large_object || incoming.raw.type == raw_type::large_object) {
+        basic_heap<RefCount> merged {base};
+        for (auto const& key : incoming.keys()) merged.add_field(basic_heap<RefCount> {key}, basic_heap<RefCount> {incoming.get(key.strv())});
+        return buffer {merged};
+      }
+
+      // Merging copies fields byte for byte, which not every object supports.
+      if (!is_copyable(base)) return merge_buffers(materialize(base), incoming);
+      else if (!is_copyable(incoming)) return merge_buffers(base, materialize(incoming));
+
       // Unwrap our buffers to get the underlying machine representation.
       auto* raw_base = get_object<RefCount>(base.raw);
       auto* raw_incoming = get_object<RefCount>(incoming.raw);
@@ -260,9 +802,36 @@ namespace dart {
       return basic_buffer<RefCount> {std::move(ref)};
     }
 
+    template <template <class> class RefCount>
+    bool buffer_builder<RefCount>::is_copyable(buffer const& base) noexcept {
+      // Rows of a record batch, and objects that refer to a key dictionary, don't own all of
+      // their bytes, and objects holding a key dictionary can only be copied as a whole.
+      // Small objects have a different layout entirely.
+      if (is_dependent<RefCount>(base.raw)) return false;
+      return base.raw.type == raw_type::object && !get_object<RefCount>(base.raw)->owns_dictionary();
+    }
+
+    template <template <class> class RefCount>
+    auto buffer_builder<RefCount>::materialize(buffer const& base) -> buffer {
+      // Copies everything out through the API into a plain object.
+      return buffer {basic_heap<RefCount> {base}};
+    }
+
     template <template <class> class RefCount>
     template <class Spannable>
     auto buffer_builder<RefCount>::project_keys(buffer const& base, Spannable const& keys) -> buffer {
+      // Large objects are projected on the heap, as the result is likely small enough not to be one.
+      if (base.raw.type == raw_type::large_object) {
+        auto projected = basic_heap<RefCount>::make_object();
+        for (auto const& key : keys) {
+          if (base.has_key(key)) projected.add_field(basic_heap<RefCount>::make_string(key), basic_heap<RefCount> {base.get(key)});
+        }
+        return buffer {projected};
+      }
+
+      // Projecting copies fields byte for byte, which not every object supports.
+      if (!is_copyable(base)) return project_keys(materialize(base), keys);
+
       return detail::sort_spannable<RefCount>(keys, [&] (auto key_ptrs) {
         // Unwrap our buffers to get the underlying machine representation.
         auto* raw_base = get_object<RefCount>(base.raw);
@@ -279,7 +848,7 @@ namespace dart {
 
     template <template <class> class RefCount>
     template <class Span>
-    size_t buffer_builder<RefCount>::max_bytes(Span pairs) {
+    size_t buffer_builder<RefCount>::max_bytes(Span pairs, finalize_options const& opts) {
       // Walk across the span of pairs and calculate the total required memory.
       size_t bytes = 0;
       shim::optional<shim::string_view> prev_key;
@@ -296,10 +865,17 @@ namespace dart {
 
         // Accumulate the total number of bytes.
         bytes += pair.key.upper_bound() + alignment_of<RefCount>(pair.key.get_raw_type()) - 1;
-        bytes += pair.value.upper_bound() + alignment_of<RefCount>(pair.value.get_raw_type()) - 1;
+        bytes += pair.value.upper_bound(opts) + alignment_of<RefCount>(pair.value.get_raw_type()) - 1;
       }
       bytes += sizeof(detail::object<RefCount>) + ((sizeof(detail::object_entry) * (pairs.size() + 1)));
-      return bytes + detail::pad_bytes<RefCount>(bytes, detail::raw_type::object);
+      bytes += object<RefCount>::extension_sizeof(object<RefCount>::extension_flags(pairs.size(), opts), pairs.size());
+      bytes += detail::pad_bytes<RefCount>(bytes, detail::raw_type::object);
+
+      // Objects built directly from pairs always use the ordinary encoding, larger ones have to go through dart::heap.
+      if (bytes > object_layout::max_offset) {
+        throw std::length_error("dart::buffer is too large to build directly, and must be finalized from a dart::heap");
+      }
+      return bytes;
     }
 
     template <template <class> class RefCount>
@@ -413,6 +989,148 @@ namespace dart {
       }
     }
 
+    template <template <class> class RefCount>
+    uint64_t hash_contents(raw_element elem) noexcept {
+      switch (simplify_type(elem.type)) {
+        case type::object:
+          // Objects that carry their own hash don't have to be walked at all.
+          if (auto stored = stored_hash<RefCount>(elem)) return *stored;
+          return object_deref<RefCount>([] (auto& obj) {
+            uint64_t fields = 0;
+            auto keys = obj.key_begin();
+            for (auto vals = obj.begin(); vals != obj.end(); ++keys, ++vals) {
+              auto const key = string_deref([] (auto& str) { return str.get_strv(); }, *keys);
+              fields += hash_field(hash_string(key), hash_contents<RefCount>(*vals));
+            }
+            return hash_object(obj.size(), fields);
+          }, elem);
+        case type::array:
+          return array_deref<RefCount>([] (auto& arr) {
+            auto hash = hash_array(arr.size());
+            for (auto it = arr.begin(); it != arr.end(); ++it) hash = hash_combine(hash, hash_contents<RefCount>(*it));
+            return hash;
+          }, elem);
+        case type::string:
+          return hash_string(string_deref([] (auto& str) { return str.get_strv(); }, elem));
+        case type::integer:
+          return hash_integer(integer_deref([] (auto& num) { return static_cast<int64_t>(num.get_data()); }, elem));
+        case type::decimal:
+          return hash_decimal(decimal_deref([] (auto& num) { return static_cast<double>(num.get_data()); }, elem));
+        case type::boolean:
+          return hash_boolean(get_primitive<bool>(elem)->get_data());
+        default:
+          return hash_null();
+      }
+    }
+
+    template <template <class> class RefCount>
+    shim::optional<uint64_t> stored_hash(raw_element elem) noexcept {
+      if (elem.type != raw_type::object) return shim::nullopt;
+      auto const* obj = get_object<RefCount>(elem);
+      if (!obj->has_content_hash()) return shim::nullopt;
+      return obj->content_hash();
+    }
+
+    template <class Packet>
+    uint64_t hash_generic(Packet const& pkt) noexcept {
+      // Must agree with hash_contents for every value, so that equal values hash the same
+      // whether they've been finalized or not.
+      switch (pkt.get_type()) {
+        case type::object:
+          {
+            uint64_t fields = 0;
+            typename Packet::iterator k, v;
+            std::tie(k, v) = pkt.kvbegin();
+            while (v != pkt.end()) {
+              fields += hash_field(hash_string((*k).strv()), hash_generic(*v));
+              ++k, ++v;
+            }
+            return hash_object(pkt.size(), fields);
+          }
+        case type::array:
+          {
+            auto hash = hash_array(pkt.size());
+            for (auto const& elem : pkt) hash = hash_combine(hash, hash_generic(elem));
+            return hash;
+          }
+        case type::string:
+          return hash_string(pkt.strv());
+        case type::integer:
+          return hash_integer(pkt.integer());
+        case type::decimal:
+          return hash_decimal(pkt.decimal());
+        case type::boolean:
+          return hash_boolean(pkt.boolean());
+        default:
+          return hash_null();
+      }
+    }
+
+  }
+
+  inline key::key(shim::string_view name) :
+    name(name.data(), name.size()),
+    meta(detail::key_meta(name)),
+    hash(detail::hash_key(name, 0)),
+    hint(0)
+  {}
+
+  inline key::key(key const& other) :
+    name(other.name),
+    meta(other.meta),
+    hash(other.hash),
+    hint(other.hint.load(std::memory_order_relaxed))
+  {}
+
+  inline key& key::operator =(key const& other) {
+    if (this == &other) return *this;
+    name = other.name;
+    meta = other.meta;
+    hash = other.hash;
+    hint.store(other.hint.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+  }
+
+  inline shim::string_view key::strv() const noexcept {
+    return name;
+  }
+
+  inline size_t key::size() const noexcept {
+    return name.size();
+  }
+
+  inline path::path(shim::string_view needle, char separator) {
+    // Split the same way get_nested does, so the two agree about every path.
+    auto start = needle.begin();
+    while (start < needle.end()) {
+      auto stop = std::find(start, needle.end(), separator);
+      auto const name = needle.substr(start - needle.begin(), stop - start);
+
+      // Segments of digits double as array indices, as long as they fit.
+      size_t index = name.empty() ? npos : 0;
+      for (auto c : name) {
+        if (c < '0' || c > '9' || index > (npos - 10) / 10) {
+          index = npos;
+          break;
+        }
+        index = index * 10 + static_cast<size_t>(c - '0');
+      }
+      segments.push_back({dart::key {name}, index});
+
+      stop == needle.end() ? start = stop : start = stop + 1;
+    }
+  }
+
+  inline auto path::begin() const noexcept -> const_iterator {
+    return segments.begin();
+  }
+
+  inline auto path::end() const noexcept -> const_iterator {
+    return segments.end();
+  }
+
+  inline size_t path::size() const noexcept {
+    return segments.size();
   }
 
 }
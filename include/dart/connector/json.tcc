@@ -7,7 +7,7 @@
 
 /*----- Type Declarations -----*/
 
-#if DART_HAS_RAPIDJSON
+#if DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
 namespace dart {
   namespace detail {
     template <template <class> class RefCount>
@@ -15,7 +15,7 @@ namespace dart {
 
       /*----- Types -----*/
 
-      using size_type = rapidjson::SizeType;
+      using size_type = size_t;
 
       /*----- API -----*/
 
@@ -48,6 +48,17 @@ namespace dart {
 
 /*----- Function Declarations -----*/
 
+namespace dart {
+  namespace detail {
+    template <unsigned flags, class Handler>
+    void json_parse(shim::string_view json, Handler& handler, char const* name);
+    template <template <class> class RefCount, unsigned flags>
+    buffer_parser<RefCount>& buffer_parse(shim::string_view json);
+  }
+}
+#endif
+
+#if DART_HAS_RAPIDJSON
 namespace dart {
   namespace detail {
     template <class Writer, class Packet>
@@ -98,9 +109,10 @@ namespace dart {
     sajson::string view {json.data(), json.size()};
     auto doc = detail::sajson_parse(view, stack);
 
-    // Allocate space to store our finalized representation.
-    // FIXME: Make this allocation size more intelligent.
-    auto block = detail::aligned_alloc<RefCount>(json.size() * 8, detail::raw_type::object, [&] (auto* buf) {
+    // Allocate exactly as much space as our finalized representation needs.
+    auto const bytes = detail::json_sizeof<RefCount>(doc.get_root());
+    auto block = detail::aligned_alloc<RefCount>(bytes, detail::raw_type::object, [&] (auto* buf) {
+      std::fill_n(buf, bytes, gsl::byte {});
       detail::json_lower<RefCount>(buf, doc.get_root());
     });
 
@@ -108,6 +120,23 @@ namespace dart {
     return basic_buffer {std::move(block)};
   }
 
+  template <template <class> class RefCount>
+  template <unsigned parse_stack_size, bool, class EnableIf>
+  auto basic_buffer<RefCount>::from_json_into(shim::string_view json, gsl::span<gsl::byte> dest) -> size_type {
+    // Allocate however much stack space was requested.
+    std::array<size_t, parse_stack_size / sizeof(size_t)> stack;
+
+    // Have sajson parse our string, potentially using the stack space.
+    sajson::string view {json.data(), json.size()};
+    auto doc = detail::sajson_parse(view, stack);
+    if (doc.get_root().get_type() != sajson::TYPE_OBJECT) {
+      throw type_error("dart::buffer root must be an object.");
+    }
+
+    // Lay it out in the caller's memory.
+    return detail::json_lower_into<RefCount>(doc.get_root(), dest);
+  }
+
   template <template <class> class RefCount>
   template <unsigned parse_stack_size, bool, class EnableIf>
   basic_packet<RefCount> basic_packet<RefCount>::from_json(shim::string_view json, bool finalized) {
@@ -132,65 +161,50 @@ namespace dart {
   basic_packet<RefCount> basic_packet<RefCount>::parse(shim::string_view json, bool finalized) {
     return basic_packet::from_json(json, finalized);
   }
-#elif DART_HAS_RAPIDJSON
+#elif DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
   template <template <class> class RefCount>
   template <unsigned flags, bool enabled, class EnableIf>
   basic_heap<RefCount> basic_heap<RefCount>::from_json(shim::string_view json) {
-    // Construct a reader class to parse this string.
-    rapidjson::Reader reader;
-
-    // Construct a dart::packet heap_parser context to go with it.
     detail::heap_parser<RefCount> context;
-
-    // Parse!
-    rapidjson::MemoryStream ss(json.data(), json.size());
-    if (reader.Parse<flags>(ss, context)) {
-      return context.curr_obj;
-    } else {
-      auto err = reader.GetParseErrorCode();
-      auto off = reader.GetErrorOffset();
-      std::string errmsg = "dart::heap could not parse the given string due to: \"";
-      errmsg += rapidjson::GetParseError_En(err);
-      errmsg += "\" near  \"";
-      errmsg += std::string {json.substr(off ? off - 1 : off, off + 10 < json.size() ? 10 : shim::string_view::npos)};
-      errmsg += "\"";
-      throw parse_error(errmsg.data());
-    }
+    detail::json_parse<flags>(json, context, "dart::heap");
+    return context.curr_obj;
   }
 
   template <template <class> class RefCount>
   template <unsigned flags, bool enabled, class EnableIf>
   basic_buffer<RefCount> basic_buffer<RefCount>::from_json(shim::string_view json) {
-    // Duplicate the given string locally so we can use the RapidJSON in-situ parser.
-    auto buf = std::make_unique<char[]>(json.size() + 1);
-    std::copy_n(json.data(), json.size(), buf.get());
-    buf[json.size()] = '\0';
-
-    // Fire up RapidJSON.
-    rapidjson::Document doc;
-    if (doc.ParseInsitu<flags>(buf.get()).HasParseError()) {
-      auto err = doc.GetParseError();
-      auto off = doc.GetErrorOffset();
-      std::string errmsg = "dart::buffer could not parse the given string due to: \"";
-      errmsg += rapidjson::GetParseError_En(err);
-      errmsg += "\" near \"";
-      errmsg += std::string {json.substr(off ? off - 1 : off, 10)};
-      errmsg += "...\"";
-      throw parse_error(errmsg.data());
-    } else if (!doc.IsObject()) {
-      throw type_error("dart::buffer root must be an object.");
-    }
-
-    // Allocate space to store our finalized representation.
-    // FIXME: Make this allocation size more intelligent.
-    auto block = detail::aligned_alloc<RefCount>(json.size() * 8, detail::raw_type::object, [&] (auto* buf) {
-      detail::json_lower<RefCount>(buf, doc);
+    // Stream the string straight into the buffer parser, which knows exactly how
+    // much space we need by the time it's done.
+    auto& parser = detail::buffer_parse<RefCount, flags>(json);
+    auto const bytes = parser.get_sizeof();
+    auto block = detail::aligned_alloc<RefCount>(bytes, detail::raw_type::object, [&] (auto* buf) {
+      std::fill_n(buf, bytes, gsl::byte {});
+      parser.layout(buf);
     });
+    parser.clear();
 
     // Export our buffer to the user.
     return basic_buffer {std::move(block)};
   }
 
+  template <template <class> class RefCount>
+  template <unsigned flags, bool enabled, class EnableIf>
+  auto basic_buffer<RefCount>::from_json_into(shim::string_view json, gsl::span<gsl::byte> dest) -> size_type {
+    auto& parser = detail::buffer_parse<RefCount, flags>(json);
+    auto const bytes = parser.get_sizeof();
+    if (static_cast<size_t>(dest.size()) < bytes) {
+      throw size_error("dart::buffer does not fit in the given buffer", bytes);
+    } else if (detail::align_pointer<RefCount>(dest.data(), detail::raw_type::object) != dest.data()) {
+      throw std::invalid_argument("dart::buffer can only be parsed into memory aligned to a 64-bit word boundary");
+    }
+
+    // Lay it out in the caller's memory.
+    std::fill_n(dest.data(), bytes, gsl::byte {});
+    auto const written = parser.layout(dest.data());
+    parser.clear();
+    return written;
+  }
+
   template <template <class> class RefCount>
   template <unsigned flags, bool enabled, class EnableIf>
   basic_packet<RefCount> basic_packet<RefCount>::from_json(shim::string_view json, bool finalized) {
@@ -299,7 +313,7 @@ namespace dart {
 
 namespace dart {
   namespace detail {
-#if DART_HAS_RAPIDJSON
+#if DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
     template <template <class> class RefCount>
     bool heap_parser<RefCount>::StartObject() {
       if (curr_key) key_stack.push_back(std::move(curr_key));
@@ -415,6 +429,50 @@ namespace dart {
       return true;
     }
 
+    template <unsigned flags, class Handler>
+    void json_parse(shim::string_view json, Handler& handler, char const* name) {
+#ifdef DART_USE_NATIVE_JSON
+      // The reader hangs onto its structural index between calls.
+      static thread_local json_reader reader;
+      if (reader.parse<flags>(json.data(), json.size(), handler)) return;
+      auto const* err = reader.error();
+      auto const off = reader.error_offset();
+#else
+      rapidjson::Reader reader;
+      rapidjson::MemoryStream ss(json.data(), json.size());
+      if (reader.Parse<flags>(ss, handler)) return;
+      auto const* err = rapidjson::GetParseError_En(reader.GetParseErrorCode());
+      auto const off = reader.GetErrorOffset();
+#endif
+
+      std::string errmsg = name;
+      errmsg += " could not parse the given string due to: \"";
+      errmsg += err;
+      errmsg += "\" near \"";
+      errmsg += std::string {json.substr(off ? off - 1 : off, 10)};
+      errmsg += "...\"";
+      throw parse_error(errmsg.data());
+    }
+
+    template <template <class> class RefCount, unsigned flags>
+    buffer_parser<RefCount>& buffer_parse(shim::string_view json) {
+      // Every thread keeps its own parser around, so parsing a steady stream
+      // of documents stops allocating scratch space after the first few.
+      // Clearing the parser gives back whatever an unusually large document needed.
+      static thread_local buffer_parser<RefCount> parser;
+      parser.clear();
+
+      // Parse!
+      json_parse<flags>(json, parser, "dart::buffer");
+      auto const root = parser.root_type();
+      if (root != raw_type::object && root != raw_type::large_object) {
+        throw type_error("dart::buffer root must be an object.");
+      }
+      return parser;
+    }
+#endif
+
+#if DART_HAS_RAPIDJSON
     template <class Writer, class Packet>
     void json_serialize(Writer& writer, Packet const& packet) {
       switch (packet.get_type()) {
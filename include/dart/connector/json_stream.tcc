@@ -0,0 +1,503 @@
+#ifndef DART_JSON_STREAM_IMPL_H
+#define DART_JSON_STREAM_IMPL_H
+
+/*----- Local Includes -----*/
+
+#include "../common.h"
+
+/*----- System Includes -----*/
+
+#include <cerrno>
+#include <thread>
+#include <istream>
+#include <exception>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/*----- Function Implementations -----*/
+
+#if defined(DART_USE_SAJSON) || DART_HAS_RAPIDJSON || defined(DART_USE_NATIVE_JSON)
+namespace dart {
+
+  namespace detail {
+    // Whitespace, as far as JSON is concerned.
+    inline bool is_json_space(char c) noexcept {
+      return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    inline shim::string_view trim_json_space(shim::string_view json) noexcept {
+      while (!json.empty() && is_json_space(json.back())) json.remove_suffix(1);
+      while (!json.empty() && is_json_space(json.front())) json.remove_prefix(1);
+      return json;
+    }
+
+    inline stream_parse_error locate_error(char const* name, char const* what, size_t off, size_t line) {
+      std::string msg = name;
+      msg += " could not parse the value on line " + std::to_string(line)
+        + " at offset " + std::to_string(off) + ": " + what;
+      return stream_parse_error(msg.data(), off, line);
+    }
+
+    // Rethrows whatever a line threw as a dart::stream_parse_error, so it keeps its position.
+    [[noreturn]] inline void rethrow_located(char const* name, std::exception_ptr err, size_t off, size_t line) {
+      try {
+        std::rethrow_exception(err);
+      } catch (stream_parse_error const&) {
+        throw;
+      } catch (std::exception const& inner) {
+        throw locate_error(name, inner.what(), off, line);
+      } catch (...) {
+        throw locate_error(name, "unknown exception", off, line);
+      }
+    }
+  }
+
+  template <class Packet, unsigned flags>
+  basic_json_stream_parser<Packet, flags>::basic_json_stream_parser(mode framing,
+      size_type read_size, size_type max_value) :
+    framing(framing),
+    read_size(read_size ? read_size : 1),
+    max_value(max_value)
+  {
+    reset();
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::feed(gsl::span<char const> chunk, Callback&& cb) -> size_type {
+    // Whatever an exception left unconsumed goes ahead of the new chunk.
+    if (!backlog.empty()) {
+      auto prev = std::move(backlog);
+      backlog.clear();
+      prev.append(chunk.data(), chunk.size());
+      return consume(prev.data(), prev.size(), cb);
+    }
+    return consume(chunk.data(), chunk.size(), cb);
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::finish(Callback&& cb) -> size_type {
+    auto emitted = feed(gsl::span<char const> {}, cb);
+    try {
+      switch (state) {
+        case lexer::idle:
+          break;
+        case lexer::scalar:
+          emitted += complete(nullptr, 0, framing == mode::ndjson, cb);
+          break;
+        default:
+          throw stream_parse_error("dart::json_stream_parser stream ended in the middle of a value", value_offset, value_line);
+      }
+    } catch (...) {
+      // There's nothing left to pick back up from.
+      reset();
+      throw;
+    }
+    reset();
+    return emitted;
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::read(std::FILE* file, Callback&& cb) -> size_type {
+    size_type emitted = 0;
+    read_buf.resize(read_size);
+    while (true) {
+      // fread only comes up short at end of file, or on error, and isn't required to set errno either way.
+      errno = 0;
+      auto const got = std::fread(read_buf.data(), 1, read_buf.size(), file);
+      auto const err = errno;
+      if (got) emitted += feed(gsl::make_span(read_buf.data(), got), cb);
+      if (got < read_buf.size()) {
+        if (std::ferror(file)) {
+          auto const code = err ? std::error_code(err, std::generic_category()) : std::make_error_code(std::errc::io_error);
+          throw std::system_error(code, "dart::json_stream_parser could not read from the given file");
+        }
+        break;
+      }
+    }
+    return emitted + finish(cb);
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::read(int fd, Callback&& cb) -> size_type {
+    size_type emitted = 0;
+    read_buf.resize(read_size);
+    while (true) {
+#ifdef _WIN32
+      auto const got = ::_read(fd, read_buf.data(), static_cast<unsigned>(read_buf.size()));
+#else
+      auto const got = ::read(fd, read_buf.data(), read_buf.size());
+#endif
+      if (got < 0) {
+        if (errno == EINTR) continue;
+        throw std::system_error(errno, std::generic_category(), "dart::json_stream_parser could not read from the given descriptor");
+      } else if (!got) {
+        break;
+      }
+      emitted += feed(gsl::make_span(read_buf.data(), static_cast<size_type>(got)), cb);
+    }
+    return emitted + finish(cb);
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::read(std::istream& in, Callback&& cb) -> size_type {
+    size_type emitted = 0;
+    read_buf.resize(read_size);
+    while (in) {
+      in.read(read_buf.data(), static_cast<std::streamsize>(read_buf.size()));
+      auto const got = static_cast<size_type>(in.gcount());
+      if (got) emitted += feed(gsl::make_span(read_buf.data(), got), cb);
+    }
+    if (in.bad()) throw std::ios_base::failure("dart::json_stream_parser could not read from the given stream");
+    return emitted + finish(cb);
+  }
+
+  template <class Packet, unsigned flags>
+  void basic_json_stream_parser<Packet, flags>::reset() noexcept {
+    state = lexer::idle;
+    depth = 0;
+    consumed = 0;
+    lines = 1;
+    value_offset = 0;
+    value_line = 1;
+    oversized = false;
+    partial.clear();
+    backlog.clear();
+  }
+
+  template <class Packet, unsigned flags>
+  bool basic_json_stream_parser<Packet, flags>::pending() const noexcept {
+    return state != lexer::idle || !backlog.empty();
+  }
+
+  template <class Packet, unsigned flags>
+  auto basic_json_stream_parser<Packet, flags>::offset() const noexcept -> size_type {
+    return consumed;
+  }
+
+  template <class Packet, unsigned flags>
+  auto basic_json_stream_parser<Packet, flags>::line() const noexcept -> size_type {
+    return lines;
+  }
+
+  template <class Packet, unsigned flags>
+  auto basic_json_stream_parser<Packet, flags>::buffered() const noexcept -> size_type {
+    return partial.size();
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::consume(char const* data, size_type len, Callback& cb) -> size_type {
+    size_type pos = 0;
+    try {
+      auto const emitted = framing == mode::ndjson
+        ? consume_lines(data, len, pos, cb)
+        : consume_values(data, len, pos, cb);
+      consumed += len;
+      return emitted;
+    } catch (...) {
+      // Whatever threw, the value it was thrown for is gone, so hang onto everything after it
+      // and pick up from there next time.
+      state = lexer::idle;
+      depth = 0;
+      oversized = false;
+      partial.clear();
+      backlog.assign(data + pos, len - pos);
+      consumed += pos;
+      throw;
+    }
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::consume_values(char const* data,
+      size_type len, size_type& pos, Callback& cb) -> size_type {
+    // Values that started in an earlier chunk pick up from the beginning of this one.
+    size_type emitted = 0, start = 0;
+    while (pos < len) {
+      switch (state) {
+        case lexer::idle:
+          {
+            auto const c = data[pos];
+            if (detail::is_json_space(c)) {
+              if (c == '\n') ++lines;
+              ++pos;
+              continue;
+            }
+            start = pos++;
+            value_offset = consumed + start;
+            value_line = lines;
+            if (c == '{' || c == '[') {
+              state = lexer::aggregate;
+              depth = 1;
+            } else if (c == '"') {
+              state = lexer::string;
+            } else {
+              state = lexer::scalar;
+            }
+            break;
+          }
+        case lexer::aggregate:
+          while (pos < len) {
+            pos = detail::json_reader::skip_plain(data, pos, len, false);
+            if (pos == len) break;
+            auto const c = data[pos++];
+            if (c == '"') {
+              state = lexer::string;
+              break;
+            } else if (c == '{' || c == '[') {
+              ++depth;
+            } else if (c == '}' || c == ']') {
+              if (--depth) continue;
+              emitted += complete(data + start, pos - start, false, cb);
+              break;
+            } else if (c == '\n') {
+              ++lines;
+            }
+          }
+          break;
+        case lexer::string:
+          while (pos < len) {
+            pos = detail::json_reader::skip_plain(data, pos, len, true);
+            if (pos == len) break;
+            auto const c = data[pos++];
+            if (c == '\\') {
+              state = lexer::escape;
+              break;
+            } else if (c == '"') {
+              if (depth) state = lexer::aggregate;
+              else emitted += complete(data + start, pos - start, false, cb);
+              break;
+            } else if (c == '\n') {
+              ++lines;
+            }
+          }
+          break;
+        case lexer::escape:
+          // Whatever follows a backslash can't end the string.
+          ++pos;
+          state = lexer::string;
+          break;
+        case lexer::scalar:
+          {
+            // Bare numbers and literals run until whatever comes next.
+            while (pos < len) {
+              auto const c = data[pos];
+              if (detail::is_json_space(c) || c == '{' || c == '[' || c == '"') break;
+              ++pos;
+            }
+            if (pos < len) emitted += complete(data + start, pos - start, false, cb);
+            break;
+          }
+      }
+    }
+
+    // Set aside whatever we have of a value that continues into the next chunk.
+    if (state != lexer::idle) set_aside(data + start, len - start);
+    return emitted;
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::consume_lines(char const* data,
+      size_type len, size_type& pos, Callback& cb) -> size_type {
+    size_type emitted = 0;
+    while (pos < len) {
+      if (state == lexer::idle) {
+        value_offset = consumed + pos;
+        value_line = lines;
+        state = lexer::scalar;
+      }
+
+      // Lines can't contain raw newlines, so there's no need to look at anything in between.
+      auto const* nl = static_cast<char const*>(std::memchr(data + pos, '\n', len - pos));
+      if (!nl) {
+        set_aside(data + pos, len - pos);
+        pos = len;
+        break;
+      }
+      auto const begin = pos;
+      pos = static_cast<size_type>(nl - data) + 1;
+      ++lines;
+      emitted += complete(data + begin, pos - begin - 1, true, cb);
+    }
+    return emitted;
+  }
+
+  template <class Packet, unsigned flags>
+  template <class Callback>
+  auto basic_json_stream_parser<Packet, flags>::complete(char const* data,
+      size_type len, bool line, Callback& cb) -> size_type {
+    state = lexer::idle;
+    depth = 0;
+
+    // Values that ran past the limit have already been dropped, and only their end is left.
+    if (oversized || partial.size() + len > max_value) {
+      oversized = false;
+      partial.clear();
+      std::string msg = "dart::json_stream_parser value on line " + std::to_string(value_line)
+        + " is longer than the maximum of " + std::to_string(max_value) + " bytes";
+      throw stream_parse_error(msg.data(), value_offset, value_line);
+    }
+
+    // Only values that straddled chunks have to be glued back together.
+    shim::string_view json {data, len};
+    if (!partial.empty()) {
+      partial.append(data, len);
+      json = partial;
+    }
+
+    // Blank lines don't hold a value.
+    if (line) {
+      json = detail::trim_json_space(json);
+      if (json.empty()) {
+        partial.clear();
+        return 0;
+      }
+    }
+
+    auto val = parse(json);
+    partial.clear();
+    cb(std::move(val));
+    return 1;
+  }
+
+  template <class Packet, unsigned flags>
+  void basic_json_stream_parser<Packet, flags>::set_aside(char const* data, size_type len) {
+    // Once a value is too long to accept, there's no point in holding onto any of it,
+    // so just keep lexing until it ends.
+    if (oversized) return;
+    if (partial.size() + len > max_value) {
+      oversized = true;
+      std::string {}.swap(partial);
+    } else {
+      partial.append(data, len);
+    }
+  }
+
+  template <class Packet, unsigned flags>
+  Packet basic_json_stream_parser<Packet, flags>::parse(shim::string_view json) const {
+    try {
+      return Packet::template from_json<flags>(json);
+    } catch (parse_error const& err) {
+      throw detail::locate_error("dart::json_stream_parser", err.what(), value_offset, value_line);
+    }
+  }
+
+  template <unsigned flags>
+  std::vector<buffer> parse_ndjson(shim::string_view ndjson, size_t threads) {
+    std::vector<buffer> values;
+    parse_ndjson<flags>(ndjson, threads, [&] (buffer val) { values.push_back(std::move(val)); });
+    return values;
+  }
+
+  template <unsigned flags>
+  std::vector<buffer> parse_ndjson(shim::string_view ndjson, parallel_policy const& policy) {
+    std::vector<buffer> values;
+    parse_ndjson<flags>(ndjson, policy, [&] (buffer val) { values.push_back(std::move(val)); });
+    return values;
+  }
+
+  template <unsigned flags, class Callback>
+  size_t parse_ndjson(shim::string_view ndjson, size_t threads, Callback&& cb) {
+    return detail::parse_ndjson_impl<flags>(ndjson, parallel_policy {threads}, cb);
+  }
+
+  template <unsigned flags, class Callback>
+  size_t parse_ndjson(shim::string_view ndjson, parallel_policy const& policy, Callback&& cb) {
+    return detail::parse_ndjson_impl<flags>(ndjson, policy, cb);
+  }
+
+  template <unsigned flags, class Callback>
+  size_t detail::parse_ndjson_impl(shim::string_view ndjson, parallel_policy const& policy, Callback& cb) {
+    struct chunk {
+      size_t begin;
+      size_t end;
+      size_t lines;
+      std::vector<buffer> values;
+      size_t err_line;
+      size_t err_offset;
+      std::exception_ptr err;
+    };
+
+    auto* pool = policy.pool.get();
+    auto const threads = policy.threads();
+
+    // Give every thread a few chunks per window, so that stealing can even out
+    // lines that take longer than others, but keep chunks big enough that handing
+    // them out doesn't cost anything.
+    auto const* data = ndjson.data();
+    auto const len = ndjson.size();
+    auto const window = threads * 4;
+    auto const chunk_size = std::min<size_t>(std::max<size_t>(len / window, 1U << 16U), 1U << 22U);
+    std::vector<chunk> chunks(window);
+
+    // Parses each line of a chunk until the first one that fails.
+    auto parse_chunk = [&] (size_t idx) {
+      auto& curr = chunks[idx];
+      auto pos = curr.begin;
+      curr.lines = 0;
+      curr.err = nullptr;
+      while (pos < curr.end) {
+        auto const* nl = static_cast<char const*>(std::memchr(data + pos, '\n', curr.end - pos));
+        auto const end = nl ? static_cast<size_t>(nl - data) : curr.end;
+        auto const json = detail::trim_json_space({data + pos, end - pos});
+        if (!json.empty()) {
+          try {
+            curr.values.push_back(buffer::from_json<flags>(json));
+          } catch (...) {
+            curr.err = std::current_exception();
+            curr.err_line = curr.lines;
+            curr.err_offset = pos;
+            return;
+          }
+        }
+        curr.lines += nl ? 1 : 0;
+        pos = end + 1;
+      }
+    };
+
+    size_t pos = 0, line = 1, emitted = 0;
+    while (pos < len) {
+      // Cut the next window of chunks, just past the first newline after every chunk_size bytes.
+      size_t count = 0;
+      for (; count < window && pos < len; ++count) {
+        auto end = std::min(pos + chunk_size, len);
+        if (end < len) {
+          auto const* nl = static_cast<char const*>(std::memchr(data + end, '\n', len - end));
+          end = nl ? static_cast<size_t>(nl - data) + 1 : len;
+        }
+        chunks[count].begin = pos;
+        chunks[count].end = end;
+        pos = end;
+      }
+
+      if (pool) pool->for_each(count, parse_chunk);
+      else for (size_t i = 0; i < count; ++i) parse_chunk(i);
+
+      // Hand everything out in order, up until the first line that failed.
+      for (size_t i = 0; i < count; ++i) {
+        auto& curr = chunks[i];
+        for (auto& val : curr.values) cb(std::move(val));
+        emitted += curr.values.size();
+        curr.values.clear();
+        if (curr.err) detail::rethrow_located("dart::parse_ndjson", curr.err, curr.err_offset, line + curr.err_line);
+        line += curr.lines;
+      }
+    }
+    return emitted;
+  }
+
+}
+#endif
+
+#endif
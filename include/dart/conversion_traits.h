@@ -92,12 +92,14 @@ namespace dart {
                   obj.add_field(heap {*k}, heap {*v});
                   ++k, ++v;
                 }
+                link_source(buff, *obj.try_get_fields());
                 return obj;
               }
             case dart::detail::type::array:
               {
                 auto arr = heap::make_array();
                 for (auto elem : buff) arr.push_back(heap {std::move(elem)});
+                link_source(buff, *arr.try_get_elements());
                 return arr;
               }
             case dart::detail::type::string:
@@ -113,6 +115,17 @@ namespace dart {
               return heap::make_null();
           }
         }
+
+        template <class Aggregate>
+        static void link_source(buffer const& buff, Aggregate& aggr) {
+          // Finalizing the heap again with the default options would lay out these exact bytes,
+          // so long as the aggregate is using the canonical encoding throughout, and doesn't refer
+          // to anything outside of itself.
+          auto const raw = buff.raw;
+          if (raw.type != dart::detail::raw_type::object && raw.type != dart::detail::raw_type::array) return;
+          else if (!dart::detail::is_canonical<RefCount>(raw) || dart::detail::is_dependent<RefCount>(raw)) return;
+          aggr.source.set(buff, gsl::make_span(raw.buffer, dart::detail::find_sizeof<RefCount>(raw)));
+        }
       };
       template <template <class> class RefCount>
       struct api_converter<basic_heap<RefCount>, basic_buffer<RefCount>> {
@@ -120,23 +133,184 @@ namespace dart {
         using buffer = basic_buffer<RefCount>;
 
         template <class Heap>
-        static buffer convert(Heap&& hp) {
+        static buffer convert(Heap&& hp, finalize_options const& opts = {}) {
+          // Allocate the whole thing in one go.
+          buffer buff;
+          auto target = plan_target(hp, opts);
+          buff.buffer_ref = dart::detail::aligned_alloc<RefCount>(target.bytes, target.type, [&] (auto* buff) {
+            write(hp, opts, target, buff);
+          });
+          buff.raw = {target.type, buff.buffer_ref.get()};
+          return buff;
+        }
+
+        template <class Heap>
+        static size_t convert_into(Heap const& hp, gsl::span<gsl::byte> dest, finalize_options const& opts) {
+          // Same as above, except the caller has already allocated, and only needs to know how much we used.
+          auto target = plan_target(hp, opts);
+          if (static_cast<size_t>(dest.size()) < target.bytes) {
+            throw size_error("dart::heap does not fit in the given buffer", target.bytes);
+          } else if (dart::detail::align_pointer<RefCount>(dest.data(), target.type) != dest.data()) {
+            throw std::invalid_argument("dart::heap can only be finalized into memory aligned to a 64-bit word boundary");
+          }
+          write(hp, opts, target, dest.data());
+          return dart::detail::find_sizeof<RefCount>({target.type, dest.data()});
+        }
+
+        // Everything that has to be worked out before a heap can be laid out.
+        struct layout_target {
+          size_t bytes;
+          dart::detail::raw_type type;
+          shim::optional<dart::detail::key_dictionary> dict;
+          shim::optional<dart::detail::perfect_hash_scratch> scratch;
+        };
+
+        template <class Heap>
+        static layout_target plan_target(Heap const& hp, finalize_options const& opts) {
+          if (!hp.is_object()) {
+            throw type_error("dart::buffer can only be constructed from an object heap");
+          }
+
+          // Calculate the maximum amount of memory that could be required to represent this dart::packet,
+          // which also tells us whether it needs to be laid out as a large object.
+          // Packets laid out with the canonical encoding know exactly how much they need, and remember it
+          // between finalizations, so only packets using the optional encodings pay for a pessimistic bound.
+          auto const exact = dart::detail::has_exact_layout(opts) ? hp.exact_bound(opts) : 0;
+          auto const bound = exact ? exact : hp.upper_bound(opts);
+          layout_target target {bound, dart::detail::identify_aggregate(dart::detail::raw_type::object, bound, opts), {}, {}};
+
+          // Keys that repeat often enough are interned into a dictionary at the root,
+          // which has to be sized before anything is laid out.
+          // Large objects have nowhere to keep one.
+          if (opts.key_dictionary_threshold != std::numeric_limits<size_t>::max()
+              && target.type == dart::detail::raw_type::object) {
+            dart::detail::key_dictionary::counts_type counts;
+            count_keys(hp, counts);
+            target.dict.emplace(counts, opts.key_dictionary_threshold);
+            if (target.dict->empty()) target.dict.reset();
+            else target.bytes += target.dict->upper_bound();
+          }
+
+          // Perfect hash tables are built as objects are laid out, which can't allocate.
+          if (opts.perfect_hash_threshold != std::numeric_limits<size_t>::max()) {
+            target.scratch.emplace(dart::detail::perfect_hash_scratch::largest_table(hp, opts));
+          }
+          return target;
+        }
+
+        template <class Heap>
+        static void write(Heap const& hp, finalize_options const& opts, layout_target& target, gsl::byte* buff) {
+          std::fill_n(buff, target.bytes, gsl::byte {});
+          dart::detail::perfect_hash_scratch::scope scratch {target.scratch ? &*target.scratch : nullptr};
+          if (target.dict) {
+            target.dict->bind(buff, target.bytes);
+            dart::detail::key_dictionary::scope guard {&*target.dict};
+            hp.layout(buff, opts, target.type);
+          } else {
+            hp.layout(buff, opts, target.type);
+          }
+        }
+
+        template <class Heap>
+        static buffer convert(Heap&& hp, finalize_options const& opts, parallel_policy const& policy) {
+          // Only heaps laid out with the canonical encoding know where each of their subtrees will land
+          // ahead of time, and only heaps with a few subtrees worth handing out are worth the trouble.
           if (!hp.is_object()) {
             throw type_error("dart::buffer can only be constructed from an object heap");
           }
+          auto const bytes = dart::detail::has_exact_layout(opts) ? hp.exact_bound(opts) : 0;
+          if (!policy.pool || bytes < 2 * policy.grain()) return convert(hp, opts);
 
-          // Calculate the maximum amount of memory that could be required to represent this dart::packet and
-          // allocate the whole thing in one go.
           buffer buff;
-          size_t bytes = hp.upper_bound();
-          auto buftype = dart::detail::raw_type::object;
-          buff.buffer_ref = dart::detail::aligned_alloc<RefCount>(bytes, buftype, [&] (auto* buff) {
-            std::fill_n(buff, bytes, gsl::byte {});
-            hp.layout(buff);
+          buff.buffer_ref = dart::detail::aligned_alloc<RefCount>(bytes, dart::detail::raw_type::object, [&] (auto* base) {
+            std::fill_n(base, bytes, gsl::byte {});
+
+            // Split the tree into runs of subtrees of about a grain each, and lay them out in parallel.
+            layout_plan plan;
+            plan_layout(hp, base, opts, policy.grain(), plan);
+            plan.close();
+
+            // Every run, and the calling thread, needs its own space to build perfect hash tables in.
+            std::vector<dart::detail::perfect_hash_scratch> scratch;
+            if (opts.perfect_hash_threshold != std::numeric_limits<size_t>::max()) {
+              scratch.reserve(plan.tasks.size());
+              for (auto task = 0U; task + 1 < plan.tasks.size(); ++task) {
+                size_t largest = 0;
+                for (auto idx = plan.tasks[task]; idx < plan.tasks[task + 1]; ++idx) {
+                  largest = std::max(largest, dart::detail::perfect_hash_scratch::largest_table(*plan.subtrees[idx].first, opts));
+                }
+                scratch.emplace_back(largest);
+              }
+              scratch.emplace_back(dart::detail::perfect_hash_scratch::largest_table(hp, opts));
+            }
+            auto const scratch_for = [&] (size_t task) { return scratch.empty() ? nullptr : &scratch[task]; };
+
+            policy.pool->for_each(plan.tasks.size() - 1, [&] (size_t task) {
+              dart::detail::perfect_hash_scratch::scope guard {scratch_for(task)};
+              for (auto idx = plan.tasks[task]; idx < plan.tasks[task + 1]; ++idx) {
+                auto const& subtree = plan.subtrees[idx];
+                subtree.first->layout(subtree.second, opts, subtree.first->get_raw_type(opts));
+              }
+            });
+
+            // Then lay out everything else around them.
+            std::vector<gsl::byte const*> addresses;
+            addresses.reserve(plan.subtrees.size());
+            for (auto const& subtree : plan.subtrees) addresses.push_back(subtree.second);
+            dart::detail::prelaid_layout done {std::move(addresses)};
+            dart::detail::prelaid_layout::scope guard {&done};
+            dart::detail::perfect_hash_scratch::scope hashing {scratch_for(plan.tasks.size() - 1)};
+            hp.layout(base, opts, dart::detail::raw_type::object);
           });
           buff.raw = {dart::detail::raw_type::object, buff.buffer_ref.get()};
           return buff;
         }
+
+        struct layout_plan {
+          // Grows a run of subtrees until it holds at least a grain's worth of bytes.
+          void add(heap const& subtree, gsl::byte* at, size_t bytes, size_t grain) {
+            subtrees.emplace_back(&subtree, at);
+            pending += bytes;
+            if (pending >= grain) close();
+          }
+          void close() {
+            if (tasks.back() == subtrees.size()) return;
+            tasks.push_back(subtrees.size());
+            pending = 0;
+          }
+
+          // Subtrees are in the order they appear in the buffer, and each task is a run of them.
+          std::vector<std::pair<heap const*, gsl::byte*>> subtrees;
+          std::vector<size_t> tasks {0};
+          size_t pending = 0;
+        };
+
+        template <class Heap>
+        static void plan_layout(Heap const& hp, gsl::byte* at,
+            finalize_options const& opts, size_t grain, layout_plan& plan)
+        {
+          // Subtrees no bigger than a grain are handed out whole, and anything bigger is split
+          // further, leaving its own header, vtable, keys, and scalars for the calling thread.
+          hp.exact_offsets(opts, [&] (auto& child, size_t offset) {
+            auto const child_bytes = child.exact_bound(opts);
+            if (!child.is_aggregate()) return child_bytes;
+            else if (child_bytes > grain) plan_layout(child, at + offset, opts, grain, plan);
+            else plan.add(child, at + offset, child_bytes, grain);
+            return child_bytes;
+          });
+        }
+
+        template <class Heap>
+        static void count_keys(Heap const& hp, dart::detail::key_dictionary::counts_type& counts) {
+          if (auto* fields = hp.try_get_fields()) {
+            for (auto const& field : *fields) {
+              ++counts[field.first.strv()];
+              count_keys(field.second, counts);
+            }
+          } else if (auto* elems = hp.try_get_elements()) {
+            for (auto const& elem : *elems) count_keys(elem, counts);
+          }
+        }
       };
       template <template <class> class RefCount>
       struct api_converter<basic_packet<RefCount>, basic_heap<RefCount>> {
@@ -209,6 +383,9 @@ namespace dart {
         return TargetPacket {std::forward<Packet>(pkt)};
       }
 
+      template <class Lhs, class Rhs>
+      bool generic_compare(Lhs const& lhs, Rhs const& rhs) noexcept;
+
       // Struct is basically a switch table of different Dart comparison operations
       // where both lhs and rhs are known to be specializations of the same Dart
       // template, even if instantiated with different reference counters.
@@ -257,14 +434,30 @@ namespace dart {
           else if (lhs.get_type() != rhs.get_type()) return false;
           else if (rawlhs.buffer == rawrhs.buffer) return true;
 
+          // Objects that carry content hashes can be told apart without looking at their contents.
+          if (auto const lhs_hash = dart::detail::stored_hash<RefCount>(rawlhs)) {
+            auto const rhs_hash = dart::detail::stored_hash<RefCount>(rawrhs);
+            if (rhs_hash && *lhs_hash != *rhs_hash) return false;
+          }
+
+          // Rows of a record batch don't own their bytes, so they can only be compared structurally.
+          auto const rows = rawlhs.type == dart::detail::raw_type::record || rawrhs.type == dart::detail::raw_type::record;
+          if (rows) return generic_compare(lhs, rhs);
+
           // Fall back on a comparison of the underlying buffers.
           auto lhs_size = dart::detail::find_sizeof<RefCount>(rawlhs);
           auto rhs_size = dart::detail::find_sizeof<RefCount>(rawrhs);
-          if (lhs_size == rhs_size) {
-            return std::equal(rawlhs.buffer, rawlhs.buffer + lhs_size, rawrhs.buffer);
-          } else {
-            return false;
+          if (lhs_size == rhs_size && std::equal(rawlhs.buffer, rawlhs.buffer + lhs_size, rawrhs.buffer)) {
+            return true;
           }
+
+          // Buffers finalized with optional encodings can hold the same contents
+          // with different bytes, so they have to be compared structurally.
+          // Packed arrays also widen their elements, so equal primitives can differ in width.
+          auto canonical = rawlhs.type == rawrhs.type
+            && dart::detail::is_canonical<RefCount>(rawlhs) && dart::detail::is_canonical<RefCount>(rawrhs);
+          if (canonical) return false;
+          else return generic_compare(lhs, rhs);
         }
       };
       template <template <class> class RefCount>
@@ -255,6 +255,8 @@ namespace dart {
   template <template <class> class RefCount>
   template <bool enabled, class EnableIf>
   void basic_heap<RefCount>::clear() {
+    // Perform our copy on write if our heap is shared.
+    copy_on_write();
     if (is_object()) get_fields().clear();
     else if (is_array()) get_elements().clear();
     else throw type_error("dart::heap is not an aggregate and cannot be cleared");
@@ -314,6 +316,24 @@ namespace dart {
     return basic_buffer<RefCount> {*this};
   }
 
+  template <template <class> class RefCount>
+  template <bool enabled, class EnableIf>
+  basic_buffer<RefCount> basic_heap<RefCount>::finalize(finalize_options const& opts) const {
+    return convert::detail::api_converter<basic_heap, basic_buffer<RefCount>>::convert(*this, opts);
+  }
+
+  template <template <class> class RefCount>
+  template <bool enabled, class EnableIf>
+  basic_buffer<RefCount> basic_heap<RefCount>::finalize(parallel_policy const& policy, finalize_options const& opts) const {
+    return convert::detail::api_converter<basic_heap, basic_buffer<RefCount>>::convert(*this, opts, policy);
+  }
+
+  template <template <class> class RefCount>
+  template <bool enabled, class EnableIf>
+  auto basic_heap<RefCount>::finalize_into(gsl::span<gsl::byte> dest, finalize_options const& opts) const -> size_type {
+    return convert::detail::api_converter<basic_heap, basic_buffer<RefCount>>::convert_into(*this, dest, opts);
+  }
+
   template <template <class> class RefCount>
   template <bool enabled, class EnableIf>
   basic_buffer<RefCount> basic_heap<RefCount>::lower() const {
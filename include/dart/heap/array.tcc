@@ -129,6 +129,7 @@ namespace dart {
   template <template <class> class RefCount>
   template <class T, class EnableIf>
   void basic_heap<RefCount>::resize(size_type count, T const& def) {
+    copy_on_write();
     get_elements().resize(count, convert::cast<basic_heap>(def));
   }
 
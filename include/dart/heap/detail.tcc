@@ -58,60 +58,80 @@ namespace dart {
       if (is_object()) data = fields_type(new packet_fields(get_fields()));
       else if (is_array()) data = elements_type(new packet_elements(get_elements()));
     }
+
+    // Every mutation passes through here, so whatever size we'd cached is about to be wrong,
+    // and we're about to stop matching the buffer we were definalized from.
+    if (auto* fields = try_get_fields()) {
+      fields->finalized.reset();
+      fields->source.reset();
+    } else if (auto* elements = try_get_elements()) {
+      elements->finalized.reset();
+      elements->source.reset();
+    }
   }
 
   // FIXME: Audit this function. A LOT has changed since it was written.
   template <template <class> class RefCount>
-  auto basic_heap<RefCount>::upper_bound() const -> size_type {
+  auto basic_heap<RefCount>::upper_bound(finalize_options const& opts) const -> size_type {
     switch (get_raw_type()) {
       case detail::raw_type::object:
         {
-          // Start with the base size of the object structure, then add the size of our vtable.
-          // The plus one is to account for any potentially required padding.
+          // Iterate over our fields and calculate the max memory required for each.
           auto* fields = try_get_fields();
-          size_t max = sizeof(detail::object<RefCount>) + ((sizeof(detail::object_entry) * (fields->size() + 1)));
-
-          // Now iterate over our fields and calculate the max memory required for each.
+          size_t body = 0;
           for (auto& field : *fields) {
             // Get the maximum size of both our key and value.
-            size_t key_max = field.first.upper_bound(), val_max = field.second.upper_bound();
+            size_t key_max = field.first.upper_bound(), val_max = field.second.upper_bound(opts);
 
             // Total size required for this field is the max size of the key, plus the maximum required
             // padding for the value type (minus 1), plus the max size of the value, plus the maximum
             // required padding for a subsequent key (minus 1).
-            max += key_max + detail::alignment_of<RefCount>(field.second.get_raw_type()) - 1;
-            max += val_max + detail::alignment_of<RefCount>(detail::raw_type::string) - 1;
+            body += key_max + detail::alignment_of<RefCount>(field.second.get_raw_type()) - 1;
+            body += val_max + detail::alignment_of<RefCount>(detail::raw_type::string) - 1;
           }
 
+          // Add the base size of the object structure, the size of our vtable, and the size of any
+          // optional sections the object will carry.
+          // The plus one is to account for any potentially required padding.
+          auto extensions = detail::object<RefCount>::extension_flags(fields->size(), opts);
+          size_t max = sizeof(detail::object<RefCount>) + ((sizeof(detail::object_entry) * (fields->size() + 1)));
+          max += detail::object<RefCount>::extension_sizeof(extensions, fields->size()) + body;
+
           // This is required so that packets can be copied into contiguous buffers
           // without ruining their alignment.
           max = detail::pad_bytes<RefCount>(max, detail::raw_type::object);
 
-          // Make sure we aren't going to exceed the maximum offset value we can encode in our vtable.
-          if (max > max_aggregate_size) {
-            throw std::length_error("Offset required for encoding is too large for dart::packet vtable");
-          }
-          return max;
+          // If we'd exceed the maximum offset value we can encode in our vtable, or the number
+          // of fields we can encode in our header, we'll be laid out as a large object instead.
+          if (max <= detail::large_aggregate_limit(opts) && fields->size() <= detail::aggregate_size_mask) return max;
+          max = sizeof(detail::large_object<RefCount>) + sizeof(detail::large_object_entry) * (fields->size() + 1) + body;
+          return std::max(detail::pad_bytes<RefCount>(max, detail::raw_type::object), detail::large_aggregate_limit(opts) + 1);
         }
       case detail::raw_type::array:
         {
-          // Start with the base size of the array structure, then add the size of our vtable.
-          // The plus one is to account for any potentially required padding.
-          auto* elements = try_get_elements();
-          size_t max = sizeof(detail::array<RefCount>) + (sizeof(detail::array_entry) * (elements->size() + 1));
-
-          // Now iterate over each element and add their max size.
+          // Iterate over each element and add their max size.
           // Max size for each element is considered to be their reported maximum size, plus the maximum required
           // padding for the next element.
+          auto* elements = try_get_elements();
+          size_t body = 0;
           for (auto& elem : *elements) {
-            max += elem.upper_bound() + detail::alignment_of<RefCount>(elem.get_raw_type()) - 1;
+            body += elem.upper_bound(opts) + detail::alignment_of<RefCount>(elem.get_raw_type()) - 1;
           }
 
-          // Make sure we aren't going to exceed the maximum offset value we can encode in our vtable.
-          if (max > max_aggregate_size) {
-            throw std::length_error("Offset required for encoding is too large for dart::packet vtable");
+          // Add the base size of the array structure, and the size of our vtable.
+          // The plus one is to account for any potentially required padding.
+          size_t max = sizeof(detail::array<RefCount>) + (sizeof(detail::array_entry) * (elements->size() + 1)) + body;
+
+          // Record batches are laid out differently, and need a bound of their own.
+          if (detail::array<RefCount>::is_batchable(elements, opts)) {
+            max = std::max(max, detail::array<RefCount>::batch_upper_bound(elements, opts));
           }
-          return max;
+
+          // If we'd exceed the maximum offset value we can encode in our vtable, we'll be laid out
+          // as a large array instead, which is never packed or batched.
+          if (max <= detail::large_aggregate_limit(opts) && elements->size() <= detail::aggregate_size_mask) return max;
+          max = sizeof(detail::large_array<RefCount>) + sizeof(detail::large_array_entry) * (elements->size() + 1) + body;
+          return std::max(max, detail::large_aggregate_limit(opts) + 1);
         }
       case detail::raw_type::small_string:
       case detail::raw_type::string:
@@ -141,16 +161,156 @@ namespace dart {
   }
 
   template <template <class> class RefCount>
-  auto basic_heap<RefCount>::layout(gsl::byte* buffer) const noexcept -> size_type {
-    // Construct a wrapper class of the correct type in the provided buffer, and return the number
-    // of bytes used.
-    auto raw = get_raw_type();
+  auto basic_heap<RefCount>::small_upper_bound(finalize_options const& opts, size_type limit) const -> size_type {
+    // Small aggregates can only hold scalars and other small aggregates, so give up on anything
+    // that's going to need one of the optional encodings, and as soon as we're past the limit.
+    switch (get_raw_type()) {
+      case detail::raw_type::object:
+        {
+          // Small objects store all of their values in the body, so inline values don't count.
+          auto* fields = try_get_fields();
+          auto const extensions = detail::object<RefCount>::extension_flags(fields->size(), opts);
+          if (extensions & ~detail::inline_value_section) return limit + 1;
+
+          // Objects whose keys can all be shared with a key dictionary are better off sharing them.
+          auto* dict = detail::key_dictionary::current();
+          auto const shared = dict && !fields->empty()
+            && std::all_of(std::begin(*fields), std::end(*fields), [dict] (auto const& field) {
+              return dict->find(field.first.strv());
+            });
+          if (shared) return limit + 1;
+
+          // Same calculation as for the canonical encoding, just with a smaller header and vtable.
+          size_type max = sizeof(detail::small_object<RefCount>) + sizeof(detail::small_object_entry) * fields->size();
+          for (auto& field : *fields) {
+            max += field.first.upper_bound() + detail::alignment_of<RefCount>(field.second.get_raw_type()) - 1;
+            max += field.second.small_upper_bound(opts, limit)
+              + detail::alignment_of<RefCount>(detail::raw_type::string) - 1;
+            if (max > limit) return limit + 1;
+          }
+          return detail::pad_bytes<RefCount>(max, detail::raw_type::object);
+        }
+      case detail::raw_type::array:
+        {
+          auto* elements = try_get_elements();
+          if (detail::array<RefCount>::packing_for(elements, opts) != detail::raw_type::null) return limit + 1;
+          else if (detail::array<RefCount>::is_batchable(elements, opts)) return limit + 1;
+
+          size_type max = sizeof(detail::small_array<RefCount>) + sizeof(detail::small_array_entry) * elements->size();
+          for (auto& elem : *elements) {
+            max += elem.small_upper_bound(opts, limit) + detail::alignment_of<RefCount>(elem.get_raw_type()) - 1;
+            if (max > limit) return limit + 1;
+          }
+          return detail::pad_bytes<RefCount>(max, detail::raw_type::array);
+        }
+      default:
+        return upper_bound(opts);
+    }
+  }
+
+  template <template <class> class RefCount>
+  auto basic_heap<RefCount>::exact_bound(finalize_options const& opts) const -> size_type {
+    // Returns zero if anything would need to be laid out as a large aggregate.
+    // Sizes of aggregates are cached for the default options, so only the parts of the tree that
+    // have been modified since the last finalization have to be walked again.
+    DART_ASSERT(detail::has_exact_layout(opts));
+    if (!is_aggregate()) return upper_bound(opts);
+
+    auto const cacheable = detail::has_default_layout(opts);
+    auto& cache = is_object() ? try_get_fields()->finalized : try_get_elements()->finalized;
+    if (cacheable) {
+      if (auto const cached = cache.get()) return cached;
+      else if (!finalized_source().empty()) return finalized_source().size();
+    }
+
+    auto const bytes = exact_offsets(opts, [&opts] (auto& child, auto) { return child.exact_bound(opts); });
+    if (cacheable && bytes) cache.set(bytes);
+    return bytes;
+  }
+
+  template <template <class> class RefCount>
+  template <class Callback>
+  auto basic_heap<RefCount>::exact_offsets(finalize_options const& opts, Callback&& cb) const -> size_type {
+    // Walks our children exactly the way the canonical object and array constructors will, but
+    // only keeps track of offsets, passing each child, and its offset, to the callback,
+    // which returns its size.
+    // Returns our size, or zero if either we, or a child, would need to be laid out as a large aggregate.
+    size_type offset;
+    if (auto* fields = try_get_fields()) {
+      // Offsets start after the header, vtable, and any optional sections, all of
+      // which are multiples of eight bytes.
+      auto const extensions = detail::object<RefCount>::extension_flags(fields->size(), opts);
+      offset = sizeof(detail::object<RefCount>) + sizeof(detail::object_entry) * fields->size();
+      offset += detail::object<RefCount>::extension_sizeof(extensions, fields->size());
+      for (auto& field : *fields) {
+        offset = detail::pad_bytes<RefCount>(offset, detail::raw_type::string) + field.first.upper_bound();
+        offset = detail::pad_bytes<RefCount>(offset, field.second.get_raw_type());
+
+        auto const val_bytes = cb(field.second, offset);
+        if (field.second.is_aggregate() && !val_bytes) return 0;
+        offset += val_bytes;
+      }
+      offset = detail::pad_bytes<RefCount>(offset, detail::raw_type::object);
+      if (fields->size() > detail::aggregate_size_mask) return 0;
+    } else {
+      auto* elements = try_get_elements();
+      offset = sizeof(detail::array<RefCount>) + sizeof(detail::array_entry) * elements->size();
+      for (auto& elem : *elements) {
+        offset = detail::pad_bytes<RefCount>(offset, elem.get_raw_type());
+
+        auto const elem_bytes = cb(elem, offset);
+        if (elem.is_aggregate() && !elem_bytes) return 0;
+        offset += elem_bytes;
+      }
+      if (elements->size() > detail::aggregate_size_mask) return 0;
+    }
+    return offset <= detail::large_aggregate_limit(opts) ? offset : 0;
+  }
+
+  template <template <class> class RefCount>
+  auto basic_heap<RefCount>::layout(gsl::byte* buffer, finalize_options const& opts) const noexcept -> size_type {
+    return layout(buffer, opts, get_raw_type());
+  }
+
+  template <template <class> class RefCount>
+  auto basic_heap<RefCount>::layout(gsl::byte* buffer,
+      finalize_options const& opts, detail::raw_type raw) const noexcept -> size_type
+  {
+    // Construct a wrapper class of the requested type in the provided buffer, and return the number
+    // of bytes used. The type is either our own, or the one get_raw_type picked for us.
+    // Aggregates may have already been laid out by another thread if we're being finalized in parallel.
+    auto const canonical = raw == detail::raw_type::object || raw == detail::raw_type::array;
+    if (canonical && detail::prelaid_layout::contains(buffer)) {
+      return detail::find_sizeof<RefCount>({raw, buffer});
+    }
+
+    // Aggregates that haven't been modified since they were definalized can be copied
+    // straight out of the buffer they came from.
+    if (canonical && detail::has_default_layout(opts)) {
+      auto const source = finalized_source();
+      if (!source.empty()) {
+        std::copy(source.begin(), source.end(), buffer);
+        return source.size();
+      }
+    }
     switch (raw) {
       case detail::raw_type::object:
-        new(buffer) detail::object<RefCount>(try_get_fields());
+        new(buffer) detail::object<RefCount>(try_get_fields(), opts);
         break;
       case detail::raw_type::array:
-        new(buffer) detail::array<RefCount>(try_get_elements());
+        new(buffer) detail::array<RefCount>(try_get_elements(), opts);
+        break;
+      case detail::raw_type::small_object:
+        new(buffer) detail::small_object<RefCount>(try_get_fields(), opts);
+        break;
+      case detail::raw_type::small_array:
+        new(buffer) detail::small_array<RefCount>(try_get_elements(), opts);
+        break;
+      case detail::raw_type::large_object:
+        new(buffer) detail::large_object<RefCount>(try_get_fields(), opts);
+        break;
+      case detail::raw_type::large_array:
+        new(buffer) detail::large_array<RefCount>(try_get_elements(), opts);
         break;
       case detail::raw_type::small_string:
       case detail::raw_type::string:
@@ -190,6 +350,43 @@ namespace dart {
     return detail::find_sizeof<RefCount>({raw, buffer});
   }
 
+  template <template <class> class RefCount>
+  gsl::span<gsl::byte const> basic_heap<RefCount>::finalized_source() const noexcept {
+    if (auto* fields = try_get_fields()) return fields->source.get();
+    else if (auto* elements = try_get_elements()) return elements->source.get();
+    else return {};
+  }
+
+  template <template <class> class RefCount>
+  detail::raw_type basic_heap<RefCount>::get_raw_type(finalize_options const& opts) const {
+    // Aggregates that are guaranteed to fit in a small aggregate are laid out as one, if requested.
+    auto const raw = get_raw_type();
+    if (!opts.small_aggregate_threshold) return raw;
+    else if (raw != detail::raw_type::object && raw != detail::raw_type::array) return raw;
+
+    auto const max_size = size_type {detail::small_object<RefCount>::max_size};
+    auto const limit = std::min(size_type {opts.small_aggregate_threshold - 1}, max_size);
+    if (small_upper_bound(opts, limit) > limit) return raw;
+    else if (raw == detail::raw_type::object) return detail::raw_type::small_object;
+    else return detail::raw_type::small_array;
+  }
+
+  template <template <class> class RefCount>
+  detail::raw_type basic_heap<RefCount>::large_raw_type(finalize_options const& opts) const {
+    // Only large aggregates can hold other large aggregates, so this check is only made
+    // for their children, which keeps it off the path of every other finalization.
+    auto const raw = get_raw_type(opts);
+    if (raw != detail::raw_type::object && raw != detail::raw_type::array) return raw;
+    else return detail::identify_aggregate(raw, upper_bound(opts), opts);
+  }
+
+  template <template <class> class RefCount>
+  bool basic_heap<RefCount>::fits_inline(size_t bytes) const {
+    // Only scalars can be stored in a vtable, and the upper bound of a scalar is exact.
+    if (is_aggregate()) return false;
+    else return upper_bound() <= bytes;
+  }
+
   template <template <class> class RefCount>
   detail::raw_type basic_heap<RefCount>::get_raw_type() const noexcept {
     switch (get_type()) {
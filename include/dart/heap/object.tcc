@@ -199,6 +199,11 @@ namespace dart {
     return detail::get_nested_impl(*this, path, separator);
   }
 
+  template <template <class> class RefCount>
+  basic_heap<RefCount> basic_heap<RefCount>::get_nested(path const& needle) const {
+    return detail::get_path_impl(*this, needle);
+  }
+
   template <template <class> class RefCount>
   template <class String>
   basic_heap<RefCount> basic_heap<RefCount>::at(basic_string<String> const& key) const {
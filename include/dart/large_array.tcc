@@ -0,0 +1,208 @@
+#ifndef DART_LARGE_ARRAY_H
+#define DART_LARGE_ARRAY_H
+
+/*----- Project Includes -----*/
+
+#include "common.h"
+
+/*----- Function Implementations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    template <template <class> class RefCount>
+    large_array<RefCount>::large_array(packet_elements<RefCount> const* vals, finalize_options const& opts) noexcept :
+      marker(0),
+      reserved(0),
+      elems(vals->size())
+    {
+      // Iterate over our elements and write each one into the buffer.
+      // Our children may need to be large aggregates themselves.
+      large_array_entry* entry = vtable();
+      size_t offset = header_len + size() * sizeof(large_array_entry);
+      for (auto const& elem : *vals) {
+        // Using the current offset, align a pointer for the next element type.
+        auto const type = elem.large_raw_type(opts);
+        auto* unaligned = DART_FROM_THIS_MUT + offset;
+        auto* aligned = detail::align_pointer<RefCount>(unaligned, type);
+        offset += aligned - unaligned;
+
+        // Add an entry to the vtable.
+        auto* curr = new(entry++) large_array_entry {};
+        curr->offset = offset;
+        curr->type = static_cast<uint8_t>(type);
+
+        // Recurse.
+        offset += elem.layout(aligned, opts, type);
+      }
+
+      // This is necessary to ensure packets can be naively stored in
+      // contiguous buffers without ruining their alignment.
+      offset = pad_bytes<RefCount>(offset, detail::raw_type::array);
+      bytes = offset;
+    }
+
+    template <template <class> class RefCount>
+    large_array<RefCount>::large_array(buffer_parser<RefCount> const& parser, size_t idx) noexcept :
+      marker(0),
+      reserved(0),
+      elems(parser.get_children(idx).size())
+    {
+      // Iterate over our elements and write each one into the buffer.
+      large_array_entry* entry = vtable();
+      size_t offset = header_len + size() * sizeof(large_array_entry);
+      for (auto elem : parser.get_children(idx)) {
+        // Using the current offset, align a pointer for the next element type.
+        auto const type = parser.get_type(elem);
+        auto* unaligned = DART_FROM_THIS_MUT + offset;
+        auto* aligned = detail::align_pointer<RefCount>(unaligned, type);
+        offset += aligned - unaligned;
+
+        // Add an entry to the vtable.
+        auto* curr = new(entry++) large_array_entry {};
+        curr->offset = offset;
+        curr->type = static_cast<uint8_t>(type);
+
+        // Recurse.
+        offset += parser.lower(aligned, elem);
+      }
+
+      // This is necessary to ensure packets can be naively stored in
+      // contiguous buffers without ruining their alignment.
+      offset = pad_bytes<RefCount>(offset, detail::raw_type::array);
+      bytes = offset;
+    }
+
+// Unfortunately some versions of GCC and MSVC aren't smart enough to figure
+// out that if this function is declared noexcept the throwing cases are dead code
+#if DART_USING_GCC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wterminate"
+#elif DART_USING_MSVC
+#pragma warning(push)
+#pragma warning(disable: 4297)
+#endif
+
+    template <template <class> class RefCount>
+    template <bool silent>
+    bool large_array<RefCount>::is_valid(size_t bytes) const noexcept(silent) {
+      // Check if we even have enough space left for the array header.
+      if (bytes < header_len) {
+        if (silent) return false;
+        else throw validation_error("Serialized large array is truncated");
+      }
+
+      // Check that the header really does belong to a large array, that the array doesn't claim
+      // to be larger than our total buffer, and then that its vtable is within its own bounds.
+      // Sizes are sixty four bits wide, so everything is checked before it's used in any arithmetic.
+      if (marker.get() != 0) {
+        if (silent) return false;
+        else throw validation_error("Serialized large array header is malformed");
+      } else if (get_sizeof() > bytes || get_sizeof() < header_len) {
+        if (silent) return false;
+        else throw validation_error("Serialized large array length is out of bounds");
+      } else if (size() > (get_sizeof() - header_len) / sizeof(large_array_entry)) {
+        if (silent) return false;
+        else throw validation_error("Serialized large array vtable length is out of bounds");
+      }
+      auto const total_size = static_cast<std::ptrdiff_t>(get_sizeof());
+
+      // Iterate over the vtable and check all contained children.
+      void const* prev = this;
+      for (size_t i = 0; i < size(); ++i) {
+        auto const& entry = vtable()[i];
+        if (!valid_type(static_cast<raw_type>(entry.type.get()))) {
+          if (silent) return false;
+          else throw validation_error("Serialized large array value is of no known type");
+        }
+
+        // Verify that the value is within bounds, and then load its base address.
+        if (entry.offset.get() > get_sizeof()) {
+          if (silent) return false;
+          else throw validation_error("Serialized large array value offset is out of bounds");
+        }
+        auto const val_offset = static_cast<std::ptrdiff_t>(entry.offset.get());
+        auto const raw_val = get_elem(i);
+        if (raw_val.type == raw_type::null) {
+          // Nulls take up no space, so they share their offset with whatever follows them.
+          continue;
+        } else if (raw_val.buffer <= prev) {
+          if (silent) return false;
+          else throw validation_error("Serialized large array value contained a negative or cyclic offset");
+        } else if (align_pointer<RefCount>(raw_val.buffer, raw_val.type) != raw_val.buffer) {
+          if (silent) return false;
+          else throw validation_error("Serialized large array value offset does not meet alignment requirements");
+        }
+        prev = raw_val.buffer;
+
+        // Recurse on the value.
+        if (!valid_buffer<silent, RefCount>(raw_val, total_size - val_offset)) return false;
+      }
+      return true;
+    }
+
+#if DART_USING_GCC
+#pragma GCC diagnostic pop
+#elif DART_USING_MSVC
+#pragma warning(pop)
+#endif
+
+    template <template <class> class RefCount>
+    size_t large_array<RefCount>::size() const noexcept {
+      return elems.get();
+    }
+
+    template <template <class> class RefCount>
+    size_t large_array<RefCount>::get_sizeof() const noexcept {
+      return bytes.get();
+    }
+
+    template <template <class> class RefCount>
+    auto large_array<RefCount>::begin() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(0, DART_FROM_THIS, load_elem);
+    }
+
+    template <template <class> class RefCount>
+    auto large_array<RefCount>::end() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(size(), DART_FROM_THIS, load_elem);
+    }
+
+    template <template <class> class RefCount>
+    auto large_array<RefCount>::get_elem(size_t index) const noexcept -> raw_element {
+      if (index >= size()) return {raw_type::null, nullptr};
+      auto const& entry = vtable()[index];
+      return {static_cast<raw_type>(entry.type.get()), DART_FROM_THIS + entry.offset.get()};
+    }
+
+    template <template <class> class RefCount>
+    auto large_array<RefCount>::at_elem(size_t index) const -> raw_element {
+      if (index >= size()) throw std::out_of_range("dart::buffer does not contain requested index");
+      return get_elem(index);
+    }
+
+    template <template <class> class RefCount>
+    auto large_array<RefCount>::load_elem(gsl::byte const* base, size_t idx) noexcept
+      -> typename ll_iterator<RefCount>::value_type
+    {
+      return get_large_array<RefCount>({raw_type::large_array, base})->get_elem(idx);
+    }
+
+    template <template <class> class RefCount>
+    large_array_entry* large_array<RefCount>::vtable() noexcept {
+      auto* base = DART_FROM_THIS_MUT + header_len;
+      return shim::launder(reinterpret_cast<large_array_entry*>(base));
+    }
+
+    template <template <class> class RefCount>
+    large_array_entry const* large_array<RefCount>::vtable() const noexcept {
+      auto* base = DART_FROM_THIS + header_len;
+      return shim::launder(reinterpret_cast<large_array_entry const*>(base));
+    }
+
+  }
+
+}
+
+#endif
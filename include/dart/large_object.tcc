@@ -0,0 +1,358 @@
+#ifndef DART_LARGE_OBJECT_H
+#define DART_LARGE_OBJECT_H
+
+/*----- Project Includes -----*/
+
+#include "common.h"
+
+/*----- Function Implementations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    template <template <class> class RefCount>
+    large_object<RefCount>::large_object(packet_fields<RefCount> const* fields, finalize_options const& opts) noexcept :
+      marker(0),
+      reserved(0),
+      elems(fields->size())
+    {
+      // Iterate over our elements and write each one into the buffer.
+      // Our children may need to be large aggregates themselves.
+      large_object_entry* entry = vtable();
+      size_t offset = header_len + size() * sizeof(large_object_entry);
+      for (auto const& field : *fields) {
+        auto const type = field.second.large_raw_type(opts);
+        auto const key = field.first.strv();
+
+        // Using the current offset, align a pointer for the key.
+        auto* unaligned = DART_FROM_THIS_MUT + offset;
+        auto* aligned = align_pointer<RefCount>(unaligned, detail::raw_type::string);
+        offset += aligned - unaligned;
+
+        // Add an entry to the vtable, with as much of the key as we can fit.
+        auto* curr = new(entry++) large_object_entry {};
+        curr->offset = offset;
+        curr->type = static_cast<uint8_t>(type);
+        curr->len = static_cast<uint8_t>(std::min(key.size(), size_t {large_object_entry::max_len}));
+        std::copy_n(key.data(), std::min(key.size(), size_t {large_object_entry::prefix_len}), curr->prefix);
+
+        // Layout our key.
+        offset += field.first.layout(aligned);
+
+        // Realign our pointer for our value type, and recurse.
+        unaligned = DART_FROM_THIS_MUT + offset;
+        aligned = align_pointer<RefCount>(unaligned, type);
+        offset += aligned - unaligned;
+        offset += field.second.layout(aligned, opts, type);
+      }
+
+      // This is necessary to ensure packets can be naively stored in
+      // contiguous buffers without ruining their alignment.
+      offset = pad_bytes<RefCount>(offset, detail::raw_type::object);
+      bytes = offset;
+    }
+
+    template <template <class> class RefCount>
+    large_object<RefCount>::large_object(buffer_parser<RefCount> const& parser, size_t idx) noexcept :
+      marker(0),
+      reserved(0),
+      elems(parser.get_children(idx).size())
+    {
+      // Iterate over our fields, which the parser has already sorted, and write each one into the buffer.
+      large_object_entry* entry = vtable();
+      size_t offset = header_len + size() * sizeof(large_object_entry);
+      for (auto key : parser.get_children(idx)) {
+        auto const type = parser.get_type(key + 1);
+        auto const strv = parser.get_string(key);
+
+        // Using the current offset, align a pointer for the key.
+        auto* unaligned = DART_FROM_THIS_MUT + offset;
+        auto* aligned = align_pointer<RefCount>(unaligned, detail::raw_type::string);
+        offset += aligned - unaligned;
+
+        // Add an entry to the vtable, with as much of the key as we can fit.
+        auto* curr = new(entry++) large_object_entry {};
+        curr->offset = offset;
+        curr->type = static_cast<uint8_t>(type);
+        curr->len = static_cast<uint8_t>(std::min(strv.size(), size_t {large_object_entry::max_len}));
+        std::copy_n(strv.data(), std::min(strv.size(), size_t {large_object_entry::prefix_len}), curr->prefix);
+
+        // Layout our key.
+        offset += parser.lower(aligned, key);
+
+        // Realign our pointer for our value, which immediately follows our key.
+        unaligned = DART_FROM_THIS_MUT + offset;
+        aligned = align_pointer<RefCount>(unaligned, type);
+        offset += aligned - unaligned;
+        offset += parser.lower(aligned, key + 1);
+      }
+
+      // This is necessary to ensure packets can be naively stored in
+      // contiguous buffers without ruining their alignment.
+      offset = pad_bytes<RefCount>(offset, detail::raw_type::object);
+      bytes = offset;
+    }
+
+// Unfortunately some versions of GCC and MSVC aren't smart enough to figure
+// out that if this function is declared noexcept the throwing cases are dead code
+#if DART_USING_GCC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wterminate"
+#elif DART_USING_MSVC
+#pragma warning(push)
+#pragma warning(disable: 4297)
+#endif
+
+    template <template <class> class RefCount>
+    template <bool silent>
+    bool large_object<RefCount>::is_valid(size_t bytes) const noexcept(silent) {
+      // Check if we even have enough space left for the object header.
+      if (bytes < header_len) {
+        if (silent) return false;
+        else throw validation_error("Serialized large object is truncated");
+      }
+
+      // Check that the header really does belong to a large object, that the object doesn't claim
+      // to be larger than our total buffer, and then that its vtable is within its own bounds.
+      // Sizes are sixty four bits wide, so everything is checked before it's used in any arithmetic.
+      if (marker.get() != 0) {
+        if (silent) return false;
+        else throw validation_error("Serialized large object header is malformed");
+      } else if (get_sizeof() > bytes || get_sizeof() < header_len) {
+        if (silent) return false;
+        else throw validation_error("Serialized large object length is out of bounds");
+      } else if (size() > (get_sizeof() - header_len) / sizeof(large_object_entry)) {
+        if (silent) return false;
+        else throw validation_error("Serialized large object vtable length is out of bounds");
+      }
+      auto const total_size = static_cast<std::ptrdiff_t>(get_sizeof());
+
+      // Check that every element in the vtable has a valid type, and that its key
+      // metadata agrees with the key itself.
+      void const* prev = this;
+      for (size_t i = 0; i < size(); ++i) {
+        auto const& entry = vtable()[i];
+        if (!valid_type(static_cast<raw_type>(entry.type.get()))) {
+          if (silent) return false;
+          else throw validation_error("Serialized large object value is of no known type");
+        }
+
+        // Verify that the key is within bounds, and then load its base address.
+        if (entry.offset.get() > get_sizeof()) {
+          if (silent) return false;
+          else throw validation_error("Serialized large object key offset is out of bounds");
+        }
+        auto const* key = DART_FROM_THIS + entry.offset.get();
+        auto const key_offset = key - DART_FROM_THIS;
+        if (key <= prev) {
+          if (silent) return false;
+          else throw validation_error("Serialized large object key contained a negative or cyclic offset");
+        } else if (align_pointer<RefCount>(key, raw_type::string) != key) {
+          if (silent) return false;
+          else throw validation_error("Serialized large object key offset does not meet alignment requirements");
+        }
+        if (!valid_buffer<silent, RefCount>({raw_type::string, key}, total_size - key_offset)) return false;
+
+        // Lookups trust the lengths and prefixes in the vtable, so they must agree with the keys.
+        auto const strv = get_string({raw_type::string, key})->get_strv();
+        auto const len = std::min(strv.size(), size_t {large_object_entry::max_len});
+        auto const prefix_len = std::min(strv.size(), size_t {large_object_entry::prefix_len});
+        if (entry.len.get() != len || std::memcmp(entry.prefix, strv.data(), prefix_len)) {
+          if (silent) return false;
+          else throw validation_error("Serialized large object vtable does not match its keys");
+        }
+
+        // Load the base address of the value and verify that it's within bounds.
+        auto const raw_val = load_value(DART_FROM_THIS, i);
+        auto const val_offset = raw_val.buffer - DART_FROM_THIS;
+        if (val_offset > total_size) {
+          if (silent) return false;
+          else throw validation_error("Serialized large object value offset is out of bounds");
+        } else if (raw_val.type == raw_type::null) {
+          // Nulls take up no space, so they share their offset with whatever follows them.
+          continue;
+        }
+        prev = raw_val.buffer;
+
+        // Recurse on the value.
+        if (!valid_buffer<silent, RefCount>(raw_val, total_size - val_offset)) return false;
+      }
+      return true;
+    }
+
+#if DART_USING_GCC
+#pragma GCC diagnostic pop
+#elif DART_USING_MSVC
+#pragma warning(pop)
+#endif
+
+    template <template <class> class RefCount>
+    size_t large_object<RefCount>::size() const noexcept {
+      return elems.get();
+    }
+
+    template <template <class> class RefCount>
+    size_t large_object<RefCount>::get_sizeof() const noexcept {
+      return bytes.get();
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::begin() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(0, DART_FROM_THIS, load_value);
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::key_begin() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(0, DART_FROM_THIS, load_key);
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::end() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(size(), DART_FROM_THIS, load_value);
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::key_end() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(size(), DART_FROM_THIS, load_key);
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    auto large_object<RefCount>::get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element {
+      // Like objects, return the key along with the type of its value.
+      auto const idx = find_key(key);
+      if (idx < 0) return {raw_type::null, nullptr};
+      auto const& entry = vtable()[idx];
+      cb(static_cast<size_t>(idx));
+      return {static_cast<raw_type>(entry.type.get()), DART_FROM_THIS + entry.offset.get()};
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    auto large_object<RefCount>::get_key(dart::key const& handle, Callback&& cb) const noexcept -> raw_element {
+      return get_key(handle.strv(), std::forward<Callback>(cb));
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::get_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount> {
+      size_t idx = size();
+      get_key(key, [&] (auto target) { idx = target; });
+      return ll_iterator<RefCount>(idx, DART_FROM_THIS, load_value);
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::get_key_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount> {
+      size_t idx = size();
+      get_key(key, [&] (auto target) { idx = target; });
+      return ll_iterator<RefCount>(idx, DART_FROM_THIS, load_key);
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::get_value(shim::string_view const key) const noexcept -> raw_element {
+      auto const idx = find_key(key);
+      if (idx < 0) return {raw_type::null, nullptr};
+      return load_value(DART_FROM_THIS, static_cast<size_t>(idx));
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::get_value(dart::key const& handle) const noexcept -> raw_element {
+      return get_value(handle.strv());
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    void large_object<RefCount>::get_values(gsl::span<shim::string_view const> keys, Callback&& cb) const {
+      // Large objects are only ever used for enormous packets, so there's little to gain from ordering the keys.
+      for (auto i = 0U; i < static_cast<size_t>(keys.size()); ++i) cb(i, get_value(keys[i]));
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::at_value(shim::string_view const key) const -> raw_element {
+      auto const idx = find_key(key);
+      if (idx < 0) throw std::out_of_range("dart::buffer does not contain the requested mapping");
+      return load_value(DART_FROM_THIS, static_cast<size_t>(idx));
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::load_key(gsl::byte const* base, size_t idx) noexcept
+      -> typename ll_iterator<RefCount>::value_type
+    {
+      auto const* obj = get_large_object<RefCount>({raw_type::large_object, base});
+      return {raw_type::string, base + obj->vtable()[idx].offset.get()};
+    }
+
+    template <template <class> class RefCount>
+    auto large_object<RefCount>::load_value(gsl::byte const* base, size_t idx) noexcept
+      -> typename ll_iterator<RefCount>::value_type
+    {
+      // Jump over the key and align to the given type.
+      auto const* obj = get_large_object<RefCount>({raw_type::large_object, base});
+      auto const& entry = obj->vtable()[idx];
+      auto const type = static_cast<raw_type>(entry.type.get());
+      return {type, obj->value_after(base + entry.offset.get(), type)};
+    }
+
+    template <template <class> class RefCount>
+    ssize_t large_object<RefCount>::find_key(shim::string_view const key) const noexcept {
+      // Same strategy as small objects.
+      ssize_t low = 0, high = static_cast<ssize_t>(size()) - 1;
+      if (size() <= DART_LINEAR_LOOKUP_THRESHOLD) {
+        for (; low <= high; ++low) {
+          if (!compare_entry(low, key)) return low;
+        }
+        return -1;
+      }
+
+      while (high >= low) {
+        auto const mid = (low + high) / 2;
+        auto const comparison = compare_entry(mid, key);
+        if (comparison == 0) return mid;
+        else if (comparison < 0) low = mid + 1;
+        else high = mid - 1;
+      }
+      return -1;
+    }
+
+    template <template <class> class RefCount>
+    int large_object<RefCount>::compare_entry(size_t idx, shim::string_view const key) const noexcept {
+      // Keys are sorted by length, and then lexically, and the vtable gives us the lengths
+      // of every key that isn't capped, along with the first couple of characters.
+      auto const& entry = vtable()[idx];
+      auto const len = static_cast<size_t>(entry.len.get());
+      if (len < large_object_entry::max_len || key.size() < large_object_entry::max_len) {
+        if (len != key.size()) return (len < key.size()) ? -1 : 1;
+        auto const prefix_len = std::min(len, size_t {large_object_entry::prefix_len});
+        if (auto const diff = std::memcmp(entry.prefix, key.data(), prefix_len)) return diff;
+        else if (len <= large_object_entry::prefix_len) return 0;
+      }
+
+      // The prefix couldn't settle it, so compare against the key itself.
+      auto const stored = get_string({raw_type::string, DART_FROM_THIS + entry.offset.get()})->get_strv();
+      if (stored.size() != key.size()) return (stored.size() < key.size()) ? -1 : 1;
+      return stored.compare(key);
+    }
+
+    template <template <class> class RefCount>
+    large_object_entry* large_object<RefCount>::vtable() noexcept {
+      auto* base = DART_FROM_THIS_MUT + header_len;
+      return shim::launder(reinterpret_cast<large_object_entry*>(base));
+    }
+
+    template <template <class> class RefCount>
+    large_object_entry const* large_object<RefCount>::vtable() const noexcept {
+      auto* base = DART_FROM_THIS + header_len;
+      return shim::launder(reinterpret_cast<large_object_entry const*>(base));
+    }
+
+    template <template <class> class RefCount>
+    gsl::byte const* large_object<RefCount>::value_after(gsl::byte const* key, raw_type type) const noexcept {
+      return align_pointer<RefCount>(key + get_string({raw_type::string, key})->get_sizeof(), type);
+    }
+
+  }
+
+}
+
+#endif
@@ -173,6 +173,11 @@ namespace dart {
     return val.get_nested(path, separator);
   }
 
+  template <class Object>
+  auto basic_object<Object>::get_nested(path const& needle) const -> value_type {
+    return val.get_nested(needle);
+  }
+
   template <class Object>
   template <class KeyType, class EnableIf>
   auto basic_object<Object>::at(KeyType const& key) const& -> value_type {
@@ -260,56 +265,33 @@ namespace dart {
     }
 #endif
 
-#if DART_HAS_RAPIDJSON
     template <template <class> class RefCount>
-    object<RefCount>::object(rapidjson::Value const& fields) noexcept :
-      elems(static_cast<uint32_t>(fields.MemberCount()))
+    object<RefCount>::object(buffer_parser<RefCount> const& parser, size_t idx) noexcept :
+      elems(static_cast<uint32_t>(parser.get_children(idx).size()))
     {
-      using sorter = std::vector<rapidjson::Value::ConstMemberIterator>;
-
-      // Sort our fields real quick.
-      // Ugly that this is necessary, but key lookup assumes things
-      // are lexicographically sorted.
-      sorter sorted;
-      sorted.reserve(elems);
-      for (auto it = fields.MemberBegin(); it != fields.MemberEnd(); ++it) {
-        sorted.push_back(it);
-      }
-      std::sort(sorted.begin(), sorted.end(), [] (auto& lhs, auto& rhs) {
-        auto lhs_len = lhs->name.GetStringLength();
-        auto rhs_len = rhs->name.GetStringLength();
-        if (lhs_len == rhs_len) {
-          shim::string_view l {lhs->name.GetString(), lhs_len};
-          shim::string_view r {rhs->name.GetString(), rhs_len};
-          return l < r;
-        } else {
-          return lhs_len < rhs_len;
-        }
-      });
-
-      // Iterate over our elements and write each one into the buffer.
+      // Iterate over our fields, which the parser has already sorted, and write each one into the buffer.
       object_entry* entry = vtable();
       size_t offset = reinterpret_cast<gsl::byte*>(&vtable()[elems]) - DART_FROM_THIS_MUT;
-      for (auto& it : sorted) {
+      for (auto key : parser.get_children(idx)) {
         // Using the current offset, align a pointer for the key (string type).
         auto* unaligned = DART_FROM_THIS_MUT + offset;
         auto* aligned = align_pointer<RefCount>(unaligned, detail::raw_type::string);
         offset += aligned - unaligned;
 
-        // Add an entry to the vtable.
-        auto val_type = json_identify<RefCount>(it->value);
-        new(entry++) object_entry(val_type, static_cast<uint32_t>(offset), it->name.GetString());
+        // Add an entry to the vtable, our value immediately follows our key.
+        auto val_type = parser.get_type(key + 1);
+        new(entry++) object_entry(val_type, static_cast<uint32_t>(offset), parser.get_string(key));
 
         // Layout our key.
-        offset += json_lower<RefCount>(aligned, it->name);
+        offset += parser.lower(aligned, key);
 
         // Realign our pointer for our value type.
         unaligned = DART_FROM_THIS_MUT + offset;
         aligned = align_pointer<RefCount>(unaligned, val_type);
         offset += aligned - unaligned;
 
-        // Layout our value (or copy it in if it's already been finalized).
-        offset += json_lower<RefCount>(aligned, it->value);
+        // Layout our value.
+        offset += parser.lower(aligned, key + 1);
       }
 
       // This is necessary to ensure packets can be naively stored in
@@ -319,83 +301,178 @@ namespace dart {
       // object is laid out, write in our final size.
       bytes = static_cast<uint32_t>(offset);
     }
-#endif
 
     template <template <class> class RefCount>
-    object<RefCount>::object(gsl::span<packet_pair<RefCount>> pairs) noexcept :
+    object<RefCount>::object(gsl::span<packet_pair<RefCount>> pairs, finalize_options const& opts) noexcept :
       elems(static_cast<uint32_t>(pairs.size()))
     {
+      // Figure out which optional sections we need to leave room for after the vtable.
+      // Objects being finalized alongside a key dictionary refer to it wherever they can,
+      // and the root object holds it.
+      auto* dict = key_dictionary::current();
+      if (dict && !dict->in_buffer(this)) dict = nullptr;
+      auto const owner = dict && dict->is_root(this);
+      auto extensions = extension_flags(size(), opts) | (owner ? key_dictionary_section : 0U);
+
+      // Only leave room for inline values if there are some, and write the extension header
+      // up front, as they're written into their section as we go.
+      auto const inlines = (extensions & inline_value_section)
+        && std::any_of(std::begin(pairs), std::end(pairs), [] (auto const& pair) {
+          return pair.value.fits_inline(object_inline_bytes);
+        });
+      if (inlines) {
+        auto* ext = new(raw_vtable() + size() * sizeof(object_entry)) extension_layout;
+        ext->flags = extensions;
+      } else {
+        extensions &= ~inline_value_section;
+      }
+
       // Iterate over our elements and write each one into the buffer.
+      bool canonical = true;
       object_entry* entry = vtable();
       size_t offset = reinterpret_cast<gsl::byte*>(&vtable()[elems]) - DART_FROM_THIS_MUT;
+      offset += extension_sizeof(extensions, size());
+      if (owner) offset += dict->layout(DART_FROM_THIS_MUT + offset);
+
+      // Keys are shared all or nothing, so any key missing from the dictionary keeps them all inline.
+      auto const shared = dict && size() && std::all_of(std::begin(pairs), std::end(pairs), [dict] (auto const& pair) {
+        return dict->find(pair.key.strv());
+      });
+      if (!shared) dict = nullptr;
+      bool dependent = shared && !owner;
       for (auto& pair : pairs) {
-        // Using the current offset, align a pointer for the key (string type).
+        // Nested aggregates may be laid out with a smaller encoding than their own.
+        auto const type = pair.value.get_raw_type(opts);
+
+        // Using the current offset, align a pointer for the key (string type, or a reference to one).
         auto* unaligned = DART_FROM_THIS_MUT + offset;
-        auto* aligned = align_pointer<RefCount>(unaligned, detail::raw_type::string);
+        auto* aligned = shared ? align_to(unaligned, key_reference::alignment)
+          : align_pointer<RefCount>(unaligned, detail::raw_type::string);
         offset += aligned - unaligned;
 
         // Add an entry to the vtable.
-        new(entry++)
-          object_entry(pair.value.get_raw_type(),
+        auto* curr = new(entry++)
+          object_entry(type,
             static_cast<uint32_t>(offset), pair.key.str());
 
         // Layout our key.
-        offset += pair.key.layout(aligned);
+        offset += layout_key(aligned, pair.key, dict);
+
+        // Scalars that fit alongside the vtable don't take up any space in the body.
+        if (inlines && pair.value.fits_inline(object_inline_bytes)) {
+          curr->set_inline();
+          pair.value.layout(inline_value(curr - vtable()), opts, type);
+          continue;
+        }
 
         // Realign our pointer for our value type.
         unaligned = DART_FROM_THIS_MUT + offset;
-        aligned = align_pointer<RefCount>(unaligned, pair.value.get_raw_type());
+        aligned = align_pointer<RefCount>(unaligned, type);
         offset += aligned - unaligned;
 
         // Layout our value (or copy it in if it's already been finalized).
-        offset += pair.value.layout(aligned);
+        offset += pair.value.layout(aligned, opts, type);
+        canonical = canonical && detail::is_canonical<RefCount>({type, aligned});
+        dependent = dependent || (!owner && detail::is_dependent<RefCount>({type, aligned}));
       }
 
       // This is necessary to ensure packets can be naively stored in
       // contiguous buffers without ruining their alignment.
       offset = pad_bytes<RefCount>(offset, detail::raw_type::object);
 
-      // object is laid out, write in our final size.
+      // object is laid out, write in our final size and any optional sections.
+      // Sections are derived from the keys, so we have to know where they are first.
       bytes = static_cast<uint32_t>(offset);
+      if (shared) elems |= aggregate_shared_keys_flag;
+      if (dependent) elems |= aggregate_dependent_flag;
+      write_extensions(extensions, canonical && !shared);
     }
 
     // FIXME: Audit this function. A LOT has changed since it was written.
     template <template <class> class RefCount>
-    object<RefCount>::object(packet_fields<RefCount> const* fields) noexcept :
+    object<RefCount>::object(packet_fields<RefCount> const* fields, finalize_options const& opts) noexcept :
       elems(static_cast<uint32_t>(fields->size()))
     {
+      // Figure out which optional sections we need to leave room for after the vtable.
+      // Objects being finalized alongside a key dictionary refer to it wherever they can,
+      // and the root object holds it.
+      auto* dict = key_dictionary::current();
+      if (dict && !dict->in_buffer(this)) dict = nullptr;
+      auto const owner = dict && dict->is_root(this);
+      auto extensions = extension_flags(size(), opts) | (owner ? key_dictionary_section : 0U);
+
+      // Only leave room for inline values if there are some, and write the extension header
+      // up front, as they're written into their section as we go.
+      auto const inlines = (extensions & inline_value_section)
+        && std::any_of(std::begin(*fields), std::end(*fields), [] (auto const& field) {
+          return field.second.fits_inline(object_inline_bytes);
+        });
+      if (inlines) {
+        auto* ext = new(raw_vtable() + size() * sizeof(object_entry)) extension_layout;
+        ext->flags = extensions;
+      } else {
+        extensions &= ~inline_value_section;
+      }
+
       // Iterate over our elements and write each one into the buffer.
+      bool canonical = true;
       object_entry* entry = vtable();
       size_t offset = reinterpret_cast<gsl::byte*>(&vtable()[elems]) - DART_FROM_THIS_MUT;
+      offset += extension_sizeof(extensions, size());
+      if (owner) offset += dict->layout(DART_FROM_THIS_MUT + offset);
+
+      // Keys are shared all or nothing, so any key missing from the dictionary keeps them all inline.
+      auto const shared = dict && size() && std::all_of(std::begin(*fields), std::end(*fields), [dict] (auto const& field) {
+        return dict->find(field.first.strv());
+      });
+      if (!shared) dict = nullptr;
+      bool dependent = shared && !owner;
       for (auto const& field : *fields) {
-        // Using the current offset, align a pointer for the key (string type).
+        // Nested aggregates may be laid out with a smaller encoding than their own.
+        auto const type = field.second.get_raw_type(opts);
+
+        // Using the current offset, align a pointer for the key (string type, or a reference to one).
         auto* unaligned = DART_FROM_THIS_MUT + offset;
-        auto* aligned = align_pointer<RefCount>(unaligned, detail::raw_type::string);
+        auto* aligned = shared ? align_to(unaligned, key_reference::alignment)
+          : align_pointer<RefCount>(unaligned, detail::raw_type::string);
         offset += aligned - unaligned;
 
         // Add an entry to the vtable.
-        new(entry++)
-          object_entry(field.second.get_raw_type(),
+        auto* curr = new(entry++)
+          object_entry(type,
               static_cast<uint32_t>(offset), field.first.str());
 
         // Layout our key.
-        offset += field.first.layout(aligned);
+        offset += layout_key(aligned, field.first, dict);
+
+        // Scalars that fit alongside the vtable don't take up any space in the body.
+        if (inlines && field.second.fits_inline(object_inline_bytes)) {
+          curr->set_inline();
+          field.second.layout(inline_value(curr - vtable()), opts, type);
+          continue;
+        }
 
         // Realign our pointer for our value type.
         unaligned = DART_FROM_THIS_MUT + offset;
-        aligned = align_pointer<RefCount>(unaligned, field.second.get_raw_type());
+        aligned = align_pointer<RefCount>(unaligned, type);
         offset += aligned - unaligned;
 
         // Layout our value (or copy it in if it's already been finalized).
-        offset += field.second.layout(aligned);
+        offset += field.second.layout(aligned, opts, type);
+        canonical = canonical && detail::is_canonical<RefCount>({type, aligned});
+        dependent = dependent || (!owner && detail::is_dependent<RefCount>({type, aligned}));
       }
 
       // This is necessary to ensure packets can be naively stored in
       // contiguous buffers without ruining their alignment.
       offset = pad_bytes<RefCount>(offset, detail::raw_type::object);
 
-      // object is laid out, write in our final size.
+      // object is laid out, write in our final size and any optional sections.
+      // Sections are derived from the keys, so we have to know where they are first.
       bytes = static_cast<uint32_t>(offset);
+      if (shared) elems |= aggregate_shared_keys_flag;
+      if (dependent) elems |= aggregate_dependent_flag;
+      write_extensions(extensions, canonical && !shared);
     }
 
     template <template <class> class RefCount>
@@ -417,6 +494,7 @@ namespace dart {
       // Iterate across both object simultaneously, uniquely visiting each key-value pair,
       // giving precedence to the incoming packet for collisions.
       // Write each pair into our buffer.
+      bool canonical = true;
       object_entry* entry = vtable();
       size_t offset = reinterpret_cast<gsl::byte*>(&vtable()[guess]) - DART_FROM_THIS_MUT;
       buffer_builder<RefCount>::each_unique_pair(base, incoming, [&] (auto raw_key, auto raw_val) {
@@ -443,6 +521,7 @@ namespace dart {
         // Copy in our value
         auto val_len = find_sizeof<RefCount>(raw_val);
         std::copy_n(raw_val.buffer, val_len, aligned);
+        canonical = canonical && detail::is_canonical<RefCount>(raw_val);
         offset += val_len;
         ++elems;
       });
@@ -457,6 +536,7 @@ namespace dart {
 
       // object is laid out, write in our final size.
       bytes = static_cast<uint32_t>(offset);
+      write_extensions(0, canonical);
     }
 
     template <template <class> class RefCount>
@@ -466,6 +546,7 @@ namespace dart {
       auto guess = key_ptrs.size();
 
       // Iterate over our elements and write each one into the buffer.
+      bool canonical = true;
       object_entry* entry = vtable();
       size_t offset = reinterpret_cast<gsl::byte*>(&vtable()[guess]) - DART_FROM_THIS_MUT;
       buffer_builder<RefCount>::project_each_pair(base, key_ptrs, [&] (auto raw_key, auto raw_val) {
@@ -492,6 +573,7 @@ namespace dart {
         // Copy in our value
         auto val_len = find_sizeof<RefCount>(raw_val);
         std::copy_n(raw_val.buffer, val_len, aligned);
+        canonical = canonical && detail::is_canonical<RefCount>(raw_val);
         offset += val_len;
         ++elems;
       });
@@ -506,6 +588,7 @@ namespace dart {
 
       // object is laid out, write in our final size.
       bytes = static_cast<uint32_t>(offset);
+      write_extensions(0, canonical);
     }
 
 // Unfortunately some versions of GCC and MSVC aren't smart enough to figure
@@ -519,6 +602,100 @@ namespace dart {
 #pragma warning(disable: 4297)
 #endif
 
+    template <template <class> class RefCount>
+    template <bool silent>
+    bool object<RefCount>::is_valid_layout(size_t bytes) const noexcept(silent) {
+      // Everything checked here lives within the first bytes of the object, so the bound can be
+      // smaller than the object itself.
+      auto const total_size = static_cast<std::ptrdiff_t>(bytes);
+
+      // Check if the vtable is within bounds.
+      auto* vtable_end = raw_vtable() + (size() * sizeof(object_entry));
+      if (vtable_end - DART_FROM_THIS > total_size) {
+        if (silent) return false;
+        else throw validation_error("Serialized object vtable length is out of bounds");
+      }
+
+      // We now know that the vtable is fully within bounds, but it could still be full of crap
+      // Check that every element in the vtable has a valid type
+      for (size_t i = 0; i < size(); ++i) {
+        if (!valid_type(strip_inline(vtable()[i].get_type()))) {
+          if (silent) return false;
+          else throw validation_error("Serialized object value is of no known type");
+        }
+      }
+
+      // If the object carries an extension area, check that it's internally consistent
+      // before anyone tries to use it for lookups.
+      if (is_extended()) {
+        if (vtable_end + sizeof(extension_layout) - DART_FROM_THIS > total_size) {
+          if (silent) return false;
+          else throw validation_error("Serialized object extension header is out of bounds");
+        }
+
+        auto const* ext = extension();
+        auto const ext_flags = ext->flags.get();
+        auto ext_bytes = extension_sizeof(ext_flags, size());
+        if (ext_flags & ~all_sections) {
+          if (silent) return false;
+          else throw validation_error("Serialized object extension contains sections of no known type");
+        } else if (ext_flags & key_dictionary_section) {
+          // The key dictionary records its own size, so its header has to be checked first.
+          if (vtable_end + ext_bytes + sizeof(key_dictionary_layout) - DART_FROM_THIS > total_size) {
+            if (silent) return false;
+            else throw validation_error("Serialized object key dictionary header is out of bounds");
+          }
+          auto const* header =
+            reinterpret_cast<key_dictionary_layout const*>(extension_section(key_dictionary_section));
+          if (header->bytes < sizeof(key_dictionary_layout)) {
+            if (silent) return false;
+            else throw validation_error("Serialized object key dictionary is malformed");
+          }
+          ext_bytes += header->bytes;
+        }
+
+        if (ext->bytes != ext_bytes) {
+          if (silent) return false;
+          else throw validation_error("Serialized object extension length is inconsistent");
+        } else if (vtable_end + ext->bytes - DART_FROM_THIS > total_size) {
+          if (silent) return false;
+          else throw validation_error("Serialized object extension length is out of bounds");
+        }
+
+        // Every entry of an eytzinger index refers back to the vtable by position.
+        if (ext_flags & eytzinger_section) {
+          auto const* index = reinterpret_cast<object_entry const*>(extension_section(eytzinger_section));
+          for (size_t i = 0; i < size(); ++i) {
+            if (index[i].get_offset() >= size()) {
+              if (silent) return false;
+              else throw validation_error("Serialized object eytzinger index is out of bounds");
+            }
+          }
+        }
+
+        // Same goes for the slots of a perfect hash table, and the table must have been
+        // built with the same number of buckets we'd use to read it.
+        if (ext_flags & perfect_hash_section) {
+          auto const* header =
+            reinterpret_cast<perfect_hash_layout const*>(extension_section(perfect_hash_section));
+          auto const num_buckets = perfect_hash_buckets(size());
+          if (header->buckets != num_buckets && header->buckets != 0) {
+            if (silent) return false;
+            else throw validation_error("Serialized object perfect hash table is malformed");
+          }
+
+          auto const* slots = reinterpret_cast<little_order<uint32_t> const*>(header + 1) + num_buckets;
+          for (size_t i = 0; header->buckets && i < size(); ++i) {
+            if (slots[i].get() >= size()) {
+              if (silent) return false;
+              else throw validation_error("Serialized object perfect hash table is out of bounds");
+            }
+          }
+        }
+      }
+      return true;
+    }
+
     template <template <class> class RefCount>
     template <bool silent>
     bool object<RefCount>::is_valid(size_t bytes) const noexcept(silent) {
@@ -539,52 +716,88 @@ namespace dart {
         else throw validation_error("Serialized object length is out of bounds");
       }
 
-      // The object reports a reasonable total length,
-      // so now check if the vtable is within bounds.
-      auto* vtable_end = raw_vtable() + (size() * sizeof(object_entry));
-      if (vtable_end - DART_FROM_THIS > total_size) {
+      // The object reports a reasonable total length, so check that its vtable and extension
+      // area are internally consistent.
+      if (!is_valid_layout<silent>(static_cast<size_t>(total_size))) return false;
+
+      // Objects holding a key dictionary make it available to everything they contain,
+      // which is the only place a key reference is allowed to point.
+      shim::optional<key_dictionary> owned;
+      shim::optional<key_dictionary::scope> guard;
+      if (owns_dictionary()) {
+        auto const* section = extension_section(key_dictionary_section);
+        auto const* header = reinterpret_cast<key_dictionary_layout const*>(section);
+        owned.emplace(section, section + header->bytes);
+        guard.emplace(&*owned);
+      }
+      auto const* dict = shares_keys() ? key_dictionary::current() : nullptr;
+      if (shares_keys() && !dict) {
         if (silent) return false;
-        else throw validation_error("Serialized object vtable length is out of bounds");
+        else throw validation_error("Serialized object shares keys, but is not within a key dictionary");
       }
 
-      // We now know that the vtable is fully within bounds, but it could still be full of crap
-      // Check that every element in the vtable has a valid type
-      for (size_t i = 0; i < size(); ++i) {
-        if (!valid_type(vtable()[i].get_type())) {
-          if (silent) return false;
-          else throw validation_error("Serialized object value is of no known type");
-        }
-      }
+      // Inline values can only be stored if there's somewhere to put them.
+      auto const has_inlines = is_extended() && (extension()->flags & inline_value_section);
 
       // We now know the entire vtable is within bounds,
       // so iterate over it and check all contained children.
       void const* prev = this;
-      auto key_it = key_begin(), val_it = begin();
-      while (val_it != end()) {
+      auto val_it = begin();
+      for (size_t i = 0; i < size(); ++i, ++val_it) {
         // We know the whole vtable is within bounds, but it could still specify offsets that aren't,
         // so load the base address of the key and verify that it's within bounds
         // We compare against the size of the object here as we already know it's within bounds
-        auto raw_key = *key_it;
-        auto key_offset = raw_key.buffer - DART_FROM_THIS;
+        auto const* slot = DART_FROM_THIS + vtable()[i].get_offset();
+        auto key_offset = slot - DART_FROM_THIS;
+        auto const* aligned = dict ? align_to(slot, key_reference::alignment)
+          : align_pointer<RefCount>(slot, raw_type::string);
         if (key_offset > total_size) {
           // Key offset is out of bounds
           if (silent) return false;
           else throw validation_error("Serialized object key offset is out of bounds");
-        } else if (raw_key.buffer <= prev) {
+        } else if (slot <= prev) {
           if (silent) return false;
           else throw validation_error("Serialized object key contained a negative or cyclic offset");
-        } else if (align_pointer<RefCount>(raw_key.buffer, raw_key.type) != raw_key.buffer) {
+        } else if (aligned != slot) {
           if (silent) return false;
           else throw validation_error("Serialized object key offset does not meet alignment requirements");
         }
-        prev = raw_key.buffer;
+        prev = slot;
 
         // We now know that at least up to the base of the key is within bounds, so recurse on the key.
         // If the buffer validation routine returns false, it means we're not throwing errors.
         // It would be unsafe to dereference the value iterator at this point, because doing so
         // loads offset information from the key, and we haven't check if it's safe yet.
-        auto valid_key = valid_buffer<silent, RefCount>(raw_key, total_size - key_offset);
-        if (!valid_key) return false;
+        // Shared keys are references, which must land on a key within the dictionary.
+        if (dict) {
+          if (key_offset + static_cast<std::ptrdiff_t>(sizeof(key_reference)) > total_size) {
+            if (silent) return false;
+            else throw validation_error("Serialized object key reference is out of bounds");
+          }
+          auto const* key = dict->resolve(slot, reinterpret_cast<key_reference const*>(slot)->offset.get());
+          if (!key || align_pointer<RefCount>(key, raw_type::string) != key) {
+            if (silent) return false;
+            else throw validation_error("Serialized object key reference does not point into its key dictionary");
+          }
+          auto valid_key = valid_buffer<silent, RefCount>({raw_type::string, key}, dict->end() - key);
+          if (!valid_key) return false;
+        } else {
+          auto valid_key = valid_buffer<silent, RefCount>({raw_type::string, slot}, total_size - key_offset);
+          if (!valid_key) return false;
+        }
+
+        // Inline values live in a section we've already bounds checked, but have to be scalars
+        // that fit within their slot.
+        if (vtable()[i].is_inline()) {
+          auto const kind = simplify_type(strip_inline(vtable()[i].get_type()));
+          if (!has_inlines || kind == type::object || kind == type::array) {
+            if (silent) return false;
+            else throw validation_error("Serialized object inline value is malformed");
+          }
+          auto valid_val = valid_buffer<silent, RefCount>(*val_it, object_inline_bytes);
+          if (!valid_val) return false;
+          continue;
+        }
 
         // Now we can dereference the value iterator since we know the key appears reasonable.
         // Load the base address of the value and verify that it's within bounds.
@@ -593,6 +806,9 @@ namespace dart {
         if (val_offset > total_size) {
           if (silent) return false;
           else throw validation_error("Serialized object value offset is out of bounds");
+        } else if (raw_val.type == raw_type::null) {
+          // Nulls take up no space, so they share their offset with whatever follows them.
+          continue;
         } else if (raw_val.buffer <= prev) {
           if (silent) return false;
           else throw validation_error("Serialized object value contained a negative or cyclic offset");
@@ -605,9 +821,24 @@ namespace dart {
         // We now know that at least up to the base of the value is within bounds, so recurse on the value.
         auto valid_val = valid_buffer<silent, RefCount>(raw_val, total_size - val_offset);
         if (!valid_val) return false;
+      }
+
+      // Lookups trust the wide prefixes of short keys entirely, so they must agree with the keys.
+      if (auto const* wide = wide_prefixes()) {
+        for (size_t i = 0; i < size(); ++i) {
+          auto const expected = make_wide_prefix(get_string(load_key(DART_FROM_THIS, i))->get_strv());
+          if (std::memcmp(wide[i].bytes, expected.bytes, sizeof(expected.bytes))) {
+            if (silent) return false;
+            else throw validation_error("Serialized object wide prefix does not match its key");
+          }
+        }
+      }
 
-        // Check the next pair.
-        ++key_it, ++val_it;
+      // Comparisons trust content hashes to tell unequal buffers apart, so they must agree with the contents.
+      // Everything beneath us has already been validated, so nested hashes can be relied upon.
+      if (has_content_hash() && content_hash() != compute_content_hash()) {
+        if (silent) return false;
+        else throw validation_error("Serialized object content hash does not match its contents");
       }
       return true;
     }
@@ -620,7 +851,7 @@ namespace dart {
 
     template <template <class> class RefCount>
     size_t object<RefCount>::size() const noexcept {
-      return elems;
+      return elems & aggregate_size_mask;
     }
 
     template <template <class> class RefCount>
@@ -628,6 +859,37 @@ namespace dart {
       return bytes;
     }
 
+    template <template <class> class RefCount>
+    bool object<RefCount>::is_canonical() const noexcept {
+      return !(elems & aggregate_noncanonical_flag);
+    }
+
+    template <template <class> class RefCount>
+    bool object<RefCount>::has_content_hash() const noexcept {
+      return is_extended() && (extension()->flags & content_hash_section);
+    }
+
+    template <template <class> class RefCount>
+    uint64_t object<RefCount>::content_hash() const noexcept {
+      return reinterpret_cast<little_order<uint64_t> const*>(extension_section(content_hash_section))->get();
+    }
+
+    template <template <class> class RefCount>
+    bool object<RefCount>::is_dependent() const noexcept {
+      return elems & aggregate_dependent_flag;
+    }
+
+    template <template <class> class RefCount>
+    bool object<RefCount>::owns_dictionary() const noexcept {
+      return is_extended() && (extension()->flags & key_dictionary_section);
+    }
+
+    template <template <class> class RefCount>
+    size_t object<RefCount>::field_offset(size_t idx) const noexcept {
+      // Keys are laid out in vtable order, so this is also where the body of the field begins.
+      return vtable()[idx].get_offset();
+    }
+
     template <template <class> class RefCount>
     auto object<RefCount>::begin() const noexcept -> ll_iterator<RefCount> {
       return ll_iterator<RefCount>(0, DART_FROM_THIS, load_value);
@@ -651,14 +913,160 @@ namespace dart {
     template <template <class> class RefCount>
     template <class Callback>
     auto object<RefCount>::get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element {
+      auto hasher = [key] (uint32_t seed) { return hash_key(key, seed); };
+      return get_key_impl(key, hasher, std::forward<Callback>(cb));
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    auto object<RefCount>::get_key(dart::key const& handle, Callback&& cb) const noexcept -> raw_element {
+      // Buffers of the same shape store a given key at the same position,
+      // so check wherever this key was last found before searching for it.
+      auto const hint = handle.hint.load(std::memory_order_relaxed);
+      if (hint < size() && entry_matches(hint, handle.strv(), handle.meta)) {
+        auto const& entry = vtable()[hint];
+        cb(hint);
+        return {entry.get_type(), DART_FROM_THIS + entry.get_offset()};
+      }
+
+      // Perfect hash tables are almost always built with the first seed,
+      // for which the handle already knows its hash.
+      auto hasher = [&handle] (uint32_t seed) { return seed ? hash_key(handle.strv(), seed) : handle.hash; };
+      return get_key_impl(handle.strv(), hasher, [&handle, &cb] (auto idx) {
+        handle.hint.store(static_cast<uint32_t>(idx), std::memory_order_relaxed);
+        cb(idx);
+      });
+    }
+
+    template <template <class> class RefCount>
+    template <class Hasher, class Callback>
+    auto object<RefCount>::get_key_impl(shim::string_view const key,
+        Hasher&& hasher, Callback&& cb) const noexcept -> raw_element
+    {
+      if (DART_UNLIKELY(is_extended()) && (extension()->flags & fingerprint_section)) {
+        return cached_get_key(key, std::forward<Hasher>(hasher), std::forward<Callback>(cb));
+      }
+      return search_get_key(key, std::forward<Hasher>(hasher), std::forward<Callback>(cb));
+    }
+
+    template <template <class> class RefCount>
+    template <class Hasher, class Callback>
+    auto object<RefCount>::cached_get_key(shim::string_view const key,
+        Hasher&& hasher, Callback&& cb) const noexcept -> raw_element
+    {
+      // Objects with the same fingerprint have the same keys in the same order,
+      // so wherever a key was last found in an object of this shape is where it will be now.
+      auto const fingerprint =
+        reinterpret_cast<little_order<uint64_t> const*>(extension_section(fingerprint_section))->get();
+      auto const key_hash = hasher(0);
+      auto& cached = shape_cache_slot(fingerprint, key_hash);
+      if (cached.fingerprint == fingerprint && cached.key == key_hash) {
+        // The cache is shared by every object on this thread, so verify the hit.
+        auto const idx = cached.index;
+        if (idx < size() && entry_matches(idx, key, key_meta(key))) {
+          auto const& entry = vtable()[idx];
+          cb(idx);
+          return {entry.get_type(), DART_FROM_THIS + entry.get_offset()};
+        }
+      }
+
+      // Fall back on searching, and remember where we found the key.
+      auto rehasher = [&hasher, key_hash] (uint32_t seed) { return seed ? hasher(seed) : key_hash; };
+      return search_get_key(key, rehasher, [&] (auto idx) {
+        cached = {fingerprint, key_hash, static_cast<size_t>(idx)};
+        cb(idx);
+      });
+    }
+
+    template <template <class> class RefCount>
+    template <class Hasher, class Callback>
+    auto object<RefCount>::search_get_key(shim::string_view const key,
+        Hasher&& hasher, Callback&& cb) const noexcept -> raw_element
+    {
+      // Prefer any lookup index the object was finalized with.
+      if (DART_UNLIKELY(is_extended())) {
+        // Objects that couldn't be given a perfect hash table still carry its (empty) section.
+        auto const flags = extension()->flags.get();
+        if ((flags & perfect_hash_section) && has_perfect_hash()) {
+          return perfect_hash_get_key(key, std::forward<Hasher>(hasher), std::forward<Callback>(cb));
+        } else if (flags & eytzinger_section) {
+          return eytzinger_get_key(key, std::forward<Callback>(cb));
+        }
+      }
+
+      // Small objects are cheaper to scan than to search, as the whole vtable
+      // fits in a handful of cache lines and the scan doesn't mispredict.
+      if (size() <= DART_LINEAR_LOOKUP_THRESHOLD) return linear_get_key(key, std::forward<Callback>(cb));
+      else return binary_get_key(key, std::forward<Callback>(cb));
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    auto object<RefCount>::linear_get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element {
+      // The last four bytes of every vtable entry hold the type, the (capped) key length,
+      // and the key prefix, so build an identically laid out word for the key we're looking for.
+      constexpr auto prefix_len = sizeof(prefix_entry::prefix_type);
+      auto const key_size = key.size();
+      auto const needle = key_meta(key);
+      auto const mask = key_meta_mask();
+
+      // Length and prefix matching is only a filter for keys longer than the prefix,
+      // so candidates may need to be verified against the actual key.
+      gsl::byte const* const base = DART_FROM_THIS;
+      auto const* entries = raw_vtable();
+      auto const* wide = wide_prefixes();
+      auto check = [&] (size_t idx) {
+        if (key_size <= prefix_len) return true;
+        return !compare_tail(idx, key, wide);
+      };
+      auto found = [&] (size_t idx) -> raw_element {
+        auto const& entry = vtable()[idx];
+        cb(idx);
+        return {entry.get_type(), base + entry.get_offset()};
+      };
+
+      size_t idx = 0;
+      size_t const num_keys = size();
+#if DART_HAS_SSE2
+      // Compare two entries per register, four per iteration.
+      // The offset lanes are masked to zero and compared against all ones so they never match.
+      auto const vmask = _mm_set_epi32(static_cast<int>(mask), 0, static_cast<int>(mask), 0);
+      auto const vneedle = _mm_set_epi32(static_cast<int>(needle), -1, static_cast<int>(needle), -1);
+      for (; idx + 4 <= num_keys; idx += 4) {
+        auto const* chunk = reinterpret_cast<__m128i const*>(entries + (idx * sizeof(object_entry)));
+        auto const lo = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(chunk), vmask), vneedle);
+        auto const hi = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(chunk + 1), vmask), vneedle);
+        auto const hits = static_cast<uint32_t>(_mm_movemask_epi8(lo))
+          | (static_cast<uint32_t>(_mm_movemask_epi8(hi)) << 16);
+        if (!hits) continue;
+
+        // Each matching entry sets a nibble starting at bit four of its eight bit group.
+        for (size_t i = 0; i < 4; ++i) {
+          if ((hits & (0x10U << (i * 8))) && check(idx + i)) return found(idx + i);
+        }
+      }
+#endif
+
+      // Scalar path for the remaining entries.
+      for (; idx < num_keys; ++idx) {
+        uint32_t meta;
+        std::memcpy(&meta, entries + (idx * sizeof(object_entry)) + sizeof(uint32_t), sizeof(meta));
+        if ((meta & mask) == needle && check(idx)) return found(idx);
+      }
+      return {detail::raw_type::null, nullptr};
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    auto object<RefCount>::binary_get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element {
       // Get the size of the vtable.
       size_t const num_keys = size();
 
       // Run binary search to find the key.
       gsl::byte const* target = nullptr;
       auto type = detail::raw_type::null;
-      ssize_t const key_size = key.size();
       gsl::byte const* const base = DART_FROM_THIS;
+      auto const* wide = wide_prefixes();
       int32_t low = 0, high = static_cast<int32_t>(num_keys) - 1;
       while (high >= low) {
         // Calculate the location of the next guess.
@@ -667,12 +1075,7 @@ namespace dart {
         // Run the comparison.
         auto const& entry = vtable()[mid];
         ssize_t comparison = -entry.prefix_compare(key);
-        if (!comparison) {
-          auto const* curr_str = detail::get_string({detail::raw_type::string, base + entry.get_offset()});
-          auto const curr_view = curr_str->get_strv();
-          ssize_t const curr_size = curr_view.size();
-          comparison = (curr_size == key_size) ? key.compare(curr_view) : key_size - curr_size;
-        }
+        if (!comparison) comparison = -compare_tail(mid, key, wide);
 
         // Update.
         if (comparison == 0) {
@@ -695,6 +1098,135 @@ namespace dart {
       return {type, target};
     }
 
+    template <template <class> class RefCount>
+    template <class Callback>
+    auto object<RefCount>::eytzinger_get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element {
+      // The index holds a copy of the vtable in breadth-first order, with each offset replaced by the
+      // position of the corresponding entry in the (sorted) vtable.
+      // The children of slot k live at 2k and 2k + 1, so the descent is a single multiply-add
+      // per level, and the next few levels of the tree are contiguous and can be prefetched.
+      size_t const num_keys = size();
+      gsl::byte const* const base = DART_FROM_THIS;
+      auto const* index = reinterpret_cast<object_entry const*>(extension_section(eytzinger_section));
+      auto const* wide = wide_prefixes();
+
+      size_t slot = 1;
+      while (slot <= num_keys) {
+        // Sixteen entries, four levels down, fill two cache lines.
+        if (slot * 16 <= num_keys) DART_PREFETCH(&index[slot * 16 - 1]);
+
+        // Run the comparison.
+        auto const& probe = index[slot - 1];
+        ssize_t comparison = -probe.prefix_compare(key);
+        if (!comparison) comparison = -compare_tail(probe.get_offset(), key, wide);
+
+        if (comparison == 0) {
+          auto const idx = probe.get_offset();
+          auto const& entry = vtable()[idx];
+          cb(idx);
+          return {entry.get_type(), base + entry.get_offset()};
+        }
+        slot = 2 * slot + (comparison > 0);
+      }
+      return {detail::raw_type::null, nullptr};
+    }
+
+    template <template <class> class RefCount>
+    template <class Hasher, class Callback>
+    auto object<RefCount>::perfect_hash_get_key(shim::string_view const key,
+        Hasher&& hasher, Callback&& cb) const noexcept -> raw_element
+    {
+      // The table maps every key of the object to a distinct slot, so the only
+      // candidate for our key is the one stored in the slot it hashes to.
+      size_t const num_keys = size();
+      auto const* header = reinterpret_cast<perfect_hash_layout const*>(extension_section(perfect_hash_section));
+      auto const* table = reinterpret_cast<little_order<uint32_t> const*>(header + 1);
+      auto const num_buckets = header->buckets.get();
+
+      auto const hash = hasher(header->seed.get());
+      auto const displacement = table[(hash >> 32) % num_buckets].get();
+      auto const idx = table[num_buckets + perfect_hash_slot(hash, displacement, num_keys)].get();
+
+      // Keys that weren't in the object still hash somewhere, so verify the candidate.
+      if (!entry_matches(idx, key, key_meta(key))) return {detail::raw_type::null, nullptr};
+      auto const& entry = vtable()[idx];
+      cb(idx);
+      return {entry.get_type(), DART_FROM_THIS + entry.get_offset()};
+    }
+
+    template <template <class> class RefCount>
+    bool object<RefCount>::has_perfect_hash() const noexcept {
+      auto const* header = reinterpret_cast<perfect_hash_layout const*>(extension_section(perfect_hash_section));
+      return header->buckets.get();
+    }
+
+    template <template <class> class RefCount>
+    ssize_t object<RefCount>::compare_entry(size_t idx, shim::string_view const key) const noexcept {
+      // Same ordering as dart_comparator, returns the ordering of the entry relative to the key.
+      ssize_t const comparison = vtable()[idx].prefix_compare(key);
+      if (comparison) return comparison;
+      return compare_tail(idx, key, wide_prefixes());
+    }
+
+    template <template <class> class RefCount>
+    ssize_t object<RefCount>::compare_tail(size_t idx,
+        shim::string_view const key, wide_prefix_layout const* wide) const noexcept
+    {
+      // Only called once the length and prefix in the vtable entry have compared equal,
+      // so anything that could still differ lies past the prefix.
+      constexpr auto prefix_len = sizeof(prefix_entry::prefix_type);
+      size_t const key_size = key.size();
+      if (key_size <= prefix_len) return 0;
+
+      // Vtable lengths are capped, so the wide prefix is only comparable if the key is
+      // short enough that the lengths are known to be identical.
+      // Keys that fit in the wide prefix are settled without touching the key at all.
+      if (wide && key_size < std::numeric_limits<uint8_t>::max()) {
+        auto const len = std::min<size_t>(key_size - prefix_len, wide_prefix_layout::max_len);
+        auto const comparison = std::memcmp(wide[idx].bytes, key.data() + prefix_len, len);
+        if (comparison || key_size <= prefix_len + wide_prefix_layout::max_len) return comparison;
+      }
+
+      auto const* curr_str = detail::get_string({detail::raw_type::string, key_at(DART_FROM_THIS + vtable()[idx].get_offset())});
+      auto const curr_view = curr_str->get_strv();
+      ssize_t const curr_size = curr_view.size();
+      return (curr_size == static_cast<ssize_t>(key_size)) ? curr_view.compare(key) : curr_size - static_cast<ssize_t>(key_size);
+    }
+
+    template <template <class> class RefCount>
+    size_t object<RefCount>::gallop_lower_bound(size_t low, shim::string_view const key) const noexcept {
+      // Probe exponentially further ahead until we overshoot the key, which keeps the cost
+      // of each search logarithmic in the distance from the previous match, rather than in
+      // the size of the object.
+      size_t const num_keys = size();
+      size_t probe = low, step = 1;
+      while (probe < num_keys && compare_entry(probe, key) < 0) {
+        low = probe + 1;
+        probe = low + step - 1;
+        step *= 2;
+      }
+
+      // Every entry before low is less than the key, and the probe (if it's in bounds)
+      // is not, so binary search what's left.
+      size_t high = probe < num_keys ? probe : num_keys;
+      while (low < high) {
+        auto const mid = low + (high - low) / 2;
+        if (compare_entry(mid, key) < 0) low = mid + 1;
+        else high = mid;
+      }
+      return low;
+    }
+
+    template <template <class> class RefCount>
+    bool object<RefCount>::entry_matches(size_t idx, shim::string_view const key, uint32_t meta) const noexcept {
+      // Length and prefix are only a filter for keys longer than the prefix.
+      uint32_t entry_meta;
+      std::memcpy(&entry_meta, raw_vtable() + (idx * sizeof(object_entry)) + sizeof(uint32_t), sizeof(entry_meta));
+      if ((entry_meta & key_meta_mask()) != meta) return false;
+      else if (key.size() <= sizeof(prefix_entry::prefix_type)) return true;
+      else return !compare_tail(idx, key, wide_prefixes());
+    }
+
     template <template <class> class RefCount>
     auto object<RefCount>::get_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount> {
       size_t idx;
@@ -714,6 +1246,151 @@ namespace dart {
       return get_value_impl(key, [] (auto) {});
     }
 
+    template <template <class> class RefCount>
+    auto object<RefCount>::get_value(dart::key const& handle) const noexcept -> raw_element {
+      return get_value_impl(handle, [] (auto) {});
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    void object<RefCount>::get_values(gsl::span<shim::string_view const> keys, Callback&& cb) const {
+      // Resolve the keys in the order they're stored in, so that each search
+      // can start where the previous one left off.
+      dart_comparator<RefCount> comp;
+      std::vector<size_t> order;
+      if (!std::is_sorted(std::begin(keys), std::end(keys), comp)) {
+        order.resize(keys.size());
+        for (auto i = 0U; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&] (auto lhs, auto rhs) { return comp(keys[lhs], keys[rhs]); });
+      }
+
+      size_t low = 0;
+      size_t const num_keys = size(), num_lookups = keys.size();
+      for (auto i = 0U; i < num_lookups; ++i) {
+        auto const curr = order.empty() ? i : order[i];
+        auto const key = keys[curr];
+        low = gallop_lower_bound(low, key);
+        if (low < num_keys && !compare_entry(low, key)) {
+          // Jump over the key and align to the value, same as get_value.
+          auto const val = load_value(DART_FROM_THIS, low);
+          if (val.type == detail::raw_type::null) cb(curr, raw_element {val.type, nullptr});
+          else cb(curr, val);
+        } else {
+          cb(curr, raw_element {detail::raw_type::null, nullptr});
+        }
+      }
+    }
+
+    template <template <class> class RefCount>
+    template <class Loader, class Callback>
+    void object<RefCount>::get_values_batch(size_t count,
+        Loader&& load, shim::string_view const key, Callback&& cb)
+    {
+      // Every step of a binary search depends on the one before it, so a single search can't
+      // have more than one cache miss in flight. Independent searches can though, so step one
+      // search per object in lockstep, prefetching the next probe of each before comparing any.
+      struct search_state {
+        object const* obj;
+        int32_t low, high, mid;
+        ssize_t found;
+        bool lockstep, pending;
+      };
+      constexpr auto prefix_len = sizeof(prefix_entry::prefix_type);
+      std::array<search_state, DART_LOOKUP_BATCH_WIDTH> batch;
+
+      for (size_t start = 0; start < count; start += batch.size()) {
+        auto const width = std::min(count - start, batch.size());
+
+        // Pull in the headers of every object in the batch.
+        for (auto i = 0U; i < width; ++i) {
+          batch[i].obj = load(start + i);
+          DART_PREFETCH(batch[i].obj);
+        }
+
+        // Objects that would be scanned, or that carry a lookup index, use their usual search,
+        // everything else gets the first probe of its binary search prefetched.
+        size_t active = 0;
+        for (auto i = 0U; i < width; ++i) {
+          auto& state = batch[i];
+          auto const num_keys = state.obj->size();
+          state.found = -1;
+          state.pending = false;
+          state.lockstep = !state.obj->is_extended() && num_keys > DART_LINEAR_LOOKUP_THRESHOLD;
+          if (state.lockstep) {
+            state.low = 0;
+            state.high = static_cast<int32_t>(num_keys) - 1;
+            state.mid = state.high / 2;
+            DART_PREFETCH(&state.obj->vtable()[state.mid]);
+            ++active;
+          } else if (!state.obj->is_extended()) {
+            auto const* entries = state.obj->raw_vtable();
+            for (size_t off = 0; off < num_keys * sizeof(object_entry); off += 64) DART_PREFETCH(entries + off);
+          }
+        }
+        for (auto i = 0U; i < width; ++i) {
+          auto& state = batch[i];
+          if (!state.lockstep) state.obj->get_key(key, [&] (auto idx) { state.found = idx; });
+        }
+
+        while (active) {
+          for (auto i = 0U; i < width; ++i) {
+            auto& state = batch[i];
+            if (!state.lockstep || state.high < state.low) continue;
+
+            // Entries whose prefix matches need their key, which was prefetched last round.
+            auto const* obj = state.obj;
+            auto const& entry = obj->vtable()[state.mid];
+            ssize_t comparison;
+            if (state.pending) {
+              comparison = -obj->compare_tail(state.mid, key, nullptr);
+              state.pending = false;
+            } else {
+              comparison = -entry.prefix_compare(key);
+              if (!comparison && key.size() > prefix_len) {
+                DART_PREFETCH(reinterpret_cast<gsl::byte const*>(obj) + entry.get_offset());
+                state.pending = true;
+                continue;
+              }
+            }
+
+            if (comparison == 0) {
+              state.found = state.mid;
+              state.high = state.low - 1;
+            } else if (comparison > 0) {
+              state.low = state.mid + 1;
+            } else {
+              state.high = state.mid - 1;
+            }
+
+            if (state.high < state.low) {
+              --active;
+            } else {
+              state.mid = (state.low + state.high) / 2;
+              DART_PREFETCH(&obj->vtable()[state.mid]);
+            }
+          }
+        }
+
+        // Values are found by jumping over their keys, so pull in the keys we haven't touched yet.
+        for (auto i = 0U; i < width; ++i) {
+          auto const& state = batch[i];
+          if (state.found < 0) continue;
+          DART_PREFETCH(reinterpret_cast<gsl::byte const*>(state.obj) + state.obj->vtable()[state.found].get_offset());
+        }
+        for (auto i = 0U; i < width; ++i) {
+          auto const& state = batch[i];
+          if (state.found < 0) {
+            cb(start + i, raw_element {detail::raw_type::null, nullptr});
+            continue;
+          }
+
+          auto const val = load_value(reinterpret_cast<gsl::byte const*>(state.obj), state.found);
+          if (val.type == detail::raw_type::null) cb(start + i, raw_element {val.type, nullptr});
+          else cb(start + i, val);
+        }
+      }
+    }
+
     template <template <class> class RefCount>
     auto object<RefCount>::at_value(shim::string_view const key) const -> raw_element {
       auto& ex_msg = "dart::buffer does not contain the requested mapping";
@@ -725,8 +1402,9 @@ namespace dart {
       -> typename ll_iterator<RefCount>::value_type
     {
       // Get our vtable entry.
-      auto const& entry = detail::get_object<RefCount>({raw_type::object, base})->vtable()[idx];
-      return {detail::raw_type::string, base + entry.get_offset()};
+      auto const* obj = detail::get_object<RefCount>({raw_type::object, base});
+      auto const& entry = obj->vtable()[idx];
+      return {detail::raw_type::string, obj->key_at(base + entry.get_offset())};
     }
 
     template <template <class> class RefCount>
@@ -734,12 +1412,76 @@ namespace dart {
       -> typename ll_iterator<RefCount>::value_type
     {
       // Get our vtable entry.
-      auto const& entry = detail::get_object<RefCount>({raw_type::object, base})->vtable()[idx];
+      auto const* obj = detail::get_object<RefCount>({raw_type::object, base});
+      auto const& entry = obj->vtable()[idx];
+
+      // Inline values are stored alongside the vtable, everything else follows its key,
+      // aligned to the given type.
+      if (DART_UNLIKELY(entry.is_inline())) {
+        auto const type = strip_inline(entry.get_type());
+        return {type, type == raw_type::null ? nullptr : obj->inline_value(idx)};
+      }
+      return {entry.get_type(), obj->value_after(base + entry.get_offset(), entry.get_type())};
+    }
+
+    template <template <class> class RefCount>
+    uint32_t object<RefCount>::extension_flags(size_t elems, finalize_options const& opts) noexcept {
+      uint32_t flags = 0;
+      if (elems && elems >= opts.eytzinger_threshold) flags |= eytzinger_section;
+      if (elems && elems >= opts.perfect_hash_threshold) flags |= perfect_hash_section;
+      if (elems && elems >= opts.fingerprint_threshold) flags |= fingerprint_section;
+      if (elems && elems >= opts.wide_prefix_threshold) flags |= wide_prefix_section;
+      if (elems && elems >= opts.content_hash_threshold) flags |= content_hash_section;
+      if (elems && opts.inline_scalars) flags |= inline_value_section;
+      return flags;
+    }
+
+    template <template <class> class RefCount>
+    size_t object<RefCount>::extension_sizeof(uint32_t flags, size_t elems) noexcept {
+      if (!flags) return 0;
+
+      // Every section is a multiple of eight bytes, so the first key stays aligned.
+      size_t total = sizeof(extension_layout);
+      if (flags & eytzinger_section) total += elems * sizeof(object_entry);
+      if (flags & perfect_hash_section) {
+        auto const table_bytes = (perfect_hash_buckets(elems) + elems) * sizeof(uint32_t);
+        total += sizeof(perfect_hash_layout) + pad_bytes<RefCount>(table_bytes, detail::raw_type::object);
+      }
+      if (flags & fingerprint_section) total += sizeof(uint64_t);
+      if (flags & wide_prefix_section) total += elems * sizeof(wide_prefix_layout);
+      if (flags & content_hash_section) total += sizeof(uint64_t);
+      if (flags & inline_value_section) total += elems * object_inline_bytes;
+      return total;
+    }
 
-      // Jump over the key and align to the given type.
-      auto const* val_ptr = base + entry.get_offset();
-      auto const* key_ptr = detail::get_string({raw_type::string, val_ptr});
-      return {entry.get_type(), align_pointer<RefCount>(val_ptr + key_ptr->get_sizeof(), entry.get_type())};
+    template <template <class> class RefCount>
+    size_t object<RefCount>::perfect_hash_buckets(size_t elems) noexcept {
+      // Two keys per bucket on average costs an extra two bytes per key over
+      // denser tables, but makes the table several times faster to build.
+      return (elems + 1) / 2;
+    }
+
+    template <template <class> class RefCount>
+    size_t object<RefCount>::perfect_hash_slot(uint64_t hash, uint32_t displacement, size_t elems) noexcept {
+      // Each displacement rehashes the keys of a bucket into a fresh, independent set of slots,
+      // a variant of the "hash, displace, and compress" scheme of Belazzougui et al.
+      uint64_t mixed = hash ^ (displacement * 0x9E3779B97F4A7C15ULL);
+      mixed ^= mixed >> 31;
+      mixed *= 0xBF58476D1CE4E5B9ULL;
+      mixed ^= mixed >> 32;
+      return mixed % elems;
+    }
+
+    template <template <class> class RefCount>
+    wide_prefix_layout object<RefCount>::make_wide_prefix(shim::string_view const key) noexcept {
+      // The first bytes of the key already live in the vtable entry, so start after them.
+      constexpr auto prefix_len = sizeof(prefix_entry::prefix_type);
+      wide_prefix_layout wide {};
+      if (key.size() > prefix_len) {
+        auto const len = std::min<size_t>(key.size() - prefix_len, wide_prefix_layout::max_len);
+        std::copy_n(key.data() + prefix_len, len, wide.bytes);
+      }
+      return wide;
     }
 
     template <template <class> class RefCount>
@@ -767,10 +1509,208 @@ namespace dart {
     }
 
     template <template <class> class RefCount>
-    template <class Callback>
-    auto object<RefCount>::get_value_impl(shim::string_view const key, Callback&& cb) const -> raw_element {
+    template <class Key>
+    size_t object<RefCount>::layout_key(gsl::byte* buffer, Key const& key, key_dictionary const* dict) noexcept {
+      // Without a dictionary, keys are laid out like any other string.
+      if (!dict) return key.layout(buffer);
+
+      // Otherwise we leave behind the distance back to the copy in the dictionary,
+      // which keeps the buffer relocatable.
+      auto* ref = new(buffer) key_reference;
+      ref->offset = static_cast<uint32_t>(buffer - dict->find(key.strv()));
+      return sizeof(key_reference);
+    }
+
+    template <template <class> class RefCount>
+    void object<RefCount>::write_extensions(uint32_t flags, bool canonical) noexcept {
+      // Must be called after the vtable is complete, as every section is derived from it.
+      if (flags) {
+        auto* ext = new(raw_vtable() + size() * sizeof(object_entry)) extension_layout;
+        ext->flags = flags;
+        ext->bytes = static_cast<uint32_t>(extension_bytes());
+        elems |= aggregate_extended_flag;
+        if (flags & eytzinger_section) write_eytzinger();
+        if (flags & perfect_hash_section) write_perfect_hash();
+        if (flags & fingerprint_section) write_fingerprint();
+        if (flags & wide_prefix_section) write_wide_prefix();
+        if (flags & content_hash_section) write_content_hash();
+      }
+      if (flags || !canonical) elems |= aggregate_noncanonical_flag;
+    }
+
+    template <template <class> class RefCount>
+    void object<RefCount>::write_eytzinger() noexcept {
+      // Walk the implicit tree in order, which visits its slots in the same order as the
+      // sorted vtable, and copy each vtable entry into its slot.
+      auto const num_keys = size();
+      auto* index = reinterpret_cast<object_entry*>(extension_section(eytzinger_section));
+
+      // Start at the leftmost leaf.
+      size_t slot = 1;
+      while (slot * 2 <= num_keys) slot *= 2;
+      for (auto idx = 0U; idx < num_keys; ++idx) {
+        auto key = get_string(load_key(DART_FROM_THIS, idx))->get_strv();
+        new(&index[slot - 1]) object_entry(strip_inline(vtable()[idx].get_type()), idx, key);
+
+        // Step to the in-order successor.
+        // Either the leftmost leaf of our right subtree, or the first ancestor we're a left child of.
+        if (slot * 2 + 1 <= num_keys) {
+          slot = slot * 2 + 1;
+          while (slot * 2 <= num_keys) slot *= 2;
+        } else {
+          while (slot & 1) slot /= 2;
+          slot /= 2;
+        }
+      }
+    }
+
+    template <template <class> class RefCount>
+    void object<RefCount>::write_perfect_hash() noexcept {
+      auto const num_keys = size();
+      auto const num_buckets = perfect_hash_buckets(num_keys);
+      auto* section = extension_section(perfect_hash_section);
+      auto const section_bytes = extension_sizeof(perfect_hash_section, num_keys) - sizeof(extension_layout);
+
+      // The table is padded out to an alignment boundary, and the padding must be
+      // zeroed so that equivalent buffers stay byte-identical.
+      // A table with no buckets is how we leave behind an object without one, and lookups
+      // fall back on the vtable, so we start there, and only fill in the buckets if we succeed.
+      std::fill_n(section, section_bytes, gsl::byte {});
+      auto* header = new(section) perfect_hash_layout;
+      auto* displacements = reinterpret_cast<little_order<uint32_t>*>(header + 1);
+      auto* slots = displacements + num_buckets;
+
+      // Scratch space has to be reserved by whoever started the finalization, as we can't allocate.
+      auto* scratch = perfect_hash_scratch::current();
+      if (!scratch || scratch->capacity() < num_keys) return;
+      auto& hashes = scratch->hashes;
+      auto& members = scratch->members;
+      auto& starts = scratch->starts;
+      auto& order = scratch->order;
+      auto& candidates = scratch->candidates;
+      auto& taken = scratch->taken;
+
+      // Bound the search for any one bucket.
+      // If a bucket can't be placed, start over with a new seed, which also resolves
+      // the (vanishingly unlikely) case of two keys with identical hashes.
+      // Seeds are bounded too, as an adversarial key set could otherwise keep us here forever.
+      uint64_t const max_displacement =
+        std::min<uint64_t>(uint64_t(num_keys) * 64, std::numeric_limits<uint32_t>::max());
+      for (uint32_t seed = 0; seed < DART_PERFECT_HASH_MAX_SEEDS; ++seed) {
+        // Hash every key, and group the keys by bucket.
+        auto const bucket_end = starts.begin() + num_buckets + 1;
+        std::fill(starts.begin(), bucket_end, 0);
+        for (auto idx = 0U; idx < num_keys; ++idx) {
+          hashes[idx] = hash_key(get_string(load_key(DART_FROM_THIS, idx))->get_strv(), seed);
+          ++starts[(hashes[idx] >> 32) % num_buckets + 1];
+        }
+        for (auto b = 0U; b < num_buckets; ++b) starts[b + 1] += starts[b];
+
+        // Members are handed out from the back of each bucket, which leaves every start where it was.
+        for (auto b = 0U; b < num_buckets; ++b) order[b] = starts[b + 1] - starts[b];
+        for (auto idx = num_keys; idx; --idx) {
+          auto const bucket = (hashes[idx - 1] >> 32) % num_buckets;
+          members[starts[bucket] + --order[bucket]] = idx - 1;
+        }
+
+        // Place the largest buckets first, while the table still has plenty of room.
+        for (auto b = 0U; b < num_buckets; ++b) order[b] = b;
+        std::stable_sort(order.begin(), order.begin() + num_buckets, [&] (auto lhs, auto rhs) {
+          return starts[lhs + 1] - starts[lhs] > starts[rhs + 1] - starts[rhs];
+        });
+
+        bool placed = true;
+        std::fill(taken.begin(), taken.begin() + num_keys, false);
+        for (auto it = order.begin(); it != order.begin() + num_buckets; ++it) {
+          auto const bucket = *it;
+          auto const count = starts[bucket + 1] - starts[bucket];
+          displacements[bucket] = 0;
+          if (!count) continue;
+
+          // Find a displacement that sends every key in the bucket to a distinct, free slot.
+          placed = false;
+          for (uint64_t disp = 0; !placed && disp < max_displacement; ++disp) {
+            size_t found = 0;
+            for (auto i = starts[bucket]; i < starts[bucket + 1]; ++i, ++found) {
+              auto slot = static_cast<uint32_t>(perfect_hash_slot(hashes[members[i]], static_cast<uint32_t>(disp), num_keys));
+              auto const prev = candidates.begin() + found;
+              if (taken[slot] || std::find(candidates.begin(), prev, slot) != prev) break;
+              candidates[found] = slot;
+            }
+            if (found != count) continue;
+
+            for (auto i = starts[bucket]; i < starts[bucket + 1]; ++i) {
+              auto slot = candidates[i - starts[bucket]];
+              taken[slot] = true;
+              slots[slot] = members[i];
+            }
+            displacements[bucket] = static_cast<uint32_t>(disp);
+            placed = true;
+          }
+          if (!placed) break;
+        }
+
+        if (placed) {
+          header->seed = seed;
+          header->buckets = static_cast<uint32_t>(num_buckets);
+          return;
+        }
+      }
+
+      // Out of seeds, clear out whatever the last attempt left behind.
+      std::fill_n(section, section_bytes, gsl::byte {});
+    }
+
+    template <template <class> class RefCount>
+    void object<RefCount>::write_fingerprint() noexcept {
+      // Keys are stored in sorted order, so hashing them in vtable order
+      // gives the same fingerprint for any two objects with the same key set.
+      uint64_t fingerprint = hash_key({}, static_cast<uint32_t>(size()));
+      for (auto idx = 0U; idx < size(); ++idx) {
+        fingerprint ^= hash_key(get_string(load_key(DART_FROM_THIS, idx))->get_strv(), 0);
+        fingerprint *= 0x9E3779B97F4A7C15ULL;
+        fingerprint ^= fingerprint >> 29;
+      }
+      auto* section = extension_section(fingerprint_section);
+      new(section) little_order<uint64_t>(fingerprint);
+    }
+
+    template <template <class> class RefCount>
+    void object<RefCount>::write_wide_prefix() noexcept {
+      auto* section = extension_section(wide_prefix_section);
+      for (auto idx = 0U; idx < size(); ++idx) {
+        auto const wide = make_wide_prefix(get_string(load_key(DART_FROM_THIS, idx))->get_strv());
+        new(section + idx * sizeof(wide_prefix_layout)) wide_prefix_layout(wide);
+      }
+    }
+
+    template <template <class> class RefCount>
+    uint64_t object<RefCount>::compute_content_hash() const noexcept {
+      // Hashed field by field, as hash_contents would just hand back whatever is already stored.
+      uint64_t fields = 0;
+      auto keys = key_begin();
+      for (auto vals = begin(); vals != end(); ++keys, ++vals) {
+        fields += hash_field(hash_string(get_string(*keys)->get_strv()), hash_contents<RefCount>(*vals));
+      }
+      return hash_object(size(), fields);
+    }
+
+    template <template <class> class RefCount>
+    void object<RefCount>::write_content_hash() noexcept {
+      // Everything beneath us has already been laid out, so any nested objects
+      // that carry their own hashes have already computed them.
+      auto* section = extension_section(content_hash_section);
+      new(section) little_order<uint64_t>(compute_content_hash());
+    }
+
+    template <template <class> class RefCount>
+    template <class Key, class Callback>
+    auto object<RefCount>::get_value_impl(Key const& key, Callback&& cb) const -> raw_element {
       // Propagate through to get_key to grab the pointer to our key and the type of our value.
-      auto const field = get_key(key, [] (auto) {});
+      // The position of the key is only needed for inline values, but get_key already has it
+      // in a register when it calls back, so holding onto it costs next to nothing.
+      size_t idx = 0;
+      auto const field = get_key(key, [&idx] (auto target) { idx = target; });
 
       // If the pointer is null, the key didn't exist, and we're done.
       // Callback function is passed through here specifically so that at_value can throw without having
@@ -786,9 +1726,14 @@ namespace dart {
       // do not hold memory, so the pointer is worthless).
       if (field.type == detail::raw_type::null) return {field.type, nullptr};
 
+      // Inline values are stored alongside the vtable, at the same position as their key.
+      if (DART_UNLIKELY(is_inline_type(field.type))) {
+        auto const type = strip_inline(field.type);
+        return {type, type == raw_type::null ? nullptr : inline_value(idx)};
+      }
+
       // Otherwise, jump over the key and align to the given type.
-      auto const* key_ptr = detail::get_string({detail::raw_type::string, field.buffer});
-      return {field.type, align_pointer<RefCount>(field.buffer + key_ptr->get_sizeof(), field.type)};
+      return {field.type, value_after(field.buffer, field.type)};
     }
 
     template <template <class> class RefCount>
@@ -813,6 +1758,83 @@ namespace dart {
       return DART_FROM_THIS + sizeof(bytes) + sizeof(elems);
     }
 
+
+    template <template <class> class RefCount>
+    bool object<RefCount>::shares_keys() const noexcept {
+      return elems & aggregate_shared_keys_flag;
+    }
+
+    template <template <class> class RefCount>
+    gsl::byte const* object<RefCount>::key_at(gsl::byte const* slot) const noexcept {
+      if (!DART_UNLIKELY(shares_keys())) return slot;
+      return slot - reinterpret_cast<key_reference const*>(slot)->offset.get();
+    }
+
+    template <template <class> class RefCount>
+    gsl::byte const* object<RefCount>::value_after(gsl::byte const* slot, raw_type type) const noexcept {
+      auto const key_len = !DART_UNLIKELY(shares_keys()) ?
+        detail::get_string({raw_type::string, slot})->get_sizeof() : sizeof(key_reference);
+      return align_pointer<RefCount>(slot + key_len, type);
+    }
+
+    template <template <class> class RefCount>
+    bool object<RefCount>::is_extended() const noexcept {
+      return elems & aggregate_extended_flag;
+    }
+
+    template <template <class> class RefCount>
+    extension_layout const* object<RefCount>::extension() const noexcept {
+      auto* base = raw_vtable() + size() * sizeof(object_entry);
+      return shim::launder(reinterpret_cast<extension_layout const*>(base));
+    }
+
+    template <template <class> class RefCount>
+    size_t object<RefCount>::extension_bytes() const noexcept {
+      // Every section but the key dictionary can be sized from the flags alone.
+      auto const flags = extension()->flags.get();
+      auto total = extension_sizeof(flags, size());
+      if (flags & key_dictionary_section) {
+        total += reinterpret_cast<key_dictionary_layout const*>(extension_section(key_dictionary_section))->bytes.get();
+      }
+      return total;
+    }
+
+    template <template <class> class RefCount>
+    gsl::byte* object<RefCount>::extension_section(uint32_t section) noexcept {
+      auto const* that = this;
+      return const_cast<gsl::byte*>(that->extension_section(section));
+    }
+
+    template <template <class> class RefCount>
+    gsl::byte const* object<RefCount>::extension_section(uint32_t section) const noexcept {
+      // Skip over the header, and every section that precedes the requested one.
+      auto const flags = extension()->flags.get();
+      auto* base = reinterpret_cast<gsl::byte const*>(extension()) + sizeof(extension_layout);
+      for (uint32_t prev = 1; prev < section; prev <<= 1) {
+        if (flags & prev) base += extension_sizeof(prev, size()) - sizeof(extension_layout);
+      }
+      return base;
+    }
+
+    template <template <class> class RefCount>
+    gsl::byte* object<RefCount>::inline_value(size_t idx) noexcept {
+      auto const* that = this;
+      return const_cast<gsl::byte*>(that->inline_value(idx));
+    }
+
+    template <template <class> class RefCount>
+    gsl::byte const* object<RefCount>::inline_value(size_t idx) const noexcept {
+      // The section comes first, so there's nothing to skip over.
+      auto* base = reinterpret_cast<gsl::byte const*>(extension()) + sizeof(extension_layout);
+      return base + idx * object_inline_bytes;
+    }
+
+    template <template <class> class RefCount>
+    wide_prefix_layout const* object<RefCount>::wide_prefixes() const noexcept {
+      if (!is_extended() || !(extension()->flags & wide_prefix_section)) return nullptr;
+      return reinterpret_cast<wide_prefix_layout const*>(extension_section(wide_prefix_section));
+    }
+
   }
 
 }
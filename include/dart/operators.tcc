@@ -109,4 +109,23 @@ namespace dart {
 
 }
 
+namespace std {
+
+  template <template <class> class RefCount>
+  size_t hash<dart::basic_heap<RefCount>>::operator ()(dart::basic_heap<RefCount> const& val) const noexcept {
+    return static_cast<size_t>(dart::detail::hash_generic(val));
+  }
+
+  template <template <class> class RefCount>
+  size_t hash<dart::basic_buffer<RefCount>>::operator ()(dart::basic_buffer<RefCount> const& val) const noexcept {
+    return static_cast<size_t>(dart::detail::hash_contents<RefCount>(val.raw));
+  }
+
+  template <template <class> class RefCount>
+  size_t hash<dart::basic_packet<RefCount>>::operator ()(dart::basic_packet<RefCount> const& val) const noexcept {
+    return dart::shim::visit([] (auto& impl) { return hash<std::decay_t<decltype(impl)>> {}(impl); }, val.impl);
+  }
+
+}
+
 #endif
@@ -213,6 +213,20 @@ namespace dart {
     return *this;
   }
 
+  template <template <class> class RefCount>
+  template <bool enabled, class EnableIf>
+  basic_packet<RefCount>& basic_packet<RefCount>::finalize(finalize_options const& opts) & {
+    if (!is_finalized()) impl = shim::get<basic_heap<RefCount>>(impl).finalize(opts);
+    return *this;
+  }
+
+  template <template <class> class RefCount>
+  template <bool enabled, class EnableIf>
+  basic_packet<RefCount>&& basic_packet<RefCount>::finalize(finalize_options const& opts) && {
+    finalize(opts);
+    return std::move(*this);
+  }
+
   template <template <class> class RefCount>
   template <bool enabled, class EnableIf>
   basic_packet<RefCount>&& basic_packet<RefCount>::finalize() && {
@@ -294,6 +308,18 @@ namespace dart {
     return get_buffer().get_bytes();
   }
 
+  template <template <class> class RefCount>
+  template <class T>
+  gsl::span<T const> basic_packet<RefCount>::as_span() const {
+    return get_buffer().template as_span<T>();
+  }
+
+  template <template <class> class RefCount>
+  template <class T>
+  gsl::span<T const> basic_packet<RefCount>::column_span(shim::string_view key) const {
+    return get_buffer().template column_span<T>(key);
+  }
+
   template <template <class> class RefCount>
   size_t basic_packet<RefCount>::share_bytes(RefCount<gsl::byte const>& bytes) const {
     return get_buffer().share_bytes(bytes);
@@ -10,27 +10,41 @@
 namespace dart {
 
   template <template <class> class RefCount>
-  size_t basic_packet<RefCount>::upper_bound() const noexcept {
+  size_t basic_packet<RefCount>::upper_bound(finalize_options const& opts) const noexcept {
     return shim::visit(
       shim::compose_together(
-        [] (basic_buffer<RefCount> const& impl) { return detail::find_sizeof<RefCount>(impl.raw); },
-        [] (basic_heap<RefCount> const& impl) { return impl.upper_bound(); }
+        [&] (basic_buffer<RefCount> const& impl) {
+          // Rows of a record batch, and anything that refers to a key dictionary,
+          // don't own all of their bytes, and must have been copied out through the API already.
+          DART_ASSERT(!detail::is_dependent<RefCount>(impl.raw));
+          return detail::find_sizeof<RefCount>(impl.raw);
+        },
+        [&] (basic_heap<RefCount> const& impl) { return impl.upper_bound(opts); }
       ),
       impl
     );
   }
 
   template <template <class> class RefCount>
-  auto basic_packet<RefCount>::layout(gsl::byte* buffer) const noexcept -> size_type {
+  auto basic_packet<RefCount>::layout(gsl::byte* buffer, finalize_options const& opts) const noexcept -> size_type {
+    return layout(buffer, opts, get_raw_type());
+  }
+
+  template <template <class> class RefCount>
+  auto basic_packet<RefCount>::layout(gsl::byte* buffer,
+      finalize_options const& opts, detail::raw_type type) const noexcept -> size_type
+  {
     return shim::visit(
       shim::compose_together(
-        [=] (basic_buffer<RefCount> const& impl) {
+        [&] (basic_buffer<RefCount> const& impl) {
+          // Finalized values already have a type, and it's the one get_raw_type reports.
+          DART_ASSERT(!detail::is_dependent<RefCount>(impl.raw));
           auto bytes = detail::find_sizeof<RefCount>(impl.raw);
           std::copy_n(impl.raw.buffer, bytes, buffer);
           return bytes;
         },
-        [=] (basic_heap<RefCount> const& impl) {
-          return impl.layout(buffer);
+        [&] (basic_heap<RefCount> const& impl) {
+          return impl.layout(buffer, opts, type);
         }
       ),
       impl
@@ -42,6 +56,7 @@ namespace dart {
     return shim::visit(
       shim::compose_together(
         [] (basic_buffer<RefCount> const& impl) {
+          if (impl.raw.type == detail::raw_type::record) return detail::raw_type::object;
           return impl.raw.type;
         },
         [] (basic_heap<RefCount> const& impl) {
@@ -52,6 +67,19 @@ namespace dart {
     );
   }
 
+  template <template <class> class RefCount>
+  detail::raw_type basic_packet<RefCount>::get_raw_type(finalize_options const& opts) const {
+    if (auto* heap = try_get_heap()) return heap->get_raw_type(opts);
+    else return get_raw_type();
+  }
+
+  template <template <class> class RefCount>
+  bool basic_packet<RefCount>::fits_inline(size_t bytes) const {
+    if (auto* heap = try_get_heap()) return heap->fits_inline(bytes);
+    else if (is_aggregate()) return false;
+    else return upper_bound() <= bytes;
+  }
+
   template <template <class> class RefCount>
   basic_heap<RefCount>& basic_packet<RefCount>::get_heap() {
     if (!is_finalized()) return shim::get<basic_heap<RefCount>>(impl);
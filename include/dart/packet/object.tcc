@@ -194,6 +194,11 @@ namespace dart {
     return shim::visit([&] (auto& v) -> basic_packet { return v.get_nested(path, separator); }, impl);
   }
 
+  template <template <class> class RefCount>
+  basic_packet<RefCount> basic_packet<RefCount>::get_nested(path const& needle) const {
+    return shim::visit([&] (auto& v) -> basic_packet { return v.get_nested(needle); }, impl);
+  }
+
   template <template <class> class RefCount>
   template <class String>
   basic_packet<RefCount> basic_packet<RefCount>::at(basic_string<String> const& key) const& {
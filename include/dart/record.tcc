@@ -0,0 +1,142 @@
+#ifndef DART_RECORD_H
+#define DART_RECORD_H
+
+/*----- Project Includes -----*/
+
+#include "common.h"
+
+/*----- Function Implementations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    template <template <class> class RefCount>
+    template <bool silent>
+    bool record<RefCount>::is_valid(size_t) const noexcept(silent) {
+      // Rows never appear in a network buffer on their own,
+      // and are validated along with the rest of their batch.
+      return true;
+    }
+
+    template <template <class> class RefCount>
+    size_t record<RefCount>::size() const noexcept {
+      return batch()->batch_size();
+    }
+
+    template <template <class> class RefCount>
+    size_t record<RefCount>::get_sizeof() const noexcept {
+      return header_len;
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::begin() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(0, DART_FROM_THIS, load_value);
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::end() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(size(), DART_FROM_THIS, load_value);
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::key_begin() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(0, DART_FROM_THIS, load_key);
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::key_end() const noexcept -> ll_iterator<RefCount> {
+      return ll_iterator<RefCount>(size(), DART_FROM_THIS, load_key);
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    auto record<RefCount>::get_key(shim::string_view const key, Callback&& cb) const noexcept -> raw_element {
+      // Like objects, return the key along with the type of its value.
+      auto const* arr = batch();
+      auto const idx = arr->find_batch_key(key);
+      if (idx < 0) return {raw_type::null, nullptr};
+      cb(static_cast<size_t>(idx));
+      return {arr->batch_value(idx, row()).type, arr->batch_key(idx).buffer};
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    auto record<RefCount>::get_key(dart::key const& handle, Callback&& cb) const noexcept -> raw_element {
+      return get_key(handle.strv(), std::forward<Callback>(cb));
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::get_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount> {
+      size_t idx = size();
+      get_key(key, [&] (auto target) { idx = target; });
+      return ll_iterator<RefCount>(idx, DART_FROM_THIS, load_value);
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::get_key_it(shim::string_view const key) const noexcept -> ll_iterator<RefCount> {
+      size_t idx = size();
+      get_key(key, [&] (auto target) { idx = target; });
+      return ll_iterator<RefCount>(idx, DART_FROM_THIS, load_key);
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::get_value(shim::string_view const key) const noexcept -> raw_element {
+      auto const* arr = batch();
+      auto const idx = arr->find_batch_key(key);
+      if (idx < 0) return {raw_type::null, nullptr};
+      return arr->batch_value(idx, row());
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::get_value(dart::key const& handle) const noexcept -> raw_element {
+      return get_value(handle.strv());
+    }
+
+    template <template <class> class RefCount>
+    template <class Callback>
+    void record<RefCount>::get_values(gsl::span<shim::string_view const> keys, Callback&& cb) const {
+      // The keys are shared by the whole batch, and are likely already in cache.
+      for (auto i = 0U; i < static_cast<size_t>(keys.size()); ++i) cb(i, get_value(keys[i]));
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::at_value(shim::string_view const key) const -> raw_element {
+      auto const* arr = batch();
+      auto const idx = arr->find_batch_key(key);
+      if (idx < 0) throw std::out_of_range("dart::buffer does not contain the requested mapping");
+      return arr->batch_value(idx, row());
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::load_key(gsl::byte const* base, size_t idx) noexcept
+      -> typename ll_iterator<RefCount>::value_type
+    {
+      return get_record<RefCount>({raw_type::record, base})->batch()->batch_key(idx);
+    }
+
+    template <template <class> class RefCount>
+    auto record<RefCount>::load_value(gsl::byte const* base, size_t idx) noexcept
+      -> typename ll_iterator<RefCount>::value_type
+    {
+      auto const* rec = get_record<RefCount>({raw_type::record, base});
+      return rec->batch()->batch_value(idx, rec->row());
+    }
+
+    template <template <class> class RefCount>
+    array<RefCount> const* record<RefCount>::batch() const noexcept {
+      return shim::launder(reinterpret_cast<array<RefCount> const*>(DART_FROM_THIS - offset.get()));
+    }
+
+    template <template <class> class RefCount>
+    size_t record<RefCount>::row() const noexcept {
+      // Handles are packed immediately after the header of their batch.
+      auto const first = array<RefCount>::header_len + sizeof(packed_array_layout);
+      return (offset.get() - first) / header_len;
+    }
+
+  }
+
+}
+
+#endif
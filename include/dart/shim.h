@@ -48,6 +48,16 @@ using ssize_t = SSIZE_T;
 #define DART_NODISCARD
 #endif
 
+// Keeps rarely taken paths out of line, so they don't count against
+// the inlining budget of the hot paths that call them.
+#if __has_cpp_attribute(gnu::noinline)
+#define DART_NOINLINE [[gnu::noinline]]
+#elif DART_USING_MSVC
+#define DART_NOINLINE __declspec(noinline)
+#else
+#define DART_NOINLINE
+#endif
+
 #define DART_STRINGIFY_IMPL(x) #x
 #define DART_STRINGIFY(x) DART_STRINGIFY_IMPL(x)
 
@@ -57,6 +67,54 @@ using ssize_t = SSIZE_T;
 #define DART_UNLIKELY(x) __builtin_expect(!!(x), 0)
 #endif
 
+// Figure out if we can use SSE2 intrinsics for vectorized vtable scans.
+// Can be disabled by defining DART_NO_SIMD, in which case a portable scalar
+// implementation is used instead.
+#if !defined(DART_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DART_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Software prefetch hint for memory we expect to touch soon.
+#if !DART_USING_MSVC
+#define DART_PREFETCH(ptr) __builtin_prefetch(ptr)
+#elif DART_HAS_SSE2
+#define DART_PREFETCH(ptr) _mm_prefetch(reinterpret_cast<char const*>(ptr), _MM_HINT_T0)
+#else
+#define DART_PREFETCH(ptr)
+#endif
+
+// Objects with at most this many keys are searched via linear scan over
+// their vtables instead of via binary search.
+// The scan stops paying for itself somewhere around sixty four keys.
+#ifndef DART_LINEAR_LOOKUP_THRESHOLD
+#define DART_LINEAR_LOOKUP_THRESHOLD 48
+#endif
+
+// Number of objects whose searches are stepped in lockstep by batched lookups.
+// Beyond the number of cache misses a core can keep in flight, wider batches don't help.
+#ifndef DART_LOOKUP_BATCH_WIDTH
+#define DART_LOOKUP_BATCH_WIDTH 16
+#endif
+
+// Number of seeds tried while building the perfect hash table of an object before
+// giving up, and laying the object out without one.
+#ifndef DART_PERFECT_HASH_MAX_SEEDS
+#define DART_PERFECT_HASH_MAX_SEEDS 16
+#endif
+
+// Bytes of scratch space the per-thread JSON parsers keep between documents.
+// Larger documents still parse, but their scratch space is given back afterwards.
+#ifndef DART_PARSER_RETAINED_BYTES
+#define DART_PARSER_RETAINED_BYTES (8 * 1024 * 1024)
+#endif
+
+// Number of entries in the per-thread cache that maps object shapes and keys
+// to vtable positions. Must be a power of two.
+#ifndef DART_SHAPE_CACHE_SIZE
+#define DART_SHAPE_CACHE_SIZE 1024
+#endif
+
 #ifndef NDEBUG
 
 #if DART_USING_MSVC
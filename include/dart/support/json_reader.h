@@ -0,0 +1,136 @@
+#ifndef DART_JSON_READER_H
+#define DART_JSON_READER_H
+
+/*----- System Includes -----*/
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*----- Local Includes -----*/
+
+#include "../shim.h"
+
+// Pick the widest block classifier the target supports.
+// Defining DART_JSON_NO_SIMD forces the portable fallback.
+#if !defined(DART_JSON_NO_SIMD) && defined(__AVX2__)
+# define DART_JSON_AVX2 1
+# include <immintrin.h>
+#elif !defined(DART_JSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+# define DART_JSON_SSE2 1
+# include <emmintrin.h>
+#endif
+#if !defined(DART_JSON_NO_SIMD) && defined(__PCLMUL__) && (defined(__x86_64__) || defined(_M_X64))
+# define DART_JSON_CLMUL 1
+# include <wmmintrin.h>
+#endif
+
+/*----- Type Declarations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    /**
+     *  @brief
+     *  In-tree JSON reader that indexes every structural character of a document up front,
+     *  and then walks that index, firing RapidJSON style events at a handler.
+     *
+     *  @details
+     *  The first stage classifies the input 64 bytes at a time (with AVX2 or SSE2 when the
+     *  target has them, and a portable fallback when it doesn't), resolves escapes and string
+     *  boundaries with carry and prefix-xor tricks instead of a byte at a time state machine,
+     *  and validates UTF-8 as it goes.
+     *  The second stage only looks at indexed positions, so whitespace and string contents
+     *  are skipped wholesale, and strings without escapes go to the handler straight out
+     *  of the input.
+     *  Readers hang onto their scratch space, so a reader kept around for a stream of
+     *  documents stops allocating after the first few.
+     */
+    class json_reader {
+
+      public:
+
+        /*----- Public Types -----*/
+
+        // Same values as the RapidJSON flags of the same meaning.
+        static constexpr unsigned parse_comments = 1U << 5U;
+        static constexpr unsigned parse_trailing_commas = 1U << 7U;
+        static constexpr unsigned parse_nan = 1U << 8U;
+        static constexpr unsigned supported_flags = parse_trailing_commas | parse_nan;
+
+        /*----- Public API -----*/
+
+        // Parses a single JSON document, calling back into the handler as values are found.
+        // Returns false, with error and error_offset set, if the document is malformed
+        // or the handler asked to stop.
+        template <unsigned flags, class Handler>
+        bool parse(char const* json, size_t len, Handler& handler);
+
+        inline char const* error() const noexcept;
+        inline size_t error_offset() const noexcept;
+
+        // Skips over bytes that can't affect where a value ends (anything but quotes, brackets,
+        // and newlines outside of strings, or quotes, backslashes, and newlines inside of them),
+        // 16 at a time where the target allows it.
+        // Returns the first position it couldn't rule out, which callers still have to look at
+        // a byte at a time, and which may just be the last few bytes of the input.
+        inline static size_t skip_plain(char const* json, size_t pos, size_t len, bool string) noexcept;
+
+      private:
+
+        /*----- Private Types -----*/
+
+        // One bit per byte of a 64 byte block.
+        struct block {
+          uint64_t quote;
+          uint64_t backslash;
+          uint64_t op;
+          uint64_t space;
+          uint64_t control;
+          uint64_t high;
+        };
+
+        struct frame {
+          bool object;
+          size_t count;
+        };
+
+        /*----- Private Helpers -----*/
+
+        inline bool index(char const* json, size_t len);
+        template <unsigned flags, class Handler>
+        bool walk(char const* json, size_t len, Handler& handler);
+        template <class Handler>
+        bool read_string(char const* json, size_t open, size_t close, bool key, Handler& handler);
+        template <unsigned flags, class Handler>
+        bool read_scalar(char const* json, size_t len, size_t pos, Handler& handler);
+        template <class Handler>
+        bool read_number(char const* json, size_t len, size_t pos, size_t& end, Handler& handler);
+        inline bool fail(char const* msg, size_t off) noexcept;
+        inline void trim() noexcept;
+
+        inline static block classify(char const* ptr) noexcept;
+        inline static size_t validate_utf8(char const* json, size_t len, size_t pos) noexcept;
+        inline static uint64_t prefix_xor(uint64_t bits) noexcept;
+        inline static unsigned trailing_zeros(uint64_t bits) noexcept;
+
+        /*----- Private Members -----*/
+
+        std::vector<uint32_t> structurals;
+        size_t count = 0;
+        std::vector<frame> frames;
+        std::string scratch;
+        char const* err = nullptr;
+        size_t err_off = 0;
+
+    };
+
+  }
+
+}
+
+#include "json_reader.tcc"
+
+#endif
@@ -0,0 +1,657 @@
+#ifndef DART_JSON_READER_IMPL_H
+#define DART_JSON_READER_IMPL_H
+
+/*----- System Includes -----*/
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/*----- Local Includes -----*/
+
+#include "json_reader.h"
+
+/*----- Function Implementations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    template <unsigned flags, class Handler>
+    bool json_reader::parse(char const* json, size_t len, Handler& handler) {
+      static_assert(!(flags & parse_comments), "dart's built in JSON reader cannot parse comments");
+      err = nullptr;
+      err_off = 0;
+      auto const parsed = index(json, len) && walk<flags>(json, len, handler);
+      trim();
+      return parsed;
+    }
+
+    void json_reader::trim() noexcept {
+      // The index takes four bytes per byte of input, so don't hang onto it after
+      // an unusually large document.
+      auto const retained = structurals.capacity() * sizeof(uint32_t)
+        + frames.capacity() * sizeof(frame) + scratch.capacity();
+      if (retained > DART_PARSER_RETAINED_BYTES) {
+        std::vector<uint32_t> {}.swap(structurals);
+        std::vector<frame> {}.swap(frames);
+        std::string {}.swap(scratch);
+      }
+    }
+
+    char const* json_reader::error() const noexcept {
+      return err;
+    }
+
+    size_t json_reader::error_offset() const noexcept {
+      return err_off;
+    }
+
+    bool json_reader::index(char const* json, size_t len) {
+      if (len > std::numeric_limits<uint32_t>::max() - 64) {
+        return fail("The document is too large to index.", 0);
+      }
+
+      // The index can never hold more positions than there are bytes, so size it once
+      // up front and write through a raw pointer.
+      if (structurals.size() < len + 64) structurals.resize(len + 64);
+      auto* out = structurals.data();
+
+      // State carried from one block to the next.
+      uint64_t prev_escaped = 0, prev_in_string = 0, prev_scalar = 0;
+      size_t utf8_pos = 0;
+
+      std::array<char, 64> tail;
+      for (size_t base = 0; base < len; base += 64) {
+        // Pad the final block out with whitespace, which can't change its meaning.
+        auto const* ptr = json + base;
+        if (len - base < 64) {
+          tail.fill(' ');
+          std::memcpy(tail.data(), ptr, len - base);
+          ptr = tail.data();
+        }
+        auto const curr = classify(ptr);
+
+        // Find every character escaped by an odd length run of backslashes.
+        // Runs starting on odd bits carry into the bit after an odd length run when
+        // added to the run itself, which flips the parity of everything they touch.
+        uint64_t escaped = prev_escaped;
+        if (curr.backslash) {
+          static constexpr uint64_t even_bits = 0x5555555555555555ULL;
+          auto const backslash = curr.backslash & ~prev_escaped;
+          auto const follows_escape = (backslash << 1) | prev_escaped;
+          auto const odd_starts = backslash & ~even_bits & ~follows_escape;
+          auto const even_starts = odd_starts + backslash;
+          auto const carried = even_starts < backslash;
+          escaped = (even_bits ^ (even_starts << 1)) & follows_escape;
+          prev_escaped = carried ? 1 : 0;
+        } else {
+          prev_escaped = 0;
+        }
+
+        // Every unescaped quote toggles whether we're in a string, so a running xor
+        // of them marks everything from an opening quote up to its closing quote.
+        auto const quote = curr.quote & ~escaped;
+        auto const in_string = prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+        auto const inside = in_string & ~quote;
+        if (curr.control & inside) {
+          return fail("Invalid encoding in string.", base + trailing_zeros(curr.control & inside));
+        }
+
+        // Most documents are entirely ASCII, so only validate blocks that aren't.
+        auto high = curr.high;
+        while (high) {
+          auto const pos = base + trailing_zeros(high);
+          high &= high - 1;
+          if (pos < utf8_pos) continue;
+
+          auto const width = validate_utf8(json, len, pos);
+          if (!width) return fail("Invalid encoding in string.", pos);
+          utf8_pos = pos + width;
+        }
+
+        // Structural characters are operators and quotes outside of strings,
+        // along with the first character of every scalar.
+        auto const outside = ~(in_string | quote);
+        auto const scalar = outside & ~(curr.op | curr.space);
+        auto const scalar_starts = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+
+        auto bits = (curr.op & outside) | quote | scalar_starts;
+        while (bits) {
+          *out++ = static_cast<uint32_t>(base + trailing_zeros(bits));
+          bits &= bits - 1;
+        }
+      }
+      if (prev_in_string) return fail("Missing a closing quotation mark in string.", len);
+
+      count = static_cast<size_t>(out - structurals.data());
+      return true;
+    }
+
+    template <unsigned flags, class Handler>
+    bool json_reader::walk(char const* json, size_t len, Handler& handler) {
+      static constexpr auto stopped = "Terminate parsing due to Handler error.";
+      size_t idx = 0;
+      auto next = [&] { return idx < count ? static_cast<size_t>(structurals[idx++]) : len; };
+      auto at = [&] (size_t pos) { return pos < len ? json[pos] : '\0'; };
+
+      frames.clear();
+      if (!count) return fail("The document is empty.", 0);
+
+      // Reads a key, and the colon after it, leaving pos on the value.
+      size_t pos = next();
+      auto read_key = [&] {
+        if (at(pos) != '"') return fail("Missing a name for object member.", pos);
+        else if (!read_string(json, pos, next(), true, handler)) return false;
+
+        pos = next();
+        if (at(pos) != ':') return fail("Missing a colon after a name of object member.", pos);
+        pos = next();
+        return true;
+      };
+      auto close = [&] (bool object, size_t members) {
+        if (object ? handler.EndObject(members) : handler.EndArray(members)) return true;
+        else return fail(stopped, pos);
+      };
+
+      while (true) {
+        // Read a value, which either opens a new scope, or is finished on its own.
+        auto const c = at(pos);
+        if (c == '{' || c == '[') {
+          auto const object = c == '{';
+          if (!(object ? handler.StartObject() : handler.StartArray())) return fail(stopped, pos);
+
+          pos = next();
+          if (at(pos) != (object ? '}' : ']')) {
+            frames.push_back({object, 0});
+            if (object && !read_key()) return false;
+            continue;
+          } else if (!close(object, 0)) {
+            return false;
+          }
+        } else if (c == '"') {
+          if (!read_string(json, pos, next(), false, handler)) return false;
+        } else if (!read_scalar<flags>(json, len, pos, handler)) {
+          return false;
+        }
+
+        // Finish however many scopes that value closed out.
+        while (true) {
+          if (frames.empty()) {
+            if (idx == count) return true;
+            return fail("The document root must not be followed by other values.", structurals[idx]);
+          }
+
+          auto& curr = frames.back();
+          auto const closer = curr.object ? '}' : ']';
+          ++curr.count;
+          pos = next();
+          if (at(pos) == ',') {
+            pos = next();
+            if (!(flags & parse_trailing_commas) || at(pos) != closer) {
+              if (curr.object && !read_key()) return false;
+              break;
+            }
+          } else if (at(pos) != closer) {
+            if (curr.object) return fail("Missing a comma or '}' after an object member.", pos);
+            else return fail("Missing a comma or ']' after an array element.", pos);
+          }
+
+          auto const done = curr;
+          frames.pop_back();
+          if (!close(done.object, done.count)) return false;
+        }
+      }
+    }
+
+    template <class Handler>
+    bool json_reader::read_string(char const* json, size_t open, size_t close, bool key, Handler& handler) {
+      // The index already knows where the string ends, so the common case of a string
+      // without escapes can go straight to the handler.
+      auto const* begin = json + open + 1;
+      auto const* const end = json + close;
+      if (!std::memchr(begin, '\\', end - begin)) {
+        auto const len = static_cast<size_t>(end - begin);
+        if (key ? handler.Key(begin, len, false) : handler.String(begin, len, false)) return true;
+        else return fail("Terminate parsing due to Handler error.", open);
+      }
+
+      auto hex = [end] (char const* ptr, unsigned& out) {
+        if (end - ptr < 4) return false;
+        out = 0;
+        for (auto i = 0; i < 4; ++i) {
+          auto const c = ptr[i];
+          out <<= 4;
+          if (c >= '0' && c <= '9') out |= c - '0';
+          else if (c >= 'a' && c <= 'f') out |= c - 'a' + 10;
+          else if (c >= 'A' && c <= 'F') out |= c - 'A' + 10;
+          else return false;
+        }
+        return true;
+      };
+
+      // Unescape into our scratch space.
+      // A backslash can never be the last character, as it would have escaped the closing quote.
+      scratch.clear();
+      while (begin < end) {
+        auto const* slash = static_cast<char const*>(std::memchr(begin, '\\', end - begin));
+        if (!slash) {
+          scratch.append(begin, end);
+          break;
+        }
+        scratch.append(begin, slash);
+        begin = slash + 2;
+        switch (slash[1]) {
+          case '"':
+          case '\\':
+          case '/':
+            scratch.push_back(slash[1]);
+            break;
+          case 'b':
+            scratch.push_back('\b');
+            break;
+          case 'f':
+            scratch.push_back('\f');
+            break;
+          case 'n':
+            scratch.push_back('\n');
+            break;
+          case 'r':
+            scratch.push_back('\r');
+            break;
+          case 't':
+            scratch.push_back('\t');
+            break;
+          case 'u':
+            {
+              unsigned point;
+              if (!hex(begin, point)) {
+                return fail("Incorrect hex digit after \\u escape in string.", begin - json);
+              }
+              begin += 4;
+
+              // Characters outside of the basic multilingual plane come in surrogate pairs.
+              if (point >= 0xD800 && point <= 0xDBFF) {
+                unsigned low;
+                if (end - begin < 6 || begin[0] != '\\' || begin[1] != 'u' || !hex(begin + 2, low)) {
+                  return fail("The surrogate pair in string is invalid.", begin - json);
+                } else if (low < 0xDC00 || low > 0xDFFF) {
+                  return fail("The surrogate pair in string is invalid.", begin - json);
+                }
+                point = 0x10000 + ((point - 0xD800) << 10) + (low - 0xDC00);
+                begin += 6;
+              } else if (point >= 0xDC00 && point <= 0xDFFF) {
+                return fail("The surrogate pair in string is invalid.", begin - json);
+              }
+
+              // Encode as UTF-8.
+              if (point < 0x80) {
+                scratch.push_back(static_cast<char>(point));
+              } else if (point < 0x800) {
+                scratch.push_back(static_cast<char>(0xC0 | (point >> 6)));
+                scratch.push_back(static_cast<char>(0x80 | (point & 0x3F)));
+              } else if (point < 0x10000) {
+                scratch.push_back(static_cast<char>(0xE0 | (point >> 12)));
+                scratch.push_back(static_cast<char>(0x80 | ((point >> 6) & 0x3F)));
+                scratch.push_back(static_cast<char>(0x80 | (point & 0x3F)));
+              } else {
+                scratch.push_back(static_cast<char>(0xF0 | (point >> 18)));
+                scratch.push_back(static_cast<char>(0x80 | ((point >> 12) & 0x3F)));
+                scratch.push_back(static_cast<char>(0x80 | ((point >> 6) & 0x3F)));
+                scratch.push_back(static_cast<char>(0x80 | (point & 0x3F)));
+              }
+              break;
+            }
+          default:
+            return fail("Invalid escape character in string.", slash - json);
+        }
+      }
+
+      if (key ? handler.Key(scratch.data(), scratch.size(), true) : handler.String(scratch.data(), scratch.size(), true)) {
+        return true;
+      } else {
+        return fail("Terminate parsing due to Handler error.", open);
+      }
+    }
+
+    template <unsigned flags, class Handler>
+    bool json_reader::read_scalar(char const* json, size_t len, size_t pos, Handler& handler) {
+      auto literal = [&] (char const* word, size_t size) {
+        return len - pos >= size && !std::memcmp(json + pos, word, size);
+      };
+      auto finished = [&] (size_t end) {
+        // Scalars have to run right up to whitespace, an operator, or the end of the input.
+        if (end == len) return true;
+        switch (json[end]) {
+          case ' ':
+          case '\t':
+          case '\n':
+          case '\r':
+          case ',':
+          case ':':
+          case '"':
+          case '[':
+          case ']':
+          case '{':
+          case '}':
+            return true;
+          default:
+            return false;
+        }
+      };
+      auto emit = [&] (bool ok) { return ok || fail("Terminate parsing due to Handler error.", pos); };
+
+      if (pos >= len) return fail("Invalid value.", pos);
+      if ((flags & parse_nan) && (json[pos] == 'I' || json[pos] == '-')) {
+        auto const neg = json[pos] == '-';
+        auto const inf = std::numeric_limits<double>::infinity();
+        auto const start = pos + (neg ? 1 : 0);
+        for (auto const* word : {"Infinity", "Inf"}) {
+          auto const size = std::strlen(word);
+          if (len - start < size || std::memcmp(json + start, word, size) || !finished(start + size)) continue;
+          return emit(handler.Double(neg ? -inf : inf));
+        }
+      }
+
+      switch (json[pos]) {
+        case 't':
+          if (!literal("true", 4) || !finished(pos + 4)) break;
+          return emit(handler.Bool(true));
+        case 'f':
+          if (!literal("false", 5) || !finished(pos + 5)) break;
+          return emit(handler.Bool(false));
+        case 'n':
+          if (!literal("null", 4) || !finished(pos + 4)) break;
+          return emit(handler.Null());
+        case 'N':
+          if (!(flags & parse_nan) || !literal("NaN", 3) || !finished(pos + 3)) break;
+          return emit(handler.Double(std::numeric_limits<double>::quiet_NaN()));
+        default:
+          {
+            size_t end;
+            return read_number(json, len, pos, end, handler);
+          }
+      }
+      return fail("Invalid value.", pos);
+    }
+
+    template <class Handler>
+    bool json_reader::read_number(char const* json, size_t len, size_t pos, size_t& end, Handler& handler) {
+      // Every power of ten that a double holds exactly.
+      static constexpr double exact_powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+      };
+
+      auto const* const begin = json + pos;
+      auto const* const stop = json + len;
+      auto const* curr = begin;
+      auto digit = [stop] (char const* ptr) { return ptr < stop && static_cast<unsigned>(*ptr - '0') < 10; };
+
+      // Accumulate the significand for as long as it fits, which covers every integer,
+      // and most decimals.
+      uint64_t mantissa = 0;
+      int64_t exponent = 0;
+      bool exact = true, decimal = false;
+      auto accumulate = [&] (char c) {
+        auto const val = static_cast<uint64_t>(c - '0');
+        if (exact && mantissa <= (std::numeric_limits<uint64_t>::max() - val) / 10) mantissa = mantissa * 10 + val;
+        else exact = false;
+        return exact;
+      };
+
+      auto const neg = *curr == '-';
+      if (neg) ++curr;
+      if (!digit(curr)) return fail("Invalid value.", pos);
+      if (*curr == '0') ++curr;
+      else while (digit(curr)) accumulate(*curr++);
+      if (!exact) decimal = true;
+
+      if (curr < stop && *curr == '.') {
+        decimal = true;
+        if (!digit(++curr)) return fail("Missing fraction part in number.", curr - json);
+        while (digit(curr)) {
+          if (accumulate(*curr++)) --exponent;
+        }
+      }
+
+      if (curr < stop && (*curr == 'e' || *curr == 'E')) {
+        decimal = true;
+        ++curr;
+        auto const neg_exp = curr < stop && *curr == '-';
+        if (curr < stop && (*curr == '-' || *curr == '+')) ++curr;
+        if (!digit(curr)) return fail("Missing exponent in number.", curr - json);
+
+        int64_t exp = 0;
+        while (digit(curr)) {
+          if (exp < 100000) exp = exp * 10 + (*curr - '0');
+          ++curr;
+        }
+        exponent += neg_exp ? -exp : exp;
+      }
+
+      // Numbers have to run right up to a delimiter.
+      end = static_cast<size_t>(curr - json);
+      if (end != len) {
+        switch (*curr) {
+          case ' ': case '\t': case '\n': case '\r': case ',': case ':':
+          case '"': case '[': case ']': case '{': case '}':
+            break;
+          default:
+            return fail("Invalid value.", pos);
+        }
+      }
+
+      // Integers are reported the same way RapidJSON reports them.
+      bool ok;
+      static constexpr uint64_t int_limit = 1ULL << 63;
+      if (!decimal && neg && mantissa <= int_limit) {
+        if (mantissa <= (1ULL << 31)) ok = handler.Int(static_cast<int>(-static_cast<int64_t>(mantissa)));
+        else if (mantissa == int_limit) ok = handler.Int64(std::numeric_limits<int64_t>::min());
+        else ok = handler.Int64(-static_cast<int64_t>(mantissa));
+      } else if (!decimal && !neg) {
+        if (mantissa <= std::numeric_limits<unsigned>::max()) ok = handler.Uint(static_cast<unsigned>(mantissa));
+        else ok = handler.Uint64(mantissa);
+      } else {
+        // Small significands scaled by an exactly representable power of ten round correctly
+        // with a single multiplication or division.
+        // Everything else goes through strtod, which assumes the C locale.
+        double val;
+        if (exact && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+          val = static_cast<double>(mantissa);
+          val = exponent < 0 ? val / exact_powers[-exponent] : val * exact_powers[exponent];
+          if (neg) val = -val;
+        } else {
+          scratch.assign(begin, curr);
+          val = std::strtod(scratch.c_str(), nullptr);
+          if (std::isinf(val)) return fail("Number too big to be stored in double.", pos);
+        }
+        ok = handler.Double(val);
+      }
+      return ok || fail("Terminate parsing due to Handler error.", pos);
+    }
+
+    bool json_reader::fail(char const* msg, size_t off) noexcept {
+      err = msg;
+      err_off = off;
+      return false;
+    }
+
+    auto json_reader::classify(char const* ptr) noexcept -> block {
+      block out {};
+#if DART_JSON_AVX2
+      for (auto half = 0U; half < 2; ++half) {
+        auto const in = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr + half * 32));
+        auto const eq = [&in] (char c) { return _mm256_cmpeq_epi8(in, _mm256_set1_epi8(c)); };
+        auto const bits = [half] (__m256i mask) {
+          return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(mask))) << (half * 32);
+        };
+
+        // Brackets only differ from braces by the 0x20 bit.
+        auto const folded = _mm256_or_si256(in, _mm256_set1_epi8(0x20));
+        auto const braces = _mm256_or_si256(
+          _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+          _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))
+        );
+        auto const limit = _mm256_set1_epi8(0x1F);
+
+        out.quote |= bits(eq('"'));
+        out.backslash |= bits(eq('\\'));
+        out.op |= bits(_mm256_or_si256(braces, _mm256_or_si256(eq(':'), eq(','))));
+        out.space |= bits(_mm256_or_si256(_mm256_or_si256(eq(' '), eq('\t')), _mm256_or_si256(eq('\n'), eq('\r'))));
+        out.control |= bits(_mm256_cmpeq_epi8(_mm256_max_epu8(in, limit), limit));
+        out.high |= bits(in);
+      }
+#elif DART_JSON_SSE2
+      for (auto quarter = 0U; quarter < 4; ++quarter) {
+        auto const in = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr + quarter * 16));
+        auto const eq = [&in] (char c) { return _mm_cmpeq_epi8(in, _mm_set1_epi8(c)); };
+        auto const bits = [quarter] (__m128i mask) {
+          return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(mask))) << (quarter * 16);
+        };
+
+        // Brackets only differ from braces by the 0x20 bit.
+        auto const folded = _mm_or_si128(in, _mm_set1_epi8(0x20));
+        auto const braces = _mm_or_si128(
+          _mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+          _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))
+        );
+        auto const limit = _mm_set1_epi8(0x1F);
+
+        out.quote |= bits(eq('"'));
+        out.backslash |= bits(eq('\\'));
+        out.op |= bits(_mm_or_si128(braces, _mm_or_si128(eq(':'), eq(','))));
+        out.space |= bits(_mm_or_si128(_mm_or_si128(eq(' '), eq('\t')), _mm_or_si128(eq('\n'), eq('\r'))));
+        out.control |= bits(_mm_cmpeq_epi8(_mm_max_epu8(in, limit), limit));
+        out.high |= bits(in);
+      }
+#else
+      enum : uint8_t { quote = 1, backslash = 2, op = 4, space = 8, control = 16, high = 32 };
+      static auto const classes = [] {
+        std::array<uint8_t, 256> table {};
+        for (auto c = 0U; c < 0x20; ++c) table[c] = control;
+        for (auto c = 0x80U; c < 0x100; ++c) table[c] = high;
+        for (auto c : {' ', '\t', '\n', '\r'}) table[static_cast<uint8_t>(c)] |= space;
+        for (auto c : {'{', '}', '[', ']', ':', ','}) table[static_cast<uint8_t>(c)] = op;
+        table['"'] = quote;
+        table['\\'] = backslash;
+        return table;
+      }();
+
+      for (auto i = 0U; i < 64; ++i) {
+        auto const type = classes[static_cast<uint8_t>(ptr[i])];
+        if (!type) continue;
+        auto const bit = 1ULL << i;
+        if (type & quote) out.quote |= bit;
+        if (type & backslash) out.backslash |= bit;
+        if (type & op) out.op |= bit;
+        if (type & space) out.space |= bit;
+        if (type & control) out.control |= bit;
+        if (type & high) out.high |= bit;
+      }
+#endif
+      return out;
+    }
+
+    size_t json_reader::validate_utf8(char const* json, size_t len, size_t pos) noexcept {
+      auto const* bytes = reinterpret_cast<uint8_t const*>(json);
+      auto trailing = [&] (size_t count) {
+        for (auto i = 1U; i <= count; ++i) {
+          if (pos + i >= len || (bytes[pos + i] & 0xC0) != 0x80) return false;
+        }
+        return true;
+      };
+
+      // Rejects overlong encodings, surrogates, and anything past U+10FFFF.
+      auto const lead = bytes[pos];
+      if (lead < 0x80) {
+        return 1;
+      } else if (lead < 0xC2) {
+        return 0;
+      } else if (lead < 0xE0) {
+        return trailing(1) ? 2 : 0;
+      } else if (lead < 0xF0) {
+        if (!trailing(2)) return 0;
+        else if (lead == 0xE0 && bytes[pos + 1] < 0xA0) return 0;
+        else if (lead == 0xED && bytes[pos + 1] >= 0xA0) return 0;
+        return 3;
+      } else if (lead < 0xF5) {
+        if (!trailing(3)) return 0;
+        else if (lead == 0xF0 && bytes[pos + 1] < 0x90) return 0;
+        else if (lead == 0xF4 && bytes[pos + 1] >= 0x90) return 0;
+        return 4;
+      } else {
+        return 0;
+      }
+    }
+
+    uint64_t json_reader::prefix_xor(uint64_t bits) noexcept {
+#if DART_JSON_CLMUL
+      // Carryless multiplication by all ones is exactly a running xor.
+      auto const ones = _mm_set1_epi8(static_cast<char>(0xFF));
+      auto const product = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(bits)), ones, 0);
+      return static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+#else
+      bits ^= bits << 1;
+      bits ^= bits << 2;
+      bits ^= bits << 4;
+      bits ^= bits << 8;
+      bits ^= bits << 16;
+      bits ^= bits << 32;
+      return bits;
+#endif
+    }
+
+    size_t json_reader::skip_plain(char const* json, size_t pos, size_t len, bool string) noexcept {
+#if DART_JSON_AVX2 || DART_JSON_SSE2
+      // Square brackets are a case bit away from curly brackets.
+      auto const quote = _mm_set1_epi8('"'), newline = _mm_set1_epi8('\n'), backslash = _mm_set1_epi8('\\');
+      auto const open = _mm_set1_epi8('{'), close = _mm_set1_epi8('}'), fold = _mm_set1_epi8(0x20);
+      while (pos + 16 <= len) {
+        auto const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(json + pos));
+        auto hits = _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, newline));
+        if (string) {
+          hits = _mm_or_si128(hits, _mm_cmpeq_epi8(bytes, backslash));
+        } else {
+          auto const folded = _mm_or_si128(bytes, fold);
+          hits = _mm_or_si128(hits, _mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)));
+        }
+        auto const mask = static_cast<uint64_t>(_mm_movemask_epi8(hits));
+        if (mask) return pos + trailing_zeros(mask);
+        pos += 16;
+      }
+#else
+      (void) json;
+      (void) len;
+      (void) string;
+#endif
+      return pos;
+    }
+
+    unsigned json_reader::trailing_zeros(uint64_t bits) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+      return static_cast<unsigned>(__builtin_ctzll(bits));
+#elif defined(_MSC_VER) && defined(_M_X64)
+      unsigned long idx;
+      _BitScanForward64(&idx, bits);
+      return static_cast<unsigned>(idx);
+#else
+      unsigned idx = 0;
+      while (!(bits & 1)) bits >>= 1, ++idx;
+      return idx;
+#endif
+    }
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef DART_LZ_H
+#define DART_LZ_H
+
+/*----- System Includes -----*/
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <gsl/gsl>
+
+/*----- Type Declarations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    /**
+     *  @brief
+     *  Small, self-contained LZ77 codec used for compressed buffers.
+     *
+     *  @details
+     *  The format follows LZ4 closely: a stream of sequences, each made up of a token
+     *  byte holding a literal length and a match length, any bytes needed to extend
+     *  either length, the literals themselves, and a sixteen bit little endian distance
+     *  back to the start of the match.
+     *  The final sequence holds only literals, and every block is independently
+     *  decodable, with no dictionary shared between them.
+     */
+    struct lz {
+      static constexpr size_t min_match = 4;
+      static constexpr size_t max_distance = std::numeric_limits<uint16_t>::max();
+      static constexpr size_t hash_bits = 12;
+
+      // Returns the largest number of bytes compress can produce for an input of the given size.
+      static constexpr size_t bound(size_t bytes) noexcept {
+        return bytes + bytes / 255 + 16;
+      }
+
+      // Compresses the input into the output, which must be at least bound(in.size()) bytes long.
+      // Returns the number of bytes written.
+      inline static size_t compress(gsl::span<gsl::byte const> in, gsl::byte* out) noexcept;
+
+      // Decompresses the input into the output, which must be exactly the size of the original data.
+      // Returns false if the input is malformed, or doesn't decode to exactly that many bytes.
+      inline static bool decompress(gsl::span<gsl::byte const> in, gsl::span<gsl::byte> out) noexcept;
+    };
+
+  }
+
+}
+
+#include "lz.tcc"
+
+#endif
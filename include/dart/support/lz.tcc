@@ -0,0 +1,135 @@
+#ifndef DART_LZ_IMPL_H
+#define DART_LZ_IMPL_H
+
+/*----- System Includes -----*/
+
+#include <array>
+#include <cstring>
+
+/*----- Local Includes -----*/
+
+#include "lz.h"
+
+/*----- Function Implementations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    size_t lz::compress(gsl::span<gsl::byte const> in, gsl::byte* out) noexcept {
+      auto const* src = reinterpret_cast<uint8_t const*>(in.data());
+      auto* dst = reinterpret_cast<uint8_t*>(out);
+      auto const len = static_cast<size_t>(in.size());
+
+      auto read_word = [src] (size_t pos) {
+        uint32_t word;
+        std::memcpy(&word, src + pos, sizeof(word));
+        return word;
+      };
+      auto write_len = [&dst] (size_t extra) {
+        while (extra >= 255) {
+          *dst++ = 255;
+          extra -= 255;
+        }
+        *dst++ = static_cast<uint8_t>(extra);
+      };
+      auto write_literals = [&] (size_t begin, size_t end, uint8_t match_nibble) {
+        auto const count = end - begin;
+        *dst++ = static_cast<uint8_t>(((count < 15 ? count : 15) << 4) | match_nibble);
+        if (count >= 15) write_len(count - 15);
+        std::memcpy(dst, src + begin, count);
+        dst += count;
+      };
+
+      // Positions are stored off by one, so that zero marks an empty slot.
+      std::array<uint32_t, 1U << hash_bits> table {};
+      size_t anchor = 0, pos = 0;
+      while (pos + min_match <= len) {
+        auto const word = read_word(pos);
+        auto& slot = table[(word * 2654435761U) >> (32 - hash_bits)];
+        auto const cand = static_cast<size_t>(slot);
+        slot = static_cast<uint32_t>(pos + 1);
+
+        // Keep scanning until we find a match that's close enough to encode.
+        if (!cand || pos - (cand - 1) > max_distance || read_word(cand - 1) != word) {
+          ++pos;
+          continue;
+        }
+
+        // Extend the match as far as it goes, and emit the sequence that ends with it.
+        auto const ref = cand - 1;
+        auto match = min_match;
+        while (pos + match < len && src[ref + match] == src[pos + match]) ++match;
+        auto const extra = match - min_match;
+        write_literals(anchor, pos, static_cast<uint8_t>(extra < 15 ? extra : 15));
+        auto const distance = pos - ref;
+        *dst++ = static_cast<uint8_t>(distance & 0xFF);
+        *dst++ = static_cast<uint8_t>(distance >> 8);
+        if (extra >= 15) write_len(extra - 15);
+        pos += match;
+        anchor = pos;
+      }
+
+      // Whatever is left over goes out as literals.
+      write_literals(anchor, len, 0);
+      return dst - reinterpret_cast<uint8_t*>(out);
+    }
+
+    bool lz::decompress(gsl::span<gsl::byte const> in, gsl::span<gsl::byte> out) noexcept {
+      auto const* ip = reinterpret_cast<uint8_t const*>(in.data());
+      auto const* const iend = ip + in.size();
+      auto* op = reinterpret_cast<uint8_t*>(out.data());
+      auto* const ostart = op;
+      auto* const oend = op + out.size();
+
+      // Reads a length extension, bailing out if it runs off the end of the input.
+      auto read_len = [&ip, iend] (size_t& total) {
+        uint8_t curr;
+        do {
+          if (ip == iend) return false;
+          curr = *ip++;
+          total += curr;
+        } while (curr == 255);
+        return true;
+      };
+
+      while (ip < iend) {
+        auto const token = *ip++;
+
+        // Copy out the literals.
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_len(literals)) return false;
+        if (static_cast<size_t>(iend - ip) < literals || static_cast<size_t>(oend - op) < literals) return false;
+        std::memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // The final sequence has no match.
+        if (ip == iend) break;
+
+        // Copy out the match, which may overlap with itself.
+        if (iend - ip < 2) return false;
+        size_t const distance = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t match = (token & 0x0F);
+        if (match == 15 && !read_len(match)) return false;
+        match += min_match;
+        if (!distance || static_cast<size_t>(op - ostart) < distance) return false;
+        else if (static_cast<size_t>(oend - op) < match) return false;
+
+        auto const* ref = op - distance;
+        if (distance >= match) {
+          std::memcpy(op, ref, match);
+          op += match;
+        } else {
+          while (match--) *op++ = *ref++;
+        }
+      }
+      return op == oend;
+    }
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef DART_MAPPED_FILE_H
+#define DART_MAPPED_FILE_H
+
+/*----- System Includes -----*/
+
+#include <string>
+#include <cstddef>
+
+/*----- Local Includes -----*/
+
+#include "../shim.h"
+
+/*----- Type Declarations -----*/
+
+namespace dart {
+
+  /**
+   *  @brief
+   *  Read-only view of an entire file, for parsing large inputs in place.
+   *
+   *  @details
+   *  On POSIX systems the file is memory mapped, so pages are only read in as they're
+   *  touched, and are shared with the page cache.
+   *  Elsewhere, the file is read into memory up front.
+   *  Values parsed out of the view copy what they need, and don't refer back to it.
+   */
+  class mapped_file {
+
+    public:
+
+      /*----- Lifecycle Functions -----*/
+
+      // Maps the file at the given path, throwing a std::system_error if it can't be.
+      inline explicit mapped_file(std::string const& path);
+      mapped_file(mapped_file const&) = delete;
+      inline mapped_file(mapped_file&& other) noexcept;
+      inline ~mapped_file() noexcept;
+
+      /*----- Operators -----*/
+
+      mapped_file& operator =(mapped_file const&) = delete;
+      inline mapped_file& operator =(mapped_file&& other) noexcept;
+
+      /*----- Public API -----*/
+
+      inline char const* data() const noexcept;
+      inline size_t size() const noexcept;
+      inline shim::string_view view() const noexcept;
+
+    private:
+
+      /*----- Private Helpers -----*/
+
+      inline void unmap() noexcept;
+
+      /*----- Private Members -----*/
+
+      char const* ptr;
+      size_t len;
+#ifdef _WIN32
+      std::string contents;
+#endif
+
+  };
+
+}
+
+#include "mapped_file.tcc"
+
+#endif
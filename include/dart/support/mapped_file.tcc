@@ -0,0 +1,126 @@
+#ifndef DART_MAPPED_FILE_IMPL_H
+#define DART_MAPPED_FILE_IMPL_H
+
+/*----- Local Includes -----*/
+
+#include "mapped_file.h"
+
+/*----- System Includes -----*/
+
+#include <cerrno>
+#include <utility>
+#include <system_error>
+
+#ifdef _WIN32
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/*----- Function Implementations -----*/
+
+namespace dart {
+
+#ifdef _WIN32
+  mapped_file::mapped_file(std::string const& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::system_error(errno, std::generic_category(), "dart::mapped_file could not open " + path);
+    std::ostringstream in;
+    in << file.rdbuf();
+    contents = in.str();
+    ptr = contents.data();
+    len = contents.size();
+  }
+
+  mapped_file::mapped_file(mapped_file&& other) noexcept :
+    contents(std::move(other.contents))
+  {
+    ptr = contents.data();
+    len = contents.size();
+    other.ptr = nullptr;
+    other.len = 0;
+  }
+
+  mapped_file& mapped_file::operator =(mapped_file&& other) noexcept {
+    if (this == &other) return *this;
+    contents = std::move(other.contents);
+    ptr = contents.data();
+    len = contents.size();
+    other.ptr = nullptr;
+    other.len = 0;
+    return *this;
+  }
+
+  void mapped_file::unmap() noexcept {}
+#else
+  mapped_file::mapped_file(std::string const& path) : ptr(nullptr), len(0) {
+    auto const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "dart::mapped_file could not open " + path);
+
+    struct stat info;
+    if (::fstat(fd, &info)) {
+      auto const err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), "dart::mapped_file could not stat " + path);
+    }
+
+    // Empty files can't be mapped, but there's nothing to map anyways.
+    len = static_cast<size_t>(info.st_size);
+    if (len) {
+      auto* mem = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mem == MAP_FAILED) {
+        auto const err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "dart::mapped_file could not map " + path);
+      }
+      ::madvise(mem, len, MADV_SEQUENTIAL);
+      ptr = static_cast<char const*>(mem);
+    }
+    ::close(fd);
+  }
+
+  mapped_file::mapped_file(mapped_file&& other) noexcept : ptr(other.ptr), len(other.len) {
+    other.ptr = nullptr;
+    other.len = 0;
+  }
+
+  mapped_file& mapped_file::operator =(mapped_file&& other) noexcept {
+    if (this == &other) return *this;
+    unmap();
+    ptr = other.ptr;
+    len = other.len;
+    other.ptr = nullptr;
+    other.len = 0;
+    return *this;
+  }
+
+  void mapped_file::unmap() noexcept {
+    if (ptr) ::munmap(const_cast<char*>(ptr), len);
+    ptr = nullptr;
+    len = 0;
+  }
+#endif
+
+  mapped_file::~mapped_file() noexcept {
+    unmap();
+  }
+
+  char const* mapped_file::data() const noexcept {
+    return ptr;
+  }
+
+  size_t mapped_file::size() const noexcept {
+    return len;
+  }
+
+  shim::string_view mapped_file::view() const noexcept {
+    return {ptr, len};
+  }
+
+}
+
+#endif
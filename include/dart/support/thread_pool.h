@@ -0,0 +1,100 @@
+#ifndef DART_THREAD_POOL_H
+#define DART_THREAD_POOL_H
+
+/*----- System Includes -----*/
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <type_traits>
+#include <condition_variable>
+
+/*----- Type Declarations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    /**
+     *  @brief
+     *  Small, fixed size pool of threads used to finalize large heaps in parallel.
+     *
+     *  @details
+     *  Work is submitted as a batch of independent, indexed tasks, which are split
+     *  into contiguous runs, one per thread. Each thread works through its own run
+     *  from the back, and once it runs dry, steals from the front of the others,
+     *  so threads that happen to get cheaper tasks pick up the slack.
+     *  The calling thread takes part in every batch, and batches are run one at a time.
+     */
+    class thread_pool {
+
+      public:
+
+        /*----- Lifecycle Functions -----*/
+
+        // Spawns enough threads that, along with the calling thread, threads are working on every batch.
+        inline explicit thread_pool(size_t threads);
+        thread_pool(thread_pool const&) = delete;
+        inline ~thread_pool() noexcept;
+
+        /*----- Operators -----*/
+
+        thread_pool& operator =(thread_pool const&) = delete;
+
+        /*----- Public API -----*/
+
+        // Calls task with every index in [0, count), and returns once every call has.
+        // Task must not throw.
+        template <class Task>
+        void for_each(size_t count, Task&& task);
+
+        inline size_t size() const noexcept;
+
+      private:
+
+        /*----- Private Types -----*/
+
+        struct queue {
+          std::mutex lock;
+          std::deque<size_t> indices;
+        };
+
+        struct batch {
+          void (*invoke)(void*, size_t);
+          void* task;
+          std::vector<queue>* queues;
+        };
+
+        /*----- Private Helpers -----*/
+
+        inline void run(size_t id);
+        inline void work(batch const& curr, size_t id);
+        inline static bool pop(queue& from, bool back, size_t& idx);
+
+        /*----- Private Members -----*/
+
+        std::vector<queue> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex serial;
+        std::mutex lock;
+        std::condition_variable wake;
+        std::condition_variable done;
+        batch const* curr;
+        size_t generation;
+        size_t active;
+        bool stopping;
+
+    };
+
+  }
+
+}
+
+#include "thread_pool.tcc"
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef DART_THREAD_POOL_IMPL_H
+#define DART_THREAD_POOL_IMPL_H
+
+/*----- Local Includes -----*/
+
+#include "thread_pool.h"
+
+/*----- Function Implementations -----*/
+
+namespace dart {
+
+  namespace detail {
+
+    thread_pool::thread_pool(size_t threads) :
+      queues(threads ? threads : 1),
+      curr(nullptr),
+      generation(0),
+      active(0),
+      stopping(false)
+    {
+      // The calling thread is always the first participant.
+      workers.reserve(queues.size() - 1);
+      for (auto id = 1U; id < queues.size(); ++id) workers.emplace_back([this, id] { run(id); });
+    }
+
+    thread_pool::~thread_pool() noexcept {
+      {
+        std::lock_guard<std::mutex> guard {lock};
+        stopping = true;
+      }
+      wake.notify_all();
+      for (auto& worker : workers) worker.join();
+    }
+
+    template <class Task>
+    void thread_pool::for_each(size_t count, Task&& task) {
+      if (!count) return;
+      std::lock_guard<std::mutex> guard {serial};
+
+      // Hand out contiguous runs of indices, which keeps neighboring tasks on the same thread
+      // unless somebody has to steal them.
+      auto const participants = queues.size();
+      for (auto id = 0U; id < participants; ++id) {
+        auto const first = count * id / participants, last = count * (id + 1) / participants;
+        for (auto idx = first; idx < last; ++idx) queues[id].indices.push_back(idx);
+      }
+
+      // Wake everybody up and pitch in.
+      auto invoke = [] (void* ctx, size_t idx) { (*static_cast<std::remove_reference_t<Task>*>(ctx))(idx); };
+      batch const submitted {invoke, &task, &queues};
+      {
+        std::lock_guard<std::mutex> state {lock};
+        curr = &submitted;
+        active = workers.size();
+        ++generation;
+      }
+      wake.notify_all();
+      work(submitted, 0);
+
+      // Every worker has to check in before the batch can go out of scope.
+      std::unique_lock<std::mutex> state {lock};
+      done.wait(state, [this] { return !active; });
+      curr = nullptr;
+    }
+
+    size_t thread_pool::size() const noexcept {
+      return queues.size();
+    }
+
+    void thread_pool::run(size_t id) {
+      size_t seen = 0;
+      std::unique_lock<std::mutex> state {lock};
+      while (true) {
+        wake.wait(state, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+
+        auto const* submitted = curr;
+        state.unlock();
+        work(*submitted, id);
+        state.lock();
+        if (!--active) done.notify_all();
+      }
+    }
+
+    void thread_pool::work(batch const& submitted, size_t id) {
+      // Work through our own run first, then go looking for somebody else's.
+      size_t idx;
+      auto& all = *submitted.queues;
+      while (pop(all[id], true, idx)) submitted.invoke(submitted.task, idx);
+      for (auto offset = 1U; offset < all.size(); ++offset) {
+        auto& victim = all[(id + offset) % all.size()];
+        while (pop(victim, false, idx)) submitted.invoke(submitted.task, idx);
+      }
+    }
+
+    bool thread_pool::pop(queue& from, bool back, size_t& idx) {
+      std::lock_guard<std::mutex> guard {from.lock};
+      if (from.indices.empty()) return false;
+      if (back) {
+        idx = from.indices.back();
+        from.indices.pop_back();
+      } else {
+        idx = from.indices.front();
+        from.indices.pop_front();
+      }
+      return true;
+    }
+
+  }
+
+}
+
+#endif
@@ -24,6 +24,40 @@ namespace {
     else return val;
   }
 
+  int dart_buffer_obj_has_key_handle_impl(dart_buffer_t const* src, dart_key_t const* key) {
+    bool val = false;
+    auto* handle = reinterpret_cast<dart::key const*>(DART_RAW_BYTES(key));
+    auto err = buffer_access([&val, handle] (auto& src) { val = src.has_key(*handle); }, src);
+    if (err) return false;
+    else return val;
+  }
+
+  dart_err_t dart_buffer_obj_get_many_impl(dart_buffer_t const* src,
+      dart_string_view_t const* keys, dart_buffer_t* dsts, size_t count)
+  {
+    std::vector<string_view> views(count);
+    for (auto i = 0U; i < count; ++i) views[i] = string_view {keys[i].ptr, keys[i].len};
+
+    // Run the lookup into temporary storage first, so no output is initialized on failure.
+    auto rtti = src->rtti;
+    auto get_many = [&] (auto& src) {
+      using buffer_type = std::decay_t<decltype(src)>;
+      std::vector<buffer_type> vals(count);
+      src.get_many(views, vals);
+      for (auto i = 0U; i < count; ++i) {
+        dsts[i].rtti = rtti;
+        new(DART_RAW_BYTES(&dsts[i])) buffer_type(std::move(vals[i]));
+      }
+    };
+    return buffer_access(
+      compose(
+        [get_many] (dart::buffer const& src) { get_many(src); },
+        [get_many] (dart::unsafe_buffer const& src) { get_many(src); }
+      ),
+      src
+    );
+  }
+
   char const* dart_buffer_str_get_len_impl(dart_buffer_t const* src, size_t* len) {
     char const* str;
     auto get_str = [&] (auto& src) {
@@ -100,6 +134,13 @@ namespace {
     else return equal;
   }
 
+  uint64_t dart_buffer_hash_impl(dart_buffer_t const* src) {
+    uint64_t hash = 0;
+    auto err = buffer_access([&hash] (auto& src) { hash = std::hash<std::decay_t<decltype(src)>> {}(src); }, src);
+    if (err) return 0;
+    else return hash;
+  }
+
   dart_type_t dart_buffer_get_type_impl(dart_buffer_t const* src) {
     dart_type_t type;
     auto get_type = [&] (auto& pkt) { type = abi_type(pkt.get_type()); };
@@ -316,6 +357,60 @@ extern "C" {
     );
   }
 
+  int dart_buffer_obj_has_key_handle(dart_buffer_t const* src, dart_key_t const* key) {
+    return dart_buffer_obj_has_key_handle_impl(src, key);
+  }
+
+  dart_buffer_t dart_buffer_obj_get_handle(dart_buffer_t const* src, dart_key_t const* key) {
+    dart_buffer_t dst;
+    auto err = dart_buffer_obj_get_handle_err(&dst, src, key);
+    if (err) return dart_buffer_init();
+    else return dst;
+  }
+
+  dart_err_t dart_buffer_obj_get_handle_err(dart_buffer_t* dst, dart_buffer_t const* src, dart_key_t const* key) {
+    // Initialize.
+    dst->rtti = src->rtti;
+    auto* handle = reinterpret_cast<dart::key const*>(DART_RAW_BYTES(key));
+    return buffer_access(
+      compose(
+        [=] (dart::buffer const& src) {
+          return buffer_construct([&] (dart::buffer* dst) {
+            new(dst) dart::buffer(src[*handle]);
+          }, dst);
+        },
+        [=] (dart::unsafe_buffer const& src) {
+          return buffer_construct([&] (dart::unsafe_buffer* dst) {
+            new(dst) dart::unsafe_buffer(src[*handle]);
+          }, dst);
+        }
+      ),
+      src
+    );
+  }
+
+  dart_err_t dart_buffer_obj_get_many(dart_buffer_t const* src,
+      dart_string_view_t const* keys, dart_buffer_t* dsts, size_t count)
+  {
+    return dart_buffer_obj_get_many_impl(src, keys, dsts, count);
+  }
+
+  dart_err_t dart_key_init_err(dart_key_t* dst, char const* key) {
+    return dart_key_init_len_err(dst, key, strlen(key));
+  }
+
+  dart_err_t dart_key_init_len_err(dart_key_t* dst, char const* key, size_t len) {
+    return err_handler([=] {
+      new(DART_RAW_BYTES(dst)) dart::key(string_view {key, len});
+      return DART_NO_ERROR;
+    });
+  }
+
+  dart_err_t dart_key_destroy(dart_key_t* key) {
+    reinterpret_cast<dart::key*>(DART_RAW_BYTES(key))->~key();
+    return DART_NO_ERROR;
+  }
+
   dart_buffer_t dart_buffer_arr_get(dart_buffer_t const* src, size_t idx) {
     dart_buffer_t dst;
     auto err = dart_buffer_arr_get_err(&dst, src, idx);
@@ -394,6 +489,10 @@ extern "C" {
     return dart_buffer_equal_impl(lhs, rhs);
   }
 
+  uint64_t dart_buffer_hash(dart_buffer_t const* src) {
+    return dart_buffer_hash_impl(src);
+  }
+
   int dart_buffer_is_obj(dart_buffer_t const* src) {
     return dart_buffer_get_type(src) == DART_OBJECT;
   }
@@ -967,6 +967,18 @@ SCENARIO("arrays can contain nulls", "[array unit]") {
           REQUIRE(arr[0].is_null());
         }
       }
+
+      DYNAMIC_WHEN("nulls are finalized between other values", idx) {
+        // Nulls take up no space, so they share an offset with whatever comes next.
+        auto null = dart::heap::null();
+        auto mixed = dart::heap::make_object("arr", dart::heap::make_array(null, null, "value", null, 1));
+        auto fin = dart::conversion_helper<pkt>(mixed).finalize();
+        DYNAMIC_THEN("the result still validates", idx) {
+          REQUIRE(dart::is_valid(fin.get_bytes()));
+          REQUIRE(fin["arr"][2] == "value");
+          REQUIRE(fin["arr"][3].is_null());
+        }
+      }
     });
   }
 }
@@ -1044,3 +1056,223 @@ SCENARIO("arrays can optionally access non-existent elements with a fallback", "
     });
   }
 }
+
+SCENARIO("arrays can be finalized in packed form", "[array unit]") {
+  GIVEN("an object containing homogeneous numeric arrays") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto ints = pkt::make_array(), floats = pkt::make_array(), doubles = pkt::make_array();
+      for (auto i = 0; i < 100; ++i) {
+        ints.push_back(i % 2 ? i * 100000 : -i);
+        floats.push_back(i + 0.5);
+        doubles.push_back(i + 0.1);
+      }
+      auto bools = pkt::make_array(true, false, true);
+      auto mixed = pkt::make_array(1, 2.5, true);
+      auto obj = pkt::make_object("ints", ints, "floats", floats,
+          "doubles", doubles, "bools", bools, "mixed", mixed, "empty", pkt::make_array());
+
+      DYNAMIC_WHEN("the object is finalized with packed arrays", idx) {
+        dart::finalize_options opts;
+        opts.packed_array_threshold = 1;
+        auto plain_copy = obj, packed_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto packed = packed_copy.finalize(opts);
+
+        DYNAMIC_THEN("every element is still reachable", idx) {
+          auto packed_ints = packed["ints"];
+          REQUIRE(packed_ints.size() == 100);
+          for (auto i = 0; i < 100; ++i) {
+            REQUIRE(packed_ints[i].integer() == (i % 2 ? i * 100000 : -i));
+            REQUIRE(packed["floats"][i].decimal() == i + 0.5);
+            REQUIRE(packed["doubles"][i].decimal() == i + 0.1);
+          }
+          auto total = 0.0;
+          for (auto val : packed["floats"]) total += val.decimal();
+          REQUIRE(total == 5000.0);
+          REQUIRE(packed["bools"][1].boolean() == false);
+          REQUIRE(packed["mixed"][2].boolean());
+          REQUIRE(packed["empty"].empty());
+        }
+
+        DYNAMIC_THEN("packed runs can be viewed directly", idx) {
+          auto span = packed["doubles"].template as_span<double>();
+          REQUIRE(span.size() == 100);
+          REQUIRE(span[42] == 42.1);
+          REQUIRE(packed["floats"].template as_span<float>()[7] == 7.5f);
+          REQUIRE(packed["ints"].template as_span<int32_t>()[3] == 300000);
+          REQUIRE(packed["bools"].template as_span<bool>()[2]);
+          REQUIRE_THROWS_AS(packed["ints"].template as_span<int64_t>(), dart::type_error);
+          REQUIRE_THROWS_AS(packed["mixed"].template as_span<int16_t>(), dart::type_error);
+          REQUIRE_THROWS_AS(plain["doubles"].template as_span<double>(), dart::type_error);
+          REQUIRE_THROWS_AS(packed.template as_span<double>(), dart::type_error);
+        }
+
+        DYNAMIC_THEN("it compares equal to the canonical encoding", idx) {
+          REQUIRE(packed == plain);
+          REQUIRE(plain == packed);
+          REQUIRE(packed["ints"] == plain["ints"]);
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(packed.get_bytes()));
+          dart::buffer copy {packed.dup_bytes()};
+          REQUIRE(copy == packed);
+          REQUIRE(copy["doubles"].template as_span<double>()[99] == 99.1);
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("packed booleans are validated", "[array unit]") {
+  GIVEN("a packed array of booleans, and a record batch with a boolean column") {
+    auto records = dart::heap::make_array();
+    for (auto i = 0; i < 8; ++i) records.push_back(dart::heap::make_object("flag", i % 2 == 0, "id", i));
+    auto obj = dart::heap::make_object("bools", dart::heap::make_array(true, false, true), "records", records);
+
+    dart::finalize_options opts;
+    opts.packed_array_threshold = 1;
+    opts.record_batch_threshold = 1;
+    auto packed = obj.finalize(opts);
+
+    // Copies the buffer, overwriting the given boolean with something that isn't one.
+    auto corrupt = [&] (bool const* target) {
+      auto bytes = packed.get_bytes();
+      std::vector<int64_t> storage(bytes.size() / sizeof(int64_t) + 1);
+      auto* copy = reinterpret_cast<gsl::byte*>(storage.data());
+      std::copy(bytes.begin(), bytes.end(), copy);
+      copy[reinterpret_cast<gsl::byte const*>(target) - bytes.data()] = static_cast<gsl::byte>(2);
+      return storage;
+    };
+
+    WHEN("it's left alone") {
+      THEN("it validates") {
+        REQUIRE(dart::is_valid(packed.get_bytes()));
+        REQUIRE(packed["records"].template column_span<bool>("flag")[2]);
+      }
+    }
+
+    WHEN("a packed boolean is neither true nor false") {
+      auto storage = corrupt(&packed["bools"].template as_span<bool>()[1]);
+      THEN("validation rejects it") {
+        auto raw = gsl::make_span(reinterpret_cast<gsl::byte const*>(storage.data()), packed.get_bytes().size());
+        REQUIRE_FALSE(dart::is_valid(raw));
+      }
+    }
+
+    WHEN("a boolean in a record batch column is neither true nor false") {
+      auto storage = corrupt(&packed["records"].template column_span<bool>("flag")[3]);
+      THEN("validation rejects it") {
+        auto raw = gsl::make_span(reinterpret_cast<gsl::byte const*>(storage.data()), packed.get_bytes().size());
+        REQUIRE_FALSE(dart::is_valid(raw));
+      }
+    }
+  }
+}
+
+SCENARIO("record batches with null columns are validated", "[array unit]") {
+  GIVEN("a record batch whose last column holds nothing but nulls") {
+    auto null = dart::heap::make_null();
+    auto obj = dart::heap::make_object("a", dart::heap::make_array(dart::heap::make_object("x", null),
+          dart::heap::make_object("x", null)), "b", dart::heap::make_array(dart::heap::make_object("y", 1, "z", null),
+          dart::heap::make_object("y", 2, "z", null)));
+
+    WHEN("it's finalized") {
+      dart::finalize_options opts;
+      opts.record_batch_threshold = 2;
+      auto batch = obj.finalize(opts);
+
+      THEN("its nulls share their offsets, and it still validates") {
+        REQUIRE(dart::is_valid(batch.get_bytes()));
+        REQUIRE_NOTHROW(dart::validate(batch.get_bytes()));
+        REQUIRE(batch["a"][1]["x"].is_null());
+        REQUIRE(batch["b"][1]["y"] == 2);
+      }
+    }
+  }
+}
+
+SCENARIO("arrays of same-shaped objects can be finalized as record batches", "[array unit]") {
+  GIVEN("an object containing an array of records") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto records = pkt::make_array();
+      for (auto i = 0; i < 64; ++i) {
+        auto tags = pkt::make_array("tag", i);
+        auto note = i % 2 ? pkt::make_null() : pkt::make_string("even");
+        records.push_back(pkt::make_object("id", i, "price", i + 0.1,
+              "name", "item" + std::to_string(i), "tags", tags, "note", note));
+      }
+      auto obj = pkt::make_object("records", records,
+          "mixed", pkt::make_array(pkt::make_object("a", 1), pkt::make_object("b", 2)));
+
+      DYNAMIC_WHEN("the object is finalized with record batches", idx) {
+        dart::finalize_options opts;
+        opts.record_batch_threshold = 1;
+        auto plain_copy = obj, batch_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto batch = batch_copy.finalize(opts);
+        auto rows = batch["records"];
+
+        DYNAMIC_THEN("every row still behaves like an object", idx) {
+          REQUIRE(rows.size() == 64);
+          auto count = 0;
+          for (auto row : rows) {
+            REQUIRE(row.is_object());
+            REQUIRE(row.size() == 5);
+            REQUIRE(row["id"].integer() == count);
+            REQUIRE(row["price"].decimal() == count + 0.1);
+            REQUIRE(row["name"] == "item" + std::to_string(count));
+            REQUIRE(row["tags"][1].integer() == count);
+            REQUIRE(row.has_key("note"));
+            REQUIRE(row["note"].is_null() == (count % 2 == 1));
+            REQUIRE_FALSE(row.has_key("missing"));
+            ++count;
+          }
+          REQUIRE(count == 64);
+          REQUIRE(rows[3].keys().size() == 5);
+          REQUIRE(*rows[3].find("name") == "item3");
+          REQUIRE_THROWS_AS(rows[3].at("missing"), std::out_of_range);
+          REQUIRE(batch["mixed"][1]["b"].integer() == 2);
+        }
+
+        DYNAMIC_THEN("columns of primitives can be scanned directly", idx) {
+          auto prices = rows.template column_span<double>("price");
+          REQUIRE(prices.size() == 64);
+          REQUIRE(prices[42] == 42.1);
+          REQUIRE(rows.template column_span<int16_t>("id")[63] == 63);
+          REQUIRE_THROWS_AS(rows.template column_span<double>("name"), dart::type_error);
+          REQUIRE_THROWS_AS(rows.template column_span<double>("missing"), dart::type_error);
+          REQUIRE_THROWS_AS(plain["records"].template column_span<double>("price"), dart::type_error);
+        }
+
+        DYNAMIC_THEN("rows can be used to build new packets", idx) {
+          auto wrapped = dart::buffer::make_object("row", rows[7]);
+          REQUIRE(wrapped["row"]["name"] == "item7");
+          REQUIRE(rows[7].inject("extra", true)["extra"].boolean());
+          REQUIRE(rows[7].project({"id"}).size() == 1);
+          REQUIRE(rows[7].definalize() == plain["records"][7]);
+          REQUIRE_THROWS_AS(rows[7].get_bytes(), dart::type_error);
+        }
+
+        DYNAMIC_THEN("it compares equal to the canonical encoding", idx) {
+          REQUIRE(batch == plain);
+          REQUIRE(plain == batch);
+          REQUIRE(rows[5] == plain["records"][5]);
+          REQUIRE_FALSE(rows[5] == rows[6]);
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(batch.get_bytes()));
+          REQUIRE(batch.get_bytes().size() < plain.get_bytes().size());
+          dart::buffer copy {batch.dup_bytes()};
+          REQUIRE(copy == batch);
+          REQUIRE(copy["records"][63]["name"] == "item63");
+        }
+      }
+    });
+  }
+}
@@ -199,6 +199,83 @@ SCENARIO("dart buffers are regular types", "[buffer abi unit]") {
   }
 }
 
+SCENARIO("buffer objects can be queried with precompiled keys", "[buffer abi unit]") {
+  GIVEN("a precompiled key and some objects of the same shape") {
+    dart_key_t key;
+    REQUIRE(dart_key_init_err(&key, "int") == DART_NO_ERROR);
+    auto key_guard = make_scope_guard([&] { dart_key_destroy(&key); });
+
+    dart_key_t truncated;
+    REQUIRE(dart_key_init_len_err(&truncated, "intx", strlen("int")) == DART_NO_ERROR);
+    auto truncated_guard = make_scope_guard([&] { dart_key_destroy(&truncated); });
+
+    auto mut = dart_obj_init();
+    dart_obj_insert_str(&mut, "hello", "world");
+    dart_obj_insert_int(&mut, "int", 5);
+    auto guard = make_scope_guard([&] { dart_destroy(&mut); });
+
+    WHEN("the key is looked up in each object") {
+      THEN("it's found every time") {
+        for (auto i = 0; i < 4; ++i) {
+          dart_obj_insert_int(&mut, "int", i);
+          auto fin = dart_to_buffer(&mut);
+          auto val = dart_buffer_obj_get_handle(&fin, &key);
+          auto guard = make_scope_guard([&] {
+            dart_buffer_destroy(&val);
+            dart_buffer_destroy(&fin);
+          });
+          REQUIRE(dart_buffer_obj_has_key_handle(&fin, &key));
+          REQUIRE(dart_buffer_is_int(&val));
+          REQUIRE(dart_buffer_int_get(&val) == i);
+          REQUIRE(dart_buffer_obj_has_key_handle(&fin, &truncated));
+        }
+      }
+    }
+
+    WHEN("an absent key is looked up") {
+      dart_key_t absent;
+      REQUIRE(dart_key_init_err(&absent, "nope") == DART_NO_ERROR);
+      auto fin = dart_to_buffer(&mut);
+      auto val = dart_buffer_obj_get_handle(&fin, &absent);
+      auto guard = make_scope_guard([&] {
+        dart_buffer_destroy(&val);
+        dart_buffer_destroy(&fin);
+        dart_key_destroy(&absent);
+      });
+      THEN("it isn't found") {
+        REQUIRE_FALSE(dart_buffer_obj_has_key_handle(&fin, &absent));
+        REQUIRE(dart_buffer_is_null(&val));
+      }
+    }
+  }
+}
+
+SCENARIO("buffer objects can look up many keys at once", "[buffer abi unit]") {
+  GIVEN("a finalized object") {
+    auto mut = dart_obj_init();
+    dart_obj_insert_str(&mut, "hello", "world");
+    dart_obj_insert_int(&mut, "int", 5);
+    auto fin = dart_to_buffer(&mut);
+    auto guard = make_scope_guard([&] {
+      dart_buffer_destroy(&fin);
+      dart_destroy(&mut);
+    });
+
+    WHEN("a batch of keys is looked up") {
+      dart_string_view_t keys[] = {{"int", 3}, {"nope", 4}, {"hello", 5}};
+      dart_buffer_t vals[3];
+      REQUIRE(dart_buffer_obj_get_many(&fin, keys, vals, 3) == DART_NO_ERROR);
+      auto guard = make_scope_guard([&] { for (auto& val : vals) dart_buffer_destroy(&val); });
+
+      THEN("every key maps to its value") {
+        REQUIRE(dart_buffer_int_get(&vals[0]) == 5);
+        REQUIRE(dart_buffer_is_null(&vals[1]));
+        REQUIRE(dart_buffer_str_get(&vals[2]) == "world"s);
+      }
+    }
+  }
+}
+
 SCENARIO("dart buffers with unsafe refcounting are regular types", "[buffer abi unit]") {
   GIVEN("a default constructed object") {
     // Get an object, make sure it's cleaned up.
@@ -123,6 +123,38 @@ TEST_CASE("dart::packet parses JSON via RapidJSON", "[json unit]") {
   }
 }
 
+TEST_CASE("dart::buffer parses JSON into exactly as much memory as it needs", "[json unit]") {
+  std::string json;
+  std::ifstream file("test.json");
+  while (std::getline(file, json)) {
+    // Parsing straight into a buffer has to give the same bytes as parsing into a heap first.
+    auto direct = dart::buffer::from_json(json);
+    auto indirect = dart::heap::from_json(json).finalize();
+    auto bytes = direct.get_bytes(), expected = indirect.get_bytes();
+    REQUIRE(dart::is_valid(bytes));
+    REQUIRE(std::equal(bytes.begin(), bytes.end(), expected.begin(), expected.end()));
+
+    // And the same bytes again when the caller provides the memory.
+    std::vector<uint64_t> slab(bytes.size() / sizeof(uint64_t));
+    auto dest = gsl::make_span(reinterpret_cast<gsl::byte*>(slab.data()), slab.size() * sizeof(uint64_t));
+    REQUIRE(dart::buffer::from_json_into(json, dest) == static_cast<size_t>(bytes.size()));
+    REQUIRE(std::equal(bytes.begin(), bytes.end(), dest.begin(), dest.end()));
+    try {
+      dart::buffer::from_json_into(json, dest.first(dest.size() - sizeof(uint64_t)));
+      FAIL("parsing into too little memory should have thrown");
+    } catch (dart::size_error const& err) {
+      REQUIRE(err.needed == static_cast<size_t>(bytes.size()));
+    }
+  }
+
+  // Duplicate keys keep the last value, just like they do in a heap.
+  auto dups = dart::buffer::from_json(R"({"b":1,"a":{"c":[1,2]},"b":"two"})");
+  REQUIRE(dups.size() == 2U);
+  REQUIRE(dups["b"] == "two");
+  REQUIRE(dups == dart::heap::from_json(R"({"b":1,"a":{"c":[1,2]},"b":"two"})"));
+  REQUIRE_THROWS_AS(dart::buffer::from_json("[1,2,3]"), dart::type_error);
+}
+
 template <class Packet>
 void compare_rj_dart(rj::Value const& obj, typename Packet::view pkt) {
   switch (obj.GetType()) {
@@ -0,0 +1,376 @@
+/*----- Local Includes -----*/
+
+#include "dart_tests.h"
+
+/*----- System Includes -----*/
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <system_error>
+
+/*----- Function Implementations -----*/
+
+TEST_CASE("dart::packet parses JSON via the built in reader", "[json unit]") {
+  std::string json;
+  std::ifstream file("test.json");
+  while (std::getline(file, json)) {
+    auto heap = dart::heap::from_json(json);
+    auto buffer = dart::buffer::from_json(json);
+    auto packet = dart::packet::from_json(json, true);
+    REQUIRE(heap == buffer);
+    REQUIRE(packet == buffer);
+
+    // Both parsing paths have to agree on the finalized representation, byte for byte.
+    auto finalized = heap.finalize();
+    auto bytes = buffer.get_bytes(), expected = finalized.get_bytes();
+    REQUIRE(dart::is_valid(bytes));
+    REQUIRE(std::equal(bytes.begin(), bytes.end(), expected.begin(), expected.end()));
+  }
+}
+
+TEST_CASE("dart::packet reads strings across the built in reader's blocks", "[json unit]") {
+  // Slide escapes and multibyte characters across every position of a few 64 byte blocks.
+  for (auto len = 0U; len < 200; ++len) {
+    std::string expected, escaped;
+    for (auto i = 0U; i < len; ++i) {
+      switch ((i * 7 + len) % 11) {
+        case 0:
+          expected += '"';
+          escaped += "\\\"";
+          break;
+        case 1:
+          expected += '\\';
+          escaped += "\\\\";
+          break;
+        case 2:
+          expected += "\xc3\xa9";
+          escaped += (i % 2) ? "\xc3\xa9" : "\\u00e9";
+          break;
+        case 3:
+          expected += "\xf0\x9f\x98\x80";
+          escaped += (i % 2) ? "\xf0\x9f\x98\x80" : "\\ud83d\\ude00";
+          break;
+        case 4:
+          expected += "\n";
+          escaped += "\\n";
+          break;
+        case 5:
+          expected += "{[:,]}";
+          escaped += "{[:,]}";
+          break;
+        default:
+          expected += static_cast<char>('a' + i % 26);
+          escaped += static_cast<char>('a' + i % 26);
+          break;
+      }
+    }
+
+    auto json = "{\"" + escaped + "\":\"" + escaped + "\",\"after\":" + std::to_string(len) + "}";
+    auto heap = dart::heap::from_json(json);
+    auto buffer = dart::buffer::from_json(json);
+    REQUIRE(heap.size() == 2U);
+    REQUIRE(heap[expected].strv() == expected);
+    REQUIRE(heap["after"].integer() == static_cast<int64_t>(len));
+    REQUIRE(heap == buffer);
+  }
+}
+
+TEST_CASE("dart::packet reads numbers via the built in reader", "[json unit]") {
+  auto pkt = dart::heap::from_json(R"({
+    "zero": 0, "neg_zero": -0, "int": -2147483649, "uint": 4294967296,
+    "min": -9223372036854775808, "max": 9223372036854775807,
+    "huge": 18446744073709551616, "tenth": 0.1, "exp": 12.5e+3, "tiny": 4.9e-324,
+    "long": 3.14159265358979323846264338327950288
+  })");
+  REQUIRE(pkt["zero"].integer() == 0);
+  REQUIRE(pkt["neg_zero"].integer() == 0);
+  REQUIRE(pkt["int"].integer() == -2147483649LL);
+  REQUIRE(pkt["uint"].integer() == 4294967296LL);
+  REQUIRE(pkt["min"].integer() == std::numeric_limits<int64_t>::min());
+  REQUIRE(pkt["max"].integer() == std::numeric_limits<int64_t>::max());
+  REQUIRE(pkt["huge"].is_decimal());
+  REQUIRE(pkt["huge"].decimal() == 18446744073709551616.0);
+  REQUIRE(pkt["tenth"].decimal() == 0.1);
+  REQUIRE(pkt["exp"].decimal() == 12500.0);
+  REQUIRE(pkt["tiny"].decimal() == 4.9e-324);
+  REQUIRE(pkt["long"].decimal() == 3.14159265358979323846264338327950288);
+
+  // NaN, infinities, and trailing commas all have to be asked for.
+  auto permissive = R"({"nan":NaN,"inf":Infinity,"ninf":-Infinity,"arr":[1,2,],})";
+  REQUIRE_THROWS_AS(dart::heap::from_json(permissive), dart::parse_error);
+  auto parsed = dart::buffer::from_json<dart::parse_nan | dart::parse_trailing_commas>(permissive);
+  REQUIRE(std::isnan(parsed["nan"].decimal()));
+  REQUIRE(parsed["inf"].decimal() == std::numeric_limits<double>::infinity());
+  REQUIRE(parsed["ninf"].decimal() == -std::numeric_limits<double>::infinity());
+  REQUIRE(parsed["arr"].size() == 2U);
+}
+
+TEST_CASE("dart::packet rejects malformed JSON via the built in reader", "[json unit]") {
+  std::vector<std::string> malformed {
+    "", "   ", "{", "{\"a\":1", "{\"a\" 1}", "{\"a\":1 \"b\":2}", "{\"a\":[1 2]}", "{1:2}",
+    "{\"a\":01}", "{\"a\":1.}", "{\"a\":1e}", "{\"a\":-}", "{\"a\":tru}", "{\"a\":nulll}",
+    "{\"a\":\"\\x\"}", "{\"a\":\"\\u12g4\"}", "{\"a\":\"\\ud800\"}", "{\"a\":\"\\udc00\"}",
+    "{\"a\":\"tab\there\"}", "{\"a\":\"\xc3(\"}", "{\"a\":\"\xed\xa0\x80\"}", "{\"a\":\"open}",
+    "{\"a\":1e400}", "{} {}", "{\"a\":1,}", "{\"a\":[1,]}"
+  };
+  for (auto const& json : malformed) {
+    REQUIRE_THROWS_AS(dart::heap::from_json(json), dart::parse_error);
+    REQUIRE_THROWS_AS(dart::buffer::from_json(json), dart::parse_error);
+  }
+  REQUIRE_THROWS_AS(dart::buffer::from_json("[1,2,3]"), dart::type_error);
+}
+
+TEST_CASE("dart::buffer parses aggregates too large for the ordinary encoding", "[json unit]") {
+  std::string json = R"({"tiny":{"a":1},"wide":{)";
+  for (auto i = 0; i < 100; ++i) {
+    if (i) json += ",";
+    json += "\"field_" + std::to_string(i) + "\":" + std::to_string(i);
+  }
+  json += R"(},"long":[)";
+  for (auto i = 0; i < 100; ++i) {
+    if (i) json += ",";
+    json += R"({"idx":)" + std::to_string(i) + R"(,"name":"element)" + std::to_string(i) + R"("})";
+  }
+  json += "]}";
+
+  // Lowering the limit lets us exercise the encoding without four gigabyte documents.
+  dart::detail::buffer_parser<std::shared_ptr> parser {2048};
+  dart::detail::json_parse<dart::parse_default>(json, parser, "dart::buffer");
+  REQUIRE(parser.root_type() == dart::detail::raw_type::large_object);
+
+  std::vector<int64_t> storage((parser.get_sizeof() + sizeof(int64_t) - 1) / sizeof(int64_t));
+  auto* bytes = reinterpret_cast<gsl::byte*>(storage.data());
+  REQUIRE(parser.layout(bytes) == parser.get_sizeof());
+  auto const span = gsl::make_span(bytes, parser.get_sizeof());
+  REQUIRE(dart::is_valid(span));
+
+  auto is_large = [] (auto const& bytes) {
+    return std::all_of(bytes.begin(), bytes.begin() + 4, [] (auto b) { return b == gsl::byte {}; });
+  };
+  dart::buffer parsed {span};
+  REQUIRE(parsed == dart::heap::from_json(json));
+  REQUIRE(is_large(parsed["wide"].get_bytes()));
+  REQUIRE_FALSE(is_large(parsed["tiny"].get_bytes()));
+  REQUIRE(parsed["long"][42]["name"] == "element42");
+}
+
+TEST_CASE("dart::json_stream_parser splits chunked streams into values", "[json unit]") {
+  std::string line, stream;
+  std::vector<dart::buffer> expected;
+  std::ifstream file("test.json");
+  while (std::getline(file, line)) {
+    expected.push_back(dart::buffer::from_json(line));
+    stream += line + (expected.size() % 2 ? "\n" : " \t\r\n ");
+  }
+
+  // Chunks of every size have to come out the same, no matter where they split things.
+  for (auto chunk : {1U, 2U, 3U, 7U, 64U, 1000U, 1U << 20U}) {
+    std::vector<dart::buffer> parsed;
+    auto sink = [&] (dart::buffer val) { parsed.push_back(std::move(val)); };
+    for (auto mode : {dart::json_stream_parser::mode::concatenated, dart::json_stream_parser::mode::ndjson}) {
+      parsed.clear();
+      dart::json_stream_parser parser {mode};
+      size_t emitted = 0;
+      for (size_t off = 0; off < stream.size(); off += chunk) {
+        emitted += parser.feed(gsl::make_span(stream.data() + off, std::min<size_t>(chunk, stream.size() - off)), sink);
+      }
+      emitted += parser.finish(sink);
+      REQUIRE(emitted == expected.size());
+      REQUIRE(parsed == expected);
+      REQUIRE_FALSE(parser.pending());
+    }
+  }
+
+  // Brackets and quotes inside strings mustn't throw off where values end.
+  std::string values = R"({"a":"}"}[1,[2]]  ["str\"ing]"]{"b":"\\"}[{"c":["]"]}])";
+  std::vector<dart::heap> heaps;
+  for (auto chunk = 1U; chunk <= values.size(); ++chunk) {
+    heaps.clear();
+    dart::basic_json_stream_parser<dart::heap> parser;
+    auto sink = [&] (dart::heap val) { heaps.push_back(std::move(val)); };
+    for (size_t off = 0; off < values.size(); off += chunk) {
+      parser.feed(gsl::make_span(values.data() + off, std::min<size_t>(chunk, values.size() - off)), sink);
+    }
+    parser.finish(sink);
+    REQUIRE(heaps.size() == 5U);
+    REQUIRE(heaps[0]["a"] == "}");
+    REQUIRE(heaps[1][1][0] == 2);
+    REQUIRE(heaps[2][0] == "str\"ing]");
+    REQUIRE(heaps[3]["b"] == "\\");
+    REQUIRE(heaps[4][0]["c"][0] == "]");
+  }
+
+  // Bare scalars end wherever the next value starts, although dart::buffer won't take them.
+  std::vector<dart::buffer> parsed;
+  auto sink = [&] (dart::buffer val) { parsed.push_back(std::move(val)); };
+  dart::json_stream_parser parser;
+  REQUIRE(parser.feed(std::string("{\"a\":1}"), sink) == 1U);
+  REQUIRE_THROWS(parser.feed(std::string("-12.5e3{\"b\":2}true"), sink));
+  REQUIRE(parser.feed(gsl::span<char const> {}, sink) == 1U);
+  REQUIRE(parser.pending());
+  REQUIRE_THROWS(parser.finish(sink));
+  REQUIRE_FALSE(parser.pending());
+  REQUIRE(parser.buffered() == 0U);
+  REQUIRE(parsed.size() == 2U);
+  REQUIRE(parsed.back()["b"] == 2);
+}
+
+TEST_CASE("dart::json_stream_parser reports and skips malformed values", "[json unit]") {
+  std::string stream = "{\"a\":1}\n\n{\"b\":}\r\n{\"c\":3}\n{\"d\":";
+  dart::json_stream_parser parser {dart::json_stream_parser::mode::ndjson};
+  std::vector<dart::buffer> parsed;
+  auto sink = [&] (dart::buffer val) { parsed.push_back(std::move(val)); };
+
+  try {
+    parser.feed(stream, sink);
+    FAIL("malformed line was accepted");
+  } catch (dart::stream_parse_error const& err) {
+    REQUIRE(err.line == 3U);
+    REQUIRE(err.offset == 9U);
+  }
+  REQUIRE(parsed.size() == 1U);
+
+  // The rest of the chunk is picked up where the error left off.
+  REQUIRE(parser.feed(gsl::span<char const> {}, sink) == 1U);
+  REQUIRE(parsed.back()["c"] == 3);
+  REQUIRE(parser.pending());
+  REQUIRE(parser.buffered() == 5U);
+  REQUIRE_THROWS_AS(parser.finish(sink), dart::stream_parse_error);
+  REQUIRE_FALSE(parser.pending());
+
+  // Values cut off by the end of the stream are errors too.
+  dart::json_stream_parser concat;
+  concat.feed(std::string("{\"a\":[1,2,3]} {\"b\":\"unterminated"), sink);
+  REQUIRE(parsed.size() == 3U);
+  REQUIRE_THROWS_AS(concat.finish(sink), dart::stream_parse_error);
+}
+
+TEST_CASE("dart::json_stream_parser rejects values longer than its maximum", "[json unit]") {
+  std::string stream = "{\"a\":1}\n{\"long\":\"" + std::string(200, 'x') + "\"}\n{\"b\":2}\n";
+  for (auto mode : {dart::json_stream_parser::mode::concatenated, dart::json_stream_parser::mode::ndjson}) {
+    std::vector<dart::buffer> parsed;
+    auto sink = [&] (dart::buffer val) { parsed.push_back(std::move(val)); };
+    dart::json_stream_parser parser {mode, dart::json_stream_parser::default_read_size, 64};
+
+    // However the value is split up, no more than the maximum is ever held onto.
+    size_t failures = 0;
+    for (size_t off = 0; off < stream.size(); off += 16) {
+      try {
+        parser.feed(gsl::make_span(stream.data() + off, std::min<size_t>(16, stream.size() - off)), sink);
+      } catch (dart::stream_parse_error const& err) {
+        REQUIRE(err.line == 2U);
+        REQUIRE(err.offset == 8U);
+        ++failures;
+      }
+      REQUIRE(parser.buffered() <= 64U);
+    }
+    parser.finish(sink);
+    REQUIRE(failures == 1U);
+    REQUIRE(parsed.size() == 2U);
+    REQUIRE(parsed.back()["b"] == 2);
+
+    // Values that fit in a single chunk are held to the same limit.
+    REQUIRE_THROWS_AS(parser.feed(stream, sink), dart::stream_parse_error);
+    REQUIRE(parser.feed(gsl::span<char const> {}, sink) == 1U);
+  }
+}
+
+TEST_CASE("dart::json_stream_parser reads from files, descriptors, and streams", "[json unit]") {
+  std::string stream;
+  for (auto i = 0; i < 100; ++i) stream += "{\"idx\":" + std::to_string(i) + ",\"pad\":\"" + std::string(i, 'x') + "\"}\n";
+
+  size_t next = 0;
+  auto sink = [&] (dart::buffer val) { REQUIRE(val["idx"] == static_cast<int64_t>(next++)); };
+  dart::json_stream_parser parser {dart::json_stream_parser::mode::ndjson, 17};
+
+  std::istringstream in {stream};
+  REQUIRE(parser.read(in, sink) == 100U);
+
+  next = 0;
+  auto* tmp = std::tmpfile();
+  REQUIRE(tmp);
+  std::fwrite(stream.data(), 1, stream.size(), tmp);
+  std::rewind(tmp);
+  REQUIRE(parser.read(tmp, sink) == 100U);
+
+  next = 0;
+  std::rewind(tmp);
+  REQUIRE(parser.read(fileno(tmp), sink) == 100U);
+  std::fclose(tmp);
+}
+
+TEST_CASE("dart::parse_ndjson parses lines in order on several threads", "[json unit]") {
+  std::string ndjson;
+  std::vector<dart::buffer> expected;
+  for (auto i = 0; i < 20000; ++i) {
+    auto line = "{\"idx\":" + std::to_string(i) + ",\"str\":\"" + std::string(i % 97, 'x') + "\",\"arr\":[" + std::to_string(i % 13) + "]}";
+    expected.push_back(dart::buffer::from_json(line));
+    ndjson += line + (i % 3 ? "\n" : "\r\n");
+    if (i % 1000 == 0) ndjson += "\n  \n";
+  }
+
+  for (auto threads : {1U, 2U, 4U, 0U}) {
+    REQUIRE(dart::parse_ndjson(ndjson, threads) == expected);
+
+    size_t next = 0;
+    auto count = dart::parse_ndjson(ndjson, threads, [&] (dart::buffer val) {
+      REQUIRE(val == expected[next++]);
+    });
+    REQUIRE(count == expected.size());
+  }
+
+  // Repeated runs can share the threads of a policy.
+  dart::parallel_policy policy {4};
+  for (auto run = 0; run < 3; ++run) REQUIRE(dart::parse_ndjson(ndjson, policy) == expected);
+  REQUIRE(dart::parse_ndjson(ndjson, dart::parallel_policy {1}) == expected);
+
+  // Large files can be parsed straight out of a mapping.
+  {
+    std::ofstream out("ndjson_test.tmp", std::ios::binary);
+    out << ndjson;
+  }
+  {
+    dart::mapped_file file {"ndjson_test.tmp"};
+    REQUIRE(file.size() == ndjson.size());
+    REQUIRE(dart::parse_ndjson(file.view(), 4) == expected);
+  }
+  std::remove("ndjson_test.tmp");
+  REQUIRE_THROWS_AS(dart::mapped_file {"ndjson_test.tmp"}, std::system_error);
+}
+
+TEST_CASE("dart::parse_ndjson reports the first line that fails", "[json unit]") {
+  std::string ndjson;
+  for (auto i = 0; i < 50000; ++i) {
+    if (i == 31337 || i == 40000) ndjson += "{\"broken\":}\n";
+    else ndjson += "{\"idx\":" + std::to_string(i) + "}\n";
+  }
+  auto const offset = ndjson.find("{\"broken\"");
+
+  for (auto threads : {1U, 4U}) {
+    size_t next = 0;
+    try {
+      dart::parse_ndjson(ndjson, threads, [&] (dart::buffer val) {
+        REQUIRE(val["idx"] == static_cast<int64_t>(next++));
+      });
+      FAIL("malformed line was accepted");
+    } catch (dart::stream_parse_error const& err) {
+      REQUIRE(err.line == 31338U);
+      REQUIRE(err.offset == offset);
+    }
+    REQUIRE(next == 31337U);
+  }
+
+  // Lines that parse, but can't be held by a dart::buffer, keep their position too.
+  try {
+    dart::parse_ndjson("{}\n[1,2]\n");
+    FAIL("non-object line was accepted");
+  } catch (dart::stream_parse_error const& err) {
+    REQUIRE(err.line == 2U);
+    REQUIRE(err.offset == 3U);
+  }
+}
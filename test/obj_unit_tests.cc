@@ -892,6 +892,44 @@ SCENARIO("objects can access nested keys in one step", "[object unit]") {
   }
 }
 
+SCENARIO("objects can access nested values through precompiled paths", "[object unit]") {
+  GIVEN("an object with nested objects and arrays") {
+    dart::api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto songs = dart::heap::make_array(dart::heap::make_object("title", "time"), dart::heap::make_object("title", "money"));
+      auto tmp = dart::heap::make_object("album", dart::heap::make_object("songs", std::move(songs), "7", "seven"));
+      auto obj = dart::conversion_helper<pkt>(tmp);
+
+      DYNAMIC_WHEN("a path is evaluated", idx) {
+        dart::path title {"album.songs.1.title"}, numeric_key {"album.7"}, slashes {"album/songs/0/title", '/'};
+        DYNAMIC_THEN("it resolves keys in objects and indices in arrays", idx) {
+          REQUIRE(obj.get_nested(title) == "money");
+          REQUIRE(obj.get_nested(numeric_key) == "seven");
+          REQUIRE(obj.get_nested(slashes) == "time");
+          REQUIRE(obj.get_nested(dart::path {"album.songs"}).size() == 2U);
+          REQUIRE(obj.get_nested(dart::path {""}) == obj);
+        }
+
+        DYNAMIC_THEN("it agrees with the uncompiled path", idx) {
+          for (auto needle : {"album.7", "album.songs", "album..songs", "album.nope", ".album"}) {
+            REQUIRE(obj.get_nested(dart::path {needle}) == obj.get_nested(needle));
+          }
+        }
+      }
+
+      DYNAMIC_WHEN("an invalid path is evaluated", idx) {
+        DYNAMIC_THEN("it returns null", idx) {
+          REQUIRE(obj.get_nested(dart::path {"album.songs.2.title"}).is_null());
+          REQUIRE(obj.get_nested(dart::path {"album.songs.first"}).is_null());
+          REQUIRE(obj.get_nested(dart::path {"album.songs.0.title.more"}).is_null());
+          REQUIRE(obj.get_nested(dart::path {"album.songs.99999999999999999999999"}).is_null());
+        }
+      }
+    });
+  }
+}
+
 SCENARIO("objects can check membership for keys", "[object unit]") {
   GIVEN("a set of keys and an object with those keys") {
     dart::api_test([] (auto tag, auto idx) {
@@ -925,6 +963,1328 @@ SCENARIO("objects can check membership for keys", "[object unit]") {
   }
 }
 
+SCENARIO("finalized objects can find keys regardless of object size", "[object unit]") {
+  GIVEN("keys that share lengths and prefixes") {
+    dart::finalized_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      std::vector<std::string> keys = {"", "a", "b", "ab", "ac", std::string(255, 'x'), std::string(300, 'x')};
+      for (auto i = 0; i < 64; ++i) keys.push_back("metric_" + std::to_string(i));
+
+      // Check objects on either side of the linear scan threshold.
+      std::vector<pkt> objs;
+      for (auto count : {1U, 3U, 4U, 5U, 8U, 31U, 32U, 33U, 47U, 48U, 49U, 71U}) {
+        auto tmp = dart::heap::make_object();
+        for (auto i = 0U; i < count; ++i) tmp.add_field(keys[i], static_cast<int64_t>(i));
+        objs.push_back(dart::conversion_helper<pkt>(tmp.finalize()));
+      }
+
+      DYNAMIC_WHEN("looking up keys that exist", idx) {
+        DYNAMIC_THEN("each one resolves to its own value", idx) {
+          for (auto& obj : objs) {
+            for (auto i = 0U; i < obj.size(); ++i) {
+              REQUIRE(obj.has_key(keys[i]));
+              REQUIRE(obj[keys[i]].integer() == static_cast<int64_t>(i));
+            }
+          }
+        }
+      }
+
+      DYNAMIC_WHEN("looking up keys that don't exist", idx) {
+        DYNAMIC_THEN("they're reported as absent", idx) {
+          for (auto& obj : objs) {
+            REQUIRE_FALSE(obj.has_key("ad"));
+            REQUIRE_FALSE(obj.has_key("metric_"));
+            REQUIRE_FALSE(obj.has_key("metric_99"));
+            REQUIRE_FALSE(obj.has_key(std::string(254, 'x')));
+            REQUIRE_FALSE(obj.has_key(std::string(256, 'x')));
+            REQUIRE_FALSE(obj.has_key(std::string(1, '\0')));
+          }
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized with an eytzinger lookup index", "[object unit]") {
+  GIVEN("an object with many keys") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto obj = pkt::make_object();
+      for (auto i = 0; i < 1000; ++i) obj.add_field("field_" + std::to_string(i), i);
+      obj.add_field("nested", pkt::make_object("pi", 3.14159, "e", 2.71828));
+
+      DYNAMIC_WHEN("the object is finalized with the index enabled", idx) {
+        dart::finalize_options opts;
+        opts.eytzinger_threshold = 2;
+        auto plain_copy = obj, indexed_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto indexed = indexed_copy.finalize(opts);
+
+        DYNAMIC_THEN("every key is still reachable", idx) {
+          for (auto i = 0; i < 1000; ++i) {
+            auto key = "field_" + std::to_string(i);
+            REQUIRE(indexed.has_key(key));
+            REQUIRE(indexed[key].integer() == i);
+            REQUIRE_FALSE(indexed.has_key(key + "0000"));
+          }
+          REQUIRE(indexed["nested"]["e"].decimal() == Approx(2.71828));
+          REQUIRE_FALSE(indexed.has_key("nope"));
+        }
+
+        DYNAMIC_THEN("it iterates in the same order as the canonical encoding", idx) {
+          REQUIRE(indexed.keys() == plain.keys());
+          REQUIRE(indexed.values() == plain.values());
+        }
+
+        DYNAMIC_THEN("it compares equal to the canonical encoding", idx) {
+          REQUIRE(indexed.get_bytes().size() > plain.get_bytes().size());
+          REQUIRE(indexed == plain);
+          REQUIRE(plain == indexed);
+          REQUIRE(indexed["nested"] == plain["nested"]);
+          REQUIRE_FALSE(indexed == pkt::make_object("field_0", 0).finalize(opts));
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(indexed.get_bytes()));
+          dart::buffer copy {indexed.dup_bytes()};
+          REQUIRE(copy == indexed);
+          REQUIRE(copy["field_999"].integer() == 999);
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized with a perfect hash lookup index", "[object unit]") {
+  GIVEN("an object with many keys of different lengths") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      std::string long_key(300, 'k');
+      auto obj = pkt::make_object("", "empty", "a", "short", "ab", "shorter", long_key, "long");
+      for (auto i = 0; i < 1000; ++i) obj.add_field("field_" + std::to_string(i), i);
+
+      DYNAMIC_WHEN("the object is finalized with the index enabled", idx) {
+        dart::finalize_options opts;
+        opts.perfect_hash_threshold = 2;
+        auto plain_copy = obj, indexed_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto indexed = indexed_copy.finalize(opts);
+
+        DYNAMIC_THEN("every key is still reachable", idx) {
+          for (auto i = 0; i < 1000; ++i) {
+            auto key = "field_" + std::to_string(i);
+            REQUIRE(indexed[key].integer() == i);
+            REQUIRE_FALSE(indexed.has_key(key + "0000"));
+          }
+          REQUIRE(indexed[""] == "empty");
+          REQUIRE(indexed["a"] == "short");
+          REQUIRE(indexed["ab"] == "shorter");
+          REQUIRE(indexed[long_key] == "long");
+          REQUIRE_FALSE(indexed.has_key("b"));
+          REQUIRE_FALSE(indexed.has_key(long_key + "k"));
+        }
+
+        DYNAMIC_THEN("it compares equal to the canonical encoding", idx) {
+          REQUIRE(indexed.get_bytes().size() > plain.get_bytes().size());
+          REQUIRE(indexed == plain);
+          REQUIRE(plain == indexed);
+          REQUIRE(indexed.keys() == plain.keys());
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(indexed.get_bytes()));
+          dart::buffer copy {indexed.dup_bytes()};
+          REQUIRE(copy == indexed);
+          REQUIRE(copy["field_999"].integer() == 999);
+        }
+      }
+
+      DYNAMIC_WHEN("the object is finalized with every index enabled", idx) {
+        dart::finalize_options opts;
+        opts.eytzinger_threshold = 2;
+        opts.perfect_hash_threshold = 2;
+        auto indexed = obj.finalize(opts);
+
+        DYNAMIC_THEN("lookups still work", idx) {
+          REQUIRE(dart::is_valid(indexed.get_bytes()));
+          REQUIRE(indexed["field_500"].integer() == 500);
+          REQUIRE(indexed["ab"] == "shorter");
+          REQUIRE_FALSE(indexed.has_key("nope"));
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects without room to build a perfect hash table are laid out without one", "[object unit]") {
+  GIVEN("an object laid out with the index enabled, but without any scratch space") {
+    using pair = dart::detail::packet_pair<std::shared_ptr>;
+    std::vector<pair> pairs;
+    for (auto i = 0; i < 100; ++i) {
+      pairs.emplace_back(dart::packet::make_string("field_" + std::to_string(i)), dart::packet::make_integer(i));
+    }
+    std::sort(pairs.begin(), pairs.end(), dart::detail::dart_comparator<std::shared_ptr> {});
+
+    dart::finalize_options opts;
+    opts.perfect_hash_threshold = 2;
+    auto span = gsl::make_span(pairs);
+    auto const bytes = dart::detail::buffer_builder<std::shared_ptr>::max_bytes(span, opts);
+    std::vector<int64_t> storage(bytes / sizeof(int64_t) + 1);
+    new(storage.data()) dart::detail::object<std::shared_ptr>(span, opts);
+    dart::buffer unhashed {gsl::make_span(reinterpret_cast<gsl::byte const*>(storage.data()), bytes)};
+
+    WHEN("it's compared against the same object built with a table") {
+      auto hashed = dart::heap::make_object();
+      for (auto& p : pairs) hashed.add_field(dart::heap {p.key}, dart::heap {p.value});
+      auto indexed = hashed.finalize(opts);
+
+      THEN("it's just as valid, and just as readable") {
+        REQUIRE(dart::is_valid(unhashed.get_bytes()));
+        REQUIRE(unhashed.get_bytes().size() == indexed.get_bytes().size());
+        REQUIRE_FALSE(std::equal(unhashed.get_bytes().begin(), unhashed.get_bytes().end(), indexed.get_bytes().begin()));
+        REQUIRE(unhashed == indexed);
+        for (auto i = 0; i < 100; ++i) {
+          auto key = "field_" + std::to_string(i);
+          REQUIRE(unhashed[key].integer() == i);
+          REQUIRE_FALSE(unhashed.has_key(key + "x"));
+        }
+      }
+    }
+  }
+}
+
+SCENARIO("objects can be finalized with a shape fingerprint", "[object unit]") {
+  GIVEN("objects that share a shape, and an object that doesn't") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      dart::finalize_options opts;
+      opts.fingerprint_threshold = 1;
+      auto first = pkt::make_object("a", 1, "b", 2, "field", 3);
+      auto second = pkt::make_object("a", 4, "b", 5, "field", 6);
+      auto other = pkt::make_object("b", 7, "field", 8, "other_field", 9);
+
+      DYNAMIC_WHEN("the objects are finalized with fingerprints", idx) {
+        auto plain_copy = first;
+        auto plain = plain_copy.finalize();
+        auto fin_first = first.finalize(opts);
+        auto fin_second = second.finalize(opts);
+        auto fin_other = other.finalize(opts);
+
+        DYNAMIC_THEN("lookups alternating between shapes are correct", idx) {
+          for (auto i = 0; i < 3; ++i) {
+            REQUIRE(fin_first["field"].integer() == 3);
+            REQUIRE(fin_other["field"].integer() == 8);
+            REQUIRE(fin_second["field"].integer() == 6);
+            REQUIRE(fin_first["a"].integer() == 1);
+            REQUIRE(fin_second["b"].integer() == 5);
+            REQUIRE_FALSE(fin_other.has_key("a"));
+            REQUIRE_FALSE(fin_first.has_key("other_field"));
+            REQUIRE(fin_other["other_field"].integer() == 9);
+          }
+        }
+
+        DYNAMIC_THEN("it compares equal to the canonical encoding", idx) {
+          REQUIRE(fin_first == plain);
+          REQUIRE(plain == fin_first);
+          REQUIRE_FALSE(fin_first == fin_second);
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(fin_first.get_bytes()));
+          dart::buffer copy {fin_first.dup_bytes()};
+          REQUIRE(copy == fin_first);
+          REQUIRE(copy["field"].integer() == 3);
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized with wide key prefixes", "[object unit]") {
+  GIVEN("an object whose keys share long common prefixes") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      std::string long_key(300, 'k');
+      auto obj = pkt::make_object("", "empty", "a", "short", "ab", "shorter", long_key, "long");
+      for (auto i = 0; i < 500; ++i) {
+        obj.add_field("metric_" + std::to_string(i), i);
+        obj.add_field("request_latency_bucket_" + std::to_string(i), i * 2);
+      }
+
+      DYNAMIC_WHEN("the object is finalized with wide prefixes", idx) {
+        dart::finalize_options opts;
+        opts.wide_prefix_threshold = 2;
+        auto plain_copy = obj, wide_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto wide = wide_copy.finalize(opts);
+
+        DYNAMIC_THEN("every key is still reachable", idx) {
+          for (auto i = 0; i < 500; ++i) {
+            auto metric = "metric_" + std::to_string(i);
+            auto request = "request_latency_bucket_" + std::to_string(i);
+            REQUIRE(wide[metric].integer() == i);
+            REQUIRE(wide[request].integer() == i * 2);
+            REQUIRE_FALSE(wide.has_key(metric + "x"));
+            REQUIRE_FALSE(wide.has_key(request + "x"));
+          }
+          REQUIRE(wide[long_key] == "long");
+          REQUIRE(wide["ab"] == "shorter");
+          REQUIRE(wide[""] == "empty");
+          REQUIRE_FALSE(wide.has_key("metric_9999"));
+          REQUIRE_FALSE(wide.has_key(std::string(300, 'j')));
+        }
+
+        DYNAMIC_THEN("it compares equal to the canonical encoding", idx) {
+          REQUIRE(wide.keys() == plain.keys());
+          REQUIRE(wide == plain);
+          REQUIRE(plain == wide);
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(wide.get_bytes()));
+          dart::buffer copy {wide.dup_bytes()};
+          REQUIRE(copy == wide);
+          REQUIRE(copy["metric_42"].integer() == 42);
+        }
+      }
+
+      DYNAMIC_WHEN("the object is finalized with wide prefixes and every index", idx) {
+        dart::finalize_options opts;
+        opts.eytzinger_threshold = 2;
+        opts.perfect_hash_threshold = 2;
+        opts.fingerprint_threshold = 2;
+        opts.wide_prefix_threshold = 2;
+        auto indexed = obj.finalize(opts);
+
+        DYNAMIC_THEN("lookups still work", idx) {
+          REQUIRE(dart::is_valid(indexed.get_bytes()));
+          REQUIRE(indexed["request_latency_bucket_250"].integer() == 500);
+          REQUIRE(indexed["metric_7"].integer() == 7);
+          REQUIRE(indexed["ab"] == "shorter");
+          REQUIRE_FALSE(indexed.has_key("metric_7x"));
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized with a key dictionary", "[object unit]") {
+  GIVEN("an object of nested packets that reuse the same keys") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto obj = pkt::make_object("unique_top_level_key", "top");
+      for (auto i = 0; i < 50; ++i) {
+        auto inner = pkt::make_object("timestamp", i, "hostname", "host" + std::to_string(i % 5));
+        inner.add_field("request_latency", i * 1.5);
+        if (i % 2) inner.add_field("error_message", "timeout");
+        inner.add_field("tags", pkt::make_array("hostname", i));
+        obj.add_field("packet_" + std::to_string(i), std::move(inner));
+      }
+
+      DYNAMIC_WHEN("the object is finalized with a key dictionary", idx) {
+        dart::finalize_options opts;
+        opts.key_dictionary_threshold = 2;
+        auto plain_copy = obj, dict_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto dict = dict_copy.finalize(opts);
+
+        DYNAMIC_THEN("every key is still reachable", idx) {
+          for (auto i = 0; i < 50; ++i) {
+            auto inner = dict["packet_" + std::to_string(i)];
+            REQUIRE(inner["timestamp"].integer() == i);
+            REQUIRE(inner["hostname"] == "host" + std::to_string(i % 5));
+            REQUIRE(inner["request_latency"].decimal() == i * 1.5);
+            REQUIRE(inner.has_key("error_message") == static_cast<bool>(i % 2));
+            REQUIRE(inner["tags"][1].integer() == i);
+            REQUIRE_FALSE(inner.has_key("timestampx"));
+          }
+          REQUIRE(dict["unique_top_level_key"] == "top");
+          REQUIRE(dict.get("packet_7").get("timestamp").integer() == 7);
+        }
+
+        DYNAMIC_THEN("it compares equal to, and is smaller than, the canonical encoding", idx) {
+          REQUIRE(dict.keys() == plain.keys());
+          REQUIRE(dict == plain);
+          REQUIRE(plain == dict);
+          REQUIRE(dict["packet_3"] == plain["packet_3"]);
+          REQUIRE(dict.get_bytes().size() < plain.get_bytes().size());
+        }
+
+        DYNAMIC_THEN("nested objects have no network buffer of their own", idx) {
+          REQUIRE_THROWS_AS(dict["packet_3"].get_bytes(), dart::type_error);
+        }
+
+        DYNAMIC_THEN("nested objects can still be embedded in other packets", idx) {
+          auto host = pkt::make_object("nested", dict["packet_3"]);
+          REQUIRE(host["nested"] == plain["packet_3"]);
+          auto injected = dict["packet_4"].inject("extra", 1);
+          REQUIRE(injected["timestamp"].integer() == 4);
+          REQUIRE(injected["extra"].integer() == 1);
+          auto projected = dict["packet_5"].project({"hostname"});
+          REQUIRE(projected.size() == 1U);
+          REQUIRE(projected["hostname"] == "host0");
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(dict.get_bytes()));
+          dart::buffer copy {dict.dup_bytes()};
+          REQUIRE(copy == dict);
+          REQUIRE(copy["packet_42"]["timestamp"].integer() == 42);
+        }
+      }
+
+      DYNAMIC_WHEN("the object is finalized with a key dictionary and every index", idx) {
+        dart::finalize_options opts;
+        opts.eytzinger_threshold = 2;
+        opts.perfect_hash_threshold = 2;
+        opts.fingerprint_threshold = 2;
+        opts.wide_prefix_threshold = 2;
+        opts.key_dictionary_threshold = 2;
+        auto indexed = obj.finalize(opts);
+
+        DYNAMIC_THEN("lookups still work", idx) {
+          REQUIRE(dart::is_valid(indexed.get_bytes()));
+          REQUIRE(indexed["packet_9"]["hostname"] == "host4");
+          REQUIRE(indexed["packet_9"]["error_message"] == "timeout");
+          REQUIRE_FALSE(indexed["packet_8"].has_key("error_message"));
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized as small aggregates", "[object unit]") {
+  GIVEN("an object of many small nested objects and arrays") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      std::string long_key(300, 'k');
+      auto obj = pkt::make_object("unique_top_level_key", "top");
+      for (auto i = 0; i < 50; ++i) {
+        auto inner = pkt::make_object("ts", i, "host", "host" + std::to_string(i % 5), "", i * 1.5);
+        if (i % 2) inner.add_field(long_key, true);
+        inner.add_field("tags", pkt::make_array("host", i, pkt::make_array(), pkt::make_object()));
+        obj.add_field("packet_" + std::to_string(i), std::move(inner));
+      }
+
+      DYNAMIC_WHEN("the object is finalized with a small aggregate threshold", idx) {
+        dart::finalize_options opts;
+        opts.small_aggregate_threshold = 1024;
+        auto plain_copy = obj, small_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto small = small_copy.finalize(opts);
+
+        DYNAMIC_THEN("every value is still reachable", idx) {
+          for (auto i = 0; i < 50; ++i) {
+            auto inner = small["packet_" + std::to_string(i)];
+            REQUIRE(inner["ts"].integer() == i);
+            REQUIRE(inner["host"] == "host" + std::to_string(i % 5));
+            REQUIRE(inner[""].decimal() == i * 1.5);
+            REQUIRE(inner.has_key(long_key) == static_cast<bool>(i % 2));
+            REQUIRE(inner["tags"][1].integer() == i);
+            REQUIRE(inner["tags"].front() == "host");
+            REQUIRE(inner["tags"].back().size() == 0U);
+            REQUIRE(inner["tags"][4].is_null());
+            REQUIRE_FALSE(inner.has_key("tsx"));
+            REQUIRE_FALSE(inner.has_key(std::string(299, 'k')));
+          }
+          REQUIRE(small["unique_top_level_key"] == "top");
+          REQUIRE(small.get_nested("packet_7.tags").size() == 4U);
+          REQUIRE(small.get_nested(dart::path {"packet_8.tags.0"}) == "host");
+        }
+
+        DYNAMIC_THEN("it compares equal to, and is smaller than, the canonical encoding", idx) {
+          REQUIRE(small.keys() == plain.keys());
+          REQUIRE(small["packet_3"].keys() == plain["packet_3"].keys());
+          REQUIRE(small == plain);
+          REQUIRE(plain == small);
+          REQUIRE(small["packet_3"] == plain["packet_3"]);
+          REQUIRE(small.get_bytes().size() < plain.get_bytes().size());
+        }
+
+        DYNAMIC_THEN("small aggregates have no network buffer of their own", idx) {
+          REQUIRE_THROWS_AS(small["packet_3"].get_bytes(), dart::type_error);
+          REQUIRE_THROWS_AS(small["packet_3"]["tags"].template as_span<int64_t>(), dart::type_error);
+        }
+
+        DYNAMIC_THEN("small aggregates can still be embedded in other packets", idx) {
+          auto host = pkt::make_object("nested", small["packet_3"]);
+          REQUIRE(host["nested"] == plain["packet_3"]);
+          auto injected = small["packet_4"].inject("extra", 1);
+          REQUIRE(injected["ts"].integer() == 4);
+          REQUIRE(injected["extra"].integer() == 1);
+          auto projected = small["packet_5"].project({"host"});
+          REQUIRE(projected.size() == 1U);
+          REQUIRE(projected["host"] == "host0");
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(small.get_bytes()));
+          dart::buffer copy {small.dup_bytes()};
+          REQUIRE(copy == small);
+          REQUIRE(copy["packet_42"]["ts"].integer() == 42);
+        }
+      }
+
+      DYNAMIC_WHEN("the object is finalized with small aggregates and every other encoding", idx) {
+        dart::finalize_options opts;
+        opts.eytzinger_threshold = 2;
+        opts.perfect_hash_threshold = 2;
+        opts.packed_array_threshold = 2;
+        opts.key_dictionary_threshold = 2;
+        opts.small_aggregate_threshold = 1024;
+        auto mixed = obj.finalize(opts);
+
+        DYNAMIC_THEN("lookups still work", idx) {
+          REQUIRE(dart::is_valid(mixed.get_bytes()));
+          REQUIRE(mixed["packet_9"]["host"] == "host4");
+          REQUIRE(mixed["packet_9"][long_key].boolean());
+          REQUIRE_FALSE(mixed["packet_8"].has_key(long_key));
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized with inline scalars", "[object unit]") {
+  GIVEN("an object of mostly small scalars") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      std::string long_str(100, 's');
+      auto obj = pkt::make_object("top", long_str);
+      for (auto i = 0; i < 20; ++i) {
+        auto inner = pkt::make_object("ts", i, "big", 1LL << 40, "dbl", i * 0.5, "ok", i % 2 == 0);
+        inner.add_field("host", "h" + std::to_string(i % 10));
+        inner.add_field("name", "hello");
+        inner.add_field("desc", long_str);
+        inner.add_field("none", nullptr);
+        inner.add_field("vals", pkt::make_array(i, true, nullptr, "a", "abc", 1LL << 40, i * 0.5));
+        obj.add_field("packet_" + std::to_string(i), std::move(inner));
+      }
+
+      DYNAMIC_WHEN("the object is finalized with inline scalars", idx) {
+        dart::finalize_options opts;
+        opts.inline_scalars = true;
+        auto plain_copy = obj, inline_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto inlined = inline_copy.finalize(opts);
+
+        DYNAMIC_THEN("every value is still reachable", idx) {
+          for (auto i = 0; i < 20; ++i) {
+            auto inner = inlined["packet_" + std::to_string(i)];
+            REQUIRE(inner["ts"].integer() == i);
+            REQUIRE(inner["big"].integer() == 1LL << 40);
+            REQUIRE(inner["dbl"].decimal() == i * 0.5);
+            REQUIRE(inner["ok"].boolean() == (i % 2 == 0));
+            REQUIRE(inner["host"] == "h" + std::to_string(i % 10));
+            REQUIRE(inner["name"] == "hello");
+            REQUIRE(inner["desc"] == long_str);
+            REQUIRE(inner.has_key("none"));
+            REQUIRE(inner["none"].is_null());
+
+            auto vals = inner["vals"];
+            REQUIRE(vals[0].integer() == i);
+            REQUIRE(vals[1].boolean());
+            REQUIRE(vals[2].is_null());
+            REQUIRE(vals[3] == "a");
+            REQUIRE(vals[4] == "abc");
+            REQUIRE(vals[5].integer() == 1LL << 40);
+            REQUIRE(vals.back().decimal() == i * 0.5);
+          }
+          REQUIRE(inlined["top"] == long_str);
+          REQUIRE(inlined.get_nested("packet_7.name") == "hello");
+        }
+
+        DYNAMIC_THEN("iteration sees the same values as the canonical encoding", idx) {
+          auto inner = inlined["packet_4"];
+          REQUIRE(inner.keys() == plain["packet_4"].keys());
+          REQUIRE(inner.values() == plain["packet_4"].values());
+          REQUIRE(inner["vals"].values() == plain["packet_4"]["vals"].values());
+          REQUIRE(*inner.find("ts") == 4);
+        }
+
+        DYNAMIC_THEN("it compares equal to the canonical encoding", idx) {
+          REQUIRE(inlined == plain);
+          REQUIRE(plain == inlined);
+          REQUIRE(inlined["packet_3"] == plain["packet_3"]);
+          REQUIRE(inlined["packet_3"]["vals"] == plain["packet_3"]["vals"]);
+        }
+
+        DYNAMIC_THEN("inline values can be embedded in other packets", idx) {
+          auto host = pkt::make_object("nested", inlined["packet_3"]);
+          REQUIRE(host["nested"] == plain["packet_3"]);
+          auto injected = inlined["packet_4"].inject("extra", 1);
+          REQUIRE(injected["ts"].integer() == 4);
+          REQUIRE(injected["name"] == "hello");
+          auto projected = inlined["packet_5"].project({"host", "ok"});
+          REQUIRE(projected.size() == 2U);
+          REQUIRE(projected["host"] == "h5");
+          REQUIRE_FALSE(projected["ok"].boolean());
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(inlined.get_bytes()));
+          dart::buffer copy {inlined.dup_bytes()};
+          REQUIRE(copy == inlined);
+          REQUIRE(copy["packet_12"]["ts"].integer() == 12);
+          REQUIRE(copy["packet_12"]["vals"][3] == "a");
+        }
+      }
+
+      DYNAMIC_WHEN("the object is finalized with inline scalars and every other encoding", idx) {
+        dart::finalize_options opts;
+        opts.inline_scalars = true;
+        opts.eytzinger_threshold = 2;
+        opts.perfect_hash_threshold = 2;
+        opts.packed_array_threshold = 2;
+        opts.key_dictionary_threshold = 2;
+        opts.small_aggregate_threshold = 256;
+        auto mixed = obj.finalize(opts);
+
+        DYNAMIC_THEN("lookups still work", idx) {
+          REQUIRE(dart::is_valid(mixed.get_bytes()));
+          REQUIRE(mixed["packet_9"]["host"] == "h9");
+          REQUIRE(mixed["packet_9"]["ts"].integer() == 9);
+          REQUIRE(mixed["packet_9"]["vals"][4] == "abc");
+          REQUIRE(mixed["packet_9"]["none"].is_null());
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized as large aggregates", "[object unit]") {
+  GIVEN("an object with a mix of large and small nested aggregates") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto wide = pkt::make_object();
+      auto long_arr = pkt::make_array();
+      for (auto i = 0; i < 100; ++i) {
+        wide.add_field("field_" + std::to_string(i), i);
+        long_arr.push_back(pkt::make_object("idx", i, "name", "element" + std::to_string(i)));
+      }
+      auto obj = pkt::make_object("wide", wide, "long", long_arr, "tiny", pkt::make_object("a", 1), "str", "top");
+
+      // Lowering the threshold lets us exercise the encoding without four gigabyte packets.
+      dart::finalize_options opts;
+      opts.large_aggregate_threshold = 2048;
+      auto is_large = [] (auto const& bytes) {
+        return std::all_of(bytes.begin(), bytes.begin() + 4, [] (auto b) { return b == gsl::byte {}; });
+      };
+
+      DYNAMIC_WHEN("the object is finalized past the large aggregate threshold", idx) {
+        auto plain_copy = obj, large_copy = obj;
+        auto plain = plain_copy.finalize();
+        auto large = large_copy.finalize(opts);
+
+        DYNAMIC_THEN("only the aggregates that need it use the large encoding", idx) {
+          REQUIRE(is_large(large.get_bytes()));
+          REQUIRE(is_large(large["wide"].get_bytes()));
+          REQUIRE_FALSE(is_large(plain.get_bytes()));
+          REQUIRE_FALSE(is_large(large["tiny"].get_bytes()));
+          REQUIRE_FALSE(is_large(large["long"][3].get_bytes()));
+        }
+
+        DYNAMIC_THEN("every value is still reachable", idx) {
+          for (auto i = 0; i < 100; ++i) {
+            REQUIRE(large["wide"]["field_" + std::to_string(i)].integer() == i);
+            REQUIRE(large["long"][i]["idx"].integer() == i);
+            REQUIRE(large["long"][i]["name"] == "element" + std::to_string(i));
+          }
+          REQUIRE(large["tiny"]["a"].integer() == 1);
+          REQUIRE(large["str"] == "top");
+          REQUIRE(large["long"].size() == 100U);
+          REQUIRE(large["long"].back()["idx"].integer() == 99);
+          REQUIRE(large["long"][100].is_null());
+          REQUIRE_FALSE(large["wide"].has_key("field_100"));
+          REQUIRE(large.get_nested(dart::path {"long.7.name"}) == "element7");
+          REQUIRE(std::distance(large["wide"].begin(), large["wide"].end()) == 100);
+        }
+
+        DYNAMIC_THEN("it compares equal to the ordinary encoding", idx) {
+          REQUIRE(large.keys() == plain.keys());
+          REQUIRE(large == plain);
+          REQUIRE(plain == large);
+          REQUIRE(large["wide"] == plain["wide"]);
+          REQUIRE(pkt {large.definalize()} == obj);
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(large.get_bytes()));
+          dart::buffer copy {large.dup_bytes()};
+          REQUIRE(copy == large);
+          REQUIRE(copy["long"][42]["idx"].integer() == 42);
+          dart::buffer spanned {large.get_bytes()};
+          REQUIRE(spanned == large);
+          dart::buffer nested {large["wide"].dup_bytes()};
+          REQUIRE(nested["field_42"].integer() == 42);
+        }
+
+        DYNAMIC_THEN("truncated network buffers are rejected", idx) {
+          auto bytes = large.get_bytes();
+          REQUIRE_FALSE(dart::is_valid(bytes.data(), bytes.size() - 8));
+          REQUIRE_FALSE(dart::is_valid(bytes.data(), 16));
+          REQUIRE_THROWS_AS(dart::validate(bytes.data(), bytes.size() - 8), dart::validation_error);
+        }
+
+        DYNAMIC_THEN("it can still be injected into and projected", idx) {
+          auto injected = large.inject("extra", 1);
+          REQUIRE(injected["extra"].integer() == 1);
+          REQUIRE(injected["wide"]["field_3"].integer() == 3);
+          auto projected = large.project({"tiny", "str", "missing"});
+          REQUIRE(projected.size() == 2U);
+          REQUIRE(projected["tiny"]["a"].integer() == 1);
+          REQUIRE_FALSE(is_large(projected.get_bytes()));
+        }
+      }
+
+      DYNAMIC_WHEN("the object is finalized as a large aggregate alongside every other encoding", idx) {
+        opts.eytzinger_threshold = 2;
+        opts.packed_array_threshold = 2;
+        opts.record_batch_threshold = 2;
+        opts.key_dictionary_threshold = 2;
+        opts.small_aggregate_threshold = 256;
+        auto mixed = obj.finalize(opts);
+
+        DYNAMIC_THEN("lookups still work", idx) {
+          REQUIRE(is_large(mixed.get_bytes()));
+          REQUIRE(dart::is_valid(mixed.get_bytes()));
+          REQUIRE(mixed["wide"]["field_9"].integer() == 9);
+          REQUIRE(mixed["long"][9]["name"] == "element9");
+          REQUIRE(mixed["tiny"]["a"].integer() == 1);
+          REQUIRE(mixed == obj.finalize());
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects are finalized into exactly as much memory as they need", "[object unit]") {
+  GIVEN("an object with values of every type and alignment") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto obj = pkt::make_object("a", 1, "bb", 1.5, "ccc", true, "dddd", "str", "e", 70000, "f", 3000000000LL);
+      obj.add_field("nested", pkt::make_object("x", "y", "list", pkt::make_array(1, 2.5, "z", false, nullptr)));
+      obj.add_field("empty", pkt::make_object());
+      obj.add_field("arr", pkt::make_array(pkt::make_array(), pkt::make_object("q", 1), 0.25));
+
+      // Lowering the large aggregate threshold doesn't change the layout of anything this small,
+      // but sizes the buffer by its upper bound instead.
+      dart::finalize_options bounded;
+      bounded.large_aggregate_threshold -= 1;
+      auto same_bytes = [] (auto const& lhs, auto const& rhs) {
+        auto l = lhs.get_bytes(), r = rhs.get_bytes();
+        return std::equal(l.begin(), l.end(), r.begin(), r.end());
+      };
+
+      DYNAMIC_WHEN("the object is finalized", idx) {
+        auto fin = pkt {obj}.finalize();
+
+        DYNAMIC_THEN("it's laid out exactly as it would be in an upper bound sized buffer", idx) {
+          REQUIRE(dart::is_valid(fin.get_bytes()));
+          REQUIRE(fin == obj);
+          REQUIRE(same_bytes(fin, pkt {obj}.finalize(bounded)));
+          REQUIRE(same_bytes(fin, pkt {obj}.finalize()));
+        }
+      }
+
+      DYNAMIC_WHEN("the object is modified after being finalized", idx) {
+        auto before = pkt {obj}.finalize();
+        auto nested = obj["nested"];
+        nested.add_field("longer", "a considerably longer string than anything else");
+        obj.add_field("nested", nested);
+        auto arr = obj["arr"];
+        arr.push_back(pkt::make_object("r", 2));
+        obj.add_field("arr", arr);
+        auto empty = obj["empty"];
+        empty.add_field("no", "longer");
+        obj.add_field("empty", empty);
+        auto after = pkt {obj}.finalize();
+
+        DYNAMIC_THEN("it's sized according to its new contents", idx) {
+          REQUIRE(dart::is_valid(after.get_bytes()));
+          REQUIRE(after == obj);
+          REQUIRE(after != before);
+          REQUIRE(after.get_bytes().size() > before.get_bytes().size());
+          REQUIRE(same_bytes(after, pkt {obj}.finalize(bounded)));
+        }
+      }
+
+      DYNAMIC_WHEN("a shared aggregate is cleared after being finalized", idx) {
+        auto before = pkt {obj}.finalize();
+        auto copy = obj;
+        auto nested = copy["nested"];
+        nested.clear();
+        copy.add_field("nested", nested);
+        auto arr = copy["arr"];
+        arr.resize(1);
+        copy.add_field("arr", arr);
+
+        DYNAMIC_THEN("neither the original nor the copy is affected by the other", idx) {
+          auto orig = pkt {obj}.finalize();
+          auto cleared = pkt {copy}.finalize();
+          REQUIRE(same_bytes(orig, before));
+          REQUIRE(orig["nested"].size() == 2U);
+          REQUIRE(cleared["nested"].empty());
+          REQUIRE(cleared["arr"].size() == 1U);
+          REQUIRE(dart::is_valid(cleared.get_bytes()));
+          REQUIRE(same_bytes(cleared, pkt {copy}.finalize(bounded)));
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized in parallel", "[object unit]") {
+  GIVEN("an object holding many nested objects and arrays") {
+    auto records = dart::heap::make_array();
+    for (auto i = 0; i < 512; ++i) {
+      auto rec = dart::heap::make_object("id", i, "name", "record " + std::to_string(i), "score", i * 0.5);
+      rec.add_field("tags", dart::heap::make_array("a", i % 3 == 0, i, dart::heap::make_object("deep", i)));
+      records.push_back(std::move(rec));
+    }
+    auto obj = dart::heap::make_object("records", records, "count", 512, "nested", dart::heap::make_object("more", records));
+
+    auto same_bytes = [] (auto const& lhs, auto const& rhs) {
+      auto l = lhs.get_bytes(), r = rhs.get_bytes();
+      return std::equal(l.begin(), l.end(), r.begin(), r.end());
+    };
+
+    WHEN("the object is finalized on several threads, with subtrees small enough to split it up") {
+      dart::parallel_policy policy {4, 256};
+      auto par = obj.finalize(policy);
+
+      THEN("it's identical to the same object finalized on a single thread") {
+        REQUIRE(policy.threads() == 4U);
+        REQUIRE(same_bytes(par, obj.finalize()));
+        REQUIRE(dart::is_valid(par.get_bytes()));
+        REQUIRE(par == obj);
+        REQUIRE(par["records"][511]["tags"][3]["deep"] == 511);
+      }
+
+      THEN("finalizing again with the same policy gives the same result") {
+        REQUIRE(same_bytes(par, obj.finalize(policy)));
+      }
+    }
+
+    WHEN("the object is finalized on several threads, with optional sections") {
+      dart::parallel_policy policy {3, 512};
+      dart::finalize_options opts;
+      opts.content_hash_threshold = 1;
+      opts.eytzinger_threshold = 2;
+      opts.perfect_hash_threshold = 3;
+
+      THEN("it's identical to the same object finalized on a single thread") {
+        auto par = obj.finalize(policy, opts);
+        REQUIRE(same_bytes(par, obj.finalize(opts)));
+        REQUIRE(dart::is_valid(par.get_bytes()));
+        REQUIRE(std::hash<dart::buffer> {}(par) == std::hash<dart::heap> {}(obj));
+      }
+    }
+
+    WHEN("the object is finalized on several threads, with encodings that can't be split up") {
+      dart::parallel_policy policy {2, 256};
+      dart::finalize_options opts;
+      opts.record_batch_threshold = 2;
+      opts.small_aggregate_threshold = 128;
+
+      THEN("it falls back to finalizing on the calling thread") {
+        auto par = obj.finalize(policy, opts);
+        REQUIRE(same_bytes(par, obj.finalize(opts)));
+        REQUIRE(par == obj);
+      }
+    }
+
+    WHEN("the object is too small to be worth splitting up") {
+      dart::parallel_policy policy {4};
+      auto small = dart::heap::make_object("hello", "world");
+
+      THEN("it's finalized on the calling thread") {
+        REQUIRE(same_bytes(small.finalize(policy), small.finalize()));
+      }
+    }
+  }
+}
+
+SCENARIO("definalized objects reuse their unmodified parts when finalized again", "[object unit]") {
+  GIVEN("a finalized object with nested objects and arrays") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto obj = pkt::make_object("name", "dart", "version", 1, "ratio", 0.5);
+      obj.add_field("nested", pkt::make_object("hello", "world", "list", pkt::make_array(1, 2.5, "three")));
+      obj.add_field("untouched", pkt::make_object("deeper", pkt::make_object("deepest", pkt::make_array(true, nullptr))));
+      auto fin = pkt {obj}.finalize();
+
+      auto same_bytes = [] (auto const& lhs, auto const& rhs) {
+        auto l = lhs.get_bytes(), r = rhs.get_bytes();
+        return std::equal(l.begin(), l.end(), r.begin(), r.end());
+      };
+
+      DYNAMIC_WHEN("the object is definalized and finalized again", idx) {
+        auto again = pkt {fin}.definalize().finalize();
+
+        DYNAMIC_THEN("it's identical to the original", idx) {
+          REQUIRE(same_bytes(again, fin));
+          REQUIRE(again.get_bytes().data() != fin.get_bytes().data());
+        }
+      }
+
+      DYNAMIC_WHEN("the object is definalized, modified, and finalized again", idx) {
+        auto dyn = pkt {fin}.definalize();
+        auto nested = dyn["nested"];
+        nested.add_field("hello", "there");
+        auto list = nested["list"];
+        list.push_back(4);
+        nested.add_field("list", list);
+        dyn.add_field("nested", nested);
+        dyn.add_field("version", 2);
+        auto changed = pkt {dyn}.finalize();
+
+        obj.add_field("version", 2);
+        auto fresh_nested = pkt::make_object("hello", "there", "list", pkt::make_array(1, 2.5, "three", 4));
+        obj.add_field("nested", fresh_nested);
+        auto fresh = pkt {obj}.finalize();
+
+        DYNAMIC_THEN("it's identical to the same object built from scratch", idx) {
+          REQUIRE(dart::is_valid(changed.get_bytes()));
+          REQUIRE(same_bytes(changed, fresh));
+          REQUIRE(changed["nested"]["list"][3] == 4);
+          REQUIRE(changed["untouched"] == fin["untouched"]);
+        }
+
+        DYNAMIC_THEN("the original buffer is unaffected", idx) {
+          REQUIRE(fin["version"] == 1);
+          REQUIRE(fin["nested"]["hello"] == "world");
+          REQUIRE(fin["nested"]["list"].size() == 3U);
+        }
+      }
+
+      DYNAMIC_WHEN("the object is definalized and finalized again with optional encodings", idx) {
+        dart::finalize_options opts;
+        opts.content_hash_threshold = 1;
+        opts.inline_scalars = true;
+        auto encoded = pkt {fin}.definalize().finalize(opts);
+
+        DYNAMIC_THEN("the optional encodings are applied throughout", idx) {
+          REQUIRE(same_bytes(encoded, pkt {obj}.finalize(opts)));
+          REQUIRE(encoded == fin);
+        }
+
+        DYNAMIC_THEN("definalizing that gives back the canonical encoding", idx) {
+          REQUIRE(same_bytes(pkt {encoded}.definalize().finalize(), fin));
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("objects can be finalized into memory owned by the caller", "[object unit]") {
+  GIVEN("an object, and some word aligned memory") {
+    auto obj = dart::heap::make_object("a", 1, "bb", 1.5, "ccc", true, "dddd", "str");
+    obj.add_field("nested", dart::heap::make_object("x", "y", "list", dart::heap::make_array(1, 2.5, "z", nullptr)));
+    auto fin = obj.finalize();
+    auto bytes = fin.get_bytes();
+    std::vector<uint64_t> slab(bytes.size() / sizeof(uint64_t) + 8);
+    auto dest = gsl::make_span(reinterpret_cast<gsl::byte*>(slab.data()), slab.size() * sizeof(uint64_t));
+
+    WHEN("the object is finalized into the memory") {
+      auto used = obj.finalize_into(dest);
+
+      THEN("it's laid out exactly as an ordinary finalization would be") {
+        REQUIRE(used == static_cast<size_t>(bytes.size()));
+        REQUIRE(std::equal(bytes.begin(), bytes.end(), dest.begin(), dest.begin() + used));
+        REQUIRE(dart::is_valid(dest.first(used)));
+      }
+
+      THEN("the memory can be adopted by a buffer without copying it") {
+        auto released = 0;
+        {
+          dart::buffer adopted {dest.first(used), [&] (gsl::byte const* ptr) {
+            REQUIRE(ptr == dest.data());
+            ++released;
+          }};
+          auto copy = adopted;
+          REQUIRE(copy.get_bytes().data() == dest.data());
+          REQUIRE(copy == obj);
+          REQUIRE(copy["nested"]["list"][2] == "z");
+          REQUIRE(released == 0);
+        }
+        REQUIRE(released == 1);
+      }
+    }
+
+    WHEN("the object is finalized with optional encodings") {
+      dart::finalize_options opts;
+      opts.key_dictionary_threshold = 1;
+      opts.eytzinger_threshold = 2;
+      auto encoded = obj.finalize(opts);
+      std::vector<uint64_t> roomy(slab.size() * 4);
+      auto roomy_dest = gsl::make_span(reinterpret_cast<gsl::byte*>(roomy.data()), roomy.size() * sizeof(uint64_t));
+      auto used = obj.finalize_into(roomy_dest, opts);
+
+      THEN("it's laid out exactly as an ordinary finalization would be") {
+        auto expected = encoded.get_bytes();
+        REQUIRE(used == static_cast<size_t>(expected.size()));
+        REQUIRE(std::equal(expected.begin(), expected.end(), roomy_dest.begin(), roomy_dest.begin() + used));
+      }
+    }
+
+    WHEN("the memory is too small") {
+      THEN("the error says how much would have been needed") {
+        auto small = dest.first(bytes.size() - 8);
+        REQUIRE_THROWS_AS(obj.finalize_into(small), dart::size_error);
+        try {
+          obj.finalize_into(small);
+        } catch (dart::size_error const& err) {
+          REQUIRE(err.needed == static_cast<size_t>(bytes.size()));
+        }
+      }
+    }
+
+    WHEN("the memory is misaligned") {
+      THEN("nothing is written, and nothing is adopted") {
+        auto released = false;
+        REQUIRE_THROWS_AS(obj.finalize_into(dest.subspan(4)), std::invalid_argument);
+        REQUIRE_THROWS_AS(dart::buffer(dest.subspan(4, bytes.size()), [&] (auto*) { released = true; }), std::invalid_argument);
+        REQUIRE(!released);
+      }
+    }
+  }
+}
+
+SCENARIO("objects can be finalized with content hashes", "[object unit]") {
+  GIVEN("an object with nested objects, arrays, and scalars") {
+    dart::mutable_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto obj = pkt::make_object("name", "dart", "version", 1, "ratio", 0.5, "enabled", true);
+      obj.add_field("nested", pkt::make_object("hello", "world", "list", pkt::make_array(1, 2, 3)));
+      obj.add_field("records", pkt::make_array(pkt::make_object("a", 1, "b", "x"), pkt::make_object("a", 2, "b", "y")));
+
+      dart::finalize_options opts;
+      opts.content_hash_threshold = 1;
+      auto hash = [] (auto const& val) { return std::hash<std::decay_t<decltype(val)>> {}(val); };
+
+      DYNAMIC_WHEN("the object is finalized with content hashes", idx) {
+        auto hashed = pkt {obj}.finalize(opts);
+        auto plain = pkt {obj}.finalize();
+
+        DYNAMIC_THEN("it hashes and compares the same as the canonical encoding", idx) {
+          REQUIRE(hashed == plain);
+          REQUIRE(plain == hashed);
+          REQUIRE(hash(hashed) == hash(plain));
+          REQUIRE(hash(hashed) == hash(obj));
+          REQUIRE(hash(hashed["nested"]) == hash(plain["nested"]));
+          REQUIRE(hash(hashed["records"]) == hash(obj["records"]));
+          REQUIRE(hashed["nested"] == plain["nested"]);
+          REQUIRE(hashed.get_bytes().size() > plain.get_bytes().size());
+        }
+
+        DYNAMIC_THEN("it is rejected by buffers with different contents", idx) {
+          auto other = pkt {obj};
+          other.add_field("nested", pkt::make_object("hello", "there", "list", pkt::make_array(1, 2, 3)));
+          auto changed = other.finalize(opts);
+          REQUIRE(hashed != changed);
+          REQUIRE(hashed["nested"] != changed["nested"]);
+          REQUIRE(hashed["records"] == changed["records"]);
+          REQUIRE(hash(hashed) != hash(changed));
+          REQUIRE(hash(hashed["nested"]) != hash(changed["nested"]));
+        }
+
+        DYNAMIC_THEN("it survives a round trip through its network buffer", idx) {
+          REQUIRE(dart::is_valid(hashed.get_bytes()));
+          dart::buffer copy {hashed.dup_bytes()};
+          REQUIRE(copy == hashed);
+          REQUIRE(hash(copy) == hash(plain));
+        }
+
+        DYNAMIC_THEN("network buffers with the wrong hash are rejected", idx) {
+          // The hash is the only section, directly after the root vtable.
+          size_t len;
+          auto bytes = hashed.dup_bytes(len);
+          auto* raw = const_cast<gsl::byte*>(bytes.get());
+          auto const offset = 8 + hashed.size() * 8 + 8;
+          raw[offset] = static_cast<gsl::byte>(~static_cast<unsigned char>(raw[offset]));
+          REQUIRE_FALSE(dart::is_valid(raw, len));
+          REQUIRE_THROWS_AS(dart::validate(raw, len), dart::validation_error);
+        }
+      }
+
+      DYNAMIC_WHEN("the object is finalized with content hashes alongside other encodings", idx) {
+        opts.packed_array_threshold = 2;
+        opts.record_batch_threshold = 2;
+        opts.key_dictionary_threshold = 2;
+        opts.small_aggregate_threshold = 64;
+        opts.inline_scalars = true;
+        auto mixed = pkt {obj}.finalize(opts);
+
+        DYNAMIC_THEN("its hash doesn't depend on the encoding", idx) {
+          REQUIRE(dart::is_valid(mixed.get_bytes()));
+          REQUIRE(mixed == pkt {obj}.finalize());
+          REQUIRE(hash(mixed) == hash(obj));
+          REQUIRE(hash(mixed["records"]) == hash(obj["records"]));
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("finalized objects can be block compressed", "[object unit]") {
+  GIVEN("a finalized object full of repetitive strings") {
+    auto obj = dart::heap::make_object("top", "level");
+    for (auto i = 0; i < 200; ++i) {
+      auto inner = dart::heap::make_object("hostname", "host" + std::to_string(i % 5), "ts", i);
+      inner.add_field("message", "the quick brown fox jumps over the lazy dog, request " + std::to_string(i));
+      inner.add_field("tags", dart::heap::make_array("alpha", "beta", "gamma", i));
+      obj.add_field("packet_" + std::to_string(i), std::move(inner));
+    }
+    obj.add_field("nothing", nullptr);
+
+    dart::finalize_options opts;
+    opts.inline_scalars = true;
+    auto plain = obj.finalize();
+    auto inlined = obj.finalize(opts);
+
+    WHEN("it is compressed") {
+      dart::compressed_buffer comp {plain, 1024};
+
+      THEN("it is smaller than the original, and nothing is decompressed up front") {
+        REQUIRE(comp.decompressed_size() == plain.get_bytes().size());
+        REQUIRE(comp.get_bytes().size() < plain.get_bytes().size() / 2);
+        REQUIRE(comp.resident_bytes() == comp.get_bytes().size());
+        REQUIRE(comp.size() == plain.size());
+        REQUIRE(comp.has_key("packet_42"));
+        REQUIRE_FALSE(comp.has_key("packet_420"));
+        REQUIRE(comp.resident_bytes() == comp.get_bytes().size());
+      }
+
+      THEN("fields can be looked up, decompressing only their own block") {
+        auto inner = comp["packet_42"];
+        REQUIRE(inner == plain["packet_42"]);
+        REQUIRE(inner["tags"][3].integer() == 42);
+        REQUIRE(comp.resident_bytes() > comp.get_bytes().size());
+        REQUIRE(comp.resident_bytes() < comp.get_bytes().size() + plain.get_bytes().size() / 4);
+        REQUIRE(comp["top"] == "level");
+        REQUIRE(comp["nothing"].is_null());
+        REQUIRE(comp["missing"].is_null());
+        REQUIRE(dart::is_valid(inner.get_bytes()));
+      }
+
+      THEN("every field matches the original") {
+        auto keys = comp.keys();
+        REQUIRE(keys.size() == plain.size());
+        for (auto key : keys) REQUIRE(comp[key] == plain[key]);
+      }
+
+      THEN("values outlive the cache") {
+        auto inner = comp["packet_7"];
+        comp.evict();
+        REQUIRE(comp.resident_bytes() == comp.get_bytes().size());
+        REQUIRE(inner["message"] == plain["packet_7"]["message"]);
+      }
+
+      THEN("it decompresses back into the original buffer") {
+        auto whole = comp.decompress();
+        REQUIRE(whole.get_bytes().size() == plain.get_bytes().size());
+        REQUIRE(std::equal(whole.get_bytes().begin(), whole.get_bytes().end(), plain.get_bytes().begin()));
+      }
+
+      THEN("it survives a round trip through its bytes") {
+        auto bytes = comp.get_bytes();
+        dart::compressed_buffer copy {bytes};
+        REQUIRE(copy["packet_199"] == plain["packet_199"]);
+        REQUIRE(copy.decompress() == plain);
+
+        std::vector<gsl::byte> corrupt(bytes.begin(), bytes.end());
+        corrupt[0] = gsl::byte {};
+        REQUIRE_THROWS_AS(dart::compressed_buffer {corrupt}, dart::validation_error);
+        REQUIRE_THROWS_AS(dart::compressed_buffer {gsl::make_span(bytes.data(), 40)}, dart::validation_error);
+
+        // A block count that can't fit in the bytes given is rejected before anything is sized off of it.
+        std::vector<gsl::byte> oversized(bytes.begin(), bytes.end());
+        auto const blocks_at = offsetof(dart::detail::compressed_layout, blocks);
+        std::fill(oversized.begin() + blocks_at, oversized.begin() + blocks_at + 4, static_cast<gsl::byte>(0xFF));
+        REQUIRE_THROWS_AS(dart::compressed_buffer {oversized}, dart::validation_error);
+        std::vector<gsl::byte> zeroed(sizeof(dart::detail::compressed_layout));
+        zeroed[blocks_at + 3] = static_cast<gsl::byte>(0x03);
+        REQUIRE_THROWS_AS(dart::compressed_buffer {zeroed}, dart::validation_error);
+      }
+    }
+
+    WHEN("a buffer with inline scalars is compressed") {
+      dart::unsafe_compressed_buffer comp {dart::unsafe_buffer {inlined.dup_bytes()}};
+      THEN("inline values are read straight out of the uncompressed head") {
+        REQUIRE(comp["packet_3"]["ts"].integer() == 3);
+        REQUIRE(comp["top"] == "level");
+        REQUIRE(comp.decompress() == plain);
+      }
+
+      THEN("a corrupted value in the head is rejected up front") {
+        auto bytes = comp.get_bytes();
+        std::vector<gsl::byte> corrupt(bytes.begin(), bytes.end());
+        std::string const needle = "level";
+        auto* chars = reinterpret_cast<char const*>(corrupt.data());
+        auto const pos = std::search(chars, chars + corrupt.size(), needle.begin(), needle.end()) - chars;
+        REQUIRE(pos < static_cast<ssize_t>(corrupt.size()));
+        corrupt[pos - 1] = static_cast<gsl::byte>(0xFF);
+        corrupt[pos - 2] = static_cast<gsl::byte>(0xFF);
+        REQUIRE_THROWS_AS(dart::compressed_buffer {corrupt}, std::invalid_argument);
+      }
+    }
+
+    WHEN("a buffer with a key dictionary is compressed") {
+      dart::finalize_options dict_opts;
+      dict_opts.key_dictionary_threshold = 2;
+      auto dict = obj.finalize(dict_opts);
+      dart::compressed_buffer comp {dict};
+      THEN("values are served out of the whole buffer") {
+        REQUIRE(comp["packet_3"] == plain["packet_3"]);
+        REQUIRE(comp["packet_3"]["hostname"] == "host3");
+        REQUIRE(comp.resident_bytes() >= comp.get_bytes().size() + dict.get_bytes().size());
+      }
+    }
+
+    WHEN("something other than a finalized object is compressed") {
+      THEN("it refuses") {
+        REQUIRE_THROWS_AS(dart::compressed_buffer {plain["top"]}, dart::type_error);
+      }
+    }
+  }
+}
+
+SCENARIO("finalized objects can be queried with precompiled keys", "[object unit]") {
+  GIVEN("some precompiled keys") {
+    dart::buffer_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      dart::key short_key {"a"}, long_key {"field_7"}, missing {"field_77"};
+      DYNAMIC_WHEN("the keys are looked up in objects of the same shape", idx) {
+        DYNAMIC_THEN("they're found every time", idx) {
+          for (auto i = 0; i < 4; ++i) {
+            auto obj = pkt::make_object("a", i, "b", "b", "field_7", i * 2);
+            REQUIRE(obj[short_key].integer() == i);
+            REQUIRE(obj.get(long_key).integer() == i * 2);
+            REQUIRE(obj.has_key(long_key));
+            REQUIRE_FALSE(obj.has_key(missing));
+            REQUIRE(obj[missing].is_null());
+          }
+        }
+      }
+
+      DYNAMIC_WHEN("the keys are looked up in objects of different shapes", idx) {
+        auto first = pkt::make_object("a", 1, "field_7", 2);
+        auto second = pkt::make_object("0", 0, "1", 1, "2", 2, "field_7", 3);
+        auto third = pkt::make_object("b", 1);
+
+        DYNAMIC_THEN("they're still found", idx) {
+          REQUIRE(first[long_key].integer() == 2);
+          REQUIRE(second[long_key].integer() == 3);
+          REQUIRE(third[long_key].is_null());
+          REQUIRE(first[short_key].integer() == 1);
+          REQUIRE_FALSE(second.has_key(short_key));
+          REQUIRE_FALSE(third.has_key(short_key));
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("finalized objects can look up many keys at once", "[object unit]") {
+  GIVEN("a finalized object") {
+    dart::buffer_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      auto obj = pkt::make_object("a", 1, "bb", 2, "field_3", 3, "field_44", nullptr, "long key here", 5);
+      DYNAMIC_WHEN("a batch of present and missing keys is looked up", idx) {
+        std::vector<dart::shim::string_view> keys {"long key here", "zz", "a", "field_44", "field_3", "bb"};
+        std::vector<pkt> out(keys.size());
+        obj.get_many(keys, out);
+
+        DYNAMIC_THEN("each output matches a single lookup of the same key", idx) {
+          for (auto i = 0U; i < keys.size(); ++i) REQUIRE(out[i] == obj[keys[i]]);
+          REQUIRE(out[0].integer() == 5);
+          REQUIRE(out[1].is_null());
+          REQUIRE(out[3].is_null());
+        }
+      }
+
+      DYNAMIC_WHEN("a batch of keys is looked up into views", idx) {
+        std::vector<dart::shim::string_view> keys {"a", "bb", "field_3"};
+        std::vector<typename pkt::view> out(keys.size());
+        obj.get_many(keys, out);
+
+        DYNAMIC_THEN("the views refer to the values", idx) {
+          REQUIRE(out[0].integer() == 1);
+          REQUIRE(out[1].integer() == 2);
+          REQUIRE(out[2].integer() == 3);
+        }
+      }
+
+      DYNAMIC_WHEN("the output span is the wrong size", idx) {
+        std::vector<dart::shim::string_view> keys {"a", "bb"};
+        std::vector<pkt> out(1);
+        DYNAMIC_THEN("it refuses", idx) {
+          REQUIRE_THROWS_AS(obj.get_many(keys, out), std::invalid_argument);
+        }
+      }
+    });
+  }
+}
+
+SCENARIO("finalized objects can be searched for the same key in batches", "[object unit]") {
+  GIVEN("a batch of objects of different sizes and encodings") {
+    dart::buffer_api_test([] (auto tag, auto idx) {
+      using pkt = typename decltype(tag)::type;
+
+      std::vector<pkt> batch;
+      for (auto i = 0; i < 40; ++i) {
+        auto obj = dart::heap::make_object("ty", i);
+        auto const num_fields = (i % 3) ? 100 + i : 4;
+        for (auto j = 0; j < num_fields; ++j) obj.add_field("field_" + std::to_string(j), j);
+        if (i % 5 == 0) obj.add_field("type", nullptr);
+        else if (i % 7) obj.add_field("type", "type_" + std::to_string(i));
+
+        dart::finalize_options opts;
+        if (i % 4 == 0) opts.perfect_hash_threshold = 1;
+        else if (i % 6 == 1) opts.large_aggregate_threshold = 0;
+        batch.push_back(pkt {obj.finalize(opts).dup_bytes()});
+      }
+
+      DYNAMIC_WHEN("a key is looked up across the batch", idx) {
+        DYNAMIC_THEN("every result matches a single lookup of the same key", idx) {
+          for (auto key : {"type", "ty", "field_42", "missing"}) {
+            std::vector<pkt> out(batch.size());
+            pkt::lookup_batch(batch, key, out);
+            for (auto i = 0U; i < batch.size(); ++i) {
+              REQUIRE(out[i] == batch[i][key]);
+              REQUIRE(out[i].get_type() == batch[i][key].get_type());
+            }
+          }
+        }
+      }
+
+      DYNAMIC_WHEN("the batch contains something other than an object", idx) {
+        std::vector<pkt> mixed {batch[0], pkt::make_null()};
+        std::vector<pkt> out(mixed.size());
+        DYNAMIC_THEN("it refuses", idx) {
+          REQUIRE_THROWS_AS(pkt::lookup_batch(mixed, "type", out), dart::type_error);
+          REQUIRE_THROWS_AS(pkt::lookup_batch(batch, "type", out), std::invalid_argument);
+        }
+      }
+    });
+  }
+}
+
 SCENARIO("objects have limits on key sizes", "[object unit]") {
   GIVEN("a very long string") {
     dart::api_test([] (auto tag, auto idx) {
@@ -1510,4 +2870,25 @@ SCENARIO("objects can contain nulls", "[object unit]") {
       }
     });
   }
+
+  GIVEN("an object with nulls between its other values") {
+    // Nulls take up no space, so they share an offset with whatever comes next.
+    auto null = dart::heap::null();
+    auto inner = dart::heap::make_object("a", null, "bb", 1, "ccc", null, "dddd", "value");
+    auto obj = dart::heap::make_object("inner", inner, "z", null, "zz", inner);
+    dart::finalize_options small, large;
+    small.small_aggregate_threshold = 1024;
+    large.large_aggregate_threshold = 0;
+    WHEN("it is finalized with each encoding") {
+      THEN("the result still validates") {
+        for (auto const& opts : {dart::finalize_options {}, small, large}) {
+          auto fin = obj.finalize(opts);
+          REQUIRE(dart::is_valid(fin.get_bytes()));
+          REQUIRE(fin["inner"]["dddd"] == "value");
+          REQUIRE(fin["inner"]["ccc"].is_null());
+          REQUIRE(fin["z"].is_null());
+        }
+      }
+    }
+  }
 }
@@ -216,6 +216,15 @@ SCENARIO("objects can access nested keys in a single step", "[type unit]") {
           REQUIRE(nested.is_null());
         }
       }
+
+      DYNAMIC_WHEN("accessing a precompiled path", idx) {
+        auto dark_side = obj.get_nested(dart::path {"songs.time"});
+        auto nested = obj.get_nested(dart::path {"songs.not_here"});
+        DYNAMIC_THEN("it behaves like the uncompiled path", idx) {
+          REQUIRE(dark_side == "dark side");
+          REQUIRE(nested.is_null());
+        }
+      }
     });
   }
 }